@@ -163,6 +163,7 @@ class PASN_ConstrainedObject : public PASN_Object
     PCLASSINFO(PASN_ConstrainedObject, PASN_Object);
   public:
     PBoolean IsConstrained() const { return constraint != Unconstrained; }
+    ConstraintType GetConstraint() const { return constraint; }
     int GetLowerLimit() const { return lowerLimit; }
     unsigned GetUpperLimit() const { return upperLimit; }
 
@@ -527,6 +528,11 @@ class PASN_ConstrainedString : public PASN_ConstrainedObject
     void SetCharacterSet(ConstraintType ctype, unsigned firstChar = 0, unsigned lastChar = 255);
     void SetCharacterSet(const char * charSet, PINDEX size, ConstraintType ctype);
 
+    const PCharArray & GetCharacterSet() const { return characterSet; }
+    unsigned GetCanonicalSetBits() const { return canonicalSetBits; }
+    unsigned GetCharSetUnalignedBits() const { return charSetUnalignedBits; }
+    unsigned GetCharSetAlignedBits() const { return charSetAlignedBits; }
+
     virtual Comparison Compare(const PObject & obj) const;
     virtual void PrintOn(ostream & strm) const;
 
@@ -0,0 +1,244 @@
+/*
+ * asnpertab.h
+ *
+ * Table driven Packed Encoding Rules codec for ASN.1
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#ifndef PTLIB_ASNPERTAB_H
+#define PTLIB_ASNPERTAB_H
+
+#ifdef P_USE_PRAGMA
+#pragma interface
+#endif
+
+#if P_ASN
+
+#include <ptclib/asner.h>
+
+
+struct PPER_Field;
+
+
+/**Constraint table for an ASN.1 type, as used by PPER_TableCodec.
+   These are normally generated by asnparser using the --per-tables option,
+   one for each class it generates, named as the class with a _Table suffix.
+   The information held is exactly what the generated class would set up in its
+   constructor, so the table codec produces the identical encoding.
+
+   The members are in aggregate initialisation order, so they can be placed
+   in read only memory by the compiler.
+  */
+struct PPER_Type
+{
+  enum Kinds {
+    e_Null,
+    e_Boolean,
+    e_Integer,
+    e_Enumeration,
+    e_Real,
+    e_ObjectId,
+    e_BitString,
+    e_OctetString,
+    e_String,       ///< Any of the PASN_ConstrainedString descendants
+    e_BMPString,
+    e_Choice,
+    e_Sequence,
+    e_Array,
+    e_OpenType      ///< Unknown extension or alternative, kept as raw octets
+  };
+
+  const char *       m_name;
+  BYTE               m_kind;          ///< One of Kinds
+  BYTE               m_constraint;    ///< PASN_Object::ConstraintType for the value or size
+  BYTE               m_extendable;    ///< Extension marker on enumeration, choice or sequence
+  int                m_lower;         ///< Lower value or size limit
+  unsigned           m_upper;         ///< Upper value or size limit
+  unsigned           m_count;         ///< Root fields or alternatives, or maximum enumeration value
+  unsigned           m_options;       ///< Number of OPTIONAL root fields in a sequence
+  unsigned           m_extensions;    ///< Number of known extension fields or alternatives
+  const PPER_Field * m_fields;        ///< Sequence fields, choice alternatives or array element
+  const char *       m_charSet;       ///< Effective permitted alphabet for e_String
+  unsigned           m_charSetSize;   ///< Number of characters in m_charSet
+  BYTE               m_unalignedBits; ///< Bits per character, unaligned variant
+  BYTE               m_alignedBits;   ///< Bits per character, aligned variant
+  BYTE               m_canonicalBits; ///< Bits per character for the unconstrained alphabet
+
+  /// Table used for unknown extensions and alternatives
+  static const PPER_Type OpenType;
+};
+
+
+/**A field of a sequence or alternative of a choice in a PPER_Type table.
+  */
+struct PPER_Field
+{
+  const char *      m_name;
+  const PPER_Type * m_type;
+  int               m_option;  ///< Bit in the sequence option map, -1 if not OPTIONAL
+};
+
+
+/**Decoded value for the table driven PER codec.
+   This is a plain structure, allocated from a PPER_Arena, so a whole decoded
+   PDU is released at once via PPER_Arena::Reset().
+
+   The interpretation of the members depends on m_type->m_kind:
+     e_Boolean, e_Integer, e_Enumeration: m_value
+     e_BitString:   m_size bits in m_data, most significant bit first
+     e_OctetString, e_ObjectId, e_OpenType: m_size octets in m_data,
+                    the object identifier is in its BER contents form
+     e_String:      m_size characters in m_data, not null terminated
+     e_BMPString:   m_size WORD characters in m_data
+     e_Choice:      m_value is the alternative index, m_children[0] the value
+     e_Sequence:    m_children are the fields in table order followed by any
+                    unknown extensions, m_size is the number of extension
+                    bits received, absent fields have a NULL m_type
+     e_Array:       m_size elements in m_children
+
+   Note that octet strings, and character strings using 8 bit characters, may
+   point directly into the buffer that was decoded, which must outlive the
+   value.
+  */
+struct PPER_Value
+{
+  const PPER_Type * m_type;
+  unsigned          m_value;
+  unsigned          m_size;
+  const void *      m_data;
+  PPER_Value *      m_children;
+
+  bool IsPresent() const { return m_type != NULL; }
+  const PPER_Value & operator[](PINDEX idx) const { return m_children[idx]; }
+
+  /**Get a sequence field or choice alternative by name.
+     @return NULL if the name is not in the table, or the value is not present.
+    */
+  const PPER_Value * GetField(const char * name) const;
+
+  /// Get the string value for e_String or e_BMPString kinds
+  PString AsString() const;
+};
+
+
+/**Block allocator for decoded PPER_Value trees.
+   Allocation is simply advancing a pointer in the current block, and nothing
+   is individually freed. After Reset() the memory is re-used, coalesced into
+   a single block large enough for the previous PDU, so a steady state decode
+   loop does not touch the heap at all.
+  */
+class PPER_Arena
+{
+  public:
+    PPER_Arena(
+      size_t blockSize = 4096   ///< Initial block size
+    );
+    ~PPER_Arena();
+
+    /// Allocate memory, aligned for any of the structures used
+    void * Allocate(size_t size);
+
+    /// Allocate zeroed values
+    PPER_Value * AllocateValues(unsigned count);
+
+    /// Release everything allocated, retaining the memory for re-use
+    void Reset();
+
+    /// Get the total bytes allocated since the last Reset()
+    size_t GetUsed() const { return m_used + (m_next - m_start); }
+
+  protected:
+    void * AllocateBlock(size_t size);
+
+    struct Block {
+      Block * m_next;
+      size_t  m_size;
+    };
+    Block * m_blocks;
+    BYTE  * m_start;
+    BYTE  * m_next;
+    BYTE  * m_end;
+    size_t  m_blockSize;
+    size_t  m_used;
+
+  private:
+    PPER_Arena(const PPER_Arena &);
+    void operator=(const PPER_Arena &);
+};
+
+
+/**Table driven PER encoder/decoder.
+   This encodes and decodes using the PPER_Type tables generated by asnparser,
+   producing exactly the same octets as the generated PASN_Object classes and
+   PPER_Stream, but without constructing any objects. Bits are read a machine
+   word at a time with one bounds check per field, and decoded values are
+   allocated from a PPER_Arena.
+
+   The codec itself has no state beyond the alignment variant, so one
+   instance may be used by many threads, each with its own arena.
+  */
+class PPER_TableCodec
+{
+  public:
+    PPER_TableCodec(
+      bool aligned = true   ///< Use the aligned PER variant
+    );
+
+    /**Decode a PDU.
+       @return false if the data is malformed or truncated.
+      */
+    bool Decode(
+      const PPER_Type & type,   ///< Table for the PDU type
+      const BYTE * data,        ///< Encoded data
+      PINDEX size,              ///< Size of encoded data
+      PPER_Arena & arena,       ///< Arena for the decoded values
+      PPER_Value & value        ///< Decoded value
+    ) const;
+    bool Decode(
+      const PPER_Type & type,   ///< Table for the PDU type
+      const PBYTEArray & data,  ///< Encoded data
+      PPER_Arena & arena,       ///< Arena for the decoded values
+      PPER_Value & value        ///< Decoded value
+    ) const { return Decode(type, data, data.GetSize(), arena, value); }
+
+    /**Encode a PDU.
+       @return false if the value is not encodable, e.g. a length beyond the
+               16K fragmentation limit, which PPER_Stream does not support.
+      */
+    bool Encode(
+      const PPER_Value & value, ///< Value to encode
+      PBYTEArray & data         ///< Encoded data
+    ) const;
+
+    bool IsAligned() const { return m_aligned; }
+
+  protected:
+    bool m_aligned;
+};
+
+
+#endif // P_ASN
+
+#endif // PTLIB_ASNPERTAB_H
+
+
+// End Of File ///////////////////////////////////////////////////////////////
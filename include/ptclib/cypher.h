@@ -206,6 +206,33 @@ class PBase64 : public PObject
       PINDEX width = 76        ///< Line widths if endOfLine non empty
     );
 
+    /** Get the length of the Base64 string for the data length, including
+       any line endings, as produced by <code>EncodeBlock()</code>.
+
+       @return
+       Number of characters in the encoded string.
+     */
+    static PINDEX GetEncodedLength(
+      PINDEX length,           ///< Length of the data block.
+      Options options = e_LF,  ///< Options for encoding.
+      PINDEX width = 76        ///< Line widths if options != e_URL
+    );
+
+    /** Encode the data in memory to Base 64 in a single pass, into a caller
+       supplied buffer. The buffer must be at least the size returned by
+       <code>GetEncodedLength()</code>, and is not null terminated.
+
+       @return
+       Number of characters written to the output buffer.
+     */
+    static PINDEX EncodeBlock(
+      const void * dataBlock,  ///< Pointer to data to be encoded to Base64
+      PINDEX length,           ///< Length of the data block.
+      char * output,           ///< Buffer to receive the Base64 string
+      Options options = e_LF,  ///< Options for encoding.
+      PINDEX width = 76        ///< Line widths if options != e_URL
+    );
+
 
     void StartDecoding();
     // Begin a base 64 decoding operation, initialising the object instance.
@@ -221,6 +248,10 @@ class PBase64 : public PObject
     PBoolean ProcessDecoding(
       const char * cstr        // C String to be encoded
     );
+    PBoolean ProcessDecoding(
+      const char * data,       // Base64 data to be decoded
+      PINDEX length            // Length of the data
+    );
 
     /** Get the data decoded so far from the Base64 strings processed.
     
@@ -267,10 +298,34 @@ class PBase64 : public PObject
       PINDEX length        // Length of the data block.
     );
 
+    /** Get the maximum length of the data decoded from a Base64 string of
+       the given length, as required by <code>DecodeBlock()</code>.
+     */
+    static PINDEX GetDecodedLength(
+      PINDEX length        // Length of the Base64 string
+    ) { return (length+3)/4*3; }
+
+    /** Decode a Base64 string in a single pass, into a caller supplied buffer.
+       The buffer must be at least the size returned by
+       <code>GetDecodedLength()</code>. Both alphabets are accepted, and line
+       endings are ignored. Decoding stops at the terminating '=' characters.
+
+       The \p perfect flag is set to false if there were any extraneous or
+       illegal characters, or the data was not a multiple of four characters.
+
+       @return
+       Number of bytes written to the output buffer.
+     */
+    static PINDEX DecodeBlock(
+      const char * str,    // Encoded base64 string to be decoded.
+      PINDEX length,       // Length of the Base64 string
+      void * output,       // Buffer to receive the decoded data
+      bool * perfect = NULL // Flag for perfect decode
+    );
 
 
   private:
-    void OutputBase64(const BYTE * data);
+    void InternalEncode(const BYTE * data, PINDEX triples);
 
     PString m_encodedString;
     BYTE    m_saveTriple[3];
@@ -296,6 +351,17 @@ class PMessageDigest : public PObject
     /// Create a new message digestor
     PMessageDigest();
 
+    /// Data block for the batch functions, e.g. <code>EncodeBatch()</code>
+    struct Data
+    {
+      Data(const void * data = NULL, PINDEX length = 0) : m_data(data), m_length(length) { }
+      Data(const PBYTEArray & data) : m_data(data), m_length(data.GetSize()) { }
+      Data(const PString & str) : m_data(str.GetPointer()), m_length(str.GetLength()) { }
+
+      const void * m_data;
+      PINDEX       m_length;
+    };
+
     /// Result of digest/hash function
     class Result : public PBYTEArray {
       public:
@@ -403,6 +469,19 @@ template <class Digestor> struct PMessageDigestStatics
       stomach.Process(dataBlock, length);
       stomach.Complete(result);
     }
+
+    /** Encode a number of independent data blocks to digest values.
+        Some digest types will process several blocks in parallel, which
+        can be much faster for a lot of short messages.
+    */
+    static void EncodeBatch(
+      const PMessageDigest::Data * data,  ///< Array of data blocks to be encoded to digest
+      PINDEX count,                       ///< Number of data blocks
+      PMessageDigest::Result * results    ///< Array of resultant digest codes, must be count entries
+    ) {
+      for (PINDEX i = 0; i < count; ++i)
+        Encode(data[i].m_data, data[i].m_length, results[i]);
+    }
 };
 
 
@@ -451,6 +530,15 @@ class PMessageDigest5 : public PMessageDigest, public PMessageDigestStatics<PMes
     /// Create a new message digestor
     PMessageDigest5();
 
+    /** Encode a number of independent data blocks to digest values.
+        Where possible, eight blocks are processed in parallel using SIMD.
+    */
+    static void EncodeBatch(
+      const PMessageDigest::Data * data,  ///< Array of data blocks to be encoded to digest
+      PINDEX count,                       ///< Number of data blocks
+      PMessageDigest::Result * results    ///< Array of resultant digest codes, must be count entries
+    );
+
   protected:
     virtual void InternalStart();
     virtual void InternalProcess(const void * dataBlock, PINDEX length);
@@ -484,6 +572,8 @@ class PHMAC_MD5 : public PHMAC
 
 #if P_SSL
 
+/* In OpenSSL builds the built in SHA-1 and SHA-256 classes still derive from
+   these, as they did when they were implemented with OpenSSL. */
 class PMessageDigestSHA : public PMessageDigest
 {
     PCLASSINFO(PMessageDigestSHA, PMessageDigest)
@@ -491,8 +581,10 @@ class PMessageDigestSHA : public PMessageDigest
     struct Context;
 
   protected:
-    /// Create a new message digestor
-    explicit PMessageDigestSHA(Context * context);
+    /** Create a new message digestor, using OpenSSL via the context. A built
+        in digest, which overrides the Internal functions, passes NULL.
+      */
+    explicit PMessageDigestSHA(Context * context = NULL);
 
   public:
     ~PMessageDigestSHA();
@@ -516,77 +608,152 @@ class PMessageDigestSHA : public PMessageDigest
 };
 
 
+class PHMAC_SHA : public PHMAC
+{
+    PCLASSINFO(PHMAC_SHA, PHMAC)
+  protected:
+    typedef struct evp_md_st const * Algorithm;
+
+    explicit PHMAC_SHA(Algorithm algo = NULL);
+    virtual void InternalProcess(const void * data, PINDEX len, PHMAC::Result & result);
+
+    Algorithm m_algorithm;
+};
+
+#endif // P_SSL
+
+
 /** A class to produce a Message Digest for a block of text/data using the
- SHA-1 algorithm 
+ SHA-1 algorithm as defined in FIPS 180-4. This is built in, and uses the
+ x86 SHA extensions if the CPU has them.
  */
+#if P_SSL
 class PMessageDigestSHA1 : public PMessageDigestSHA, public PMessageDigestStatics<PMessageDigestSHA1>
 {
     PCLASSINFO(PMessageDigestSHA1, PMessageDigestSHA)
+#else
+class PMessageDigestSHA1 : public PMessageDigest, public PMessageDigestStatics<PMessageDigestSHA1>
+{
+    PCLASSINFO(PMessageDigestSHA1, PMessageDigest)
+#endif
   public:
     enum { DigestLength = 20 };
+
+    /// Create a new message digestor
     PMessageDigestSHA1();
+
+  protected:
+    virtual void InternalStart();
+    virtual void InternalProcess(const void * dataBlock, PINDEX length);
+    virtual void InternalCompleteDigest(Result & result);
+
+    BYTE    m_buffer[64];
+    DWORD   m_state[5];
+    PUInt64 m_count;
 };
 
 
 /** A class to produce a Message Digest for a block of text/data using the
- SHA-256 algorithm 
+ SHA-256 algorithm as defined in FIPS 180-4. This is built in, and uses the
+ x86 SHA extensions if the CPU has them.
  */
+#if P_SSL
 class PMessageDigestSHA256 : public PMessageDigestSHA, public PMessageDigestStatics<PMessageDigestSHA256>
 {
     PCLASSINFO(PMessageDigestSHA256, PMessageDigestSHA)
+#else
+class PMessageDigestSHA256 : public PMessageDigest, public PMessageDigestStatics<PMessageDigestSHA256>
+{
+    PCLASSINFO(PMessageDigestSHA256, PMessageDigest)
+#endif
   public:
+    enum { DigestLength = 32 };
+
+    /// Create a new message digestor
     PMessageDigestSHA256();
+
+    /** Encode a number of independent data blocks to digest values.
+        Where possible, this uses the SHA extensions one block at a time,
+        or eight blocks are processed in parallel using SIMD.
+    */
+    static void EncodeBatch(
+      const PMessageDigest::Data * data,  ///< Array of data blocks to be encoded to digest
+      PINDEX count,                       ///< Number of data blocks
+      PMessageDigest::Result * results    ///< Array of resultant digest codes, must be count entries
+    );
+
+  protected:
+    virtual void InternalStart();
+    virtual void InternalProcess(const void * dataBlock, PINDEX length);
+    virtual void InternalCompleteDigest(Result & result);
+
+    BYTE    m_buffer[64];
+    DWORD   m_state[8];
+    PUInt64 m_count;
 };
 
 
-/** A class to produce a Message Digest for a block of text/data using the
- SHA-384 algorithm 
+/** HMAC algorithm using SHA-1 hashing.
  */
-class PMessageDigestSHA384 : public PMessageDigestSHA, public PMessageDigestStatics<PMessageDigestSHA384>
+#if P_SSL
+class PHMAC_SHA1 : public PHMAC_SHA
 {
-    PCLASSINFO(PMessageDigestSHA384, PMessageDigestSHA)
+    PCLASSINFO(PHMAC_SHA1, PHMAC_SHA)
+#else
+class PHMAC_SHA1 : public PHMAC
+{
+    PCLASSINFO(PHMAC_SHA1, PHMAC)
+#endif
   public:
-    PMessageDigestSHA384();
+    enum { BlockSize = 64 };
+
+  protected:
+    virtual void InitKey(const void * key, PINDEX len);
+    virtual void InternalProcess(const void * data, PINDEX len, PHMAC::Result & result);
 };
 
 
-/** A class to produce a Message Digest for a block of text/data using the
- SHA-512 algorithm 
+/** HMAC algorithm using SHA-256 hashing.
  */
-class PMessageDigestSHA512 : public PMessageDigestSHA, public PMessageDigestStatics<PMessageDigestSHA512>
+#if P_SSL
+class PHMAC_SHA256 : public PHMAC_SHA
 {
-    PCLASSINFO(PMessageDigestSHA512, PMessageDigestSHA)
+    PCLASSINFO(PHMAC_SHA256, PHMAC_SHA)
+#else
+class PHMAC_SHA256 : public PHMAC
+{
+    PCLASSINFO(PHMAC_SHA256, PHMAC)
+#endif
   public:
-    PMessageDigestSHA512();
-};
-
+    enum { BlockSize = 64 };
 
-class PHMAC_SHA : public PHMAC
-{
-    PCLASSINFO(PHMAC_SHA, PHMAC)
   protected:
-    typedef struct evp_md_st const * Algorithm;
-
-    explicit PHMAC_SHA(Algorithm algo);
+    virtual void InitKey(const void * key, PINDEX len);
     virtual void InternalProcess(const void * data, PINDEX len, PHMAC::Result & result);
-
-    Algorithm m_algorithm;
 };
 
 
-class PHMAC_SHA1 : public PHMAC_SHA
+#if P_SSL
+
+/** A class to produce a Message Digest for a block of text/data using the
+ SHA-384 algorithm 
+ */
+class PMessageDigestSHA384 : public PMessageDigestSHA, public PMessageDigestStatics<PMessageDigestSHA384>
 {
-    PCLASSINFO(PHMAC_SHA1, PHMAC_SHA)
+    PCLASSINFO(PMessageDigestSHA384, PMessageDigestSHA)
   public:
-    PHMAC_SHA1();
+    PMessageDigestSHA384();
 };
 
 
-class PHMAC_SHA256 : public PHMAC_SHA
+/** A class to produce a Message Digest for a block of text/data using the
+ SHA-512 algorithm 
+ */
+class PMessageDigestSHA512 : public PMessageDigestSHA, public PMessageDigestStatics<PMessageDigestSHA512>
 {
-    PCLASSINFO(PHMAC_SHA256, PHMAC_SHA)
+    PCLASSINFO(PMessageDigestSHA512, PMessageDigestSHA)
   public:
-    PHMAC_SHA256();
+    PMessageDigestSHA512();
 };
 
 
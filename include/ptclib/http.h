@@ -208,6 +208,7 @@ class PHTTP : public PInternetProtocol
       Gone,                        ///< 410 - resource gone away
       LengthRequired,              ///< 411 - no Content-Length
       UnlessTrue,                  ///< 412 - no Range header for true Unless
+      RangeNotSatisfiable = 416,   ///< 416 - Range header outside of resource
       InternalServerError = 500,   ///< 500 - server has encountered an unexpected error
       NotImplemented,              ///< 501 - server does not implement request
       BadGateway,                  ///< 502 - error whilst acting as gateway
@@ -251,6 +252,12 @@ class PHTTP : public PInternetProtocol
     static const PCaselessString & ForwardedTag();
     static const PCaselessString & SetCookieTag();
     static const PCaselessString & CookieTag();
+    static const PCaselessString & ETagTag();
+    static const PCaselessString & IfNoneMatchTag();
+    static const PCaselessString & IfRangeTag();
+    static const PCaselessString & RangeTag();
+    static const PCaselessString & ContentRangeTag();
+    static const PCaselessString & AcceptRangesTag();
 
     static const PCaselessString & FormUrlEncoded();
 
@@ -2090,10 +2097,19 @@ class PHTTPString : public PHTTPResource
 //////////////////////////////////////////////////////////////////////////////
 // PHTTPFile
 
+class PHTTPFileRequest;
+
 /** This object describes a HyperText Transport Protocol resource which is a
    single file. The file can be anywhere in the file system and is mapped to
    the specified URL location in the HTTP name space defined by the
    <code>PHTTPSpace</code> class.
+
+   Files whose content type is not "text/" are sent directly from the file
+   to the socket, see <code>PTCPSocket::WriteFile()</code>, without going
+   through <code>LoadData()</code>. For these files the ETag, Last-Modified,
+   If-None-Match, If-Modified-Since, If-Range and single Range headers are
+   supported. Text files are still sent via <code>LoadText()</code> so that
+   <code>OnLoadedText()</code> may alter them.
  */
 class PHTTPFile : public PHTTPResource
 {
@@ -2159,6 +2175,23 @@ class PHTTPFile : public PHTTPResource
       PHTTPRequest & request    // Information on this request.
     );
 
+    /** Send the data associated with a GET command.
+
+       If the file may be sent directly to the socket, this does so, or sends
+       the "304 Not Modified" or "416 Range Not Satisfiable" response set up
+       by <code>LoadHeaders()</code>. Otherwise the default behaviour of
+       calling <code>SendData()</code> is used.
+
+       @return
+       true if the connection may persist, false if it should close.
+     */
+    virtual PBoolean OnGETData(
+      PHTTPServer & server,                       ///< HTTP server that received the request
+      const PURL & url,                           ///< Universal Resource Locator for document.
+      const PHTTPConnectionInfo & connectInfo,    ///< HTTP connection information
+      PHTTPRequest & request                      ///< request state information
+    );
+
     /** Get a block of data that the resource contains.
 
        @return
@@ -2189,6 +2222,16 @@ class PHTTPFile : public PHTTPResource
     );
     // Constructor used by PHTTPDirectory
 
+    /* Open the file and set the response headers for it, handling the
+       conditional and Range request headers if \p allowSendFile is true
+       and the file is not text.
+     */
+    bool LoadFileHeaders(
+      PHTTPFileRequest & request,
+      const PFilePath & filePath,
+      bool allowSendFile
+    );
+
 
     PFilePath m_filePath;
 };
@@ -2207,6 +2250,7 @@ class PHTTPFileRequest : public PHTTPRequest
     );
 
     PFile m_file;
+    bool  m_sendFile;  // Send directly from m_file rather than via LoadData()
 };
 
 
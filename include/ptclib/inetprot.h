@@ -81,6 +81,11 @@ class PInternetProtocol : public PIndirectChannel
        is completely independent of the standard iostream mechanisms which do
        not support the level of timeout control required by the protocols.
 
+       Data is read from the underlying channel in blocks of up to
+       <A>GetReadBufferSize()</A> bytes, any not returned is held for the
+       next read. If nothing is held and \p len is at least that size, the
+       data is read directly into \p buf.
+
        @return
        true if at least len bytes were written to the channel.
      */
@@ -125,6 +130,16 @@ class PInternetProtocol : public PIndirectChannel
        const PTimeInterval & t
      );
 
+     /** Set the size of the read ahead buffer. Default value is 64k. Note
+        the buffer will grow beyond this if a single line is longer.
+      */
+     void SetReadBufferSize(
+       PINDEX size
+     ) { m_readBufferSize = std::max(size, (PINDEX)1); }
+
+     /// Get the size of the read ahead buffer.
+     PINDEX GetReadBufferSize() const { return m_readBufferSize; }
+
   // New functions for class.
     /** Connect a socket to a remote host for the internet protocol.
 
@@ -380,11 +395,18 @@ class PInternetProtocol : public PIndirectChannel
     PStringArray commandNames;
     // Names of each of the command codes.
 
-    PCharArray unReadBuffer;
-    // Buffer for characters put back into the data stream.
+    bool FillReadBuffer();
+    // Read more data from the channel, appending to m_readBuffer.
+
+    PCharArray m_readBuffer;
+    // Read ahead data, and characters put back into the data stream.
+
+    PINDEX m_readStart;
+    PINDEX m_readEnd;
+    // Range of data in m_readBuffer not yet returned by Read() or ReadLine().
 
-    PINDEX unReadCount;
-    // Buffer count for characters put back into the data stream.
+    PINDEX m_readBufferSize;
+    // Amount to read from channel at a time.
 
     PTimeInterval readLineTimeout;
     // Time for characters in a line to be received.
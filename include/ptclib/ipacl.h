@@ -179,6 +179,19 @@ PSORTED_LIST(PIpAccessControlList_base, PIpAccessControlEntry);
    list sorted so that the most specific IP number specification is first and
    the broadest onse later. The entry with the value having a mask of zero,
    that is the match all entry, is always last.
+
+   Lookups do not scan the list. After every change, the plain network
+   entries are compiled into a path compressed binary trie giving a longest
+   prefix match in at most 32 steps, which is the same as the first match in
+   the sorted order. Host name, domain and non-contiguous mask entries are
+   still tested in order, but only those ranked ahead of the trie match. The
+   compiled form is an immutable snapshot, holding its own copy of the entry
+   data, published via an atomic pointer. So IsAllowed() takes no lock and
+   may be called while another thread modifies the list. A change waits for
+   any searches still using the previous snapshot before deleting it.
+
+   Find() returns an entry in the list itself, so, as before, the list must
+   not be modified while it is in use.
  */
 class PIpAccessControlList : public PIpAccessControlList_base
 {
@@ -191,6 +204,16 @@ class PIpAccessControlList : public PIpAccessControlList_base
     PIpAccessControlList(
       PBoolean defaultAllowance = true
     );
+    PIpAccessControlList(
+      const PIpAccessControlList & other
+    );
+    PIpAccessControlList & operator=(
+      const PIpAccessControlList & other
+    );
+
+    /** Destroy the list and its compiled search snapshot.
+     */
+    ~PIpAccessControlList();
 
     /** Load the system wide files commonly use under Linux (hosts.allow and
        hosts.deny file) for IP access. See the Linux man entries on these
@@ -290,6 +313,36 @@ class PIpAccessControlList : public PIpAccessControlList_base
       PIPSocket::Address mask       ///< Mask for IP network
     );
 
+    /** Add an entry to the sorted list, rebuilding the compiled search
+       snapshot.
+     */
+    virtual PINDEX Append(
+      PObject * obj   ///< New object to place into the collection.
+    );
+
+    /** Remove an entry from the sorted list, rebuilding the compiled search
+       snapshot.
+     */
+    virtual PObject * RemoveAt(
+      PINDEX index   ///< Index position in collection to remove.
+    );
+
+    /** Remove all entries, rebuilding the compiled search snapshot.
+     */
+    virtual void RemoveAll();
+
+    /** Start a group of changes to the list. Rebuilding the compiled search
+       snapshot after each of many changes is slow, so until the matching
+       EndUpdate() it is not rebuilt, and IsAllowed() searches the list as
+       it was before BeginUpdate(). Calls may be nested.
+     */
+    void BeginUpdate();
+
+    /** End a group of changes started with BeginUpdate(), rebuilding the
+       compiled search snapshot once for all of them.
+     */
+    void EndUpdate();
+
 
     /**Create a new PIpAccessControl specification entry object.
        This may be used by an application to create descendents of
@@ -302,6 +355,7 @@ class PIpAccessControlList : public PIpAccessControlList_base
     );
 
     /**Find the PIpAccessControl specification for the address.
+       An IPv4 mapped IPv6 address is searched for as its IPv4 equivalent.
       */
     PIpAccessControlEntry * Find(
       PIPSocket::Address address    ///< IP Address to find
@@ -339,6 +393,18 @@ class PIpAccessControlList : public PIpAccessControlList_base
     PBoolean InternalLoadHostsAccess(const PString & daemon, const char * file, PBoolean allow);
     PBoolean InternalRemoveEntry(PIpAccessControlEntry & entry);
 
+    PIpAccessControlEntry * InternalFind(PIPSocket::Address & address) const;
+
+    struct Snapshot;
+    struct SnapshotReader;
+    void RebuildSnapshot();
+
+    PMutex                   m_snapshotMutex;
+    atomic<Snapshot *>       m_snapshot;
+    mutable atomic<unsigned> m_snapshotReaders[2];
+    atomic<unsigned>         m_snapshotEpoch;
+    atomic<unsigned>         m_updating;
+
   protected:
     PBoolean defaultAllowance;
 };
@@ -162,6 +162,7 @@ class PJSON : public PObject
     {
       public:
         String(const char * str = NULL) : PString(str) { }
+        String(const char * str, size_t length) : PString(str, length) { }
         virtual bool IsType(Types type) const;
         virtual void ReadFrom(istream & strm);
         virtual void PrintOn(ostream & strm) const;
@@ -209,6 +210,65 @@ class PJSON : public PObject
         virtual Base * DeepClone() const;
     };
 
+    /** Event driven JSON parser.
+        This parses a contiguous buffer in a single pass, calling the virtual
+        functions below as each element is encountered, without building any
+        Base objects. This allows, for example, a very large array to be
+        processed one entry at a time.
+
+        String values and member names are passed as a pointer and length,
+        which point into the original buffer if there were no escape
+        sequences, or to a temporary buffer otherwise. In both cases they are
+        only valid for the duration of the callback. They are not null
+        terminated.
+
+        Any callback may return false to abort the parse.
+      */
+    class Parser
+    {
+      public:
+        Parser();
+        virtual ~Parser() { }
+
+        /** Parse a single JSON value from the buffer.
+            Any data after the value is ignored, use GetPosition() to find
+            where it ended, e.g. to parse a sequence of values.
+            @return false if the JSON was invalid, or a callback aborted.
+          */
+        bool Parse(
+          const char * data,    ///< JSON text
+          size_t length,        ///< Length of JSON text
+          size_t position = 0   ///< Offset in data to start parsing
+        );
+        bool Parse(const PString & str) { return Parse(str, str.GetLength()); }
+
+        /** Get the position in the buffer where the last Parse() ended.
+            If there was an error, this is where it was detected.
+          */
+        size_t GetPosition() const { return m_position - m_start; }
+
+        virtual bool OnStartObject();
+        virtual bool OnMemberName(const char * name, size_t length);
+        virtual bool OnEndObject();
+        virtual bool OnStartArray();
+        virtual bool OnEndArray();
+        virtual bool OnString(const char * value, size_t length);
+        virtual bool OnNumber(NumberType value);
+        virtual bool OnBoolean(bool value);
+        virtual bool OnNull();
+
+      protected:
+        bool ParseValue(unsigned depth);
+        bool ParseString(const char * & str, size_t & length);
+        bool ParseNumber();
+        bool ParseLiteral(const char * literal);
+
+        const char * m_start;
+        const char * m_position;
+        const char * m_end;
+        std::string  m_unescaped;
+    };
+
     ///< Constructor
     PJSON();
     explicit PJSON(Types type);
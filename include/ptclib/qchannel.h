@@ -46,17 +46,30 @@ P_PUSH_MSVC_WARNINGS(4250)
     bytes, so you must check the GetLastReadCount() to determine the actual
     number of bytes read and not rely on the count being passed into the read
     function.
+
+    If there is exactly one thread writing and one thread reading, the
+    SingleProducerConsumer mode may be used. No mutex is then taken, and the
+    peer is only woken when it is actually blocked on the queue. This mode
+    also allows data to be read and written in place, see ReserveWrite() and
+    PeekRead().
   */
 class PQueueChannel : public PChannel
 {
     PCLASSINFO(PQueueChannel, PChannel);
   public:
+    /// Threading model for the queue
+    enum Modes {
+      MultipleProducerConsumer, ///< Any number of threads, via a mutex
+      SingleProducerConsumer    ///< One writing and one reading thread, lock free
+    };
+
   /**@name Construction */
   //@{
     /** Create a new queue channel with the specified maximum size.
       */
     PQueueChannel(
-      PINDEX queueSize = 0   ///< Queue size
+      PINDEX queueSize = 0,                   ///< Queue size
+      Modes mode = MultipleProducerConsumer   ///< Threading model
     );
 
     /**Delete queue and release memory used.
@@ -114,24 +127,102 @@ class PQueueChannel : public PChannel
   /**@name Queue manipulation functions */
   //@{
     /**Open a queue, allocating the queueSize bytes.
+       In SingleProducerConsumer mode the size is rounded up to a power of two.
       */
     virtual PBoolean Open(
-      PINDEX queueSize   ///< Queue size
+      PINDEX queueSize,                       ///< Queue size
+      Modes mode = MultipleProducerConsumer   ///< Threading model
     );
 
     /// Get the queue size.
     PINDEX GetSize() const { return queueSize; }
 
     /// Get the current queue length.
-    PINDEX GetLength() const { return queueLength; }
+    PINDEX GetLength() const;
+
+    /// Get the threading model
+    Modes GetMode() const { return m_mode; }
+  //@}
+
+  /**@name Zero copy functions, SingleProducerConsumer mode only */
+  //@{
+    /**Get a pointer to free space in the queue to write into.
+       This blocks for the write timeout while the queue is full. On return,
+       size is the contiguous space available, which is at most the size
+       requested, but may be less, e.g. at the end of the ring buffer.
+
+       Only the writing thread may call this function.
+
+       @return NULL if the queue is closed, the write timed out, or the queue
+               is not in SingleProducerConsumer mode.
+      */
+    BYTE * ReserveWrite(
+      PINDEX & size   ///< Size wanted, and size available on return
+    );
+
+    /**Make data written to space from ReserveWrite() available to the reader.
+       @return false if size is more than was reserved.
+      */
+    bool CommitWrite(
+      PINDEX size   ///< Bytes written
+    );
+
+    /**Get a pointer to data in the queue to read from.
+       This blocks for the read timeout while the queue is empty. On return,
+       size is the contiguous data available, which is at most the size
+       requested, but may be less, e.g. at the end of the ring buffer.
+
+       Only the reading thread may call this function.
+
+       @return NULL if the queue is closed and empty, the read timed out, or
+               the queue is not in SingleProducerConsumer mode.
+      */
+    const BYTE * PeekRead(
+      PINDEX & size   ///< Size wanted, and size available on return
+    );
+
+    /**Release data read from PeekRead() back to the writer.
+       @return false if size is more than was peeked.
+      */
+    bool ConsumeRead(
+      PINDEX size   ///< Bytes read
+    );
   //@}
 
   protected:
+    bool WaitForSpace(size_t & space);
+    bool WaitForData(size_t & available);
+
     PDECLARE_MUTEX(mutex);
     BYTE     * queueBuffer;
     PINDEX     queueSize, queueLength, enqueuePos, dequeuePos;
     PSyncPoint unempty;
     PSyncPoint unfull;
+
+    Modes m_mode;
+
+    /* SingleProducerConsumer mode uses free running positions, so the length
+       is simply the difference. Each side keeps what it updates, and reads on
+       every call, in its own cache line, so they do not disturb each other.
+       The "waiting" flag is set by the peer only when it is about to block. */
+    enum { CacheLineSize = 64 };
+    struct ReaderSide {
+      ReaderSide() : m_position(0), m_peerPosition(0), m_peeked(0), m_writerWaiting(false) { }
+      atomic<size_t> m_position;       // Only written by reader
+      size_t         m_peerPosition;   // Last known writer position
+      size_t         m_peeked;         // Contiguous size from PeekRead()
+      atomic<bool>   m_writerWaiting;  // Writer blocked on unfull
+      BYTE           m_padding[CacheLineSize];
+    } m_reader;
+    struct WriterSide {
+      WriterSide() : m_position(0), m_peerPosition(0), m_reserved(0), m_readerWaiting(false) { }
+      atomic<size_t> m_position;       // Only written by writer
+      size_t         m_peerPosition;   // Last known reader position
+      size_t         m_reserved;       // Contiguous size from ReserveWrite()
+      atomic<bool>   m_readerWaiting;  // Reader blocked on unempty
+      BYTE           m_padding[CacheLineSize];
+    } m_writer;
+    size_t m_mask;
 };
 
 
@@ -0,0 +1,145 @@
+/*
+ * sockreactor.h
+ *
+ * Event driven socket readiness notification
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#ifndef PTLIB_SOCKREACTOR_H
+#define PTLIB_SOCKREACTOR_H
+
+#ifdef P_USE_PRAGMA
+#pragma interface
+#endif
+
+#include <ptlib.h>
+
+#if P_HAS_EPOLL
+
+#include <ptlib/channel.h>
+#include <map>
+
+
+/** Event loop for channel readiness notification.
+    Normally a PTLib application uses one thread per socket, each blocking in
+    Read() or Accept(). For servers with a very large number of connections
+    this becomes expensive, so this class allows any number of channels to
+    be registered, and a fixed number of threads wait for any of them to
+    become ready, calling a notifier to process the channel.
+
+    Each channel is registered in "one shot" mode, so only one thread will be
+    in the notifier for a given channel at any time, and it is automatically
+    re-armed when the notifier returns. The notifier should process what is
+    available without blocking, e.g. by setting the read timeout to zero.
+
+    This uses epoll, with an eventfd to wake the threads on shut down, so is
+    only available on Linux.
+  */
+class PSocketReactor : public PObject
+{
+    PCLASSINFO(PSocketReactor, PObject);
+  public:
+    P_DECLARE_BITWISE_ENUM(Events, 3, (NoEvents, ReadEvent, WriteEvent, ErrorEvent));
+
+    typedef PNotifierTemplate<Events> Notifier;
+    #define PDECLARE_SocketReactorNotifier(cls, fn) PDECLARE_NOTIFIER2(PChannel, cls, fn, PSocketReactor::Events)
+    #define PCREATE_SocketReactorNotifier(fn) PCREATE_NOTIFIER2(fn, PSocketReactor::Events)
+
+    /** Create a reactor and start \p threadCount threads to wait on it.
+      */
+    PSocketReactor(
+      unsigned threadCount = 1,
+      const char * threadName = "Reactor"
+    );
+
+    /** Destroy the reactor, stopping all threads. Channels still registered
+        are not closed. This must not be called from within a notifier.
+      */
+    ~PSocketReactor();
+
+    /** Register a channel with the reactor. The \p notifier is called, from
+        one of the reactor threads, when any of the \p events occur on the
+        channel. Note ErrorEvent is always monitored.
+
+        The channel must remain open and not be destroyed until after
+        Remove() has been called.
+
+        @return false if the channel is not open or already registered.
+      */
+    bool Add(
+      PChannel & channel,
+      Events events,
+      const Notifier & notifier
+    );
+
+    /** Change the events being monitored for a registered channel.
+      */
+    bool Modify(
+      PChannel & channel,
+      Events events
+    );
+
+    /** Remove a channel from the reactor. If the notifier for the channel is
+        currently executing in another thread, this waits for it to complete,
+        and it is guaranteed the notifier will not be called again once this
+        returns. This may be called from within the notifier itself.
+      */
+    bool Remove(
+      PChannel & channel
+    );
+
+    /** Stop all the reactor threads. This may be called from within a
+        notifier, in which case that thread stops when the notifier returns.
+      */
+    void Shutdown();
+
+    /// Get the number of channels registered.
+    PINDEX GetCount() const;
+
+  protected:
+    struct Registration;
+    bool Arm(Registration & registration, int op);
+    void Dispatch(P_INT_PTR id, unsigned epollEvents);
+    void ThreadMain();
+
+    class ReactorThread;
+
+    int                       m_epoll;
+    int                       m_wakeup;
+    atomic<bool>              m_shutdown;
+    std::vector<PThread *>    m_threads;
+
+    typedef std::map<P_INT_PTR, Registration *> RegistrationsById;
+    typedef std::map<PChannel *, Registration *> RegistrationsByChannel;
+    RegistrationsById         m_byId;
+    RegistrationsByChannel    m_byChannel;
+    P_INT_PTR                 m_nextId;
+    PDECLARE_MUTEX(           m_mutex);
+};
+
+
+#endif // P_HAS_EPOLL
+
+#endif // PTLIB_SOCKREACTOR_H
+
+
+// End Of File ///////////////////////////////////////////////////////////////
@@ -40,10 +40,14 @@
 #include <ptlib/pdirect.h>
 #include <ptclib/guid.h>
 
+#include <deque>
+#include <set>
+
 class PSpoolDirectory : PObject
 {
   public:
     PSpoolDirectory();
+    ~PSpoolDirectory();
 
     bool Open(const PDirectory & dir, const PString & type = PString::Empty());
     void Close();
@@ -70,7 +74,38 @@ class PSpoolDirectory : PObject
 
     virtual void SetNotifier(const PNotifier & func);
 
+    /** Set event driven mode, must be called before Open().
+        When enabled, and the platform supports it (inotify), the directory
+        is scanned once on start up and then only files that are closed
+        after writing, or moved into the directory, are processed. A full
+        rescan is only done if the kernel event queue overflows. An entry
+        that is still present after processing, e.g. OnProcess() returned
+        false, is retried at the scan interval, as the periodic scan would.
+        If watching the directory is not possible, the periodic scan is used.
+      */
+    void SetEventDriven(bool enable) { m_eventDriven = enable; }
+    bool IsEventDriven() const { return m_eventDriven; }
+
+    /** Set the number of worker threads that process entries, must be called
+        before Open(). If zero, the default, entries are processed one at a
+        time by the spool directory thread. Otherwise entries are queued to
+        the workers, and each entry has its lock file created by the worker
+        for the duration of the processing, so it is not picked up twice.
+      */
+    void SetWorkerThreads(unsigned count) { m_workerCount = count; }
+    unsigned GetWorkerThreads() const { return m_workerCount; }
+
   protected:
+    bool IsLocked(const PFilePath & fn) const;
+    void DispatchEntry(const PString & entry);
+    void ProcessFile(const PString & entry);
+    void WorkerMain();
+#if P_HAS_INOTIFY
+    bool WatchDirectory();
+    void ScanDirectory();
+    void RetryEntries();
+#endif
+
     PMutex m_mutex;
     PThread * m_thread;
 
@@ -85,6 +120,19 @@ class PSpoolDirectory : PObject
     int m_scanTimeout;
 
     PNotifier m_callback;
+
+    bool                   m_eventDriven;
+    int                    m_wakeUpPipe[2];
+    bool                   m_watching;       // Protected by m_queueMutex
+
+    unsigned               m_workerCount;
+    std::vector<PThread *> m_workers;
+    PDECLARE_MUTEX(        m_queueMutex);
+    PSemaphore             m_queueAvailable;
+    std::deque<PString>    m_queue;
+    std::set<PString>      m_queuedEntries;  // Queued or being processed
+    std::set<PString>      m_releasedLocks;  // Our own lock removals, to ignore the events
+    std::set<PString>      m_retryEntries;   // Still present after processing while watching
 };
 
 
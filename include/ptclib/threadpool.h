@@ -562,6 +562,139 @@ class PQueuedThreadPool : public PThreadPool<Work_T>
 };
 
 
+/** Base class for work stealing thread pools.
+    Unlike PThreadPoolBase, there is no global mutex or map taken on each
+    submission. Each worker thread has its own lock-free deque of tasks, work
+    submitted from within a worker goes onto that worker's deque, and work
+    submitted from any other thread goes onto a shared lock-free injection
+    queue. An idle worker takes from its own deque, then the injection queue,
+    and finally steals from a randomly chosen victim.
+
+    Work with the same group name is still executed serially, in the order
+    it was added, as for PThreadPool. Each active group has its own queue,
+    located via a sharded table so that only groups in the same shard contend.
+  */
+class PWorkStealingThreadPoolBase : public PObject
+{
+    PCLASSINFO(PWorkStealingThreadPoolBase, PObject);
+  public:
+    ~PWorkStealingThreadPoolBase();
+
+    /** Stop all worker threads. Any work not yet started is discarded, and
+        AddTask() fails from the time this is called. Work already started
+        is allowed to complete, this waits for it.
+      */
+    void Shutdown();
+
+    /// Get the number of worker threads used by the pool.
+    unsigned GetWorkerCount() const { return m_workerCount; }
+
+  protected:
+    PWorkStealingThreadPoolBase(
+      unsigned workerCount,
+      const char * threadName,
+      PThread::Priority priority
+    );
+
+    struct GroupQueue;
+
+    class Task
+    {
+      public:
+        Task() : m_group(NULL) { }
+        virtual ~Task() { }
+        virtual void Work() = 0;
+
+      private:
+        GroupQueue * m_group;
+      friend class PWorkStealingThreadPoolBase;
+    };
+
+    /** Add a task to the pool, the pool takes ownership of the task. If
+        \p group is not NULL or empty, the task is executed after all
+        previously added tasks of the same group have completed.
+      */
+    bool AddTask(Task * task, const char * group);
+
+  private:
+    class TaskDeque;
+    class TaskQueue;
+    class WorkerThread;
+    struct GroupShard;
+
+    void StartWorkers();
+    void InternalAddTask(Task * task, const char * group);
+    WorkerThread * GetCurrentWorker() const;
+    void Schedule(Task * task);
+    Task * FindTask(WorkerThread & worker);
+    void RunTask(Task * task);
+    void WorkerMain(WorkerThread & worker);
+
+    unsigned                    m_workerCount;
+    PString                     m_threadName;
+    PThread::Priority           m_priority;
+    std::vector<WorkerThread *> m_workers;
+    atomic<bool>                m_started;
+    atomic<bool>                m_shutdown;
+    atomic<unsigned>            m_addingCount;
+    PDECLARE_MUTEX(             m_startMutex);
+    PSemaphore                  m_available;
+    TaskQueue                 * m_injector;
+    std::queue<Task *>          m_overflow;
+    atomic<unsigned>            m_overflowCount;
+    PDECLARE_MUTEX(             m_overflowMutex);
+    GroupShard                * m_groupShards;
+};
+
+
+/** Work stealing thread pool for queued work items.
+    This may be used in place of PQueuedThreadPool where submission rate is
+    high enough that the single pool mutex becomes a point of contention. As
+    with PQueuedThreadPool, the Work_T class must have a void Work() function,
+    and the work object is deleted once it has been executed.
+  */
+template <class Work_T>
+class PWorkStealingThreadPool : public PWorkStealingThreadPoolBase
+{
+    PCLASSINFO(PWorkStealingThreadPool, PWorkStealingThreadPoolBase);
+  public:
+    PWorkStealingThreadPool(
+      unsigned workerCount = PThread::GetNumProcessors(),
+      const char * threadName = NULL,
+      PThread::Priority priority = PThread::NormalPriority
+    ) : PWorkStealingThreadPoolBase(workerCount, threadName, priority)
+    { }
+
+    /** Add a unit of work to be executed by the pool. If \p group is
+        specified all work for that group is executed serially.
+        @return false if the pool has been shut down, in which case the caller
+                retains ownership of \p work.
+      */
+    bool AddWork(Work_T * work, const char * group = NULL)
+    {
+      if (PAssertNULL(work) == NULL)
+        return false;
+
+      WorkTask * task = new WorkTask(work);
+      if (this->AddTask(task, group))
+        return true;
+
+      task->m_work = NULL;
+      delete task;
+      return false;
+    }
+
+  protected:
+    struct WorkTask : public Task
+    {
+      WorkTask(Work_T * work) : m_work(work) { }
+      ~WorkTask() { delete m_work; }
+      virtual void Work() { m_work->Work(); }
+      Work_T * m_work;
+    };
+};
+
+
 /**A PThreadPool work item template that uses PSafePtr to execute callback
    function.
   */
@@ -84,19 +84,15 @@ class PKey : public PObject
       return Compare2(this->m_key, dynamic_cast<const my_type &>(obj).m_key);
     }
 
-    /**This function calculates a hash table index value for the implementation
-       of <code>PSet</code> and <code>PDictionary</code> classes.
+    /**This function calculates a hash value for the implementation of
+       <code>PSet</code> and <code>PDictionary</code> classes.
 
        @return
-       hash table bucket number.
+       hash value for the key.
      */
     virtual PINDEX HashFunction() const
     {
-#if PINDEX_SIGNED
-      return std::abs((PINDEX)this->m_key)%23;
-#else
-      return ((PINDEX)this->m_key)%23;
-#endif
+      return (PINDEX)this->m_key;
     }
 
     /**Output the ordinal index to the specified stream. This is identical to
@@ -153,45 +149,38 @@ struct PHashTableElement
 {
     PObject           * m_key;
     PObject           * m_data;
-    PHashTableElement * m_next;
-    PHashTableElement * m_prev;
-    PINDEX              m_bucket;
+    PHashTableElement * m_next;   // Next in order of insertion
+    PHashTableElement * m_prev;   // Previous in order of insertion
+    unsigned            m_hash;   // Mixed hash value of m_key
 
     PDECLARE_POOL_ALLOCATOR(PHashTableElement);
 };
 
 P_PUSH_MSVC_WARNINGS(26495)
-struct PHashTableList
+struct PHashTableSlot
 {
-  PHashTableList()
-    : m_head(NULL)
-    , m_tail(NULL)
-#if PTRACING
-    , m_size(0)
-#endif
+  PHashTableSlot()
+    : m_element(NULL)
+    , m_hash(0)
   { }
-  PHashTableElement * m_head;
-  PHashTableElement * m_tail;
-#if PTRACING
-  PINDEX              m_size;
-#endif
+  PHashTableElement * m_element;
+  unsigned            m_hash;     // Copy of m_element->m_hash, avoids dereferencing while probing
 };
 P_POP_MSVC_WARNINGS()
-__inline std::ostream & operator<<(std::ostream & strm, const PHashTableList & hash) { return strm << (void *)hash.m_head; }
+__inline std::ostream & operator<<(std::ostream & strm, const PHashTableSlot & slot) { return strm << (void *)slot.m_element; }
 
 class PHashTable;
 
 
-class PHashTableInfo : public PBaseArray<PHashTableList>
+class PHashTableInfo : public PBaseArray<PHashTableSlot>
 {
-    typedef PBaseArray<PHashTableList> ParentClass;
+    typedef PBaseArray<PHashTableSlot> ParentClass;
     PCLASSINFO(PCharArray, ParentClass);
   public:
-    PHashTableInfo(PINDEX initialSize = 0)
-      : ParentClass(initialSize), deleteKeys(true) { }
-    PHashTableInfo(PHashTableList const * buffer, PINDEX length, PBoolean dynamic = true)
-      : ParentClass(buffer, length, dynamic), deleteKeys(true) { }
-    virtual PObject * Clone() const { return PNEW PHashTableInfo(*this, GetSize()); }
+    PHashTableInfo(PINDEX initialSize = 0);
+    PHashTableInfo(PHashTableSlot const * buffer, PINDEX length, PBoolean dynamic = true)
+      : ParentClass(buffer, length, dynamic), deleteKeys(true), m_head(NULL), m_tail(NULL), m_count(0) { }
+    virtual PObject * Clone() const;
     virtual ~PHashTableInfo() { Destruct(); }
     virtual void DestroyContents();
 
@@ -200,12 +189,24 @@ class PHashTableInfo : public PBaseArray<PHashTableList>
     PHashTableElement * GetElementAt(PINDEX index);
     PHashTableElement * GetElementAt(const PObject & key);
     PINDEX GetElementsIndex(const PObject*obj,PBoolean byVal,PBoolean keys) const;
-    PHashTableElement * NextElement(PHashTableElement * element) const;
-    PHashTableElement * PrevElement(PHashTableElement * element) const;
+    PHashTableElement * NextElement(PHashTableElement * element) const { return element != NULL ? element->m_next : NULL; }
+    PHashTableElement * PrevElement(PHashTableElement * element) const { return element != NULL ? element->m_prev : NULL; }
 
     bool deleteKeys;
     PTRACE_THROTTLE(m_throttlePoorHashFunction, 1);
 
+  protected:
+    static unsigned MixHash(const PObject & key);
+    PHashTableSlot * GetSlots() const { return (PHashTableSlot *)theArray; }
+    PINDEX ProbeDistance(PINDEX slot) const { return (slot - (PINDEX)GetSlots()[slot].m_hash) & (GetSize() - 1); }
+    PINDEX InsertSlot(PHashTableElement * element);
+    PINDEX LinkElement(PHashTableElement * element);
+    void Rehash(PINDEX newSize);
+
+    PHashTableElement * m_head;
+    PHashTableElement * m_tail;
+    PINDEX              m_count;
+
   friend class PHashTable;
   friend class PAbstractSet;
 };
@@ -215,11 +216,15 @@ class PHashTableInfo : public PBaseArray<PHashTableList>
    <code>PDictionary</code> classes.
 
    The hash table allows for very fast searches for an object based on a "hash
-   function". This function yields an index into an array which is directly
-   looked up to locate the object. When two key values have the same hash
-   function value, then a linear search of a linked list is made to locate
-   the object. Thus the efficiency of the hash table is highly dependent on the
-   quality of the hash function for the data being used as keys.
+   function". The value from this function is mixed and used as the starting
+   position in an array of slots, which is searched linearly until the object,
+   or an empty slot, is found. Robin Hood ordering keeps these searches short,
+   and the array is doubled in size whenever it becomes three quarters full.
+   The efficiency of the hash table is still dependent on the quality of the
+   hash function for the data being used as keys, in particular, keys that
+   return the same value are always compared one after the other.
+
+   Iteration, and the ordinal index position, is in the order of insertion.
  */
 class PHashTable : public PCollection
 {
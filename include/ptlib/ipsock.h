@@ -572,6 +572,38 @@ class PIPSocket : public PSocket
        */
     );
 
+    /**Result of a host name lookup, see <code>GetHostAddressAsync()</code>.
+      */
+    struct HostLookup
+    {
+      HostLookup(const PString & name = PString::Empty())
+        : m_name(name), m_address(GetInvalidAddress()) { }
+
+      bool IsValid() const { return m_address.IsValid(); }
+
+      PString      m_name;          ///< Name of host that was looked up
+      PString      m_canonicalName; ///< Canonical name of host
+      Address      m_address;       ///< Primary address of host, invalid if lookup failed
+      PStringArray m_aliases;       ///< All names and IP numbers for the host
+    };
+    typedef PNotifierTemplate<const HostLookup &> HostLookupNotifier;
+    #define PDECLARE_HostLookupNotifier(cls, fn) PDECLARE_NOTIFIER2(PObject, cls, fn, const PIPSocket::HostLookup &)
+    #define PCREATE_HostLookupNotifier(fn) PCREATE_NOTIFIER2(fn, const PIPSocket::HostLookup &)
+
+    /**Get the Internet Protocol address for the specified host without
+       blocking.
+
+       If the result is already known, e.g. \p hostname is in "dot" format or
+       is in the name cache, then \p notifier is called before this function
+       returns. Otherwise, the name is resolved in a background thread and
+       \p notifier is called from that thread. Any number of requests for the
+       same name, asynchronous or not, share a single lookup.
+     */
+    static void GetHostAddressAsync(
+      const PString & hostname,             ///< Name of host to get address for.
+      const HostLookupNotifier & notifier   ///< Function called with the result.
+    );
+
     /**Determine if the specified host is actually the local machine. This
        can be any of the host aliases or multi-homed IP numbers or even
        the special number 127.0.0.1 for the loopback device.
@@ -639,6 +671,33 @@ class PIPSocket : public PSocket
      */
     static void ClearNameCache();
 
+    /**Set the times for which host name lookups are cached.
+       A successful lookup is kept for \p positive, and a failed one for
+       \p negative. A name that is used in the last \p refresh of its life
+       is looked up again in the background, so callers do not wait when it
+       expires.
+     */
+    static void SetNameCacheTimeouts(
+      const PTimeInterval & positive,   ///< Time successful lookups are cached, default 5 minutes
+      const PTimeInterval & negative,   ///< Time failed lookups are cached, default 30 seconds
+      const PTimeInterval & refresh     ///< Time before expiry to refresh, default 30 seconds
+    );
+
+    /**Function used by the name cache to resolve host names.
+       This is passed a HostLookup with <code>m_name</code> set, and should
+       fill in the other members. The <code>m_address</code> member is left
+       invalid if the name could not be resolved.
+     */
+    typedef PNotifierTemplate<HostLookup &> HostResolver;
+
+    /**Set the function used by the name cache to resolve host names, e.g.
+       for testing. An empty notifier restores the system resolver. Note
+       that the cache is not cleared.
+     */
+    static void SetHostResolver(
+      const HostResolver & resolver   ///< Function to resolve names
+    );
+
     /**Describe a route table entry.
      */
     class RouteEntry : public PObject
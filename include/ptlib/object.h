@@ -530,6 +530,14 @@ public:
                                        application. Setting this flag will automatically
                                        execute <code>#SetStream(new PSystemLog)</code>. */
     HasFilePermissions = 0x8000000, ///< Flag indicating file permissions are to be set
+    Asynchronous       = 0x10000000, /**< Trace lines are formatted by the calling thread and passed
+                                          to a background thread for output, so threads never wait
+                                          for each other or the output device. If the background
+                                          thread falls behind, lines are dropped and counted. */
+    BinaryOutput       = 0x20000000, /**< Output to the trace file is a compact binary record per
+                                          line, with no text formatting of the prefix fields. The
+                                          file is memory mapped, up to MaxBinaryFileSize, and may be
+                                          converted to text with the tracedecode tool. */
     FilePermissionMask = 0x7ff0000, /**< Mask for setting standard file permission mask as used in
                                          open() or creat() system function calls. */
     FilePermissionShift = 16
@@ -552,6 +560,8 @@ public:
     "  hour     rotate output file hourly\r" \
     "  minute   rotate output file every minute\r" \
     "  append   append to output file, otherwise overwrites\r" \
+    "  async    output via background thread, may drop lines\r" \
+    "  binary   binary output file, see tracedecode tool\r" \
     "  <perm>   file permission similar to unix chmod, but starts\r" \
     "           with +/- and only has one combination at a time,\r" \
     "           e.g. +uw is user write, +or is other read, etc"
@@ -660,6 +670,14 @@ public:
     */
   static PINDEX GetMaxLength();
 
+  /**Get the number of lines dropped in Asynchronous mode because the output
+     thread could not keep up, or in BinaryOutput mode because the file is full.
+    */
+  static unsigned GetDroppedLines();
+
+  /// Maximum size of trace file when BinaryOutput option used, default 256Mb
+  static size_t MaxBinaryFileSize;
+
   /** Set the trace options by name.
       The parameter string consists of a series of keywords separated
       by a + or -. Use +X or -X to add/remove option where X is one of:
@@ -677,6 +695,8 @@ public:
         hour     rotate output file hourly
         minute   rotate output file every minute
         append   append to output file, otherwise overwrites
+        async    output via background thread, may drop lines
+        binary   binary output file, see tracedecode tool
         <perm>   file permission similar to unix chmod, but starts
                  with +/- and only has one combination at a time,
                  e.g. +uw is user write, +or is other read, etc"
@@ -2435,6 +2455,8 @@ class PObject {
        should override this function. The precise values returned is dependent
        on the semantics of the class. For example, the <code>PString</code> class
        overrides it to provide a hash function for distinguishing text strings.
+       The value may use the full range of PINDEX, the hash table mixes the
+       bits before use, so there is no need to reduce it to a small range.
 
        The default behaviour is to return the value zero.
 
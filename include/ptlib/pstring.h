@@ -507,9 +507,9 @@ class PString : public PCharArray
 
     /**Calculate a hash value for use in sets and dictionaries.
     
-       The hash function for strings will produce a value based on the sum of
-       the first three characters of the string. This is a fairly basic
-       function and make no assumptions about the string contents. A user may
+       The hash function for strings will produce a value based on the first
+       and last 18 characters of the string, ignoring case. This is a fairly
+       basic function and make no assumptions about the string contents. A user may
        descend from PString and override the hash function if they can take
        advantage of the types of strings being used, eg if all strings start
        with the letter 'A' followed by 'B or 'C' then the current hash function
@@ -1926,6 +1926,9 @@ class PString : public PCharArray
     ) const;
     virtual int internal_strcmp(const char * s1, const char *s2) const;
     virtual int internal_strncmp(const char * s1, const char *s2, size_t n) const;
+    /* Indicate internal_strcmp() and internal_strncmp() ignore case, so
+       Find() and related functions can use matching fast searches. */
+    virtual bool InternalIsCaseless() const;
 
     bool InternalSplit(
       const PString & delimiter,  // Delimiter around which tom plit the substrings
@@ -2100,6 +2103,7 @@ class PCaselessString : public PString
   // Overrides from class PString
     virtual int internal_strcmp(const char * s1, const char *s2) const;
     virtual int internal_strncmp(const char * s1, const char *s2, size_t n) const;
+    virtual bool InternalIsCaseless() const;
 
     /* Internal function to compare the current string value against the
        specified C string.
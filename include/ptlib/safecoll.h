@@ -35,9 +35,7 @@
 #include <ptlib/syncthrd.h>
 
 
-#if P_TIMERS
-class PTimer;
-#endif
+class PSafeCollection;
 
 
 /** This class defines a thread-safe object in a collection.
@@ -256,7 +254,7 @@ class PSafeObject : public PObject
        Note this returns the value outside of any mutexes, so it could change
        at any moment. Care must be exercised in its use.
       */
-    unsigned IsSafelyBeingRemoved() const { return m_safelyBeingRemoved; }
+    unsigned IsSafelyBeingRemoved() const { return (m_safeState.load() & SafeRemovedFlag) != 0; }
 
     /**Determine if the object can be safely deleted.
        This determines if the object has been flagged for deletion and all
@@ -284,7 +282,7 @@ class PSafeObject : public PObject
        Note this returns the value outside of any mutexes, so it could change
        at any moment. Care must be exercised in its use.
       */
-    unsigned GetSafeReferenceCount() const { PWaitAndSignal lock(m_safetyMutex); return m_safeReferenceCount; }
+    unsigned GetSafeReferenceCount() const { return m_safeState.load() & SafeCountMask; }
   //@}
 
   private:
@@ -295,12 +293,25 @@ class PSafeObject : public PObject
     bool InternalLockReadWrite(const PDebugLocation * location) const;
     void InternalUnlockReadWrite(const PDebugLocation * location) const;
     PReadWriteMutex & InternalGetMutex() const;
+    void SetSafelyBeingRemoved();
 
-    mutable PCriticalSection m_safetyMutex;
-    unsigned          m_safeReferenceCount;
-    bool              m_safelyBeingRemoved;
-    bool              m_safeMutexCreated;
-    PReadWriteMutex * m_safeInUseMutex;
+    /* Reference count and removed flag are in the one word, so that a
+       reference can be taken, or refused, with a single compare and swap. */
+    enum {
+      SafeRemovedFlag = 0x80000000,
+      SafeCountMask   = 0x7fffffff
+    };
+    atomic<unsigned>                   m_safeState;
+    bool                               m_safeMutexCreated;
+    mutable atomic<PReadWriteMutex *>  m_safeInUseMutex;   // Created on first lock
+
+    // Garbage collection, all owned by the collection that removed the object
+    mutable PCriticalSection m_safetyMutex; // Only for hand over of m_safeRemovalOwner
+    PSafeCollection * m_safeRemovalOwner;   // Deletes object once unreferenced, under m_safetyMutex
+    PSafeObject     * m_safeRemovalPrev;    // Removed objects list, under owners m_removalMutex
+    PSafeObject     * m_safeRemovalNext;
+    PSafeObject     * m_safeDeferredNext;   // Deferred deletion list
+    PInt64            m_safeDeferredTick;   // When last reference went, in nanoseconds
 
   friend class PSafeCollection;
   friend class PSafePtrBase;
@@ -486,6 +497,13 @@ class PSafeCollection : public PObject
     void DisallowDeleteObjects() { m_deleteObjects = false; }
 
     /**Delete any objects that have been removed.
+       When the last reference to a removed object is released, it is placed
+       on a lock free list of objects ready for deletion. This function takes
+       that whole list and deletes each object, so the cost is proportional
+       only to the number of objects actually deleted. Objects whose
+       PSafeObject::GarbageCollection() returns false are retried on the next
+       call.
+
        Returns true if all objects in the collection have been removed and
        their pending deletions carried out.
       */
@@ -495,10 +513,28 @@ class PSafeCollection : public PObject
       */
     virtual void DeleteObject(PObject * object) const;
 
-    /**Start a timer to automatically call DeleteObjectsToBeRemoved().
+    /**Start a background thread to automatically call DeleteObjectsToBeRemoved().
+       The thread is woken as soon as an object becomes ready for deletion,
+       and polls only while objects are waiting on GarbageCollection().
       */
     virtual void SetAutoDeleteObjects();
 
+    /// Statistics on removed objects and their deletion
+    struct GarbageStatistics
+    {
+      GarbageStatistics();
+
+      unsigned      m_pendingReferenced; ///< Removed, but still referenced by a PSafePtr
+      unsigned      m_pendingDeletion;   ///< Unreferenced, waiting to be deleted
+      PUInt64       m_reclaimed;         ///< Total objects deleted
+      PTimeInterval m_averageLatency;    ///< Average time from last reference to deletion
+      PTimeInterval m_maximumLatency;    ///< Maximum time from last reference to deletion
+    };
+
+    /**Get statistics on removed objects and their deletion.
+      */
+    GarbageStatistics GetGarbageStatistics() const;
+
     /**Get the current size of the collection.
        Note that usefulness of this function is limited as it is merely an
        instantaneous snapshot of the state of the collection.
@@ -518,31 +554,79 @@ class PSafeCollection : public PObject
   //@}
 
   protected:
+    typedef std::vector<PSafeObject *> ObjectArray;
+
+    /**Get all the objects in the collection, in index order.
+       Entries that are not PSafeObject descendants are NULL, so the position
+       in the array is the index in the collection. The default uses GetAt(),
+       PSafeColl overrides this to walk lists in linear time.
+      */
+    virtual void GetObjectsInOrder(ObjectArray & objects) const;
+
+    static void AddObjectsInOrder(const PCollection & coll, ObjectArray & objects);
+    template <class T> static void AddObjectsInOrder(const PList<T> & list, ObjectArray & objects)
+    {
+      for (typename PList<T>::const_iterator it = list.begin(); it != list.end(); ++it)
+        objects.push_back(dynamic_cast<PSafeObject *>(const_cast<T *>(&*it)));
+    }
+    template <class T> static void AddObjectsInOrder(const PSortedList<T> & list, ObjectArray & objects)
+    {
+      for (typename PSortedList<T>::const_iterator it = list.begin(); it != list.end(); ++it)
+        objects.push_back(dynamic_cast<PSafeObject *>(const_cast<T *>(&*it)));
+    }
+
     void CopySafeCollection(PCollection * other);
+    void CopySafeCollection(const PSafeCollection & other);
     void CopySafeDictionary(PAbstractDictionary * other);
     bool SafeAddObject(PSafeObject * obj, PSafeObject * old);
     void SafeRemoveObject(PSafeObject * obj);
 
+    void QueueDeletion(PSafeObject * obj);
+    void DeleteObjectsMain();
+
     PCollection      * m_collection;
     mutable PMutex     m_collectionMutex;
     bool               m_deleteObjects;
-    PList<PSafeObject> m_toBeRemoved;
-    PMutex             m_removalMutex;
 
-#if P_TIMERS
-    PDECLARE_NOTIFIER(PTimer, PSafeCollection, DeleteObjectsTimeout);
-    PTimer           * m_deleteObjectsTimer;
-#endif
+    // Objects removed but not yet deleted, intrusive list so O(1) insert and remove
+    mutable PMutex     m_removalMutex;
+    PSafeObject      * m_toBeRemoved;
+    unsigned           m_toBeRemovedCount;
+    PSafeObject      * m_garbageRetry;
+    PUInt64            m_reclaimedCount;
+    PInt64             m_reclaimedLatency;
+    PInt64             m_reclaimedMaxLatency;
+
+    // Lock free list of unreferenced objects, pushed by PSafeObject::SafeDereference()
+    atomic<PSafeObject *> m_deferredDeletion;
+    atomic<unsigned>      m_deferredCount;
+    atomic<unsigned>      m_deferredQueueing;
+
+    PThread              * m_deleteObjectsThread;
+    atomic<PSyncPoint *>   m_deleteObjectsSignal;
+    atomic<bool>           m_deleteObjectsShutdown;
 
   private:
     PSafeCollection(const PSafeCollection & other)
       : PObject(other)
       , m_collection()
       , m_deleteObjects()
-      , m_deleteObjectsTimer()
+      , m_toBeRemoved()
+      , m_toBeRemovedCount()
+      , m_garbageRetry()
+      , m_reclaimedCount()
+      , m_reclaimedLatency()
+      , m_reclaimedMaxLatency()
+      , m_deferredDeletion(NULL)
+      , m_deferredCount(0)
+      , m_deferredQueueing(0)
+      , m_deleteObjectsThread()
+      , m_deleteObjectsSignal(NULL)
+      , m_deleteObjectsShutdown(false)
     { }
     void operator=(const PSafeCollection &) { }
 
+  friend class PSafeObject;
   friend class PSafePtrBase;
 };
 
@@ -705,10 +789,18 @@ class PSafePtrBase : public PObject
     virtual void LockPtr() { }
     virtual void UnlockPtr() { }
 
+    bool LocateCurrentObject();
+
   protected:
     const PSafeCollection * m_collection;
     PSafeObject           * m_currentObject;
     PSafetyMode             m_lockMode;
+
+    /* Cursor for Next() and Previous(). As m_collection is our own copy and
+       never changes, the objects in it are fetched once, on first use, and
+       then each step is just an index increment. */
+    PSafeCollection::ObjectArray m_enumeration;
+    PINDEX                       m_enumerationIndex;
 };
 
 
@@ -1076,7 +1168,7 @@ template <class Coll, class Base> class PSafeColl : public PSafeCollection
       : PSafeCollection(new Coll)
     {
       PWaitAndSignal lock2(other.m_collectionMutex);
-      this->CopySafeCollection(dynamic_cast<Coll *>(other.m_collection));
+      this->CopySafeCollection(other);
     }
 
     /**Assign one safe collection to another.
@@ -1088,12 +1180,19 @@ template <class Coll, class Base> class PSafeColl : public PSafeCollection
         RemoveAll(true);
         PWaitAndSignal lock1(this->m_collectionMutex);
         PWaitAndSignal lock2(other.m_collectionMutex);
-        CopySafeCollection(dynamic_cast<Coll *>(other.m_collection));
+        this->CopySafeCollection(other);
       }
       return *this;
     }
   //@}
 
+  protected:
+    virtual void GetObjectsInOrder(ObjectArray & objects) const
+    {
+      this->AddObjectsInOrder(*dynamic_cast<const Coll *>(this->m_collection), objects);
+    }
+
+  public:
   /**@name Operations */
   //@{
     /**Add an object to the collection.
@@ -538,6 +538,131 @@ class PSocket : public PChannel
 };
 
 
+#if P_HAS_EPOLL
+
+struct epoll_event;
+
+/**Persistent set of sockets to be selected on.
+   PSocket::Select() must rebuild its file descriptor set from the lists on
+   every call, so the cost grows with the number of sockets, even if few are
+   ever ready. This class keeps the sockets registered with the kernel, using
+   epoll, between calls, so the cost of Select() is proportional to the number
+   of sockets that are actually ready.
+
+   A socket may only be in one selector at a time. If a registered socket is
+   closed, it is automatically removed, and a Select() in progress returns
+   PChannel::Interrupted, as it would for PSocket::Select().
+ */
+class PSocketSelector : public PObject
+{
+    PCLASSINFO(PSocketSelector, PObject);
+  public:
+    P_DECLARE_BITWISE_ENUM(Events, 3, (NoEvents, ReadEvent, WriteEvent, ExceptEvent));
+
+    enum Triggering {
+      LevelTriggered, ///< Socket is returned by every Select() while ready
+      EdgeTriggered   ///< Socket is returned once each time it becomes ready
+    };
+
+    PSocketSelector(
+      Triggering triggering = LevelTriggered
+    );
+
+    /**Destroy the selector, removing any registered sockets.
+     */
+    ~PSocketSelector();
+
+    /**Add a socket to be selected for the \p events.
+       @return false if socket not open or already in a selector.
+     */
+    bool Add(
+      PSocket & socket,
+      Events events = ReadEvent
+    );
+
+    /**Change the events being selected for a socket.
+     */
+    bool Modify(
+      PSocket & socket,
+      Events events
+    );
+
+    /**Remove a socket from the selector.
+     */
+    bool Remove(
+      PSocket & socket
+    );
+
+    /// Get the number of sockets in the selector.
+    PINDEX GetCount() const;
+
+    /**Select sockets that are ready for reading. */
+    PChannel::Errors Select(
+      PSocket::SelectList & read,   ///< Returned list of sockets ready for reading
+      const PTimeInterval & timeout = PMaxTimeInterval ///< Timeout for wait on read/write data.
+    );
+    /**Select sockets that are ready for reading or writing. */
+    PChannel::Errors Select(
+      PSocket::SelectList & read,   ///< Returned list of sockets ready for reading
+      PSocket::SelectList & write,  ///< Returned list of sockets ready for writing
+      const PTimeInterval & timeout = PMaxTimeInterval ///< Timeout for wait on read/write data.
+    );
+    /**Select sockets that are ready. This function will block until the
+       timeout or any registered socket is ready for an event it was added
+       with.
+
+       The lists are emptied and then filled with the sockets that are ready.
+       A socket with an error or hang up is returned in all the lists for the
+       events it was registered for.
+
+       @return
+       PChannel::NoError if sockets are ready, or the timeout occurred, in
+       which case all of the lists are empty. PChannel::Interrupted if
+       Interrupt() was called or a registered socket was closed, and no
+       socket was ready at the same time.
+
+       More than one thread may call Select() on the same selector.
+     */
+    PChannel::Errors Select(
+      PSocket::SelectList & read,   ///< Returned list of sockets ready for reading
+      PSocket::SelectList & write,  ///< Returned list of sockets ready for writing
+      PSocket::SelectList & except, ///< Returned list of sockets with exceptions
+      const PTimeInterval & timeout = PMaxTimeInterval ///< Timeout for wait on read/write data.
+    );
+
+    /**Cause a Select() in another thread to return PChannel::Interrupted.
+       If no Select() is in progress, the next one returns immediately.
+     */
+    void Interrupt();
+
+  protected:
+    struct Registration
+    {
+      PSocket * m_socket;
+      int       m_handle;
+      Events    m_events;
+    };
+
+    bool Arm(P_INT_PTR id, const Registration & registration, int op);
+    bool InternalRemove(PChannel & channel, bool interrupt);
+    friend class PChannel;
+
+    Triggering m_triggering;
+    int        m_epoll;
+    int        m_wakeup;
+
+    typedef std::map<P_INT_PTR, Registration> RegistrationsById;
+    typedef std::map<PChannel *, P_INT_PTR>   IdsByChannel;
+    RegistrationsById m_byId;
+    IdsByChannel      m_byChannel;
+    P_INT_PTR         m_nextId;
+    std::vector<struct epoll_event> m_events;
+    PDECLARE_MUTEX(m_mutex);
+};
+
+#endif // P_HAS_EPOLL
+
+
 #endif // PTLIB_SOCKET_H
 
 
@@ -251,18 +251,42 @@ class PIntCondMutex : public PCondMutex
    can be changed via #define to an alternate algorithm 'Faster Fair Solution
    for the Reader-Writer Problem. V.Popov, O.Mazonka 2013'
    http://arxiv.org/ftp/arxiv/papers/1309/1309.4507.pdf to improve efficiency.
+
+   Alternatively, the FastAlgorithm may be selected at construction. This
+   keeps the per thread nesting information in thread local storage, rather
+   than a mutex protected map, and uses the platform read/write lock, so an
+   uncontended read lock does no memory allocation and takes no other lock.
+   The penalty is that the possible deadlock diagnostics can only display
+   the thread that has the write lock, not every thread that has a read lock.
  */
 
+#if defined(P_PTHREADS) && __cplusplus >= 201103L
+  #define P_READ_WRITE_FAST 1
+#else
+  #define P_READ_WRITE_FAST 0
+#endif
+
 class PReadWriteMutex : public PObject, public PMutexExcessiveLockInfo, PProfiling::HighWaterMark<PReadWriteMutex>
 {
   PCLASSINFO(PReadWriteMutex, PObject);
   public:
+    enum Algorithm {
+      StandardAlgorithm, ///< Semaphore based, full deadlock diagnostics
+      FastAlgorithm      ///< Thread local nesting and platform read/write lock, if available
+    };
+
+    /// Algorithm used when none is specified in constructor, default StandardAlgorithm
+    static Algorithm DefaultAlgorithm;
+
   /**@name Construction */
   //@{
-    explicit PReadWriteMutex();
     explicit PReadWriteMutex(
-      const PDebugLocation & location, ///< Source file/line of mutex definition
-      unsigned timeout = 0             ///< Timeout in ms, before declaring a possible deadlock. Zero uses default.
+      Algorithm algorithm = DefaultAlgorithm ///< Implementation to use
+    );
+    explicit PReadWriteMutex(
+      const PDebugLocation & location,       ///< Source file/line of mutex definition
+      unsigned timeout = 0,                  ///< Timeout in ms, before declaring a possible deadlock. Zero uses default.
+      Algorithm algorithm = DefaultAlgorithm ///< Implementation to use
     );
     ~PReadWriteMutex();
   //@}
@@ -322,6 +346,8 @@ class PReadWriteMutex : public PObject, public PMutexExcessiveLockInfo, PProfili
     void InternalStartWrite(const PDebugLocation * location);
     void InternalEndWrite(const PDebugLocation * location);
 
+    Algorithm   m_algorithm;
+
 #if P_READ_WRITE_ALGO2
     PSemaphore  m_inSemaphore;
     unsigned    m_inCount;
@@ -348,6 +374,7 @@ class PReadWriteMutex : public PObject, public PMutexExcessiveLockInfo, PProfili
       atomic<PUniqueThreadIdentifier> m_uniqueId;
 
       Nest();
+      explicit Nest(PUniqueThreadIdentifier uniqueId);
       Nest(const Nest & other);
       Nest & operator=(const Nest & other);
     };
@@ -364,8 +391,20 @@ class PReadWriteMutex : public PObject, public PMutexExcessiveLockInfo, PProfili
     void InternalEndWriteWithNest(Nest & nest, const PDebugLocation & location);
     void InternalWait(Nest & nest, PSync & sync, const PDebugLocation & location) const;
 
+#if P_READ_WRITE_FAST
+    struct FastNests;
+    static FastNests & GetFastNests();
+    void FastLock(Nest & nest, bool write, const PDebugLocation & location);
+    void FastUnlock(bool write);
+
+    pthread_rwlock_t                m_fastLock;
+    atomic<PThreadIdentifier>       m_fastWriterId;
+    atomic<PUniqueThreadIdentifier> m_fastWriterUniqueId;
+    atomic<unsigned>                m_fastHolders;
+#endif
+
   private:
-    PReadWriteMutex(const PReadWriteMutex & other) : PObject(other), m_readerCount(), m_writerCount() { }
+    PReadWriteMutex(const PReadWriteMutex & other) : PObject(other), m_algorithm(), m_readerCount(), m_writerCount() { }
     void operator=(const PReadWriteMutex &) { }
 
   friend class PSafeObject;
@@ -150,6 +150,24 @@ class PTCPSocket : public PIPSocket
       PINDEX len          ///< Number of bytes pointed to by <code>buf</code>.
     );
 
+    /** Write the contents of a file to the TCP/IP stream. The data starts at
+       the current position of \p file, and that position is advanced by the
+       number of bytes written.
+
+       Where the platform supports it, sendfile() is used, so the data is
+       passed from the file to the socket without being copied through user
+       space. Otherwise, the file is read and written in blocks.
+
+       This is subject to the write timeout.
+
+       @return
+       true if all \p length bytes were sucessfully written.
+     */
+    virtual bool WriteFile(
+      PFile & file,       ///< Open file to send data from.
+      PInt64 length       ///< Number of bytes to send.
+    );
+
     /** This is callback function called by the system whenever out of band data
        from the TCP/IP stream is received. A descendent class may interpret
        this data according to the semantics of the high level protocol.
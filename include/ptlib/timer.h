@@ -365,6 +365,10 @@ class PTimer : public PTimeInterval
       private:
         bool OnTimeout(PIdGenerator::Handle handle);
 
+        // Following must be called with m_timersMutex locked
+        void InternalAdd(PTimer & timer);
+        bool InternalRemove(PIdGenerator::Handle handle);
+
         struct Timeout
         {
           PIdGenerator::Handle m_handle;
@@ -374,7 +378,20 @@ class PTimer : public PTimeInterval
         };
         PQueuedThreadPool<Timeout> m_threadPool;
 
-        typedef std::map<PIdGenerator::Handle, PTimer *> TimerMap;
+        /* Running timers ordered by their absolute expiry time, so Process()
+           need only visit the timers that have actually expired, rather than
+           every timer in existence. */
+        typedef std::multimap<PTimeInterval, PIdGenerator::Handle> ExpiryMap;
+        ExpiryMap m_expiries;
+
+        struct ActiveTimer
+        {
+          ActiveTimer(PTimer * timer, const ExpiryMap::iterator & expiry)
+            : m_timer(timer), m_expiry(expiry) { }
+          PTimer *            m_timer;
+          ExpiryMap::iterator m_expiry; // m_expiries.end() if fired and awaiting OnTimeout()
+        };
+        typedef std::map<PIdGenerator::Handle, ActiveTimer> TimerMap;
         TimerMap m_timers;
         PCriticalSection m_timersMutex;
 #if PTRACING
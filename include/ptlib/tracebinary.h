@@ -0,0 +1,119 @@
+/*
+ * tracebinary.h
+ *
+ * Binary trace file format.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#ifndef PTLIB_TRACEBINARY_H
+#define PTLIB_TRACEBINARY_H
+
+#ifdef P_USE_PRAGMA
+#pragma interface
+#endif
+
+
+/** Layout of the file written when the PTrace::BinaryOutput option is used.
+    The file consists of a FileHeader followed by a sequence of records, each
+    starting on an eight byte boundary. A record with zero size indicates the
+    end of the file, e.g. if the application did not exit cleanly.
+
+    File names, module names and class names are not written on every line.
+    Each is written once in a StringRecord and then referred to by an
+    identifier. Similarly, a ThreadRecord gives the name for each thread.
+
+    All values are little endian. Use the tracedecode tool to convert the
+    file to the normal text format.
+  */
+struct PTraceBinary
+{
+  enum {
+    Version = 1,
+    Alignment = 8
+  };
+
+  static const char * Magic() { return "PTLibTrc"; }
+
+  enum RecordTypes {
+    EndOfFile,
+    LineType,
+    StringType,
+    ThreadType,
+    TextType    ///< Pre-formatted text, uses LineRecord with only m_textLength valid
+  };
+
+  struct FileHeader
+  {
+    char     m_magic[8];
+    PUInt32l m_version;
+    PUInt32l m_headerSize;
+    PUInt64l m_startTime;       ///< Microseconds since 1970 when m_tick was zero
+    PUInt32l m_options;         ///< PTrace::Options in effect
+    PUInt32l m_processId;
+    char     m_processName[48];
+  };
+
+  struct Record
+  {
+    PUInt32l m_size;            ///< Size of record including this header and any text
+    PUInt16l m_type;            ///< RecordTypes
+    PUInt16l m_level;           ///< Trace level for LineType
+  };
+
+  struct LineRecord : Record
+  {
+    PInt64l  m_tick;            ///< Nanoseconds since FileHeader::m_startTime
+    PUInt64l m_threadId;        ///< PThread unique identifier
+    PUInt64l m_object;          ///< Address of PObject instance, or zero
+    PUInt32l m_fileId;          ///< StringRecord identifier, zero is none
+    PUInt32l m_lineNum;
+    PUInt32l m_moduleId;        ///< StringRecord identifier, zero is none
+    PUInt32l m_classId;         ///< StringRecord identifier, zero is none
+    PUInt32l m_contextId;
+    PUInt32l m_textLength;      ///< Length of message text following
+  };
+
+  struct StringRecord : Record
+  {
+    PUInt32l m_id;
+    PUInt32l m_length;          ///< Length of string following
+  };
+
+  struct ThreadRecord : Record
+  {
+    PUInt64l m_threadId;        ///< PThread unique identifier
+    PUInt64l m_threadAddress;   ///< Address of PThread object
+    PUInt32l m_length;          ///< Length of thread name following
+    PUInt32l m_reserved;
+  };
+
+  static uint32_t RecordSize(size_t fixedSize, size_t textLength)
+  {
+    return (uint32_t)((fixedSize + textLength + Alignment - 1) & ~(size_t)(Alignment - 1));
+  }
+};
+
+
+#endif // PTLIB_TRACEBINARY_H
+
+
+// End Of File ///////////////////////////////////////////////////////////////
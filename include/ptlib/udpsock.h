@@ -136,6 +136,90 @@ class PUDPSocket : public PIPDatagramSocket
        Note this usually needs to be enabled with SetSendAddress()
      */
     int GetCurrentMTU();
+
+    /// Maximum datagrams transferred by one system call in ReadBatch()/WriteBatch()
+    enum { MaxBatchSize = 64 };
+
+    /// Datagram for ReadBatch() and WriteBatch()
+    struct Datagram
+    {
+      Datagram(
+        void * data = NULL,
+        PINDEX size = 0,
+        const PIPSocketAddressAndPort & ipAndPort = PIPSocketAddressAndPort()
+      ) : m_data(data)
+        , m_size(size)
+        , m_length(0)
+        , m_ipAndPort(ipAndPort)
+        , m_segmentSize(0)
+        , m_truncated(false)
+      { }
+
+      void                  * m_data;        ///< Datagram buffer
+      PINDEX                  m_size;        ///< Size of buffer on read, length of data on write
+      PINDEX                  m_length;      ///< Bytes actually read or written
+      PIPSocketAddressAndPort m_ipAndPort;   ///< Address received from, or to send to
+      PINDEX                  m_segmentSize; ///< Size of each coalesced segment, zero if one datagram
+      bool                    m_truncated;   ///< Datagram was larger than m_size, excess discarded
+    };
+
+    /**Read a number of datagrams, each with their own source address.
+       Where the platform supports it, recvmmsg() is used to read up to
+       MaxBatchSize datagrams in a single system call. This waits, subject
+       to the read timeout, for the first datagram then returns as many as
+       are already queued. Otherwise only one datagram is read.
+
+       If SetReceiveCoalescing() has been enabled, a datagram may contain
+       several segments from the same source, each of m_segmentSize bytes
+       except for the last.
+
+       The last receive address is set to that of the final datagram read.
+
+       A datagram larger than its buffer is truncated, as for Read(), and
+       has m_truncated set. The datagrams are still returned, but the last
+       read error is set to BufferTooSmall if any were truncated.
+
+       @return
+       Number of datagrams read, zero if there was an error or timeout.
+     */
+    virtual PINDEX ReadBatch(
+      Datagram * datagrams,   ///< Datagrams to read into
+      PINDEX count            ///< Number of entries in \p datagrams
+    );
+
+    /**Write a number of datagrams, each with their own destination address.
+       Where the platform supports it, sendmmsg() is used to write up to
+       MaxBatchSize datagrams in a single system call, otherwise they are
+       written one at a time. A datagram whose m_ipAndPort is not valid is
+       sent to the address set with SetSendAddress(). Broadcast is not
+       supported, use WriteTo() for that.
+
+       If m_segmentSize is non-zero and less than m_size, the kernel is
+       asked to split the buffer into datagrams of that size (UDP GSO), if
+       it can. Otherwise the datagram is sent as is.
+
+       If the kernel has no buffer space, the write is retried, or the
+       datagram dropped, as for Write(), see PSocket::NoBufferRetryCount.
+
+       @return
+       Number of datagrams written, this is less than \p count on error.
+     */
+    virtual PINDEX WriteBatch(
+      Datagram * datagrams,   ///< Datagrams to write
+      PINDEX count            ///< Number of entries in \p datagrams
+    );
+
+    /**Set the kernel to coalesce received datagrams from the same source
+       into a single large buffer (UDP GRO), reported via the m_segmentSize
+       of ReadBatch(). Normal reads of a socket with this enabled would get
+       the coalesced data, so only use with ReadBatch().
+
+       @return
+       false if not supported by the platform.
+     */
+    bool SetReceiveCoalescing(
+      bool enable     ///< Enable coalescing
+    );
   //@}
 
     // Normally, one would expect these to be protected, but they are just so darn
@@ -169,6 +253,7 @@ class PUDPSocket : public PIPDatagramSocket
     private:
       AddressAndPort m_sendAddressAndPort;
       AddressAndPort m_lastReceiveAddressAndPort;
+      bool           m_receiveCoalescing;
 };
 
 
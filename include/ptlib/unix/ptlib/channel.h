@@ -47,6 +47,10 @@
     PDECLARE_MUTEX(  px_writeMutex);
     PThread        * px_selectThread[3];
     PCriticalSection px_selectMutex[3];
+#if P_HAS_EPOLL
+    class PSocketSelector * px_selector;
+    friend class PSocketSelector;
+#endif
 
 
 // End Of File ////////////////////////////////////////////////////////////////
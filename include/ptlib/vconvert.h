@@ -274,6 +274,58 @@ class PColourConverter : public PColourPair
     */
     PVideoFrameInfo::ResizeMode GetResizeMode() const { return m_resizeMode; }
 
+    /// Algorithm used when scaling.
+    enum ScaleQuality {
+      e_NearestNeighbour, ///< Repeat or drop pixels, the fastest
+      e_Bilinear          ///< Bilinear interpolation when growing, average over the area of each pixel when shrinking
+    };
+
+    /**Set the algorithm used when scaling.
+       The default is e_NearestNeighbour.
+    */
+    void SetScaleQuality(
+      ScaleQuality quality  ///< New scaling algorithm
+    ) { m_scaleQuality = quality; }
+
+    /**Get the algorithm used when scaling.
+    */
+    ScaleQuality GetScaleQuality() const { return m_scaleQuality; }
+
+    /// SIMD instruction sets the standard converters may use.
+    enum Acceleration {
+      e_NoAcceleration, ///< Plain C++ only
+      e_SSE41,          ///< x86 SSE4.1
+      e_AVX2            ///< x86 AVX2, and SSE4.1 where a frame is too narrow
+    };
+
+    /**Set the SIMD instruction set the standard converters may use.
+       By default this is the best the CPU supports, determined at run time.
+       The level cannot be set higher than that, and this is mainly for testing
+       and benchmarking against the plain C++ versions. It is not thread safe
+       with respect to running conversions.
+       @return The level that will actually be used.
+      */
+    static Acceleration SetAcceleration(
+      Acceleration maximum ///< Highest instruction set to use
+    );
+
+    /**Get the SIMD instruction set the standard converters use.
+      */
+    static Acceleration GetAcceleration();
+
+    /**Set the number of extra threads used by CopyYUV420P() and RotateYUV420P().
+       Large frames are split into horizontal stripes, done by the calling
+       thread and this many others from a process wide pool. Zero, the
+       default, does everything on the calling thread.
+      */
+    static void SetScaleThreads(
+      unsigned count  ///< Number of threads in pool
+    );
+
+    /**Get the number of extra threads used by CopyYUV420P() and RotateYUV420P().
+      */
+    static unsigned GetScaleThreads();
+
     /**Convert RGB to YUV.
       */
     static void RGBtoYUV(
@@ -297,7 +349,8 @@ class PColourConverter : public PColourPair
       unsigned dstX, unsigned dstY, unsigned dstWidth, unsigned dstHeight,
       unsigned dstFrameWidth, unsigned dstFrameHeight, BYTE * dstYUV,
       PVideoFrameInfo::ResizeMode resizeMode = PVideoFrameInfo::eScale,
-      bool verticalFlip = false, std::ostream * error = NULL
+      bool verticalFlip = false, std::ostream * error = NULL,
+      ScaleQuality scaleQuality = e_NearestNeighbour
     );
 
     /**Rotate the video buffer image.
@@ -330,6 +383,7 @@ class PColourConverter : public PColourPair
     PINDEX   m_dstFrameBytes;
 
     PVideoFrameInfo::ResizeMode m_resizeMode;
+    ScaleQuality                m_scaleQuality;
     bool                        m_verticalFlip;
 
     PBYTEArray m_intermediateFrameStore;
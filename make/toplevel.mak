@@ -283,6 +283,7 @@ endif
 
 ifeq ($(HAS_ASN),1)
   SOURCES += $(COMPONENT_SRC_DIR)/asner.cxx \
+             $(COMPONENT_SRC_DIR)/asnpertab.cxx \
              $(COMPONENT_SRC_DIR)/pasn.cxx 
 endif
 
@@ -449,6 +450,7 @@ endif
 ifeq ($(HAS_NETWORKING),1)
   SOURCES += $(COMPONENT_SRC_DIR)/ipacl.cxx \
              $(COMPONENT_SRC_DIR)/inetprot.cxx \
+             $(COMPONENT_SRC_DIR)/sockreactor.cxx \
              $(COMMON_SRC_DIR)/psockbun.cxx \
              $(COMMON_SRC_DIR)/sockets.cxx
   ifeq ($(target_os),mingw)
@@ -0,0 +1,291 @@
+/*
+ * main.cxx
+ *
+ * Sample program to check and benchmark PIpAccessControlList searches.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptclib/ipacl.h>
+#include <ptclib/random.h>
+
+
+class ACLBench : public PProcess
+{
+  PCLASSINFO(ACLBench, PProcess)
+  public:
+    ACLBench() : m_random(12345) { }
+
+    void Main();
+    bool Check();
+    void Bench(unsigned ruleCount, unsigned threadCount, unsigned lookupCount);
+    void LookupThread(unsigned count);
+    void ChangingLookupThread();
+
+  protected:
+    void AddRules(unsigned count);
+    PIPSocket::Address NearbyAddress();
+
+    PRandom              m_random;
+    PIpAccessControlList m_acl;
+    std::vector<DWORD>   m_addresses;
+    atomic<unsigned>     m_allowedCount;
+    atomic<bool>         m_changing;
+};
+
+PCREATE_PROCESS(ACLBench);
+
+
+// The search as it was done before compilation, the first match in order
+static PIpAccessControlEntry * LinearFind(const PIpAccessControlList & acl, PIPSocket::Address address)
+{
+  for (PIpAccessControlList::const_iterator it = acl.begin(); it != acl.end(); ++it) {
+    PIpAccessControlEntry & entry = const_cast<PIpAccessControlEntry &>(*it);
+    if (entry.Match(address))
+      return &entry;
+  }
+  return NULL;
+}
+
+
+void ACLBench::AddRules(unsigned count)
+{
+  // Mostly /24 and /32 as in typical block lists, with some wider networks
+  static unsigned const Lengths[] = { 8, 12, 16, 20, 22, 24, 24, 24, 24, 28, 30, 32, 32, 32, 32, 32 };
+
+  while (count > 0) {
+    unsigned length = Lengths[m_random.Generate(PARRAYSIZE(Lengths)-1)];
+    DWORD network = m_random.Generate() & (0xffffffff << (32 - length));
+    PIPSocket::Address address(PSocket::Host2Net(network));
+    PStringStream description;
+    description << (m_random.Generate(3) == 0 ? '+' : '-') << address << '/' << length;
+    if (m_acl.Add(description)) {
+      m_addresses.push_back(network);
+      --count;
+    }
+  }
+}
+
+
+PIPSocket::Address ACLBench::NearbyAddress()
+{
+  // Half the time somewhere inside or close to a rule, else anywhere
+  DWORD address = m_random.Generate();
+  if (!m_addresses.empty() && (address & 1) != 0)
+    address = m_addresses[m_random.Generate((uint32_t)m_addresses.size()-1)] ^ (m_random.Generate() >> m_random.Generate(8, 31));
+  return PIPSocket::Address(PSocket::Host2Net(address));
+}
+
+
+bool ACLBench::Check()
+{
+  bool ok = true;
+
+  m_acl.Add("-10.1.");
+  m_acl.Add("+10.1.2.0/24");
+  m_acl.Add("-10.1.2.3");
+  m_acl.Add("+192.168.0.0/16");
+  if (!m_acl.IsAllowed(PIPSocket::Address(10, 1, 2, 4)) || m_acl.IsAllowed(PIPSocket::Address(10, 1, 2, 3)) ||
+       m_acl.IsAllowed(PIPSocket::Address(10, 1, 3, 3)) || m_acl.IsAllowed(PIPSocket::Address(10, 2, 0, 1)) ||
+      !m_acl.IsAllowed(PIPSocket::Address(192, 168, 7, 7))) {
+    cout << "Basic longest prefix match failed" << endl;
+    ok = false;
+  }
+
+  m_acl.Remove("10.1.2.0/24");
+  if (m_acl.IsAllowed(PIPSocket::Address(10, 1, 2, 4))) {
+    cout << "Search after Remove() failed" << endl;
+    ok = false;
+  }
+
+  m_acl.Add("all");
+  if (!m_acl.IsAllowed(PIPSocket::Address(10, 2, 0, 1)) || m_acl.IsAllowed(PIPSocket::Address(10, 1, 0, 1))) {
+    cout << "Match all entry failed" << endl;
+    ok = false;
+  }
+
+  // Non-contiguous mask cannot go in the trie, is searched in list order
+  m_acl.Add(new PIpAccessControlEntry(PIPSocket::Address(10, 0, 0, 7), PIPSocket::Address(255, 0, 0, 255), false));
+  if (m_acl.IsAllowed(PIPSocket::Address(10, 9, 9, 7)) || !m_acl.IsAllowed(PIPSocket::Address(10, 9, 9, 8))) {
+    cout << "Non-contiguous mask failed" << endl;
+    ok = false;
+  }
+
+#if P_HAS_IPV6
+  if (m_acl.IsAllowed(PIPSocket::Address("::ffff:10.1.2.3")) || !m_acl.IsAllowed(PIPSocket::Address("::ffff:192.168.1.1"))) {
+    cout << "IPv4 mapped IPv6 address failed" << endl;
+    ok = false;
+  }
+#endif
+
+  m_acl.RemoveAll();
+  if (!m_acl.IsAllowed(PIPSocket::Address(10, 1, 2, 3))) {
+    cout << "Empty list did not use default allowance" << endl;
+    ok = false;
+  }
+
+  // Compare against the linear search over random rules, then again after some changes
+  for (int pass = 0; pass < 3; ++pass) {
+    if (pass == 0) {
+      m_acl.BeginUpdate();
+      AddRules(2000);
+      m_acl.EndUpdate();
+    }
+    else {
+      for (unsigned i = 0; i < 200; ++i)
+        m_acl.RemoveAt(m_random.Generate(m_acl.GetSize()-1));
+      AddRules(200);
+      if (pass == 2)
+        m_acl.Add(new PIpAccessControlEntry(PIPSocket::Address(0, 0, 0, 1), PIPSocket::Address(0, 0, 0, 3), true));
+    }
+
+    unsigned mismatches = 0;
+    for (unsigned i = 0; i < 20000; ++i) {
+      PIPSocket::Address address = NearbyAddress();
+      PIpAccessControlEntry * expected = LinearFind(m_acl, address);
+      PIpAccessControlEntry * found = m_acl.Find(address);
+      if (found != expected) {
+        if (++mismatches < 5)
+          cout << "Pass " << pass << ": " << address << " found "
+               << (found != NULL ? found->AsString() : "nothing") << " expected "
+               << (expected != NULL ? expected->AsString() : "nothing") << endl;
+        ok = false;
+      }
+      if (m_acl.IsAllowed(address) != (expected != NULL && expected->IsAllowed()))
+        ok = false;
+    }
+  }
+
+  // Search from other threads while the list changes, the denied host is never removed
+  m_acl.Add("-172.16.1.1");
+  m_changing = true;
+  m_allowedCount = 0;
+  std::vector<PThread *> threads;
+  for (unsigned i = 0; i < 2; ++i)
+    threads.push_back(new PThreadObj<ACLBench>(*this, &ACLBench::ChangingLookupThread, false, "Lookup"));
+  for (unsigned i = 0; i < 300; ++i) {
+    AddRules(1);
+    PINDEX index = m_random.Generate(m_acl.GetSize()-1);
+    if (m_acl[index].AsString() != "-172.16.1.1")
+      m_acl.RemoveAt(index);
+  }
+  m_changing = false;
+  for (size_t i = 0; i < threads.size(); ++i)
+    delete threads[i];
+  if (m_allowedCount != 0) {
+    cout << "Search during changes allowed a denied address " << m_allowedCount << " times" << endl;
+    ok = false;
+  }
+
+  m_acl.RemoveAll();
+  m_addresses.clear();
+  return ok;
+}
+
+
+void ACLBench::ChangingLookupThread()
+{
+  // Nothing can be more specific than the host entry, so it is always denied
+  while (m_changing) {
+    if (m_acl.IsAllowed(PIPSocket::Address(172, 16, 1, 1)))
+      ++m_allowedCount;
+  }
+}
+
+
+void ACLBench::LookupThread(unsigned count)
+{
+  unsigned allowed = 0;
+  DWORD address = (DWORD)(uintptr_t)PThread::Current();
+  for (unsigned i = 0; i < count; ++i) {
+    address = address*1664525 + 1013904223;
+    if (m_acl.IsAllowed(PIPSocket::Address(address)))
+      ++allowed;
+  }
+  m_allowedCount += allowed;
+}
+
+
+void ACLBench::Bench(unsigned ruleCount, unsigned threadCount, unsigned lookupCount)
+{
+  PTime start;
+  m_acl.BeginUpdate();
+  AddRules(ruleCount);
+  PTimeInterval addTime = PTime() - start;
+
+  start.SetCurrentTime();
+  m_acl.EndUpdate();
+  PTimeInterval compileTime = PTime() - start;
+
+  cout << ruleCount << " rules added in " << addTime << "s, compiled in " << compileTime << "s" << endl;
+
+  unsigned linearCount = std::max(lookupCount/ruleCount, 100U);
+  start.SetCurrentTime();
+  unsigned allowed = 0;
+  for (unsigned i = 0; i < linearCount; ++i) {
+    PIpAccessControlEntry * entry = LinearFind(m_acl, NearbyAddress());
+    if (entry != NULL && entry->IsAllowed())
+      ++allowed;
+  }
+  PTimeInterval elapsed = PTime() - start;
+  cout << "Linear scan: " << linearCount << " lookups in " << elapsed << "s, "
+       << (PUInt64)(linearCount*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1)) << " lookups/s" << endl;
+
+  m_allowedCount = 0;
+  start.SetCurrentTime();
+  std::vector<PThread *> threads;
+  for (unsigned i = 0; i < threadCount; ++i)
+    threads.push_back(new PThreadObj1Arg<ACLBench, unsigned>(*this, lookupCount/threadCount, &ACLBench::LookupThread));
+  for (size_t i = 0; i < threads.size(); ++i)
+    delete threads[i];
+  elapsed = PTime() - start;
+  cout << "Compiled:    " << threadCount << " threads, " << lookupCount << " lookups in " << elapsed << "s, "
+       << (PUInt64)(lookupCount*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1)) << " lookups/s, "
+       << m_allowedCount << " allowed" << endl;
+}
+
+
+void ACLBench::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("r-rules: Number of rules in the list, default 100000\n"
+             "n-lookups: Number of addresses to look up, default 10000000\n"
+             "T-threads: Number of threads doing look ups, default 1\n"
+             "h-help.     This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  if (!Check()) {
+    SetTerminationValue(1);
+    return;
+  }
+  cout << "Access control list checks passed." << endl;
+
+  Bench(args.GetOptionAs('r', 100000U), std::max(args.GetOptionAs('T', 1U), 1U), args.GetOptionAs('n', 10000000U));
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////
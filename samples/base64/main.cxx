@@ -0,0 +1,224 @@
+/*
+ * main.cxx
+ *
+ * Sample program to check and benchmark PBase64.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptclib/cypher.h>
+#include <ptclib/random.h>
+
+
+class Base64Test : public PProcess
+{
+  PCLASSINFO(Base64Test, PProcess)
+  public:
+    void Main();
+    bool Check();
+    void Bench(PINDEX size, unsigned iterations);
+};
+
+PCREATE_PROCESS(Base64Test);
+
+
+// Simple, obviously correct, encoder to check against
+static PString Reference(const BYTE * data, PINDEX length, PBase64::Options options, PINDEX width)
+{
+  static const char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  static const char AlphabetURL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  const char * alphabet = options == PBase64::e_URL ? AlphabetURL : Alphabet;
+  const char * eol = options == PBase64::e_CRLF ? "\r\n" : options == PBase64::e_LF ? "\n" : "";
+  PINDEX lineLength = options == PBase64::e_CRLF ? width-1 : width;
+
+  PString str;
+  PINDEX column = 0;
+  for (PINDEX i = 0; i < length; i += 3) {
+    unsigned bits = data[i] << 16;
+    if (i+1 < length)
+      bits |= data[i+1] << 8;
+    if (i+2 < length)
+      bits |= data[i+2];
+    str += alphabet[bits >> 18];
+    str += alphabet[(bits >> 12) & 0x3f];
+    if (i+1 < length)
+      str += alphabet[(bits >> 6) & 0x3f];
+    else if (options != PBase64::e_URL)
+      str += '=';
+    if (i+2 < length)
+      str += alphabet[bits & 0x3f];
+    else if (options != PBase64::e_URL)
+      str += '=';
+    else
+      break;
+
+    if (i+2 < length && (column += 4) >= lineLength) {
+      str += eol;
+      column = 0;
+    }
+  }
+  return str;
+}
+
+
+bool Base64Test::Check()
+{
+  static PBase64::Options const Options[] = { PBase64::e_CRLF, PBase64::e_LF, PBase64::e_NoLF, PBase64::e_URL };
+  static PINDEX const Widths[] = { 76, 64, 10, 3 };
+
+  PBYTEArray data = PRandom::Octets(1000);
+  for (PINDEX length = 0; length <= data.GetSize(); length += length < 200 ? 1 : 97) {
+    for (PINDEX o = 0; o < PARRAYSIZE(Options); ++o) {
+      for (PINDEX w = 0; w < PARRAYSIZE(Widths); ++w) {
+        PString expected = Reference(data, length, Options[o], Widths[w]);
+        PString encoded = PBase64::Encode(data, length, Options[o], Widths[w]);
+        if (encoded != expected || PBase64::GetEncodedLength(length, Options[o], Widths[w]) != expected.GetLength()) {
+          cout << "Encode failed: length=" << length << " option=" << o << " width=" << Widths[w] << endl;
+          return false;
+        }
+
+        // Streaming in random sized chunks must give the same result
+        PBase64 encoder(Options[o], Widths[w]);
+        for (PINDEX i = 0; i < length; ) {
+          PINDEX chunk = std::min(length - i, (PINDEX)PRandom::Number(1, 100));
+          encoder.ProcessEncoding(data.GetPointer() + i, chunk);
+          i += chunk;
+        }
+        if (encoder.CompleteEncoding() != expected) {
+          cout << "Streamed encode failed: length=" << length << " option=" << o << " width=" << Widths[w] << endl;
+          return false;
+        }
+
+        if (length == 0)
+          continue;
+
+        // Without padding, URL encoding can end part way through a quad, which is flagged
+        PBYTEArray decoded;
+        if (PBase64::Decode(expected, decoded) != (Options[o] != PBase64::e_URL || length%3 == 0) ||
+                                                          decoded != PBYTEArray(data, length, false)) {
+          cout << "Decode failed: length=" << length << " option=" << o << " width=" << Widths[w] << endl;
+          return false;
+        }
+
+        PBase64 decoder;
+        for (PINDEX i = 0; i < expected.GetLength(); ) {
+          PINDEX chunk = std::min(expected.GetLength() - i, (PINDEX)PRandom::Number(1, 100));
+          decoder.ProcessDecoding(expected.Mid(i, chunk));
+          i += chunk;
+        }
+        if (decoder.GetDecodedData() != decoded) {
+          cout << "Streamed decode failed: length=" << length << " option=" << o << " width=" << Widths[w] << endl;
+          return false;
+        }
+      }
+    }
+  }
+
+  // Illegal characters are ignored but flagged, block SIMD must fall back correctly
+  PString good = PBase64::Encode(data, 300, PBase64::e_NoLF);
+  for (PINDEX i = 0; i < 100; ++i) {
+    PString bad = good;
+    bad.Splice("*", PRandom::Number(0, good.GetLength()-1), 0);
+    PBYTEArray decoded(300);
+    bool perfect = true;
+    if (PBase64::DecodeBlock(bad, bad.GetLength(), decoded.GetPointer(), &perfect) != 300 || perfect ||
+                                                              decoded != PBYTEArray(data, 300, false)) {
+      cout << "Illegal character decode failed at " << i << endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+void Base64Test::Bench(PINDEX size, unsigned iterations)
+{
+  PBYTEArray data = PRandom::Octets(size);
+  PString encoded = PBase64::Encode(data, PBase64::e_CRLF);
+
+  // As used by PRFC822Channel, one 57 byte input line at a time
+  PTime start;
+  for (unsigned i = 0; i < iterations; ++i) {
+    PBase64 encoder(PBase64::e_CRLF);
+    for (PINDEX pos = 0; pos < size; pos += 57)
+      encoder.ProcessEncoding(data.GetPointer() + pos, std::min(size - pos, (PINDEX)57));
+    encoder.CompleteEncoding();
+  }
+  PTimeInterval streamEncodeTime = PTime() - start;
+
+  start.SetCurrentTime();
+  for (unsigned i = 0; i < iterations; ++i)
+    PBase64::Encode(data, PBase64::e_CRLF);
+  PTimeInterval blockEncodeTime = PTime() - start;
+
+  start.SetCurrentTime();
+  for (unsigned i = 0; i < iterations; ++i) {
+    PBase64 decoder;
+    for (PINDEX pos = 0; pos < encoded.GetLength(); pos += 78)
+      decoder.ProcessDecoding(encoded.Mid(pos, 78));
+    decoder.GetDecodedData();
+  }
+  PTimeInterval streamDecodeTime = PTime() - start;
+
+  PBYTEArray decoded;
+  start.SetCurrentTime();
+  for (unsigned i = 0; i < iterations; ++i)
+    PBase64::Decode(encoded, decoded);
+  PTimeInterval blockDecodeTime = PTime() - start;
+
+  double megabytes = (double)size*iterations/1048576.0;
+  cout << "Size " << setw(8) << size << ':' << setprecision(1) << fixed
+       << " encode stream " << setw(7) << megabytes/std::max(streamEncodeTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s,"
+          " block " << setw(7) << megabytes/std::max(blockEncodeTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s;"
+          " decode stream " << setw(7) << megabytes/std::max(streamDecodeTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s,"
+          " block " << setw(7) << megabytes/std::max(blockDecodeTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s"
+       << endl;
+}
+
+
+void Base64Test::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("m-megabytes: Amount of data to process for each size, default 100\n"
+             "h-help.      This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  if (!Check()) {
+    SetTerminationValue(1);
+    return;
+  }
+  cout << "Base64 checks passed." << endl;
+
+  unsigned megabytes = args.GetOptionAs('m', 100U);
+  static PINDEX const Sizes[] = { 100, 4096, 1000000 };
+  for (PINDEX i = 0; i < PARRAYSIZE(Sizes); ++i)
+    Bench(Sizes[i], (unsigned)((PInt64)megabytes*1048576/Sizes[i]));
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////
@@ -27,6 +27,20 @@ class DNSTest : public PProcess
   public:
     DNSTest();
     void Main();
+
+    bool CheckCache();
+    void BenchCache(unsigned threadCount, unsigned lookupCount);
+
+  protected:
+    PDECLARE_NOTIFIER2(PObject, DNSTest, TestResolver, PIPSocket::HostLookup &);
+    PDECLARE_HostLookupNotifier(DNSTest, OnLookup);
+    void LookupThread(unsigned count);
+
+    PDECLARE_MUTEX(m_mutex);
+    std::map<PString, unsigned> m_resolveCount;
+    unsigned m_asyncCount;
+    PSyncPoint m_asyncDone;
+    PTimeInterval m_resolveDelay;
 };
 
 PCREATE_PROCESS(DNSTest);
@@ -49,6 +63,7 @@ void Usage()
             "       dnstest -t IP hostname            (i.e. server.example.com)\n"
             "       dnstest -u url                    (i.e. http://craigs@postincrement.com)\n"
             "               -r n                      repeat count\n"
+            "       dnstest -c [ -T threads ]         check and benchmark the name cache\n"
   ;
 }
 
@@ -127,12 +142,22 @@ void DNSTest::Main()
 {
   PArgList & args = GetArguments();
 
-  args.Parse("r:t:"
+  args.Parse("r:t:cT:"
 #if P_URL
              "u."
 #endif
             );
 
+  if (args.HasOption('c')) {
+    if (!CheckCache()) {
+      SetTerminationValue(1);
+      return;
+    }
+    cout << "Name cache checks passed." << endl;
+    BenchCache(args.GetOptionAs('T', 16U), 1000000);
+    return;
+  }
+
   if (args.GetCount() < 1) {
     Usage();
     return;
@@ -285,4 +310,136 @@ void DNSTest::Main()
   }
 }
   
+
+/* A stand-in for the system resolver, so the cache can be checked without
+   any real DNS. Names starting with "bad" fail, all others succeed. */
+void DNSTest::TestResolver(PObject &, PIPSocket::HostLookup & lookup)
+{
+  PThread::Sleep(m_resolveDelay);
+
+  PWaitAndSignal lock(m_mutex);
+  unsigned count = ++m_resolveCount[lookup.m_name];
+  if (lookup.m_name.NumCompare("bad") != EqualTo) {
+    lookup.m_canonicalName = lookup.m_name + ".example.com";
+    lookup.m_address = PIPSocket::Address(10, 0, (BYTE)count, (BYTE)lookup.m_name.GetLength());
+    lookup.m_aliases.AppendString(lookup.m_name);
+  }
+}
+
+
+void DNSTest::OnLookup(PObject &, const PIPSocket::HostLookup & lookup)
+{
+  PTRACE(4, "Async lookup of " << lookup.m_name << (lookup.IsValid() ? " succeeded" : " failed"));
+  PWaitAndSignal lock(m_mutex);
+  if (--m_asyncCount == 0)
+    m_asyncDone.Signal();
+}
+
+
+void DNSTest::LookupThread(unsigned count)
+{
+  PIPSocket::Address addr;
+  for (unsigned i = 0; i < count; ++i)
+    PIPSocket::GetHostAddress(psprintf("host%u", i%1000), addr);
+}
+
+
+bool DNSTest::CheckCache()
+{
+  bool ok = true;
+  PIPSocket::SetHostResolver(PCREATE_NOTIFIER2(TestResolver, PIPSocket::HostLookup &));
+  PIPSocket::SetNameCacheTimeouts(PTimeInterval(0, 2), 500, 1000);
+  PIPSocket::ClearNameCache();
+
+  // Many threads asking for the same name at once should cause one lookup
+  m_resolveDelay = 200;
+  std::vector<PThread *> threads;
+  for (unsigned i = 0; i < 20; ++i)
+    threads.push_back(new PThreadObj1Arg<DNSTest, unsigned>(*this, 1, &DNSTest::LookupThread));
+  for (size_t i = 0; i < threads.size(); ++i)
+    delete threads[i];
+  if (m_resolveCount["host0"] != 1) {
+    cout << "Coalesced lookup resolved " << m_resolveCount["host0"] << " times" << endl;
+    ok = false;
+  }
+
+  // Failed lookups are remembered, but not for as long
+  PIPSocket::Address addr;
+  m_resolveDelay = 0;
+  if (PIPSocket::GetHostAddress("bad1", addr) || PIPSocket::GetHostAddress("bad1", addr) || m_resolveCount["bad1"] != 1) {
+    cout << "Negative caching failed" << endl;
+    ok = false;
+  }
+  PThread::Sleep(600);
+  if (PIPSocket::GetHostAddress("bad1", addr) || m_resolveCount["bad1"] != 2) {
+    cout << "Negative cache expiry failed" << endl;
+    ok = false;
+  }
+
+  // Use in the last second of the entry's life refreshes it in the background
+  PIPSocket::ClearNameCache();
+  if (!PIPSocket::GetHostAddress("fresh", addr) || addr != PIPSocket::Address(10, 0, 1, 5)) {
+    cout << "Lookup failed, got " << addr << endl;
+    ok = false;
+  }
+  PThread::Sleep(1200);
+  m_resolveDelay = 300;
+  PSimpleTimer timer;
+  if (!PIPSocket::GetHostAddress("fresh", addr) || addr != PIPSocket::Address(10, 0, 1, 5) || timer.GetElapsed() > 100) {
+    cout << "Lookup during refresh failed, got " << addr << " in " << timer.GetElapsed() << endl;
+    ok = false;
+  }
+  PThread::Sleep(500);
+  if (!PIPSocket::GetHostAddress("fresh", addr) || addr != PIPSocket::Address(10, 0, 2, 5) || m_resolveCount["fresh"] != 2) {
+    cout << "Background refresh failed, got " << addr << endl;
+    ok = false;
+  }
+
+  // An entry expiring while its refresh is still running waits for the refresh
+  m_resolveDelay = 0;
+  PIPSocket::GetHostAddress("slow", addr);
+  PThread::Sleep(1200);
+  m_resolveDelay = 1500;
+  PIPSocket::GetHostAddress("slow", addr);
+  PThread::Sleep(900);
+  if (!PIPSocket::GetHostAddress("slow", addr) || addr != PIPSocket::Address(10, 0, 2, 4) || m_resolveCount["slow"] != 2) {
+    cout << "Lookup of entry expired during refresh failed, got " << addr << " after " << m_resolveCount["slow"] << " lookups" << endl;
+    ok = false;
+  }
+
+  // Asynchronous lookups, the cached one completes immediately
+  m_resolveDelay = 100;
+  m_asyncCount = 4;
+  PIPSocket::GetHostAddressAsync("fresh", PCREATE_HostLookupNotifier(OnLookup));
+  PIPSocket::GetHostAddressAsync("async", PCREATE_HostLookupNotifier(OnLookup));
+  PIPSocket::GetHostAddressAsync("async", PCREATE_HostLookupNotifier(OnLookup));
+  PIPSocket::GetHostAddressAsync("127.0.0.1", PCREATE_HostLookupNotifier(OnLookup));
+  if (!m_asyncDone.Wait(2000) || m_resolveCount["async"] != 1) {
+    cout << "Asynchronous lookup failed" << endl;
+    ok = false;
+  }
+
+  return ok;
+}
+
+
+void DNSTest::BenchCache(unsigned threadCount, unsigned lookupCount)
+{
+  PIPSocket::SetNameCacheTimeouts(PTimeInterval(0, 0, 5), PTimeInterval(0, 30), PTimeInterval(0, 30));
+  m_resolveDelay = 0;
+  LookupThread(1000);
+
+  PTime start;
+  std::vector<PThread *> threads;
+  for (unsigned i = 0; i < threadCount; ++i)
+    threads.push_back(new PThreadObj1Arg<DNSTest, unsigned>(*this, lookupCount/threadCount, &DNSTest::LookupThread));
+  for (size_t i = 0; i < threads.size(); ++i)
+    delete threads[i];
+  PTimeInterval elapsed = PTime() - start;
+
+  cout << threadCount << " threads, " << lookupCount << " cached lookups in " << elapsed << "s, "
+       << (PUInt64)(lookupCount*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1)) << " lookups/s" << endl;
+}
+
+
 // End of File ///////////////////////////////////////////////////////////////
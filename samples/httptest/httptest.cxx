@@ -42,8 +42,17 @@ class HTTPTest : public PProcess
     PCLASSINFO(HTTPTest, PProcess)
   public:
     void Main();
+    bool Check();
+    bool CheckFileGET(WORD port, const char * name, const PString & headers,
+                      int expectedCode, PINDEX start, PINDEX length, const char * contentRange = NULL);
+    bool CheckWriteFile();
+    void CheckListener();
 
     PQueuedThreadPool<HTTPConnection> m_pool;
+    PTCPSocket                        m_listener;
+    PHTTPSpace                        m_checkNameSpace;
+    PBYTEArray                        m_fileData;
+    PString                           m_etag;
 };
 
 PCREATE_PROCESS(HTTPTest)
@@ -53,6 +62,7 @@ void HTTPTest::Main()
 {
   PArgList & args = GetArguments();
   args.Parse("h-help.       print this help message.\n"
+             "c-check.      check serving files, with ranges and conditions, then exit.\n"
              "O-operation:  do a GET/POST/PUT/DELETE, if absent then acts as server\n"
              "p-port:       port number to listen on (default 80 or 443).\n"
 #if P_SSL
@@ -73,6 +83,14 @@ void HTTPTest::Main()
     return;
   }
 
+  if (args.HasOption('c')) {
+    if (Check())
+      cout << "HTTP file checks passed." << endl;
+    else
+      SetTerminationValue(1);
+    return;
+  }
+
   if (args.HasOption('O')) {
     if (args.GetCount() < 1) {
       cerr << args.Usage("url");
@@ -178,6 +196,234 @@ void HTTPTest::Main()
 }
 
 
+void HTTPTest::CheckListener()
+{
+  for (;;) {
+#if P_SSL
+    HTTPConnection * connection = new HTTPConnection(m_checkNameSpace, NULL);
+#else
+    HTTPConnection * connection = new HTTPConnection(m_checkNameSpace);
+#endif
+    if (!connection->m_socket.Accept(m_listener)) {
+      delete connection;
+      break;
+    }
+    m_pool.AddWork(connection);
+  }
+}
+
+
+// Raw request, so exactly what is on the wire is checked
+static bool RawGET(WORD port, const PString & headers, int & code, PMIMEInfo & mime, PBYTEArray & body)
+{
+  PTCPSocket socket("127.0.0.1", port);
+  if (!socket.IsOpen())
+    return false;
+
+  socket.SetReadTimeout(5000);
+  if (!socket.WriteString("GET /file.bin HTTP/1.0\r\n" + headers + "\r\n"))
+    return false;
+
+  PBYTEArray response;
+  PINDEX length = 0;
+  while (socket.Read(response.GetPointer(length + 65536) + length, 65536))
+    length += socket.GetLastReadCount();
+  response.SetSize(length);
+
+  PString text((const char *)(const BYTE *)response, length);
+  PINDEX headerEnd = text.Find("\r\n\r\n");
+  if (headerEnd == P_MAX_INDEX)
+    return false;
+
+  PStringArray lines = text.Left(headerEnd).Lines();
+  if (lines.IsEmpty())
+    return false;
+  code = lines[0].Mid(lines[0].Find(' ')+1).AsInteger();
+  for (PINDEX i = 1; i < lines.GetSize(); ++i) {
+    PINDEX colon = lines[i].Find(':');
+    if (colon != P_MAX_INDEX)
+      mime.SetAt(lines[i].Left(colon).Trim(), lines[i].Mid(colon+1).Trim());
+  }
+
+  body = PBYTEArray((const BYTE *)response + headerEnd + 4, length - headerEnd - 4);
+  return true;
+}
+
+
+bool HTTPTest::CheckFileGET(WORD port, const char * name, const PString & headers,
+                            int expectedCode, PINDEX start, PINDEX length, const char * contentRange)
+{
+  int code = 0;
+  PMIMEInfo mime;
+  PBYTEArray body;
+  if (!RawGET(port, headers, code, mime, body)) {
+    cout << name << ": request failed" << endl;
+    return false;
+  }
+
+  bool ok = true;
+  if (code != expectedCode) {
+    cout << name << ": code " << code << ", expected " << expectedCode << endl;
+    ok = false;
+  }
+
+  if (body.GetSize() != length || memcmp(body, (const BYTE *)m_fileData + start, length) != 0) {
+    cout << name << ": body of " << body.GetSize() << " bytes incorrect, expected " << length << " from " << start << endl;
+    ok = false;
+  }
+
+  // A 304 has the length of the whole file, but no body
+  PINDEX contentLength = expectedCode == PHTTP::NotModified ? m_fileData.GetSize() : length;
+  if (expectedCode != PHTTP::RangeNotSatisfiable && mime.GetInteger(PHTTP::ContentLengthTag(), -1) != (long)contentLength) {
+    cout << name << ": Content-Length " << mime(PHTTP::ContentLengthTag()) << ", expected " << contentLength << endl;
+    ok = false;
+  }
+
+  if (contentRange != NULL && mime(PHTTP::ContentRangeTag()) != contentRange) {
+    cout << name << ": Content-Range \"" << mime(PHTTP::ContentRangeTag()) << "\", expected \"" << contentRange << '"' << endl;
+    ok = false;
+  }
+
+  if (m_etag.IsEmpty())
+    m_etag = mime(PHTTP::ETagTag());
+  else if (expectedCode != PHTTP::RangeNotSatisfiable && mime(PHTTP::ETagTag()) != m_etag) {
+    cout << name << ": ETag \"" << mime(PHTTP::ETagTag()) << "\" changed from \"" << m_etag << '"' << endl;
+    ok = false;
+  }
+
+  return ok;
+}
+
+
+class WriteFileThread : public PThread
+{
+    PCLASSINFO(WriteFileThread, PThread)
+  public:
+    WriteFileThread(PTCPSocket & socket, PFile & file, PInt64 length)
+      : PThread(10000, NoAutoDeleteThread, NormalPriority, "WriteFile")
+      , m_socket(socket)
+      , m_file(file)
+      , m_length(length)
+      , m_ok(false)
+      , m_written(0)
+    {
+      Resume();
+    }
+
+    virtual void Main()
+    {
+      m_ok = m_socket.WriteFile(m_file, m_length);
+      m_written = m_socket.GetLastWriteCount();
+    }
+
+    PTCPSocket & m_socket;
+    PFile      & m_file;
+    PInt64       m_length;
+    bool         m_ok;
+    PINDEX       m_written;
+};
+
+
+bool HTTPTest::CheckWriteFile()
+{
+  PFilePath path = PDirectory::GetTemporary() + PSTRSTRM("httptest_" << GetProcessID() << ".big");
+  PBYTEArray data(3*1024*1024+17);
+  for (PINDEX i = 0; i < data.GetSize(); ++i)
+    data[i] = (BYTE)(i*13 + i/4099);
+
+  PFile file;
+  if (!file.Open(path, PFile::ReadWrite, PFile::Create|PFile::Truncate) || !file.Write(data, data.GetSize())) {
+    cout << "Could not create " << path << endl;
+    return false;
+  }
+
+  PTCPSocket listener;
+  listener.Listen(PIPSocket::Address::GetLoopback(4), 1, 0);
+  PTCPSocket client("127.0.0.1", listener.GetPort());
+  PTCPSocket server;
+  if (!client.IsOpen() || !server.Accept(listener)) {
+    cout << "Could not connect sockets for WriteFile" << endl;
+    return false;
+  }
+
+  // Straight to the socket, from part way into the file
+  static PINDEX const Offset = 1000;
+  PINDEX length = data.GetSize() - Offset - 5;
+  file.SetPosition(Offset);
+  WriteFileThread writer(server, file, length);
+
+  client.SetReadTimeout(5000);
+  PBYTEArray received(length);
+  bool ok = client.ReadBlock(received.GetPointer(), length);
+  writer.WaitForTermination();
+
+  if (!ok || !writer.m_ok || writer.m_written != length || memcmp(received, (const BYTE *)data + Offset, length) != 0) {
+    cout << "WriteFile of " << length << " bytes incorrect, wrote " << writer.m_written << endl;
+    ok = false;
+  }
+
+  file.Close();
+  PFile::Remove(path);
+  return ok;
+}
+
+
+bool HTTPTest::Check()
+{
+  PFilePath path = PDirectory::GetTemporary() + PSTRSTRM("httptest_" << GetProcessID() << ".bin");
+  m_fileData.SetSize(100000);
+  for (PINDEX i = 0; i < m_fileData.GetSize(); ++i)
+    m_fileData[i] = (BYTE)(i*7 + i/251);
+
+  {
+    PFile file;
+    if (!file.Open(path, PFile::WriteOnly, PFile::Create|PFile::Truncate) || !file.Write(m_fileData, m_fileData.GetSize())) {
+      cout << "Could not create " << path << endl;
+      return false;
+    }
+  }
+
+  m_checkNameSpace.AddResource(new PHTTPFile(PURL("file.bin", "http"), path, "application/octet-stream"));
+  if (!m_listener.Listen(PIPSocket::Address::GetLoopback(4), 10, 0)) {
+    cout << "Could not listen for HTTP" << endl;
+    return false;
+  }
+  WORD port = m_listener.GetPort();
+  PThread * listenThread = new PThreadObj<HTTPTest>(*this, &HTTPTest::CheckListener, false, "Listener");
+
+  PINDEX size = m_fileData.GetSize();
+  bool ok = CheckFileGET(port, "Whole file", "", PHTTP::RequestOK, 0, size);
+  if (m_etag.IsEmpty()) {
+    cout << "No ETag returned" << endl;
+    ok = false;
+  }
+  PString etag = m_etag;
+
+  ok = CheckFileGET(port, "Range", "Range: bytes=100-199\r\n", PHTTP::PartialContent, 100, 100, "bytes 100-199/100000") && ok;
+  ok = CheckFileGET(port, "Range to end", "Range: bytes=99000-\r\n", PHTTP::PartialContent, 99000, 1000, "bytes 99000-99999/100000") && ok;
+  ok = CheckFileGET(port, "Suffix range", "Range: bytes=-500\r\n", PHTTP::PartialContent, size-500, 500, "bytes 99500-99999/100000") && ok;
+  ok = CheckFileGET(port, "Range past end", "Range: bytes=99990-200000\r\n", PHTTP::PartialContent, 99990, 10, "bytes 99990-99999/100000") && ok;
+
+  ok = CheckFileGET(port, "Unsatisfiable range", "Range: bytes=200000-300000\r\n", PHTTP::RangeNotSatisfiable, 0, 0, "bytes */100000") && ok;
+  ok = CheckFileGET(port, "Reversed range", "Range: bytes=500-100\r\n", PHTTP::RequestOK, 0, size) && ok;
+  ok = CheckFileGET(port, "Unknown unit", "Range: items=0-10\r\n", PHTTP::RequestOK, 0, size) && ok;
+  ok = CheckFileGET(port, "Multiple ranges", "Range: bytes=0-1,5-6\r\n", PHTTP::RequestOK, 0, size) && ok;
+
+  ok = CheckFileGET(port, "If-None-Match", "If-None-Match: " + etag + "\r\n", PHTTP::NotModified, 0, 0) && ok;
+  ok = CheckFileGET(port, "If-None-Match list", "If-None-Match: \"other\", " + etag + "\r\n", PHTTP::NotModified, 0, 0) && ok;
+  ok = CheckFileGET(port, "If-None-Match other", "If-None-Match: \"other\"\r\n", PHTTP::RequestOK, 0, size) && ok;
+  ok = CheckFileGET(port, "If-Range match", "Range: bytes=0-9\r\nIf-Range: " + etag + "\r\n", PHTTP::PartialContent, 0, 10, "bytes 0-9/100000") && ok;
+  ok = CheckFileGET(port, "If-Range mismatch", "Range: bytes=0-9\r\nIf-Range: \"other\"\r\n", PHTTP::RequestOK, 0, size) && ok;
+
+  m_listener.Close();
+  listenThread->WaitForTermination();
+  delete listenThread;
+  PFile::Remove(path);
+
+  return CheckWriteFile() && ok;
+}
+
+
 void HTTPConnection::Work()
 {
   PTRACE(3, "HTTPTest\tStarted work on " << m_socket.GetPeerAddress());
@@ -9,6 +9,7 @@ class JSONTest : public PProcess
  public:
   JSONTest();
   void Main();
+  void Bench();
 };
 
 PCREATE_PROCESS(JSONTest);
@@ -22,6 +23,11 @@ JSONTest::JSONTest()
 void JSONTest::Main()
 {
   PArgList & args = GetArguments();
+  if (args.GetCount() > 0 && args[0] == "--bench") {
+    Bench();
+    return;
+  }
+
   if (args.GetCount() > 0) {
     PJSON json;
     if (args[0] == "-")
@@ -66,6 +72,24 @@ void JSONTest::Main()
   json5 = json3;
   cout << "Test 6\n" << json5 << endl;
 
+  PJSON json7("{ \"esc\" : \"a\\\"b\\\\c\\u00e9\\ud83d\\ude00\", \"lone\" : \"\\ud83dx\\udc00\", \"num\" : [ -12, 3.5e2, 0 ], \"dup\" : 1, \"dup\" : TRUE }");
+  cout << "Test 7 " << (json7.IsValid() &&
+                        json7.GetObject().GetString("esc") == "a\"b\\c\xc3\xa9\xf0\x9f\x98\x80" &&
+                        json7.GetObject().GetString("lone") == "\xef\xbf\xbdx\xef\xbf\xbd" &&
+                        json7.GetObject().GetArray("num").GetInteger(0) == -12 &&
+                        json7.GetObject().GetArray("num").GetNumber(1) == 350 &&
+                        json7.GetObject().GetBoolean("dup") ? "(good)" : "(bad)") << endl;
+
+  static const char * const Invalid[] = { "", "{", "[1,]", "{\"a\" 1}", "\"abc", "\"\\x\"", "-", "1e", "nul" };
+  bool rejected = true;
+  for (PINDEX i = 0; i < PARRAYSIZE(Invalid); ++i) {
+    if (PJSON(Invalid[i]).IsValid()) {
+      cout << "Invalid JSON accepted: " << Invalid[i] << endl;
+      rejected = false;
+    }
+  }
+  cout << "Test 8 " << (rejected ? "(good)" : "(bad)") << endl;
+
   cout << "Test 1 pretty A\n" << setw(4) << json1 << "\n"
           "Test 1 pretty B\n" << setprecision(4) << json1 << "\n"
           "Test 1 pretty C\n" << setprecision(3) << setw(6) << json1
@@ -88,3 +112,80 @@ void JSONTest::Main()
 #endif // P_SSL
 }
 
+
+// Counts elements, to time the parse without building a tree
+class CountingParser : public PJSON::Parser
+{
+  public:
+    CountingParser() : m_count(0) { }
+    virtual bool OnStartObject() { ++m_count; return true; }
+    virtual bool OnStartArray() { ++m_count; return true; }
+    virtual bool OnString(const char *, size_t) { ++m_count; return true; }
+    virtual bool OnNumber(PJSON::NumberType) { ++m_count; return true; }
+    virtual bool OnBoolean(bool) { ++m_count; return true; }
+    virtual bool OnNull() { ++m_count; return true; }
+    unsigned m_count;
+};
+
+
+void JSONTest::Bench()
+{
+  // Something like a typical REST API response
+  PStringStream generated;
+  generated << "{ \"results\": [";
+  for (unsigned i = 0; i < 200; ++i) {
+    if (i > 0)
+      generated << ',';
+    generated << "\n    {\n"
+            "      \"id\": " << i*7919 << ",\n"
+            "      \"name\": \"User number " << i << "\",\n"
+            "      \"email\": \"user" << i << "@example.com\",\n"
+            "      \"score\": " << i*1.25 << ",\n"
+            "      \"active\": " << (i%3 != 0 ? "true" : "false") << ",\n"
+            "      \"manager\": null,\n"
+            "      \"note\": \"Line one\\nLine \\\"two\\\"\",\n"
+            "      \"tags\": [ \"alpha\", \"beta\", \"gamma\" ]\n"
+            "    }";
+  }
+  generated << "\n  ],\n  \"count\": 200\n}\n";
+
+  const PString text = generated;
+
+  static const unsigned Iterations = 200;
+  cout << "Benchmark: " << Iterations << " iterations of " << text.GetLength() << " bytes" << endl;
+
+  PTime start;
+  for (unsigned i = 0; i < Iterations; ++i) {
+    PStringStream strm(text);
+    PJSON json;
+    strm >> json;
+  }
+  PTimeInterval streamTime = PTime() - start;
+
+  start.SetCurrentTime();
+  for (unsigned i = 0; i < Iterations; ++i)
+    PJSON json(text);
+  PTimeInterval stringTime = PTime() - start;
+
+  CountingParser parser;
+  start.SetCurrentTime();
+  for (unsigned i = 0; i < Iterations; ++i)
+    parser.Parse(text);
+  PTimeInterval parserTime = PTime() - start;
+
+  PStringStream strm(text);
+  PJSON fromStream;
+  strm >> fromStream;
+  PJSON fromString(text);
+
+  double megabytes = (double)text.GetLength()*Iterations/1048576.0;
+  cout << "  istream:    " << setw(6) << streamTime.GetMilliSeconds() << "ms, "
+       << setprecision(1) << fixed << megabytes/std::max(streamTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s\n"
+          "  FromString: " << setw(6) << stringTime.GetMilliSeconds() << "ms, "
+       << megabytes/std::max(stringTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s\n"
+          "  Parser:     " << setw(6) << parserTime.GetMilliSeconds() << "ms, "
+       << megabytes/std::max(parserTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s, "
+       << parser.m_count/Iterations << " values\n"
+          "  Results " << (fromString.IsValid() && fromString.AsString() == fromStream.AsString() ? "match" : "DIFFER")
+       << endl;
+}
@@ -0,0 +1,186 @@
+/*
+ * main.cxx
+ *
+ * Sample program to check and benchmark PInternetProtocol line parsing.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptclib/inetprot.h>
+#include <ptclib/memfile.h>
+#include <ptclib/mime.h>
+
+
+class LineBench : public PProcess
+{
+  PCLASSINFO(LineBench, PProcess)
+  public:
+    void Main();
+    bool Check();
+    void Bench(unsigned messageCount, PINDEX bufferSize);
+};
+
+PCREATE_PROCESS(LineBench);
+
+
+class TestProtocol : public PInternetProtocol
+{
+  PCLASSINFO(TestProtocol, PInternetProtocol)
+  public:
+    TestProtocol(const PBYTEArray & data, PINDEX bufferSize = 65536)
+      : PInternetProtocol("test", 0, NULL)
+    {
+      SetReadBufferSize(bufferSize);
+      Open(new PMemoryFile(data));
+    }
+
+    TestProtocol(const char * data, PINDEX bufferSize = 65536)
+      : PInternetProtocol("test", 0, NULL)
+    {
+      SetReadBufferSize(bufferSize);
+      Open(new PMemoryFile(PBYTEArray((const BYTE *)data, strlen(data))));
+    }
+};
+
+
+bool LineBench::Check()
+{
+  static struct {
+    const char * m_input;
+    bool         m_continuation;
+    const char * m_lines[4];
+  } const Tests[] = {
+    { "one\r\ntwo\r\n",             false, { "one", "two" } },
+    { "one\ntwo\n",                 false, { "one", "two" } },
+    { "one\rtwo\r\n",               false, { "one", "two" } },
+    { "one\r\r\ntwo\r\n",           false, { "one", "two" } },
+    { "onx\be\r\n\r\n",             false, { "one", "" } },
+    { "A: b\r\n c\r\nD: e\r\n\r\n", true,  { "A: b c", "D: e", "" } },
+    { "A: b\r\n c\r\nD: e\r\n\r\n", false, { "A: b", " c", "D: e", "" } },
+    { "A: b\r\n\tc\bd\r\n\r\n",     true,  { "A: b\td", "" } },
+  };
+
+  bool ok = true;
+  for (PINDEX i = 0; i < PARRAYSIZE(Tests); ++i) {
+    // Small buffer size to check lines split across reads as well
+    static PINDEX const BufferSizes[] = { 1, 3, 65536 };
+    for (PINDEX b = 0; b < PARRAYSIZE(BufferSizes); ++b) {
+      PINDEX bufferSize = BufferSizes[b];
+      TestProtocol protocol(Tests[i].m_input, bufferSize);
+      for (PINDEX j = 0; j < PARRAYSIZE(Tests[i].m_lines) && Tests[i].m_lines[j] != NULL; ++j) {
+        PString line;
+        if (!protocol.ReadLine(line, Tests[i].m_continuation) || line != Tests[i].m_lines[j]) {
+          cout << "Test " << i << " line " << j << " failed: got \"" << line.ToLiteral()
+               << "\" expected \"" << PString(Tests[i].m_lines[j]).ToLiteral() << '"' << endl;
+          ok = false;
+        }
+      }
+    }
+  }
+
+  // Put back and bulk read after lines
+  TestProtocol protocol("GET / HTTP/1.1\r\nHost: x\r\n\r\nbody data");
+  PINDEX num;
+  PString args;
+  PMIMEInfo mime;
+  char body[100];
+  if (!protocol.ReadCommand(num, args, mime) || args != "GET / HTTP/1.1" || mime("Host") != "x") {
+    cout << "Command with MIME failed" << endl;
+    ok = false;
+  }
+  protocol.UnRead("more ");
+  if (!protocol.ReadBlock(body, 14) || memcmp(body, "more body data", 14) != 0) {
+    cout << "UnRead and Read failed" << endl;
+    ok = false;
+  }
+
+  return ok;
+}
+
+
+void LineBench::Bench(unsigned messageCount, PINDEX bufferSize)
+{
+  static const char Message[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Date: Sat, 17 Oct 2026 10:00:00 GMT\r\n"
+    "Server: PTLib/2.18\r\n"
+    "Content-Type: text/html; charset=utf-8\r\n"
+    "Cache-Control: no-cache, no-store, must-revalidate\r\n"
+    "Set-Cookie: session=0123456789abcdef0123456789abcdef; Path=/; HttpOnly\r\n"
+    "X-Long-Header: Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n";
+
+  PBYTEArray data(messageCount*(sizeof(Message)-1));
+  for (unsigned i = 0; i < messageCount; ++i)
+    memcpy(data.GetPointer() + i*(sizeof(Message)-1), Message, sizeof(Message)-1);
+
+  TestProtocol lines(data, bufferSize);
+  PString line;
+  unsigned lineCount = 0;
+  PTime start;
+  while (lines.ReadLine(line))
+    ++lineCount;
+  PTimeInterval lineTime = PTime() - start;
+
+  TestProtocol headers(data, bufferSize);
+  PMIMEInfo mime;
+  unsigned headerCount = 0;
+  start.SetCurrentTime();
+  while (headers.ReadLine(line) && mime.Read(headers))
+    ++headerCount;
+  PTimeInterval mimeTime = PTime() - start;
+
+  double megabytes = data.GetSize()/1048576.0;
+  cout << "Buffer " << setw(5) << bufferSize << ": "
+       << lineCount << " lines in " << lineTime.GetMilliSeconds() << "ms, "
+       << setprecision(1) << fixed << megabytes/std::max(lineTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s; "
+       << headerCount << " responses in " << mimeTime.GetMilliSeconds() << "ms, "
+       << megabytes/std::max(mimeTime.GetMilliSeconds(), (PInt64)1)*1000 << " MB/s" << endl;
+}
+
+
+void LineBench::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("n-messages: Number of HTTP response headers to parse, default 100000\n"
+             "h-help.     This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  if (!Check()) {
+    SetTerminationValue(1);
+    return;
+  }
+  cout << "Line parsing checks passed." << endl;
+
+  unsigned messageCount = args.GetOptionAs('n', 100000U);
+  Bench(messageCount, 1000);
+  Bench(messageCount, 65536);
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////
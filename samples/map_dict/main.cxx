@@ -19,6 +19,9 @@
 
 #include <vector>
 #include <map>
+#if __cplusplus >= 201103L
+#include <unordered_map>
+#endif
 
 using namespace std;
 
@@ -45,57 +48,29 @@ the next element via the current element. In this way, the code is
 made to make N acceses to seemingly random parts of the map (or
 PDictionary).
 
-Results so far:
-
-Running 100000 lookups, 10000 iterates, over map/dictionary with 20 elements.
-Structure               Insert    Lookup   Iterate    Remove
-String Map            0:00.000  0:00.964  0:00.515  0:00.000
-String Dictionary     0:00.000  0:00.140  0:00.666  0:00.000
-Integer Map           0:00.000  0:00.603  0:00.514  0:00.000
-Integer Dictionary    0:00.000  0:00.121  0:00.364  0:00.000
-
-Running 50000 lookups, 5000 iterates, over map/dictionary with 100 elements.
-Structure               Insert    Lookup   Iterate    Remove
-String Map            0:00.002  0:00.647  0:01.246  0:00.004
-String Dictionary     0:00.000  0:00.095  0:01.061  0:00.000
-Integer Map           0:00.002  0:00.359  0:01.252  0:00.002
-Integer Dictionary    0:00.001  0:00.061  0:00.816  0:00.001
-
-Running 50000 lookups, 2000 iterates, over map/dictionary with 500 elements.
-Structure               Insert    Lookup   Iterate    Remove
-String Map            0:00.018  0:00.797  0:02.507  0:00.026
-String Dictionary     0:00.009  0:00.065  0:01.843  0:00.014
-Integer Map           0:00.018  0:00.430  0:02.505  0:00.017
-Integer Dictionary    0:00.021  0:00.284  0:01.566  0:00.015
+Results with the open addressing hash table, lookups are spread over all keys:
 
 Running 20000 lookups, 500 iterates, over map/dictionary with 2000 elements.
 Structure               Insert    Lookup   Iterate    Remove
-String Map            0:00.054  0:00.422  0:02.525  0:00.182
-String Dictionary     0:00.122  0:00.079  0:01.786  0:00.168
-Integer Map           0:00.137  0:00.180  0:02.574  0:00.099
-Integer Dictionary    0:00.249  0:00.314  0:01.542  0:00.166
-
-Running 10000 lookups, 100 iterates, over map/dictionary with 10000 elements.
-Structure               Insert    Lookup   Iterate    Remove
-String Map            0:00.299  0:00.244  0:02.597  0:01.621
-String Dictionary     0:00.287  0:00.280  0:01.853  0:02.135
-Integer Map           0:00.158  0:00.099  0:02.573  0:01.166
-Integer Dictionary    0:01.125  0:00.700  0:01.612  0:01.764
+String Map            0.000876  0.004741  0.000001  0.000664
+String Unordered      0.000387  0.001160  0.000001  0.000179
+String Dictionary     0.000649  0.001706  0.002889  0.000331
+Integer Map           0.000308  0.002075  0.000001  0.000346
+Integer Dictionary    0.000480  0.001100  0.002818  0.000144
 
 Running 5000 lookups, 50 iterates, over map/dictionary with 50000 elements.
 Structure               Insert    Lookup   Iterate    Remove
-String Map            0:01.691  0:00.115  0:06.581  0:08.311
-String Dictionary     0:06.516  0:00.544  0:04.878  0:10.517
-Integer Map           0:00.921  0:00.050  0:06.562  0:06.710
-Integer Dictionary    0:22.441  0:01.899  0:04.348  0:10.303
-
-So, depending on which parameter is most importaint, there are different
-thresholds. So how many elements are required in a dictionary before you
-should switch to a map:
-
-Structure       Insert  Lookup  Iterate  Remove
-String Keys      5,000  10,000  Never!   5,000
-Integer Keys     1,000  10.000  Never!   1,000
+String Map            0.044455  0.003584  0.000001  0.038026
+String Unordered      0.013977  0.000877  0.000000  0.008750
+String Dictionary     0.020272  0.000914  0.020717  0.009705
+Integer Map           0.010315  0.001235  0.000000  0.015161
+Integer Dictionary    0.014314  0.000421  0.018142  0.005789
+
+The results previously recorded here, with the chained hash table and buckets
+limited to the small range returned by HashFunction(), had the 50000 element
+Integer Dictionary taking 22 seconds to insert and 10 seconds to remove. The dictionary now scales like
+std::unordered_map. Iterating is slower than the STL as the iterator does a
+dynamic_cast on every element.
 
 */
 
@@ -142,7 +117,7 @@ class Tester
 
     virtual const char * GetName() const = 0;
     virtual void TestInsert() const = 0;
-    virtual bool TestLookup() const = 0;
+    virtual bool TestLookup(size_t index) const = 0;
     virtual void TestIterate() const = 0;
     virtual void TestRemove() const = 0;
 };
@@ -162,9 +137,9 @@ class StringMap : public Tester
         data.insert(Type::value_type(StringKeys[i], &DataElements[i]));
     }
 
-    virtual bool TestLookup() const
+    virtual bool TestLookup(size_t index) const
     {
-      return data.find(StringKeys[StringKeys.size()/2]) != data.end();
+      return data.find(StringKeys[index]) != data.end();
     }
 
     virtual void TestIterate() const
@@ -197,9 +172,9 @@ class StringDict : public Tester
         data.Insert(StringKeys[i], &DataElements[i]);
     }
 
-    virtual bool TestLookup() const
+    virtual bool TestLookup(size_t index) const
     {
-      return data.GetAt(StringKeys[StringKeys.size()/2]) != NULL;
+      return data.GetAt(StringKeys[index]) != NULL;
     }
 
     virtual void TestIterate() const
@@ -221,6 +196,47 @@ class StringDict : public Tester
 };
 
 
+#if __cplusplus >= 201103L
+struct PStringHash
+{
+  size_t operator()(const PString & str) const { return str.HashFunction(); }
+};
+
+
+class StringUnorderedMap : public Tester
+{
+    typedef std::unordered_map<PString, Element *, PStringHash> Type;
+    mutable Type data;
+
+  public:
+    virtual const char * GetName() const { return "String Unordered"; }
+
+    virtual void TestInsert() const
+    {
+      for (size_t i = 0; i < StringKeys.size(); i++)
+        data.insert(Type::value_type(StringKeys[i], &DataElements[i]));
+    }
+
+    virtual bool TestLookup(size_t index) const
+    {
+      return data.find(StringKeys[index]) != data.end();
+    }
+
+    virtual void TestIterate() const
+    {
+      for (Type::iterator it = data.begin(); it != data.end(); ++it)
+        DoNothing(it->first, *it->second);
+    }
+
+    virtual void TestRemove() const
+    {
+      for (size_t i = 0; i < StringKeys.size(); i++)
+        data.erase(StringKeys[i]);
+    }
+};
+#endif
+
+
 class IntMap : public Tester
 {
     typedef std::map<int, Element *> Type;
@@ -234,9 +250,9 @@ class IntMap : public Tester
         data.insert(Type::value_type(IntKeys[i], &DataElements[i]));
     }
 
-    virtual bool TestLookup() const
+    virtual bool TestLookup(size_t index) const
     {
-      return data.find(IntKeys[IntKeys.size()/2]) != data.end();
+      return data.find(IntKeys[index]) != data.end();
     }
 
     virtual void TestIterate() const
@@ -268,9 +284,9 @@ class IntDict : public Tester
         data.Insert(POrdinalKey(IntKeys[i]), &DataElements[i]);
     }
 
-    virtual bool TestLookup() const
+    virtual bool TestLookup(size_t index) const
     {
-      return data.GetAt(IntKeys[IntKeys.size()/2]) != NULL;
+      return data.GetAt(IntKeys[index]) != NULL;
     }
 
     virtual void TestIterate() const
@@ -306,6 +322,7 @@ class MapDictionary : public PProcess
     }
 
     void Main();
+    bool CheckClone();
     void TestAll();
     void Test(const Tester & tester);
 
@@ -367,6 +384,11 @@ void MapDictionary::Main()
          PTrace::Blocks | PTrace::Timestamp | PTrace::Thread | PTrace::FileAndLine);
 #endif
 
+  if (!CheckClone()) {
+    SetTerminationValue(1);
+    return;
+  }
+
   if (args.HasOption("preset")) {
     m_size = 20;    m_lookups = 100000; m_iterates = 10000; TestAll();
     m_size = 100;   m_lookups = 50000;  m_iterates = 5000;  TestAll();
@@ -396,6 +418,35 @@ void MapDictionary::Main()
 }
 
 
+bool MapDictionary::CheckClone()
+{
+  PStringToString original;
+  for (PINDEX i = 0; i < 100; ++i)
+    original.SetAt(PString(i), PString(i*2));
+  for (PINDEX i = 0; i < 100; i += 3)
+    original.RemoveAt(PString(i));
+
+  // Clone must have its own elements, in the same order, and all findable
+  PStringToString * clone = (PStringToString *)original.Clone();
+  bool ok = clone->GetSize() == original.GetSize();
+  PStringToString::iterator it = clone->begin();
+  for (PStringToString::iterator orig = original.begin(); ok && orig != original.end(); ++orig, ++it)
+    ok = it->first == orig->first && it->second == orig->second &&
+         &it->second != &orig->second && (*clone)[orig->first] == orig->second;
+
+  clone->SetAt("1", "changed");
+  clone->RemoveAt("2");
+  clone->SetAt("new", "value");
+  ok = ok && original["1"] == "2" && original.Contains("2") && !original.Contains("new");
+  delete clone;
+
+  ok = ok && original.GetSize() == 66 && original["98"] == "196";
+  if (!ok)
+    cerr << "Dictionary clone incorrect" << endl;
+  return ok;
+}
+
+
 void MapDictionary::TestAll()
 {
   cout << "Running " << m_lookups << " lookups, " << m_iterates << " iterates, "
@@ -418,6 +469,9 @@ void MapDictionary::TestAll()
        << setw(10) << "Remove"
        << endl;
   Test(StringMap());
+#if __cplusplus >= 201103L
+  Test(StringUnorderedMap());
+#endif
   Test(StringDict());
   Test(IntMap());
   Test(IntDict());
@@ -431,8 +485,10 @@ void MapDictionary::Test(const Tester & tester)
   tester.TestInsert();
 
   PTime b;
-  for (PINDEX i = 0; i < m_lookups; i++)
-    tester.TestLookup();
+  for (PINDEX i = 0; i < m_lookups; i++) {
+    if (!tester.TestLookup(i % m_size))
+      cerr << tester.GetName() << " lookup failed for key " << StringKeys[i % m_size] << endl;
+  }
 
   PTime c;
   for (PINDEX i = 0; i < m_iterates; i++)
@@ -9,6 +9,7 @@
 #include <ptlib.h>
 #include <ptlib/pprocess.h>
 #include <ptclib/cypher.h>
+#include <ptclib/random.h>
 
 
 #define new PNEW
@@ -19,6 +20,8 @@ class Md5 : public PProcess
 public:
   Md5();
   void Main();
+  bool Check();
+  void Benchmark(PINDEX length, PINDEX count);
 };
 
 PCREATE_PROCESS(Md5);
@@ -34,12 +37,14 @@ void Md5::Main()
 
   PConfigArgs args(GetArguments());
   args.Parse(
-       "a-first: "
-       "b-second: "
-       "h-help. "
+       "a-first:"
+       "b-second:"
+       "c-check."
+       "B-benchmark:"
+       "h-help."
 #if PTRACING
        "o-output:"             "-no-output."
-       "t-trace: "             "-no-trace."
+       "t-trace."              "-no-trace."
 #endif
        , false);
 
@@ -57,6 +62,8 @@ void Md5::Main()
          << endl
          << " -a  --first  ## : specify first string to add to md5" << endl
          << " -b  --second ## : specify second string to add to md5" << endl
+         << " -c  --check     : check digests against known values" << endl
+         << " -B  --benchmark ## : benchmark digests of ## byte messages" << endl
          << " -h  --help      : print this help out." << endl
 
 #if PTRACING
@@ -74,6 +81,22 @@ void Md5::Main()
 #endif
 
 
+  if (args.HasOption('c')) {
+    if (Check())
+      cout << "Digest checks passed." << endl;
+    else
+      SetTerminationValue(1);
+    return;
+  }
+
+  if (args.HasOption('B')) {
+    PINDEX length = args.GetOptionString('B').AsUnsigned();
+    if (length == 0)
+      length = 64;
+    Benchmark(length, (256*1024*1024)/(length+64));
+    return;
+  }
+
   PString a = args.GetOptionString('a', "127000151");
   PString b = args.GetOptionString('b', "ebey7" );
 
@@ -84,12 +107,8 @@ void Md5::Main()
   stomach.Complete(digester);
 
   cerr << "Resultant MD5 output is " << endl 
-       << PBase64::Encode(&digester, sizeof(digester)) << endl << endl;
-
-  for(PINDEX i = 0; i < (PINDEX)sizeof(digester); i++) 
-    cerr << ::hex << ::setfill('0') << ::setw(2) << (int)(*(((BYTE *)&digester)+i));
-
-  cerr << ::dec << endl;
+       << digester.AsBase64() << endl << endl
+       << digester.AsHex() << endl;
 
 #if PTRACING
   if (args.GetOptionCount('t') > 0) {
@@ -99,6 +118,147 @@ void Md5::Main()
 #endif
 
 }
+
+
+template <class Digestor>
+static bool CheckDigest(const char * name, const PString & data, const char * expected)
+{
+  PMessageDigest::Result result;
+  Digestor::Encode(data, result);
+  if (result.AsHex() == expected)
+    return true;
+  cout << name << " of \"" << data.Left(20) << "\" failed: " << result.AsHex() << " expected " << expected << endl;
+  return false;
+}
+
+
+template <class HMAC>
+static bool CheckHMAC(const char * name, const PString & key, const PString & data, const char * expected,
+                      const PString & previousKey = PString::Empty())
+{
+  HMAC hmac;
+  if (!previousKey.IsEmpty())
+    hmac.SetKey(previousKey);
+  hmac.SetKey(key);
+  PMessageDigest::Result result;
+  hmac.Process(data, result);
+  if (result.AsHex() == expected)
+    return true;
+  cout << name << " of \"" << data << "\" failed: " << result.AsHex() << " expected " << expected << endl;
+  return false;
+}
+
+
+template <class Digestor>
+static bool CheckBatch(const char * name)
+{
+  // Various lengths to cover the padding boundaries, and lanes finishing at different times
+  PBYTEArray buffer(1000);
+  for (PINDEX i = 0; i < buffer.GetSize(); ++i)
+    buffer[i] = (BYTE)(i*7 + i/13);
+
+  std::vector<PMessageDigest::Data> data;
+  for (PINDEX length = 0; length < 300; length += 11)
+    data.push_back(PMessageDigest::Data(buffer.GetPointer() + length, length*3 % 700));
+
+  std::vector<PMessageDigest::Result> results(data.size());
+  Digestor::EncodeBatch(&data[0], data.size(), &results[0]);
+
+  bool ok = true;
+  for (size_t i = 0; i < data.size(); ++i) {
+    PMessageDigest::Result single;
+    Digestor::Encode(data[i].m_data, data[i].m_length, single);
+    if (results[i] != single) {
+      cout << name << " batch of length " << data[i].m_length << " failed" << endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+
+bool Md5::Check()
+{
+  PString million(std::string(1000000, 'a'));
+  PString key(std::string(100, ' '));
+  bool ok = true;
+
+  ok = CheckDigest<PMessageDigest5>("MD5", "", "d41d8cd98f00b204e9800998ecf8427e") && ok;
+  ok = CheckDigest<PMessageDigest5>("MD5", "abc", "900150983cd24fb0d6963f7d28e17f72") && ok;
+  ok = CheckDigest<PMessageDigest5>("MD5", million, "7707d6ae4e027c70eea2a935c2296f21") && ok;
+
+  ok = CheckDigest<PMessageDigestSHA1>("SHA-1", "", "da39a3ee5e6b4b0d3255bfef95601890afd80709") && ok;
+  ok = CheckDigest<PMessageDigestSHA1>("SHA-1", "abc", "a9993e364706816aba3e25717850c26c9cd0d89d") && ok;
+  ok = CheckDigest<PMessageDigestSHA1>("SHA-1", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                                       "84983e441c3bd26ebaae4aa1f95129e5e54670f1") && ok;
+  ok = CheckDigest<PMessageDigestSHA1>("SHA-1", million, "34aa973cd4c4daa4f61eeb2bdbad27316534016f") && ok;
+
+  ok = CheckDigest<PMessageDigestSHA256>("SHA-256", "", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855") && ok;
+  ok = CheckDigest<PMessageDigestSHA256>("SHA-256", "abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad") && ok;
+  ok = CheckDigest<PMessageDigestSHA256>("SHA-256", "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+                                         "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1") && ok;
+  ok = CheckDigest<PMessageDigestSHA256>("SHA-256", million, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0") && ok;
+
+  // RFC 2202 and RFC 4231 test case 2, and a key longer than a block
+  ok = CheckHMAC<PHMAC_MD5>("HMAC-MD5", "Jefe", "what do ya want for nothing?", "750c783e6ab0b503eaa86e310a5db738") && ok;
+  ok = CheckHMAC<PHMAC_SHA1>("HMAC-SHA1", "Jefe", "what do ya want for nothing?", "effcdf6ae5eb2fa2d27416d5f184df9c259a7c79") && ok;
+  ok = CheckHMAC<PHMAC_SHA256>("HMAC-SHA256", "Jefe", "what do ya want for nothing?",
+                               "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843") && ok;
+  ok = CheckHMAC<PHMAC_SHA256>("HMAC-SHA256", key, "data", "2dc19bec58b8138517f7177c4cbb0598feb27d808fafce9f5f2f8a24da6c4c64") && ok;
+
+  // Nothing of a longer previous key may remain after setting a shorter one
+  ok = CheckHMAC<PHMAC_MD5>("HMAC-MD5", "Jefe", "what do ya want for nothing?", "750c783e6ab0b503eaa86e310a5db738",
+                            "a key that is longer than Jefe") && ok;
+  ok = CheckHMAC<PHMAC_SHA256>("HMAC-SHA256", "Jefe", "what do ya want for nothing?",
+                               "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", key) && ok;
+
+  ok = CheckBatch<PMessageDigest5>("MD5") && ok;
+  ok = CheckBatch<PMessageDigestSHA1>("SHA-1") && ok;
+  ok = CheckBatch<PMessageDigestSHA256>("SHA-256") && ok;
+
+  return ok;
+}
+
+
+template <class Digestor>
+static void BenchmarkDigest(const char * name, const std::vector<PMessageDigest::Data> & data)
+{
+  std::vector<PMessageDigest::Result> results(data.size());
+  double megabytes = data.size()*(double)data[0].m_length/1048576.0;
+
+  PTime start;
+  for (size_t i = 0; i < data.size(); ++i)
+    Digestor::Encode(data[i].m_data, data[i].m_length, results[i]);
+  PInt64 singleTime = std::max((PTime() - start).GetMilliSeconds(), (PInt64)1);
+
+  start.SetCurrentTime();
+  Digestor::EncodeBatch(&data[0], data.size(), &results[0]);
+  PInt64 batchTime = std::max((PTime() - start).GetMilliSeconds(), (PInt64)1);
+
+  cout << setw(8) << name << ": "
+       << setprecision(1) << fixed
+       << setw(8) << megabytes*1000/singleTime << " MB/s single, "
+       << setw(8) << megabytes*1000/batchTime << " MB/s batch" << endl;
+}
+
+
+void Md5::Benchmark(PINDEX length, PINDEX count)
+{
+  PBYTEArray buffer(length*16);
+  for (PINDEX i = 0; i < buffer.GetSize(); ++i)
+    buffer[i] = (BYTE)PRandom::Number();
+
+  std::vector<PMessageDigest::Data> data(count);
+  for (PINDEX i = 0; i < count; ++i)
+    data[i] = PMessageDigest::Data(buffer.GetPointer() + (i%16)*length, length);
+
+  cout << count << " messages of " << length << " bytes" << endl;
+  BenchmarkDigest<PMessageDigest5>("MD5", data);
+  BenchmarkDigest<PMessageDigestSHA1>("SHA-1", data);
+  BenchmarkDigest<PMessageDigestSHA256>("SHA-256", data);
+}
+
+
 // End of encrypt.cxx
 
 /***
@@ -0,0 +1,406 @@
+/*
+ * main.cxx
+ *
+ * Sample program to check and benchmark the table driven PER codec against
+ * the asnparser generated classes.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptclib/asnpertab.h>
+#include <ptclib/random.h>
+
+
+/* The classes and tables are generated by "asnparser -c -t" from perbench.asn.
+   The classes from perbench2.asn, which adds version 2 extensions, are used to
+   check unknown extensions are passed through.
+ */
+#include "perbench.h"
+#include "perbench2.h"
+
+// Only the tables for the types are in the header
+extern const PPER_Type PerBench_Address_number_FieldTable;
+extern const PPER_Type PerBench_Address_name_FieldTable;
+extern const PPER_Type PerBench_Address_url_FieldTable;
+extern const PPER_Type PerBench_Message_dialled_FieldTable;
+
+
+class PERBench : public PProcess
+{
+  PCLASSINFO(PERBench, PProcess)
+  public:
+    PERBench() : m_random(12345) { }
+
+    void Main();
+    bool Check();
+    void Bench(unsigned messageCount, unsigned iterations, bool aligned);
+
+  protected:
+    template <class Message, class Parameter> void RandomMessage(Message & msg, bool version2);
+    void RandomAddress(PASN_Choice & addr, bool version2);
+    PString RandomString(const char * charSet, unsigned minLen, unsigned maxLen);
+    bool CheckTable(const PPER_Type & table, const PASN_ConstrainedString & str);
+    bool CheckRoundTrip(unsigned index, const PASN_Sequence & msg, bool aligned);
+
+    PRandom m_random;
+};
+
+PCREATE_PROCESS(PERBench);
+
+
+PString PERBench::RandomString(const char * charSet, unsigned minLen, unsigned maxLen)
+{
+  unsigned setSize = strlen(charSet);
+  PString str;
+  for (unsigned len = m_random.Generate(minLen, maxLen); len > 0; --len)
+    str += charSet[m_random.Generate(setSize-1)];
+  return str;
+}
+
+
+void PERBench::RandomAddress(PASN_Choice & addr, bool version2)
+{
+  // Version 2 only adds to the end, so the choice numbers are the same
+  addr.SetTag(m_random.Generate(version2 ? PerBench2_Address::e_email : PerBench2_Address::e_url));
+  switch (addr.GetTag()) {
+    case PerBench2_Address::e_number :
+      (PASN_NumericString &)addr.GetObject() = RandomString("0123456789", 1, 16);
+      break;
+    case PerBench2_Address::e_name :
+      (PASN_IA5String &)addr.GetObject() = RandomString("abcdefghijklmnopqrstuvwxyz. ", 1, 64);
+      break;
+    case PerBench2_Address::e_url :
+      (PASN_IA5String &)addr.GetObject() = "sip:" + RandomString("abcdefghijklmnopqrstuvwxyz", 1, 200) + "@example.com";
+      break;
+    case PerBench2_Address::e_email :
+      (PASN_IA5String &)addr.GetObject() = RandomString("abcdefghijklmnopqrstuvwxyz", 1, 20) + "@example.com";
+      break;
+  }
+}
+
+
+template <class Message, class Parameter>
+void PERBench::RandomMessage(Message & msg, bool version2)
+{
+  msg.m_sequenceNumber = m_random.Generate(65535);
+  msg.m_kind = m_random.Generate(version2 ? PerBench2_Kind::e_control : PerBench2_Kind::e_data);
+  RandomAddress(msg.m_source, version2);
+  if (m_random.Generate(1)) {
+    msg.IncludeOptionalField(Message::e_destination);
+    RandomAddress(msg.m_destination, version2);
+  }
+
+  BYTE flags = (BYTE)m_random.Generate(255);
+  msg.m_flags.SetData(8, &flags, 1);
+  msg.m_timeOffset = (int)m_random.Generate(2000) - 1000;
+
+  if (m_random.Generate(1)) {
+    msg.IncludeOptionalField(Message::e_displayName);
+    msg.m_displayName = RandomString("ABCDEFGHIJKLMNOPQRSTUVWXYZ abcdefghijklmnopqrstuvwxyz", 0, 32);
+  }
+
+  if (m_random.Generate(1)) {
+    msg.IncludeOptionalField(Message::e_dialled);
+    msg.m_dialled = RandomString("0123456789#*ABCD", 1, 32);
+  }
+
+  msg.m_parameters.SetSize(m_random.Generate(16));
+  for (PINDEX i = 0; i < msg.m_parameters.GetSize(); ++i) {
+    msg.m_parameters[i].m_id = m_random.Generate(65535);
+    if (m_random.Generate(1)) {
+      msg.m_parameters[i].IncludeOptionalField(Parameter::e_value);
+      msg.m_parameters[i].m_value = RandomString("0123456789abcdef", 0, 255);
+    }
+  }
+
+  if (m_random.Generate(3) == 0) {
+    msg.IncludeOptionalField(Message::e_token);
+    PBYTEArray token(m_random.Generate(300));
+    for (PINDEX i = 0; i < token.GetSize(); ++i)
+      token[i] = (BYTE)m_random.Generate(255);
+    msg.m_token = token;
+  }
+
+  if (m_random.Generate(1)) {
+    msg.IncludeOptionalField(Message::e_count);
+    /* PASN_Integer::EncodePER() asserts on negative values, and DecodePER()
+       sign extends by 32 bits for values above INT_MAX, so avoid both */
+    msg.m_count = m_random.Generate() >> m_random.Generate(1, 31);
+  }
+
+  if (m_random.Generate(1)) {
+    msg.IncludeOptionalField(Message::e_priority);
+    msg.m_priority = m_random.Generate(7);
+  }
+
+  if (m_random.Generate(1)) {
+    msg.IncludeOptionalField(Message::e_urgent);
+    msg.m_urgent = m_random.Generate(1) != 0;
+  }
+
+}
+
+
+// What asnparser printed must be what the classes set up
+bool PERBench::CheckTable(const PPER_Type & table, const PASN_ConstrainedString & str)
+{
+  const PCharArray & set = str.GetCharacterSet();
+  if (table.m_constraint == str.GetConstraint() &&
+      table.m_lower == str.GetLowerLimit() &&
+      table.m_upper == str.GetUpperLimit() &&
+      table.m_charSetSize == (unsigned)set.GetSize() &&
+      memcmp(table.m_charSet, (const char *)set, set.GetSize()) == 0 &&
+      table.m_unalignedBits == str.GetCharSetUnalignedBits() &&
+      table.m_alignedBits == str.GetCharSetAlignedBits() &&
+      table.m_canonicalBits == str.GetCanonicalSetBits())
+    return true;
+
+  cout << "Table " << table.m_name << " does not match class " << str.GetClass() << endl;
+  return false;
+}
+
+
+bool PERBench::CheckRoundTrip(unsigned index, const PASN_Sequence & msg, bool aligned)
+{
+  PPER_Stream strm(aligned);
+  msg.Encode(strm);
+  strm.CompleteEncoding();
+
+  PPER_TableCodec codec(aligned);
+  PPER_Arena arena;
+  PPER_Value value;
+  if (!codec.Decode(PerBench_Message_Table, strm, arena, value)) {
+    cout << "Message " << index << " failed table decode" << endl;
+    return false;
+  }
+
+  // Compare against what the class decodes, quirks and all
+  PerBench_Message expected;
+  strm.ResetDecoder();
+  if (!expected.Decode(strm)) {
+    cout << "Message " << index << " failed class decode" << endl;
+    return false;
+  }
+
+  const PPER_Value * seqNum = value.GetField("sequenceNumber");
+  const PPER_Value * dialled = value.GetField("dialled");
+  const PPER_Value * count = value.GetField("count");
+  if (seqNum == NULL || seqNum->m_value != expected.m_sequenceNumber ||
+      value.GetField("timeOffset")->m_value != expected.m_timeOffset ||
+      value.GetField("parameters")->m_size != (unsigned)expected.m_parameters.GetSize() ||
+      (dialled != NULL) != expected.HasOptionalField(PerBench_Message::e_dialled) ||
+      (dialled != NULL && dialled->AsString() != expected.m_dialled.GetValue()) ||
+      (count != NULL && count->m_value != expected.m_count)) {
+    cout << "Message " << index << " has incorrect decoded values" << endl;
+    return false;
+  }
+
+  PBYTEArray encoded;
+  if (!codec.Encode(value, encoded)) {
+    cout << "Message " << index << " failed table encode" << endl;
+    return false;
+  }
+
+  /* Again compare with the class, rather than the original encoding, as
+     PASN_Integer does not survive a round trip with a negative lower bound */
+  PPER_Stream reencoded(aligned);
+  expected.Encode(reencoded);
+  reencoded.CompleteEncoding();
+  if (encoded != reencoded) {
+    cout << "Message " << index << " table encoding differs:\n"
+         << hex << setfill('0') << PBYTEArray(reencoded) << "\n" << encoded << dec << setfill(' ') << endl;
+    return false;
+  }
+
+  return true;
+}
+
+
+bool PERBench::Check()
+{
+  bool ok = true;
+
+  PerBench_Message msg;
+  ok = CheckTable(PerBench_Message_dialled_FieldTable, msg.m_dialled) && ok;
+  PerBench_Address addr;
+  addr.SetTag(PerBench_Address::e_number);
+  ok = CheckTable(PerBench_Address_number_FieldTable, (PASN_NumericString &)addr.GetObject()) && ok;
+  addr.SetTag(PerBench_Address::e_name);
+  ok = CheckTable(PerBench_Address_name_FieldTable, (PASN_IA5String &)addr.GetObject()) && ok;
+  addr.SetTag(PerBench_Address::e_url);
+  ok = CheckTable(PerBench_Address_url_FieldTable, (PASN_IA5String &)addr.GetObject()) && ok;
+
+  unsigned failures = 0;
+  for (unsigned i = 0; i < 4000 && failures < 5; ++i) {
+    bool passed;
+    if (i < 2000) {
+      PerBench_Message msg;
+      RandomMessage<PerBench_Message, PerBench_Parameter>(msg, false);
+      passed = CheckRoundTrip(i, msg, true) && CheckRoundTrip(i, msg, false);
+    }
+    else {
+      // Second half is version 2, with extensions unknown to the tables
+      PerBench2_Message msg;
+      RandomMessage<PerBench2_Message, PerBench2_Parameter>(msg, true);
+      if (m_random.Generate(1)) {
+        msg.IncludeOptionalField(PerBench2_Message::e_tag);
+        msg.m_tag = RandomString("abcdefghijklmnopqrstuvwxyz", 1, 300);
+      }
+      /* The class decodes the length of an unknown choice alternative as a one
+         bit constrained length in the unaligned variant, so it cannot be tested. */
+      bool unknownChoice = msg.m_source.GetTag() == PerBench2_Address::e_email ||
+                           (msg.HasOptionalField(PerBench2_Message::e_destination) &&
+                            msg.m_destination.GetTag() == PerBench2_Address::e_email);
+      passed = CheckRoundTrip(i, msg, true) && (unknownChoice || CheckRoundTrip(i, msg, false));
+    }
+    if (!passed) {
+      ++failures;
+      ok = false;
+    }
+  }
+
+  // Truncated data must fail, not crash
+  PerBench_Message full;
+  RandomMessage<PerBench_Message, PerBench_Parameter>(full, false);
+  full.IncludeOptionalField(PerBench_Message::e_priority);
+  PPER_Stream strm;
+  full.Encode(strm);
+  strm.CompleteEncoding();
+  PPER_TableCodec codec;
+  PPER_Arena arena;
+  for (PINDEX len = 0; len < strm.GetSize(); ++len) {
+    PPER_Value value;
+    if (codec.Decode(PerBench_Message_Table, strm, len, arena, value)) {
+      cout << "Truncated message of " << len << " bytes did not fail" << endl;
+      ok = false;
+      break;
+    }
+    arena.Reset();
+  }
+
+  return ok;
+}
+
+
+void PERBench::Bench(unsigned messageCount, unsigned iterations, bool aligned)
+{
+  std::vector<PBYTEArray> encoded(messageCount);
+  size_t totalBytes = 0;
+  for (unsigned i = 0; i < messageCount; ++i) {
+    PerBench_Message msg;
+    RandomMessage<PerBench_Message, PerBench_Parameter>(msg, false);
+    PPER_Stream strm(aligned);
+    msg.Encode(strm);
+    strm.CompleteEncoding();
+    encoded[i] = strm;
+    totalBytes += strm.GetSize();
+  }
+
+  unsigned total = messageCount*iterations;
+  cout << messageCount << " messages, average " << totalBytes/messageCount << " bytes, "
+       << (aligned ? "aligned" : "unaligned") << ", " << iterations << " iterations" << endl;
+
+  PTime start;
+  for (unsigned n = 0; n < iterations; ++n) {
+    for (unsigned i = 0; i < messageCount; ++i) {
+      PPER_Stream strm(encoded[i], aligned);
+      PerBench_Message msg;
+      msg.Decode(strm);
+    }
+  }
+  PTimeInterval elapsed = PTime() - start;
+  cout << "Class decode: " << elapsed << "s, "
+       << (PUInt64)(total*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1)) << " messages/s" << endl;
+
+  PPER_TableCodec codec(aligned);
+  PPER_Arena arena;
+  start.SetCurrentTime();
+  for (unsigned n = 0; n < iterations; ++n) {
+    for (unsigned i = 0; i < messageCount; ++i) {
+      PPER_Value value;
+      codec.Decode(PerBench_Message_Table, encoded[i], arena, value);
+      arena.Reset();
+    }
+  }
+  elapsed = PTime() - start;
+  cout << "Table decode: " << elapsed << "s, "
+       << (PUInt64)(total*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1)) << " messages/s" << endl;
+
+  std::vector<PerBench_Message> messages(messageCount);
+  for (unsigned i = 0; i < messageCount; ++i) {
+    PPER_Stream strm(encoded[i], aligned);
+    messages[i].Decode(strm);
+  }
+
+  start.SetCurrentTime();
+  for (unsigned n = 0; n < iterations; ++n) {
+    for (unsigned i = 0; i < messageCount; ++i) {
+      PPER_Stream strm(aligned);
+      messages[i].Encode(strm);
+      strm.CompleteEncoding();
+    }
+  }
+  elapsed = PTime() - start;
+  cout << "Class encode: " << elapsed << "s, "
+       << (PUInt64)(total*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1)) << " messages/s" << endl;
+
+  std::vector<PPER_Value> values(messageCount);
+  for (unsigned i = 0; i < messageCount; ++i)
+    codec.Decode(PerBench_Message_Table, encoded[i], arena, values[i]);
+
+  PBYTEArray data;
+  start.SetCurrentTime();
+  for (unsigned n = 0; n < iterations; ++n) {
+    for (unsigned i = 0; i < messageCount; ++i)
+      codec.Encode(values[i], data);
+  }
+  elapsed = PTime() - start;
+  cout << "Table encode: " << elapsed << "s, "
+       << (PUInt64)(total*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1)) << " messages/s" << endl;
+}
+
+
+void PERBench::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("m-messages: Number of different messages, default 1000\n"
+             "i-iterations: Number of times over the messages, default 100\n"
+             "u-unaligned. Use the unaligned PER variant\n"
+             "h-help.     This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  if (!Check()) {
+    SetTerminationValue(1);
+    return;
+  }
+  cout << "PER table codec checks passed." << endl;
+
+  Bench(std::max(args.GetOptionAs('m', 1000U), 1U), args.GetOptionAs('i', 100U), !args.HasOption('u'));
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////
@@ -0,0 +1,416 @@
+//
+// perbench.cxx
+//
+// Code automatically generated by asnparse.
+//
+
+#ifdef P_USE_PRAGMA
+#pragma implementation "perbench.h"
+#endif
+
+#include <ptlib.h>
+#include "perbench.h"
+
+#define new PNEW
+
+
+#if ! H323_DISABLE_PERBENCH
+
+#ifndef PASN_NOPRINTON
+const static PASN_Names Names_PerBench_Kind[]={
+        {"audio",0}
+       ,{"video",1}
+       ,{"data",2}
+       ,{"control",3}
+};
+#endif
+//
+// Kind
+//
+
+PerBench_Kind::PerBench_Kind(unsigned tag, PASN_Object::TagClass tagClass)
+  : PASN_Enumeration(tag, tagClass, 3, TRUE
+#ifndef PASN_NOPRINTON
+    ,(const PASN_Names *)Names_PerBench_Kind,4
+#endif
+    )
+{
+}
+
+
+PerBench_Kind & PerBench_Kind::operator=(unsigned v)
+{
+  SetValue(v);
+  return *this;
+}
+
+
+PObject * PerBench_Kind::Clone() const
+{
+#ifndef PASN_LEANANDMEAN
+  PAssert(IsClass(PerBench_Kind::Class()), PInvalidCast);
+#endif
+  return new PerBench_Kind(*this);
+}
+
+
+
+#ifndef PASN_NOPRINTON
+const static PASN_Names Names_PerBench_Address[]={
+      {"number",0}
+     ,{"name",1}
+     ,{"none",2}
+     ,{"url",3}
+};
+#endif
+//
+// Address
+//
+
+PerBench_Address::PerBench_Address(unsigned tag, PASN_Object::TagClass tagClass)
+  : PASN_Choice(tag, tagClass, 3, TRUE
+#ifndef PASN_NOPRINTON
+    ,(const PASN_Names *)Names_PerBench_Address,4
+#endif
+)
+{
+}
+
+
+PBoolean PerBench_Address::CreateObject()
+{
+  switch (m_tag) {
+    case e_number :
+      choice = new PASN_NumericString();
+      choice->SetConstraints(PASN_Object::FixedConstraint, 1, 16);
+      return TRUE;
+    case e_name :
+      choice = new PASN_IA5String();
+      choice->SetConstraints(PASN_Object::FixedConstraint, 1, 64);
+      return TRUE;
+    case e_none :
+      choice = new PASN_Null();
+      return TRUE;
+    case e_url :
+      choice = new PASN_IA5String();
+      return TRUE;
+  }
+
+  choice = NULL;
+  return FALSE;
+}
+
+
+PObject * PerBench_Address::Clone() const
+{
+#ifndef PASN_LEANANDMEAN
+  PAssert(IsClass(PerBench_Address::Class()), PInvalidCast);
+#endif
+  return new PerBench_Address(*this);
+}
+
+
+//
+// Parameter
+//
+
+PerBench_Parameter::PerBench_Parameter(unsigned tag, PASN_Object::TagClass tagClass)
+  : PASN_Sequence(tag, tagClass, 1, TRUE, 0)
+{
+  m_id.SetConstraints(PASN_Object::FixedConstraint, 0, 65535);
+  m_value.SetConstraints(PASN_Object::FixedConstraint, 0, 255);
+}
+
+
+#ifndef PASN_NOPRINTON
+void PerBench_Parameter::PrintOn(ostream & strm) const
+{
+  int indent = strm.precision() + 2;
+  strm << "{\n";
+  strm << setw(indent+5) << "id = " << setprecision(indent) << m_id << '\n';
+  if (HasOptionalField(e_value))
+    strm << setw(indent+8) << "value = " << setprecision(indent) << m_value << '\n';
+  strm << setw(indent-1) << setprecision(indent-2) << "}";
+}
+#endif
+
+
+PObject::Comparison PerBench_Parameter::Compare(const PObject & obj) const
+{
+#ifndef PASN_LEANANDMEAN
+  PAssert(PIsDescendant(&obj, PerBench_Parameter), PInvalidCast);
+#endif
+  const PerBench_Parameter & other = (const PerBench_Parameter &)obj;
+
+  Comparison result;
+
+  if ((result = m_id.Compare(other.m_id)) != EqualTo)
+    return result;
+  if ((result = m_value.Compare(other.m_value)) != EqualTo)
+    return result;
+
+  return PASN_Sequence::Compare(other);
+}
+
+
+PINDEX PerBench_Parameter::GetDataLength() const
+{
+  PINDEX length = 0;
+  length += m_id.GetObjectLength();
+  if (HasOptionalField(e_value))
+    length += m_value.GetObjectLength();
+  return length;
+}
+
+
+PBoolean PerBench_Parameter::Decode(PASN_Stream & strm)
+{
+  if (!PreambleDecode(strm))
+    return FALSE;
+
+  if (!m_id.Decode(strm))
+    return FALSE;
+  if (HasOptionalField(e_value) && !m_value.Decode(strm))
+    return FALSE;
+
+  return UnknownExtensionsDecode(strm);
+}
+
+
+void PerBench_Parameter::Encode(PASN_Stream & strm) const
+{
+  PreambleEncode(strm);
+
+  m_id.Encode(strm);
+  if (HasOptionalField(e_value))
+    m_value.Encode(strm);
+
+  UnknownExtensionsEncode(strm);
+}
+
+
+PObject * PerBench_Parameter::Clone() const
+{
+#ifndef PASN_LEANANDMEAN
+  PAssert(IsClass(PerBench_Parameter::Class()), PInvalidCast);
+#endif
+  return new PerBench_Parameter(*this);
+}
+
+
+//
+// ArrayOf_Parameter
+//
+
+PerBench_ArrayOf_Parameter::PerBench_ArrayOf_Parameter(unsigned tag, PASN_Object::TagClass tagClass)
+  : PASN_Array(tag, tagClass)
+{
+}
+
+
+PASN_Object * PerBench_ArrayOf_Parameter::CreateObject() const
+{
+  return new PerBench_Parameter;
+}
+
+
+PerBench_Parameter & PerBench_ArrayOf_Parameter::operator[](PINDEX i) const
+{
+  return (PerBench_Parameter &)array[i];
+}
+
+
+PObject * PerBench_ArrayOf_Parameter::Clone() const
+{
+#ifndef PASN_LEANANDMEAN
+  PAssert(IsClass(PerBench_ArrayOf_Parameter::Class()), PInvalidCast);
+#endif
+  return new PerBench_ArrayOf_Parameter(*this);
+}
+
+
+//
+// Message
+//
+
+PerBench_Message::PerBench_Message(unsigned tag, PASN_Object::TagClass tagClass)
+  : PASN_Sequence(tag, tagClass, 5, TRUE, 2)
+{
+  m_sequenceNumber.SetConstraints(PASN_Object::FixedConstraint, 0, 65535);
+  m_flags.SetConstraints(PASN_Object::FixedConstraint, 8);
+  m_timeOffset.SetConstraints(PASN_Object::FixedConstraint, -1000, 1000);
+  m_displayName.SetConstraints(PASN_Object::FixedConstraint, 0, 32);
+  m_dialled.SetConstraints(PASN_Object::FixedConstraint, 1, 32);
+  m_dialled.SetCharacterSet(PASN_Object::FixedConstraint, "0123456789#*ABCD");
+  m_parameters.SetConstraints(PASN_Object::FixedConstraint, 0, 16);
+  m_priority.SetConstraints(PASN_Object::FixedConstraint, 0, 7);
+  IncludeOptionalField(e_priority);
+  IncludeOptionalField(e_urgent);
+}
+
+
+#ifndef PASN_NOPRINTON
+void PerBench_Message::PrintOn(ostream & strm) const
+{
+  int indent = strm.precision() + 2;
+  strm << "{\n";
+  strm << setw(indent+17) << "sequenceNumber = " << setprecision(indent) << m_sequenceNumber << '\n';
+  strm << setw(indent+7) << "kind = " << setprecision(indent) << m_kind << '\n';
+  strm << setw(indent+9) << "source = " << setprecision(indent) << m_source << '\n';
+  if (HasOptionalField(e_destination))
+    strm << setw(indent+14) << "destination = " << setprecision(indent) << m_destination << '\n';
+  strm << setw(indent+8) << "flags = " << setprecision(indent) << m_flags << '\n';
+  strm << setw(indent+13) << "timeOffset = " << setprecision(indent) << m_timeOffset << '\n';
+  if (HasOptionalField(e_displayName))
+    strm << setw(indent+14) << "displayName = " << setprecision(indent) << m_displayName << '\n';
+  if (HasOptionalField(e_dialled))
+    strm << setw(indent+10) << "dialled = " << setprecision(indent) << m_dialled << '\n';
+  strm << setw(indent+13) << "parameters = " << setprecision(indent) << m_parameters << '\n';
+  if (HasOptionalField(e_token))
+    strm << setw(indent+8) << "token = " << setprecision(indent) << m_token << '\n';
+  if (HasOptionalField(e_count))
+    strm << setw(indent+8) << "count = " << setprecision(indent) << m_count << '\n';
+  if (HasOptionalField(e_priority))
+    strm << setw(indent+11) << "priority = " << setprecision(indent) << m_priority << '\n';
+  if (HasOptionalField(e_urgent))
+    strm << setw(indent+9) << "urgent = " << setprecision(indent) << m_urgent << '\n';
+  strm << setw(indent-1) << setprecision(indent-2) << "}";
+}
+#endif
+
+
+PObject::Comparison PerBench_Message::Compare(const PObject & obj) const
+{
+#ifndef PASN_LEANANDMEAN
+  PAssert(PIsDescendant(&obj, PerBench_Message), PInvalidCast);
+#endif
+  const PerBench_Message & other = (const PerBench_Message &)obj;
+
+  Comparison result;
+
+  if ((result = m_sequenceNumber.Compare(other.m_sequenceNumber)) != EqualTo)
+    return result;
+  if ((result = m_kind.Compare(other.m_kind)) != EqualTo)
+    return result;
+  if ((result = m_source.Compare(other.m_source)) != EqualTo)
+    return result;
+  if ((result = m_destination.Compare(other.m_destination)) != EqualTo)
+    return result;
+  if ((result = m_flags.Compare(other.m_flags)) != EqualTo)
+    return result;
+  if ((result = m_timeOffset.Compare(other.m_timeOffset)) != EqualTo)
+    return result;
+  if ((result = m_displayName.Compare(other.m_displayName)) != EqualTo)
+    return result;
+  if ((result = m_dialled.Compare(other.m_dialled)) != EqualTo)
+    return result;
+  if ((result = m_parameters.Compare(other.m_parameters)) != EqualTo)
+    return result;
+  if ((result = m_token.Compare(other.m_token)) != EqualTo)
+    return result;
+  if ((result = m_count.Compare(other.m_count)) != EqualTo)
+    return result;
+
+  return PASN_Sequence::Compare(other);
+}
+
+
+PINDEX PerBench_Message::GetDataLength() const
+{
+  PINDEX length = 0;
+  length += m_sequenceNumber.GetObjectLength();
+  length += m_kind.GetObjectLength();
+  length += m_source.GetObjectLength();
+  if (HasOptionalField(e_destination))
+    length += m_destination.GetObjectLength();
+  length += m_flags.GetObjectLength();
+  length += m_timeOffset.GetObjectLength();
+  if (HasOptionalField(e_displayName))
+    length += m_displayName.GetObjectLength();
+  if (HasOptionalField(e_dialled))
+    length += m_dialled.GetObjectLength();
+  length += m_parameters.GetObjectLength();
+  if (HasOptionalField(e_token))
+    length += m_token.GetObjectLength();
+  if (HasOptionalField(e_count))
+    length += m_count.GetObjectLength();
+  return length;
+}
+
+
+PBoolean PerBench_Message::Decode(PASN_Stream & strm)
+{
+  if (!PreambleDecode(strm))
+    return FALSE;
+
+  if (!m_sequenceNumber.Decode(strm))
+    return FALSE;
+  if (!m_kind.Decode(strm))
+    return FALSE;
+  if (!m_source.Decode(strm))
+    return FALSE;
+  if (HasOptionalField(e_destination) && !m_destination.Decode(strm))
+    return FALSE;
+  if (!m_flags.Decode(strm))
+    return FALSE;
+  if (!m_timeOffset.Decode(strm))
+    return FALSE;
+  if (HasOptionalField(e_displayName) && !m_displayName.Decode(strm))
+    return FALSE;
+  if (HasOptionalField(e_dialled) && !m_dialled.Decode(strm))
+    return FALSE;
+  if (!m_parameters.Decode(strm))
+    return FALSE;
+  if (HasOptionalField(e_token) && !m_token.Decode(strm))
+    return FALSE;
+  if (HasOptionalField(e_count) && !m_count.Decode(strm))
+    return FALSE;
+  if (!KnownExtensionDecode(strm, e_priority, m_priority))
+    return FALSE;
+  if (!KnownExtensionDecode(strm, e_urgent, m_urgent))
+    return FALSE;
+
+  return UnknownExtensionsDecode(strm);
+}
+
+
+void PerBench_Message::Encode(PASN_Stream & strm) const
+{
+  PreambleEncode(strm);
+
+  m_sequenceNumber.Encode(strm);
+  m_kind.Encode(strm);
+  m_source.Encode(strm);
+  if (HasOptionalField(e_destination))
+    m_destination.Encode(strm);
+  m_flags.Encode(strm);
+  m_timeOffset.Encode(strm);
+  if (HasOptionalField(e_displayName))
+    m_displayName.Encode(strm);
+  if (HasOptionalField(e_dialled))
+    m_dialled.Encode(strm);
+  m_parameters.Encode(strm);
+  if (HasOptionalField(e_token))
+    m_token.Encode(strm);
+  if (HasOptionalField(e_count))
+    m_count.Encode(strm);
+  KnownExtensionEncode(strm, e_priority, m_priority);
+  KnownExtensionEncode(strm, e_urgent, m_urgent);
+
+  UnknownExtensionsEncode(strm);
+}
+
+
+PObject * PerBench_Message::Clone() const
+{
+#ifndef PASN_LEANANDMEAN
+  PAssert(IsClass(PerBench_Message::Class()), PInvalidCast);
+#endif
+  return new PerBench_Message(*this);
+}
+
+
+#endif // if ! H323_DISABLE_PERBENCH
+
+
+// End of perbench.cxx
@@ -0,0 +1,180 @@
+//
+// perbench.h
+//
+// Code automatically generated by asnparse.
+//
+
+#if ! H323_DISABLE_PERBENCH
+
+#ifndef __PERBENCH_H
+#define __PERBENCH_H
+
+#ifdef P_USE_PRAGMA
+#pragma interface
+#endif
+
+#include <ptclib/asner.h>
+#include <ptclib/asnpertab.h>
+
+//
+// Kind
+//
+
+class PerBench_Kind : public PASN_Enumeration
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench_Kind, PASN_Enumeration);
+#endif
+  public:
+    PerBench_Kind(unsigned tag = UniversalEnumeration, TagClass tagClass = UniversalTagClass);
+
+    enum Enumerations {
+      e_audio,
+      e_video,
+      e_data,
+      e_control
+    };
+
+    PerBench_Kind & operator=(unsigned v);
+    PObject * Clone() const;
+};
+
+
+//
+// Address
+//
+
+class PerBench_Address : public PASN_Choice
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench_Address, PASN_Choice);
+#endif
+  public:
+    PerBench_Address(unsigned tag = 0, TagClass tagClass = UniversalTagClass);
+
+    enum Choices {
+      e_number,
+      e_name,
+      e_none,
+      e_url
+    };
+
+    PBoolean CreateObject();
+    PObject * Clone() const;
+};
+
+
+//
+// Parameter
+//
+
+class PerBench_Parameter : public PASN_Sequence
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench_Parameter, PASN_Sequence);
+#endif
+  public:
+    PerBench_Parameter(unsigned tag = UniversalSequence, TagClass tagClass = UniversalTagClass);
+
+    enum OptionalFields {
+      e_value
+    };
+
+    PASN_Integer m_id;
+    PASN_OctetString m_value;
+
+    PINDEX GetDataLength() const;
+    PBoolean Decode(PASN_Stream & strm);
+    void Encode(PASN_Stream & strm) const;
+#ifndef PASN_NOPRINTON
+    void PrintOn(ostream & strm) const;
+#endif
+    Comparison Compare(const PObject & obj) const;
+    PObject * Clone() const;
+};
+
+
+//
+// ArrayOf_Parameter
+//
+
+class PerBench_Parameter;
+
+class PerBench_ArrayOf_Parameter : public PASN_Array
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench_ArrayOf_Parameter, PASN_Array);
+#endif
+  public:
+    PerBench_ArrayOf_Parameter(unsigned tag = UniversalSequence, TagClass tagClass = UniversalTagClass);
+
+    PASN_Object * CreateObject() const;
+    PerBench_Parameter & operator[](PINDEX i) const;
+    PObject * Clone() const;
+};
+
+
+//
+// Message
+//
+
+class PerBench_Message : public PASN_Sequence
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench_Message, PASN_Sequence);
+#endif
+  public:
+    PerBench_Message(unsigned tag = UniversalSequence, TagClass tagClass = UniversalTagClass);
+
+    enum OptionalFields {
+      e_destination,
+      e_displayName,
+      e_dialled,
+      e_token,
+      e_count,
+      e_priority,
+      e_urgent
+    };
+
+    PASN_Integer m_sequenceNumber;
+    PerBench_Kind m_kind;
+    PerBench_Address m_source;
+    PerBench_Address m_destination;
+    PASN_BitString m_flags;
+    PASN_Integer m_timeOffset;
+    PASN_BMPString m_displayName;
+    PASN_IA5String m_dialled;
+    PerBench_ArrayOf_Parameter m_parameters;
+    PASN_OctetString m_token;
+    PASN_Integer m_count;
+    PASN_Integer m_priority;
+    PASN_Boolean m_urgent;
+
+    PINDEX GetDataLength() const;
+    PBoolean Decode(PASN_Stream & strm);
+    void Encode(PASN_Stream & strm) const;
+#ifndef PASN_NOPRINTON
+    void PrintOn(ostream & strm) const;
+#endif
+    Comparison Compare(const PObject & obj) const;
+    PObject * Clone() const;
+};
+
+
+//
+// PER codec tables
+//
+
+extern const PPER_Type PerBench_Kind_Table;
+extern const PPER_Type PerBench_Address_Table;
+extern const PPER_Type PerBench_Parameter_Table;
+extern const PPER_Type PerBench_ArrayOf_Parameter_Table;
+extern const PPER_Type PerBench_Message_Table;
+
+
+#endif // __PERBENCH_H
+
+#endif // if ! H323_DISABLE_PERBENCH
+
+
+// End of perbench.h
@@ -0,0 +1,171 @@
+//
+// perbench2.h
+//
+// Code automatically generated by asnparse.
+//
+
+#if ! H323_DISABLE_PERBENCH2
+
+#ifndef __PERBENCH2_H
+#define __PERBENCH2_H
+
+#ifdef P_USE_PRAGMA
+#pragma interface
+#endif
+
+#include <ptclib/asner.h>
+
+//
+// Kind
+//
+
+class PerBench2_Kind : public PASN_Enumeration
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench2_Kind, PASN_Enumeration);
+#endif
+  public:
+    PerBench2_Kind(unsigned tag = UniversalEnumeration, TagClass tagClass = UniversalTagClass);
+
+    enum Enumerations {
+      e_audio,
+      e_video,
+      e_data,
+      e_control
+    };
+
+    PerBench2_Kind & operator=(unsigned v);
+    PObject * Clone() const;
+};
+
+
+//
+// Address
+//
+
+class PerBench2_Address : public PASN_Choice
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench2_Address, PASN_Choice);
+#endif
+  public:
+    PerBench2_Address(unsigned tag = 0, TagClass tagClass = UniversalTagClass);
+
+    enum Choices {
+      e_number,
+      e_name,
+      e_none,
+      e_url,
+      e_email
+    };
+
+    PBoolean CreateObject();
+    PObject * Clone() const;
+};
+
+
+//
+// Parameter
+//
+
+class PerBench2_Parameter : public PASN_Sequence
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench2_Parameter, PASN_Sequence);
+#endif
+  public:
+    PerBench2_Parameter(unsigned tag = UniversalSequence, TagClass tagClass = UniversalTagClass);
+
+    enum OptionalFields {
+      e_value
+    };
+
+    PASN_Integer m_id;
+    PASN_OctetString m_value;
+
+    PINDEX GetDataLength() const;
+    PBoolean Decode(PASN_Stream & strm);
+    void Encode(PASN_Stream & strm) const;
+#ifndef PASN_NOPRINTON
+    void PrintOn(ostream & strm) const;
+#endif
+    Comparison Compare(const PObject & obj) const;
+    PObject * Clone() const;
+};
+
+
+//
+// ArrayOf_Parameter
+//
+
+class PerBench2_Parameter;
+
+class PerBench2_ArrayOf_Parameter : public PASN_Array
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench2_ArrayOf_Parameter, PASN_Array);
+#endif
+  public:
+    PerBench2_ArrayOf_Parameter(unsigned tag = UniversalSequence, TagClass tagClass = UniversalTagClass);
+
+    PASN_Object * CreateObject() const;
+    PerBench2_Parameter & operator[](PINDEX i) const;
+    PObject * Clone() const;
+};
+
+
+//
+// Message
+//
+
+class PerBench2_Message : public PASN_Sequence
+{
+#ifndef PASN_LEANANDMEAN
+    PCLASSINFO(PerBench2_Message, PASN_Sequence);
+#endif
+  public:
+    PerBench2_Message(unsigned tag = UniversalSequence, TagClass tagClass = UniversalTagClass);
+
+    enum OptionalFields {
+      e_destination,
+      e_displayName,
+      e_dialled,
+      e_token,
+      e_count,
+      e_priority,
+      e_urgent,
+      e_tag
+    };
+
+    PASN_Integer m_sequenceNumber;
+    PerBench2_Kind m_kind;
+    PerBench2_Address m_source;
+    PerBench2_Address m_destination;
+    PASN_BitString m_flags;
+    PASN_Integer m_timeOffset;
+    PASN_BMPString m_displayName;
+    PASN_IA5String m_dialled;
+    PerBench2_ArrayOf_Parameter m_parameters;
+    PASN_OctetString m_token;
+    PASN_Integer m_count;
+    PASN_Integer m_priority;
+    PASN_Boolean m_urgent;
+    PASN_IA5String m_tag;
+
+    PINDEX GetDataLength() const;
+    PBoolean Decode(PASN_Stream & strm);
+    void Encode(PASN_Stream & strm) const;
+#ifndef PASN_NOPRINTON
+    void PrintOn(ostream & strm) const;
+#endif
+    Comparison Compare(const PObject & obj) const;
+    PObject * Clone() const;
+};
+
+
+#endif // __PERBENCH2_H
+
+#endif // if ! H323_DISABLE_PERBENCH2
+
+
+// End of perbench2.h
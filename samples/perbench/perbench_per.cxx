@@ -0,0 +1,204 @@
+//
+// perbench_per.cxx
+//
+// Code automatically generated by asnparse.
+//
+
+#include <ptlib.h>
+#include "perbench.h"
+
+
+#if ! H323_DISABLE_PERBENCH
+
+extern const PPER_Type PerBench_Address_number_FieldTable;
+extern const PPER_Type PerBench_Address_name_FieldTable;
+extern const PPER_Type PerBench_Address_none_FieldTable;
+extern const PPER_Type PerBench_Address_url_FieldTable;
+extern const PPER_Field PerBench_Address_Fields[];
+extern const PPER_Type PerBench_Parameter_id_FieldTable;
+extern const PPER_Type PerBench_Parameter_value_FieldTable;
+extern const PPER_Field PerBench_Parameter_Fields[];
+extern const PPER_Field PerBench_ArrayOf_Parameter_Fields[];
+extern const PPER_Type PerBench_Message_sequenceNumber_FieldTable;
+extern const PPER_Type PerBench_Message_flags_FieldTable;
+extern const PPER_Type PerBench_Message_timeOffset_FieldTable;
+extern const PPER_Type PerBench_Message_displayName_FieldTable;
+extern const PPER_Type PerBench_Message_dialled_FieldTable;
+extern const PPER_Type PerBench_Message_parameters_FieldTable;
+extern const PPER_Type PerBench_Message_token_FieldTable;
+extern const PPER_Type PerBench_Message_count_FieldTable;
+extern const PPER_Type PerBench_Message_priority_FieldTable;
+extern const PPER_Type PerBench_Message_urgent_FieldTable;
+extern const PPER_Field PerBench_Message_Fields[];
+
+
+//
+// Kind
+//
+
+const PPER_Type PerBench_Kind_Table = {
+  "Kind", PPER_Type::e_Enumeration, PASN_Object::Unconstrained, true, 0, UINT_MAX, 3, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+
+//
+// Address
+//
+
+const PPER_Type PerBench_Address_number_FieldTable = {
+  "number", PPER_Type::e_String, PASN_Object::FixedConstraint, false, 1, 16U, 0, 0, 0, NULL,
+  " 0123456789", 11, 4, 4, 4
+};
+
+const PPER_Type PerBench_Address_name_FieldTable = {
+  "name", PPER_Type::e_String, PASN_Object::FixedConstraint, false, 1, 64U, 0, 0, 0, NULL,
+  "\000\001\002\003\004\005\006\007\010\011\012\013\014\015\016\017\020\021\022\023\024\025\026\027\030\031\032\033\034\035\036\037 !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\177", 128, 7, 8, 7
+};
+
+const PPER_Type PerBench_Address_none_FieldTable = {
+  "none", PPER_Type::e_Null, PASN_Object::Unconstrained, false, 0, UINT_MAX, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Address_url_FieldTable = {
+  "url", PPER_Type::e_String, PASN_Object::Unconstrained, false, 0, UINT_MAX, 0, 0, 0, NULL,
+  "\000\001\002\003\004\005\006\007\010\011\012\013\014\015\016\017\020\021\022\023\024\025\026\027\030\031\032\033\034\035\036\037 !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~\177", 128, 7, 8, 7
+};
+
+const PPER_Field PerBench_Address_Fields[] = {
+  { "number", &PerBench_Address_number_FieldTable, -1 },
+  { "name", &PerBench_Address_name_FieldTable, -1 },
+  { "none", &PerBench_Address_none_FieldTable, -1 },
+  { "url", &PerBench_Address_url_FieldTable, -1 },
+  { NULL, NULL, -1 }
+};
+
+const PPER_Type PerBench_Address_Table = {
+  "Address", PPER_Type::e_Choice, PASN_Object::Unconstrained, true, 0, UINT_MAX, 3, 0, 1, PerBench_Address_Fields,
+  NULL, 0, 0, 0, 0
+};
+
+
+//
+// Parameter
+//
+
+const PPER_Type PerBench_Parameter_id_FieldTable = {
+  "id", PPER_Type::e_Integer, PASN_Object::FixedConstraint, false, 0, 65535U, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Parameter_value_FieldTable = {
+  "value", PPER_Type::e_OctetString, PASN_Object::FixedConstraint, false, 0, 255U, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Field PerBench_Parameter_Fields[] = {
+  { "id", &PerBench_Parameter_id_FieldTable, -1 },
+  { "value", &PerBench_Parameter_value_FieldTable, 0 },
+  { NULL, NULL, -1 }
+};
+
+const PPER_Type PerBench_Parameter_Table = {
+  "Parameter", PPER_Type::e_Sequence, PASN_Object::Unconstrained, true, 0, UINT_MAX, 2, 1, 0, PerBench_Parameter_Fields,
+  NULL, 0, 0, 0, 0
+};
+
+
+//
+// ArrayOf_Parameter
+//
+
+const PPER_Field PerBench_ArrayOf_Parameter_Fields[] = {
+  { "", &PerBench_Parameter_Table, -1 },
+  { NULL, NULL, -1 }
+};
+
+const PPER_Type PerBench_ArrayOf_Parameter_Table = {
+  "ArrayOf_Parameter", PPER_Type::e_Array, PASN_Object::Unconstrained, false, 0, UINT_MAX, 0, 0, 0, PerBench_ArrayOf_Parameter_Fields,
+  NULL, 0, 0, 0, 0
+};
+
+
+//
+// Message
+//
+
+const PPER_Type PerBench_Message_sequenceNumber_FieldTable = {
+  "sequenceNumber", PPER_Type::e_Integer, PASN_Object::FixedConstraint, false, 0, 65535U, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Message_flags_FieldTable = {
+  "flags", PPER_Type::e_BitString, PASN_Object::FixedConstraint, false, 8, 8U, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Message_timeOffset_FieldTable = {
+  "timeOffset", PPER_Type::e_Integer, PASN_Object::FixedConstraint, false, -1000, 1000U, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Message_displayName_FieldTable = {
+  "displayName", PPER_Type::e_BMPString, PASN_Object::FixedConstraint, false, 0, 32U, 0, 0, 0, NULL,
+  NULL, 0, 16, 16, 16
+};
+
+const PPER_Type PerBench_Message_dialled_FieldTable = {
+  "dialled", PPER_Type::e_String, PASN_Object::FixedConstraint, false, 1, 32U, 0, 0, 0, NULL,
+  "#*0123456789ABCD", 16, 4, 4, 7
+};
+
+const PPER_Type PerBench_Message_parameters_FieldTable = {
+  "parameters", PPER_Type::e_Array, PASN_Object::FixedConstraint, false, 0, 16U, 0, 0, 0, PerBench_ArrayOf_Parameter_Fields,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Message_token_FieldTable = {
+  "token", PPER_Type::e_OctetString, PASN_Object::Unconstrained, false, 0, UINT_MAX, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Message_count_FieldTable = {
+  "count", PPER_Type::e_Integer, PASN_Object::Unconstrained, false, 0, UINT_MAX, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Message_priority_FieldTable = {
+  "priority", PPER_Type::e_Integer, PASN_Object::FixedConstraint, false, 0, 7U, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Type PerBench_Message_urgent_FieldTable = {
+  "urgent", PPER_Type::e_Boolean, PASN_Object::Unconstrained, false, 0, UINT_MAX, 0, 0, 0, NULL,
+  NULL, 0, 0, 0, 0
+};
+
+const PPER_Field PerBench_Message_Fields[] = {
+  { "sequenceNumber", &PerBench_Message_sequenceNumber_FieldTable, -1 },
+  { "kind", &PerBench_Kind_Table, -1 },
+  { "source", &PerBench_Address_Table, -1 },
+  { "destination", &PerBench_Address_Table, 0 },
+  { "flags", &PerBench_Message_flags_FieldTable, -1 },
+  { "timeOffset", &PerBench_Message_timeOffset_FieldTable, -1 },
+  { "displayName", &PerBench_Message_displayName_FieldTable, 1 },
+  { "dialled", &PerBench_Message_dialled_FieldTable, 2 },
+  { "parameters", &PerBench_Message_parameters_FieldTable, -1 },
+  { "token", &PerBench_Message_token_FieldTable, 3 },
+  { "count", &PerBench_Message_count_FieldTable, 4 },
+  { "priority", &PerBench_Message_priority_FieldTable, -1 },
+  { "urgent", &PerBench_Message_urgent_FieldTable, -1 },
+  { NULL, NULL, -1 }
+};
+
+const PPER_Type PerBench_Message_Table = {
+  "Message", PPER_Type::e_Sequence, PASN_Object::Unconstrained, true, 0, UINT_MAX, 11, 5, 2, PerBench_Message_Fields,
+  NULL, 0, 0, 0, 0
+};
+
+
+#endif // if ! H323_DISABLE_PERBENCH
+
+
+// End of perbench_per.cxx
@@ -225,6 +225,7 @@ protected:
   void ContinuousStopOnTimeoutTest();
   void OneShotToContinuousSwitchTest();
   void ContinuousRestartInTimeout();
+  void BenchmarkTest(unsigned totalTimers);
 
   /**First internal timer that we manage */
   PTimer firstTimer;
@@ -276,6 +277,8 @@ void PTimerTest::Main()
              "r-restart.   A test which repeatedly restarts two internal timers.\n"
              "x-stress.    A test create 10 timers and change it repeatedly from 1000 threads\n"
              "g-stoptest.  Measure Stop() time for many timers.\n"
+             "b-benchmark: Measure dispatch lateness and CPU usage for a comma\n"
+             "             separated list of timer counts, e.g. 10000,100000,1000000\n"
              PTRACE_ARGLIST
   );
   PTRACE_INITIALISE(args);
@@ -290,6 +293,13 @@ void PTimerTest::Main()
     return;
   }
 
+  if (args.HasOption('b')) {
+    PStringArray counts = args.GetOptionString('b').Tokenise(",");
+    for (PINDEX i = 0; i < counts.GetSize(); ++i)
+      BenchmarkTest(counts[i].AsUnsigned());
+    return;
+  }
+
   PullCheck();
   CallbackCheck();
   StartStopTest();
@@ -772,6 +782,79 @@ void PTimerTest::MultiTimerTest()
 
 ////////////////////////////////////////////////////////////////////////////////
 
+class BenchmarkTimer : public PTimer
+{
+  PAtomicInteger & m_runningCount;
+  public:
+    PTimeInterval m_expected;
+    PTimeInterval m_lateness;
+
+    BenchmarkTimer(PAtomicInteger & runningCount)
+      : m_runningCount(runningCount)
+    {
+    }
+
+    void Start(const PTimeInterval & delay)
+    {
+      m_expected = PTimer::Tick() + delay;
+      SetInterval(delay.GetMilliSeconds());
+    }
+
+    void OnTimeout()
+    {
+      m_lateness = PTimer::Tick() - m_expected;
+      --m_runningCount;
+    }
+};
+
+void PTimerTest::BenchmarkTest(unsigned totalTimers)
+{
+  if (totalTimers == 0)
+    return;
+
+  cout << "Benchmark: " << totalTimers << " timers, expiring randomly over 2 to 10 seconds." << endl;
+
+  PAtomicInteger runningCount(totalTimers);
+  std::vector<BenchmarkTimer *> timers(totalTimers);
+  for (unsigned i = 0; i < totalTimers; ++i)
+    timers[i] = new BenchmarkTimer(runningCount);
+
+  PProcess::Times startTimes;
+  GetProcessTimes(startTimes);
+  PTimeInterval startTick = PTimer::Tick();
+
+  for (unsigned i = 0; i < totalTimers; ++i)
+    timers[i]->Start(PTimeInterval(PRandom::Number(2000, 10000)));
+
+  PTimeInterval startDuration = PTimer::Tick() - startTick;
+
+  while (runningCount > 0)
+    PThread::Sleep(100);
+
+  PProcess::Times endTimes;
+  GetProcessTimes(endTimes);
+  PTimeInterval elapsed = PTimer::Tick() - startTick;
+
+  PInt64 sum = 0;
+  PTimeInterval maximum;
+  for (unsigned i = 0; i < totalTimers; ++i) {
+    PTimeInterval lateness = timers[i]->m_lateness;
+    sum += lateness.GetMicroSeconds();
+    if (maximum < lateness)
+      maximum = lateness;
+    delete timers[i];
+  }
+
+  PTimeInterval cpu = (endTimes.m_user - startTimes.m_user) + (endTimes.m_kernel - startTimes.m_kernel);
+  cout << "  Start time     : " << startDuration << "s ("
+       << (startDuration.GetMicroSeconds()*1000/totalTimers) << "ns/timer)\n"
+          "  Lateness       : average " << (sum/totalTimers) << "us, maximum " << maximum << "s\n"
+          "  CPU            : " << cpu << "s in " << elapsed << "s ("
+       << (cpu.GetMilliSeconds()*100/std::max(elapsed.GetMilliSeconds(), (PInt64)1)) << "%)" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
 class SlowTimer
   : public PTimer
 {
@@ -0,0 +1,220 @@
+/*
+ * main.cxx
+ *
+ * Sample program to check and benchmark PQueueChannel modes.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptclib/qchannel.h>
+
+
+class QueueBench : public PProcess
+{
+  PCLASSINFO(QueueBench, PProcess)
+  public:
+    void Main();
+    bool Check();
+    void Bench(PQueueChannel::Modes mode, bool zeroCopy, const char * name);
+    void Writer();
+    void Reader();
+    void Monitor();
+
+  protected:
+    PQueueChannel * m_queue;
+    bool            m_zeroCopy;
+    PINDEX          m_frames;
+    PINDEX          m_frameSize;
+    PBYTEArray      m_pattern;
+    bool            m_failed;
+    atomic<bool>    m_monitoring;
+};
+
+PCREATE_PROCESS(QueueBench);
+
+
+void QueueBench::Writer()
+{
+  PUInt64 offset = 0;
+  for (PINDEX frame = 0; frame < m_frames && !m_failed; ++frame) {
+    if (!m_zeroCopy) {
+      if (!m_queue->Write(m_pattern.GetPointer() + offset%251, m_frameSize)) {
+        cout << "Write failed: " << m_queue->GetErrorText(PChannel::LastWriteError) << endl;
+        m_failed = true;
+      }
+      offset += m_frameSize;
+      continue;
+    }
+
+    // May take two goes if the frame straddles the end of the ring
+    PINDEX remaining = m_frameSize;
+    while (remaining > 0) {
+      PINDEX size = remaining;
+      BYTE * space = m_queue->ReserveWrite(size);
+      if (space == NULL) {
+        cout << "ReserveWrite failed: " << m_queue->GetErrorText(PChannel::LastWriteError) << endl;
+        m_failed = true;
+        break;
+      }
+      memcpy(space, m_pattern.GetPointer() + offset%251, size);
+      m_queue->CommitWrite(size);
+      offset += size;
+      remaining -= size;
+    }
+  }
+}
+
+
+void QueueBench::Reader()
+{
+  std::vector<BYTE> buffer(m_frameSize);
+  PUInt64 total = (PUInt64)m_frames*m_frameSize;
+  PUInt64 offset = 0;
+  while (offset < total && !m_failed) {
+    const BYTE * data;
+    PINDEX size = m_frameSize;
+    if (m_zeroCopy)
+      data = m_queue->PeekRead(size);
+    else if (m_queue->Read(&buffer[0], size)) {
+      data = &buffer[0];
+      size = m_queue->GetLastReadCount();
+    }
+    else
+      data = NULL;
+
+    if (data == NULL) {
+      cout << "Read failed at " << offset << ": " << m_queue->GetErrorText(PChannel::LastReadError) << endl;
+      m_failed = true;
+      break;
+    }
+
+    if (memcmp(data, m_pattern.GetPointer() + offset%251, size) != 0) {
+      cout << "Data incorrect at " << offset << endl;
+      m_failed = true;
+    }
+
+    if (m_zeroCopy)
+      m_queue->ConsumeRead(size);
+    offset += size;
+  }
+}
+
+
+void QueueBench::Monitor()
+{
+  // A third thread sees both positions moving, length must stay in range
+  while (m_monitoring) {
+    PINDEX length = m_queue->GetLength();
+    if (length < 0 || length > m_queue->GetSize()) {
+      cout << "Queue length " << length << " out of range" << endl;
+      m_failed = true;
+      break;
+    }
+  }
+}
+
+
+bool QueueBench::Check()
+{
+  PQueueChannel queue(1000, PQueueChannel::SingleProducerConsumer);
+  queue.SetReadTimeout(5000);
+  queue.SetWriteTimeout(5000);
+  m_queue = &queue;
+  m_zeroCopy = false;
+  m_failed = false;
+  m_monitoring = true;
+
+  PThread * monitor = new PThreadObj<QueueBench>(*this, &QueueBench::Monitor, false, "Monitor");
+  PThread * reader = new PThreadObj<QueueBench>(*this, &QueueBench::Reader, false, "Reader");
+  Writer();
+  reader->WaitForTermination();
+  delete reader;
+  m_monitoring = false;
+  monitor->WaitForTermination();
+  delete monitor;
+
+  return !m_failed;
+}
+
+
+void QueueBench::Bench(PQueueChannel::Modes mode, bool zeroCopy, const char * name)
+{
+  PQueueChannel queue(10000, mode);
+  queue.SetReadTimeout(5000);
+  queue.SetWriteTimeout(5000);
+  m_queue = &queue;
+  m_zeroCopy = zeroCopy;
+  m_failed = false;
+
+  PTimeInterval start = PTimer::Tick();
+  PThread * thread = new PThreadObj<QueueBench>(*this, &QueueBench::Reader, false, "Reader");
+  Writer();
+  thread->WaitForTermination();
+  delete thread;
+  PTimeInterval elapsed = PTimer::Tick() - start;
+
+  cout << name << setw(10) << (PUInt64)(m_frames*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1))
+       << setw(10) << (elapsed.GetMicroSeconds()*1000/std::max(m_frames, (PINDEX)1))
+       << (m_failed ? "  FAILED" : "") << endl;
+}
+
+
+void QueueBench::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("n-frames: Number of frames to pass through the queue, default 1000000\n"
+             "s-size: Size of each frame, default 320 (20ms of 8kHz 16 bit audio)\n"
+             "h-help.     This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  m_frames = args.GetOptionAs('n', (PINDEX)1000000);
+  m_frameSize = std::max(args.GetOptionAs('s', (PINDEX)320), (PINDEX)1);
+
+  // Stream byte N is N%251, so any lost, repeated or reordered byte shows up
+  m_pattern.SetSize(m_frameSize + 251);
+  for (PINDEX i = 0; i < m_pattern.GetSize(); ++i)
+    m_pattern[i] = (BYTE)(i % 251);
+
+  if (!Check()) {
+    SetTerminationValue(1);
+    return;
+  }
+  cout << "Queue checks passed." << endl;
+
+  cout << m_frames << " frames of " << m_frameSize << " bytes, writer and reader thread\n"
+          "Mode                     Frames/s  ns/frame" << endl;
+
+  Bench(PQueueChannel::MultipleProducerConsumer, false, "Mutex, Read/Write      ");
+  Bench(PQueueChannel::SingleProducerConsumer,   false, "Lock free, Read/Write  ");
+  Bench(PQueueChannel::SingleProducerConsumer,   true,  "Lock free, zero copy   ");
+
+  if (m_failed)
+    SetTerminationValue(1);
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////
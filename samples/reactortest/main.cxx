@@ -0,0 +1,418 @@
+/*
+ * main.cxx
+ *
+ * Sample program to check and benchmark the socket reactor.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptlib/sockets.h>
+#include <ptclib/sockreactor.h>
+
+
+#if P_HAS_EPOLL
+
+class TestSocket : public PUDPSocket
+{
+  PCLASSINFO(TestSocket, PUDPSocket);
+  public:
+    TestSocket()
+      : m_received(0)
+      , m_inNotifier(false)
+      , m_removed(false)
+      , m_removeInNotifier(false)
+      , m_shutdownInNotifier(false)
+      , m_delay(0)
+    { }
+
+    atomic<unsigned> m_received;
+    atomic<bool>     m_inNotifier;
+    atomic<bool>     m_removed;          // Set after Remove() has returned
+    atomic<bool>     m_removeInNotifier;
+    atomic<bool>     m_shutdownInNotifier;
+    atomic<unsigned> m_delay;            // Milliseconds to stay in the notifier
+};
+
+
+class ReactorTest : public PProcess
+{
+  PCLASSINFO(ReactorTest, PProcess)
+  public:
+    void Main();
+    bool Check(unsigned threads);
+    bool CheckShutdown(unsigned threads);
+    void Bench(unsigned socketCount, unsigned threads, unsigned datagrams);
+
+  protected:
+    bool Open(unsigned count);
+    void Close();
+    void Send(PINDEX index, unsigned count = 1);
+    unsigned GetTotalReceived() const;
+    bool WaitFor(unsigned expected, const PTimeInterval & timeout) const;
+    void SendThread();
+
+    PDECLARE_SocketReactorNotifier(ReactorTest, OnReadable);
+
+    PSocketReactor            * m_reactor;
+    PUDPSocket                  m_sender;
+    std::vector<TestSocket *>   m_sockets;
+    std::vector<PIPSocketAddressAndPort> m_addresses;
+    atomic<unsigned>            m_callbacks;
+    atomic<bool>                m_overlapped;
+    atomic<bool>                m_calledAfterRemove;
+    atomic<bool>                m_sending;
+};
+
+PCREATE_PROCESS(ReactorTest);
+
+
+void ReactorTest::OnReadable(PChannel & channel, PSocketReactor::Events)
+{
+  TestSocket & socket = dynamic_cast<TestSocket &>(channel);
+
+  // One shot, so never two threads in here for the same socket
+  if (socket.m_inNotifier.exchange(true))
+    m_overlapped = true;
+  if (socket.m_removed)
+    m_calledAfterRemove = true;
+  ++m_callbacks;
+
+  BYTE buffer[100];
+  while (socket.Read(buffer, sizeof(buffer)))
+    ++socket.m_received;
+
+  if (socket.m_delay > 0)
+    PThread::Sleep((unsigned)socket.m_delay);
+
+  if (socket.m_removeInNotifier) {
+    m_reactor->Remove(socket);
+    socket.m_removed = true;
+  }
+
+  if (socket.m_shutdownInNotifier) {
+    m_reactor->Shutdown();
+    socket.m_shutdownInNotifier = false;
+  }
+
+  socket.m_inNotifier = false;
+}
+
+
+bool ReactorTest::Open(unsigned count)
+{
+  if (!m_sender.Listen(PIPSocket::Address::GetLoopback(4), 0, 0)) {
+    cout << "Could not open sender: " << m_sender.GetErrorText() << endl;
+    return false;
+  }
+
+  m_callbacks = 0;
+  m_overlapped = false;
+  m_calledAfterRemove = false;
+
+  for (unsigned i = 0; i < count; ++i) {
+    TestSocket * socket = new TestSocket;
+    m_sockets.push_back(socket);
+    if (!socket->Listen(PIPSocket::Address::GetLoopback(4), 0, 0)) {
+      cout << "Could not open socket: " << socket->GetErrorText() << endl;
+      return false;
+    }
+    socket->SetOption(SO_RCVBUF, 1024*1024);
+    socket->SetReadTimeout(0);
+
+    PIPSocketAddressAndPort ap;
+    socket->GetLocalAddress(ap);
+    m_addresses.push_back(ap);
+
+    if (!m_reactor->Add(*socket, PSocketReactor::ReadEvent, PCREATE_SocketReactorNotifier(OnReadable))) {
+      cout << "Could not add socket to reactor" << endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+
+void ReactorTest::Close()
+{
+  for (size_t i = 0; i < m_sockets.size(); ++i) {
+    m_reactor->Remove(*m_sockets[i]);
+    delete m_sockets[i];
+  }
+  m_sockets.clear();
+  m_addresses.clear();
+  m_sender.Close();
+}
+
+
+void ReactorTest::Send(PINDEX index, unsigned count)
+{
+  static BYTE const data[20] = { 0 };
+  for (unsigned i = 0; i < count; ++i)
+    m_sender.WriteTo(data, sizeof(data), m_addresses[index]);
+}
+
+
+unsigned ReactorTest::GetTotalReceived() const
+{
+  unsigned total = 0;
+  for (size_t i = 0; i < m_sockets.size(); ++i)
+    total += m_sockets[i]->m_received;
+  return total;
+}
+
+
+bool ReactorTest::WaitFor(unsigned expected, const PTimeInterval & timeout) const
+{
+  PSimpleTimer timer(timeout);
+  while (GetTotalReceived() < expected) {
+    if (timer.HasExpired())
+      return false;
+    PThread::Sleep(1);
+  }
+  return true;
+}
+
+
+void ReactorTest::SendThread()
+{
+  while (m_sending) {
+    for (PINDEX i = 0; i < (PINDEX)m_addresses.size(); ++i)
+      Send(i);
+    PThread::Sleep(1);
+  }
+}
+
+
+bool ReactorTest::Check(unsigned threads)
+{
+  static unsigned const SocketCount = 50;
+  static unsigned const PerSocket = 10;
+
+  PSocketReactor reactor(threads);
+  m_reactor = &reactor;
+
+  bool ok = Open(SocketCount);
+
+  // Every socket gets a callback and all its data
+  if (ok) {
+    for (PINDEX i = 0; i < (PINDEX)SocketCount; ++i)
+      Send(i, PerSocket);
+    if (!WaitFor(SocketCount*PerSocket, 5000)) {
+      cout << "Only received " << GetTotalReceived() << " of " << SocketCount*PerSocket << endl;
+      ok = false;
+    }
+  }
+
+  // Remove while the notifier is running in a reactor thread, must wait for it
+  if (ok) {
+    TestSocket & socket = *m_sockets[0];
+    socket.m_delay = 200;
+    Send(0);
+    PSimpleTimer timer(5000);
+    while (!socket.m_inNotifier && !timer.HasExpired())
+      PThread::Sleep(1);
+    if (!socket.m_inNotifier) {
+      cout << "Notifier not called for delayed socket" << endl;
+      ok = false;
+    }
+    else if (!reactor.Remove(socket) || socket.m_inNotifier) {
+      cout << "Remove returned while notifier still running" << endl;
+      ok = false;
+    }
+    socket.m_removed = true;
+  }
+
+  // Remove from within the notifier itself
+  if (ok) {
+    TestSocket & socket = *m_sockets[1];
+    socket.m_removeInNotifier = true;
+    Send(1);
+    PSimpleTimer timer(5000);
+    while (!socket.m_removed && !timer.HasExpired())
+      PThread::Sleep(1);
+    if (!socket.m_removed) {
+      cout << "Notifier did not remove its own socket" << endl;
+      ok = false;
+    }
+  }
+
+  // Neither of those may be called again
+  if (ok) {
+    unsigned received0 = m_sockets[0]->m_received, received1 = m_sockets[1]->m_received;
+    Send(0, 5);
+    Send(1, 5);
+    PThread::Sleep(200);
+    if (m_sockets[0]->m_received != received0 || m_sockets[1]->m_received != received1) {
+      cout << "Notifier called for removed socket" << endl;
+      ok = false;
+    }
+  }
+
+  // Remove the rest, with callbacks constantly arriving in all threads
+  if (ok) {
+    m_sending = true;
+    PThread * sender = new PThreadObj<ReactorTest>(*this, &ReactorTest::SendThread, false, "Sender");
+    PThread::Sleep(50);
+
+    for (size_t i = 2; i < m_sockets.size(); ++i) {
+      m_sockets[i]->m_delay = i%3;
+      if (!reactor.Remove(*m_sockets[i])) {
+        cout << "Could not remove socket " << i << endl;
+        ok = false;
+      }
+      m_sockets[i]->m_removed = true;
+      PThread::Sleep(i%5);
+    }
+
+    PThread::Sleep(50);
+    m_sending = false;
+    sender->WaitForTermination();
+    delete sender;
+
+    if (reactor.GetCount() != 0) {
+      cout << reactor.GetCount() << " sockets still registered" << endl;
+      ok = false;
+    }
+  }
+
+  if (m_overlapped) {
+    cout << "Notifier called concurrently for the same socket" << endl;
+    ok = false;
+  }
+  if (m_calledAfterRemove) {
+    cout << "Notifier called after Remove() returned" << endl;
+    ok = false;
+  }
+
+  Close();
+  return ok;
+}
+
+
+bool ReactorTest::CheckShutdown(unsigned threads)
+{
+  // Shutdown() from a notifier must not wait for, or delete, its own thread
+  bool ok;
+  {
+    PSocketReactor reactor(threads);
+    m_reactor = &reactor;
+
+    ok = Open(1);
+    if (ok) {
+      TestSocket & socket = *m_sockets[0];
+      socket.m_shutdownInNotifier = true;
+      Send(0);
+      PSimpleTimer timer(5000);
+      while (socket.m_shutdownInNotifier && !timer.HasExpired())
+        PThread::Sleep(1);
+      if (socket.m_shutdownInNotifier) {
+        cout << "Notifier did not shut down reactor" << endl;
+        ok = false;
+      }
+      // Let the thread get out of the notifier before the reactor is destroyed
+      PThread::Sleep(50);
+    }
+    Close();
+  }
+  return ok;
+}
+
+
+void ReactorTest::Bench(unsigned socketCount, unsigned threads, unsigned datagrams)
+{
+  PSocketReactor reactor(threads);
+  m_reactor = &reactor;
+
+  if (Open(socketCount)) {
+    unsigned perSocket = std::max(datagrams/socketCount, 1U);
+    unsigned total = 0;
+
+    PTimeInterval start = PTimer::Tick();
+    for (unsigned sent = 0; sent < perSocket; sent += 10) {
+      for (PINDEX i = 0; i < (PINDEX)socketCount; ++i)
+        Send(i, std::min(perSocket - sent, 10U));
+      total += std::min(perSocket - sent, 10U)*socketCount;
+      // Do not get too far ahead and overflow the socket buffers
+      WaitFor(total - total/10, 1000);
+    }
+    bool complete = WaitFor(total, 5000);
+    PTimeInterval elapsed = PTimer::Tick() - start;
+
+    cout << setw(7) << socketCount << setw(8) << threads
+         << setw(12) << (PUInt64)(GetTotalReceived()*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1))
+         << setw(12) << (unsigned)(GetTotalReceived()/std::max((unsigned)m_callbacks, 1U))
+         << (complete ? "" : "  (lost datagrams)") << endl;
+  }
+
+  Close();
+}
+
+
+void ReactorTest::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("n-datagrams: Number of datagrams for each benchmark, default 200000\n"
+             "h-help.     This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  static unsigned const Threads[] = { 1, 4 };
+  for (PINDEX t = 0; t < PARRAYSIZE(Threads); ++t) {
+    if (!Check(Threads[t]) || !CheckShutdown(Threads[t])) {
+      cout << "Reactor checks with " << Threads[t] << " threads failed." << endl;
+      SetTerminationValue(1);
+      return;
+    }
+  }
+  cout << "Reactor checks passed." << endl;
+
+  unsigned datagrams = args.GetOptionAs('n', 200000U);
+  cout << "Loopback UDP, " << datagrams << " datagrams\n"
+          "Sockets Threads  Datagram/s  Per callback" << endl;
+
+  static unsigned const SocketCounts[] = { 10, 100, 500 };
+  for (PINDEX s = 0; s < PARRAYSIZE(SocketCounts); ++s) {
+    for (PINDEX t = 0; t < PARRAYSIZE(Threads); ++t)
+      Bench(SocketCounts[s], Threads[t], datagrams);
+  }
+}
+
+#else
+
+class ReactorTest : public PProcess
+{
+  PCLASSINFO(ReactorTest, PProcess)
+  public:
+    void Main() { cout << "Socket reactor not available on this platform." << endl; }
+};
+
+PCREATE_PROCESS(ReactorTest);
+
+#endif // P_HAS_EPOLL
+
+
+// End of File ///////////////////////////////////////////////////////////////
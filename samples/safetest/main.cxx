@@ -57,6 +57,13 @@ void SafeTest::Main()
 	     "r-reporting."
 	     "b-banpthreadcreate."
 	     "a-alternate."
+	     "m-mutex-benchmark."
+	     "g-gc-benchmark."
+	     "s-sweep-benchmark."
+	     "R-reference-benchmark."
+	     "T-threads:"
+	     "n-iterations:"
+	     "w-write-interval:"
 #if PTRACING
              "o-output:"             "-no-output."
              "t-trace."              "-no-trace."
@@ -87,6 +94,13 @@ void SafeTest::Main()
            << "-h  or --help         print this help" << endl
 	   << "-r                    print reporting (every minute) on current statistics" << endl
            << "-v  or --version      print version info" << endl
+           << "-m  or --mutex-benchmark  time PReadWriteMutex algorithms and exit" << endl
+           << "-T  or --threads ##   number of threads for benchmark, default 4" << endl
+           << "-g  or --gc-benchmark time PSafeCollection object deletion and exit" << endl
+           << "-R  or --reference-benchmark time PSafePtr references to one object from 1 to -T threads and exit" << endl
+           << "-s  or --sweep-benchmark time PSafePtr enumeration of 1000, 10000 and 100000 objects and exit" << endl
+           << "-n  or --iterations ##  number of read locks per thread, or objects, for benchmark, default 1000000" << endl
+           << "-w  or --write-interval ##  read locks between each write lock for benchmark, default 1000" << endl
            << "-d  or --delay ##     where ## specifies how many milliseconds the created thread waits for" << endl
 	   << "-c  or --count ##     where ## specifies the number of active threads allowed " << endl
 #if PTRACING
@@ -98,11 +112,34 @@ void SafeTest::Main()
     return;
   }
 
+  if (args.HasOption('m')) {
+    MutexBenchmark(args.GetOptionAs('T', 4U), args.GetOptionAs('n', 1000000U), args.GetOptionAs('w', 1000U));
+    return;
+  }
+
+  if (args.HasOption('g')) {
+    GarbageBenchmark(args.GetOptionAs('n', 10000U));
+    return;
+  }
+
+  if (args.HasOption('R')) {
+    ReferenceBenchmark(args.GetOptionAs('T', 4U), args.GetOptionAs('n', 1000000U));
+    return;
+  }
+
+  if (args.HasOption('s')) {
+    for (unsigned count = 1000; count <= 100000; count *= 10) {
+      SweepBenchmark< PSafeList<SweepObject> >("PSafeList      ", count);
+      SweepBenchmark< PSafeSortedList<SweepObject> >("PSafeSortedList", count);
+    }
+    return;
+  }
+
   delay = 2000;
   if (args.HasOption('d'))
     delay = args.GetOptionString('d').AsInteger();
 
-  delay = PMIN(1000000, PMAX(1, delay));
+  delay = PMIN((PINDEX)1000000, PMAX((PINDEX)1, delay));
   cout << "Created thread will wait for " << delay << " milliseconds before ending" << endl;
 
   useOnThreadEnd = args.HasOption('a');
@@ -126,7 +163,7 @@ void SafeTest::Main()
   activeCount = 10;
   if (args.HasOption('c'))
     activeCount = args.GetOptionString('c').AsInteger();
-  activeCount = PMIN(100, PMAX(1, activeCount));
+  activeCount = PMIN((PINDEX)100, PMAX((PINDEX)1, activeCount));
   cout << "There will be " << activeCount << " threads in operation" << endl;
 
   delayThreadsActive.SetAutoDeleteObjects();
@@ -141,6 +178,214 @@ void SafeTest::Main()
   PThread::Sleep(delay * 2);
 }
 
+void SafeTest::MutexBenchmark(unsigned threadCount, unsigned iterations, unsigned writeInterval)
+{
+  cout << "Benchmarking " << threadCount << " threads, each doing " << iterations
+       << " nested read locks, with a write lock every " << writeInterval << endl;
+
+  static const struct {
+    PReadWriteMutex::Algorithm algorithm;
+    const char               * name;
+  } Algorithms[] = {
+    { PReadWriteMutex::StandardAlgorithm, "Standard" },
+    { PReadWriteMutex::FastAlgorithm,     "Fast    " }
+  };
+
+  for (PINDEX alg = 0; alg < PARRAYSIZE(Algorithms); ++alg) {
+    PReadWriteMutex mutex(Algorithms[alg].algorithm);
+
+    std::vector<MutexBenchmarkThread *> threads;
+    PTime start;
+    for (unsigned i = 0; i < threadCount; ++i)
+      threads.push_back(new MutexBenchmarkThread(mutex, iterations, writeInterval));
+    for (unsigned i = 0; i < threadCount; ++i) {
+      threads[i]->WaitForTermination();
+      delete threads[i];
+    }
+    PTimeInterval elapsed = PTime() - start;
+
+    cout << Algorithms[alg].name << ": " << elapsed << " seconds, "
+         << (elapsed.GetMicroSeconds()*1000/((PInt64)threadCount*iterations)) << "ns per lock" << endl;
+  }
+}
+
+
+MutexBenchmarkThread::MutexBenchmarkThread(PReadWriteMutex & _mutex, unsigned _iterations, unsigned _writeInterval)
+  : PThread(10000, NoAutoDeleteThread, NormalPriority, "Benchmark")
+  , mutex(_mutex)
+  , iterations(_iterations)
+  , writeInterval(std::max(_writeInterval, 1U))
+{
+  Resume();
+}
+
+
+void MutexBenchmarkThread::Main()
+{
+  for (unsigned i = 0; i < iterations; ++i) {
+    if (i % writeInterval == 0) {
+      PWriteWaitAndSignal lock(mutex);
+    }
+    else {
+      PReadWaitAndSignal lock(mutex);
+      PReadWaitAndSignal nested(mutex);
+    }
+  }
+}
+
+
+void SafeTest::ReferenceBenchmark(unsigned threadCount, unsigned iterations)
+{
+  cout << "Benchmarking up to " << threadCount << " threads, each taking " << iterations
+       << " references to the same object" << endl;
+
+  SweepObject object(0);
+  object.SafeReference();
+
+  for (unsigned count = 1; count <= threadCount; count *= 2) {
+    for (int readOnly = 0; readOnly < 2; ++readOnly) {
+      std::vector<ReferenceBenchmarkThread *> threads;
+      PTime start;
+      for (unsigned i = 0; i < count; ++i)
+        threads.push_back(new ReferenceBenchmarkThread(object, iterations, readOnly ? PSafeReadOnly : PSafeReference));
+      for (unsigned i = 0; i < count; ++i) {
+        threads[i]->WaitForTermination();
+        delete threads[i];
+      }
+      PTimeInterval elapsed = PTime() - start;
+
+      cout << setw(3) << count << (readOnly ? " threads, read lock: " : " threads, reference: ")
+           << elapsed << " seconds, "
+           << (elapsed.GetMicroSeconds()*1000/((PInt64)count*iterations*2)) << "ns per PSafePtr" << endl;
+    }
+  }
+
+  if (object.GetSafeReferenceCount() != 1)
+    cout << "FAILED: reference count " << object.GetSafeReferenceCount() << ", expected 1" << endl;
+  object.SafeDereference();
+}
+
+
+ReferenceBenchmarkThread::ReferenceBenchmarkThread(PSafeObject & _object, unsigned _iterations, PSafetyMode _mode)
+  : PThread(10000, NoAutoDeleteThread, NormalPriority, "Benchmark")
+  , object(_object)
+  , iterations(_iterations)
+  , mode(_mode)
+{
+  Resume();
+}
+
+
+void ReferenceBenchmarkThread::Main()
+{
+  for (unsigned i = 0; i < iterations; ++i) {
+    PSafePtr<PSafeObject> ptr(&object, mode);
+    PSafePtr<PSafeObject> copy(ptr);
+  }
+}
+
+
+atomic<unsigned> GarbageObject::deleted(0);
+
+void SafeTest::GarbageBenchmark(unsigned count)
+{
+  cout << "Benchmarking removal of " << count << " objects, one in ten still referenced" << endl;
+
+  for (int autoDelete = 0; autoDelete < 2; ++autoDelete) {
+    GarbageObject::deleted = 0;
+    PSafeDictionary<POrdinalKey, GarbageObject> list;
+    if (autoDelete)
+      list.SetAutoDeleteObjects();
+
+    std::vector< PSafePtr<GarbageObject> > held;
+    for (unsigned i = 0; i < count; ++i) {
+      GarbageObject * obj = new GarbageObject;
+      list.SetAt(i, obj);
+      if (i % 10 == 0)
+        held.push_back(PSafePtr<GarbageObject>(obj, PSafeReference));
+    }
+
+    PTimeInterval start = PTimer::Tick();
+    list.RemoveAll();
+    if (!autoDelete)
+      list.DeleteObjectsToBeRemoved(); // With referenced objects still interleaved
+
+    PSafeCollection::GarbageStatistics stats = list.GetGarbageStatistics();
+    cout << (autoDelete ? "Background: " : "Explicit  : ")
+         << "removed in " << (PTimer::Tick() - start) << "s, "
+         << stats.m_pendingReferenced << " referenced, "
+         << stats.m_pendingDeletion << " pending" << endl;
+
+    held.clear();
+
+    // Wait for everything to go, either by the reclaimer thread or ourselves
+    while (autoDelete ? list.GetGarbageStatistics().m_pendingDeletion > 0 : !list.DeleteObjectsToBeRemoved())
+      PThread::Sleep(1);
+    PTimeInterval elapsed = PTimer::Tick() - start;
+
+    stats = list.GetGarbageStatistics();
+    cout << "            deleted in " << elapsed << "s, "
+         << (elapsed.GetMicroSeconds()*1000/std::max(count, 1U)) << "ns per object, latency average "
+         << stats.m_averageLatency.GetMicroSeconds() << "us, maximum "
+         << stats.m_maximumLatency.GetMicroSeconds() << "us" << endl;
+
+    if (GarbageObject::deleted != count || stats.m_reclaimed != count || stats.m_pendingReferenced != 0)
+      cout << "            FAILED: " << GarbageObject::deleted << " deleted, "
+           << stats.m_reclaimed << " reclaimed, expected " << count << endl;
+  }
+}
+
+
+template <class Coll> void SafeTest::SweepBenchmark(const char * name, unsigned count)
+{
+  /* PSafeColl::Append() returns a PSafePtr, which takes a copy of the whole
+     collection, so filling a large one that way would swamp the sweep time. */
+  struct Filler : public Coll
+  {
+    void Fill(unsigned count)
+    {
+      PWaitAndSignal lock(this->m_collectionMutex);
+      for (unsigned i = 0; i < count; ++i) {
+        SweepObject * obj = new SweepObject((i*7919) % count);
+        obj->SafeReference();
+        this->m_collection->Append(obj);
+      }
+    }
+  } coll;
+  coll.Fill(count);
+
+  static PSafetyMode const Modes[] = { PSafeReference, PSafeReadOnly };
+  for (PINDEX m = 0; m < PARRAYSIZE(Modes); ++m) {
+    PTimeInterval start = PTimer::Tick();
+    PSafePtr<SweepObject> ptr(coll, Modes[m]);
+    PTimeInterval copied = PTimer::Tick();
+
+    std::vector<unsigned> values;
+    values.reserve(count);
+    for (; ptr != NULL; ++ptr)
+      values.push_back(ptr->m_value);
+    PTimeInterval swept = PTimer::Tick();
+
+    // Walk back from the end, checking order matches the forward direction
+    unsigned forward = (unsigned)values.size();
+    unsigned backward = 0;
+    bool ordered = true;
+    for (ptr = PSafePtr<SweepObject>(coll, Modes[m], count-1); ptr != NULL; --ptr) {
+      ++backward;
+      if (backward > forward || ptr->m_value != values[forward-backward])
+        ordered = false;
+    }
+
+    cout << name << setw(7) << count << (Modes[m] == PSafeReference ? " reference" : " read lock")
+         << ": copy " << (copied - start) << "s, sweep " << (swept - copied) << "s, "
+         << ((swept - copied).GetMicroSeconds()*1000/std::max(count, 1U)) << "ns per step" << endl;
+
+    if (forward != count || backward != count || !ordered)
+      cout << "                 FAILED: " << forward << " forward, " << backward << " backward, expected " << count << endl;
+  }
+}
+
+
 void SafeTest::OnReleased(DelayThread & delayThread)
 {
   PString id = delayThread.GetId();
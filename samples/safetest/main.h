@@ -68,6 +68,74 @@ class ReporterThread : public PThread
   PBoolean terminateNow;
 };
 
+/////////////////////////////////////////////////////////////////////////////
+/**This class repeatedly takes nested read locks, and the occasional write
+   lock, on a shared PReadWriteMutex to measure its overhead */
+class MutexBenchmarkThread : public PThread
+{
+  PCLASSINFO(MutexBenchmarkThread, PThread);
+
+ public:
+  MutexBenchmarkThread(PReadWriteMutex & mutex, unsigned iterations, unsigned writeInterval);
+
+  /**Do the locking */
+  void Main();
+
+ protected:
+  PReadWriteMutex & mutex;
+  unsigned          iterations;
+  unsigned          writeInterval;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+/**This class repeatedly takes and releases a PSafePtr to an object shared
+   with other instances, to measure contention on the reference count */
+class ReferenceBenchmarkThread : public PThread
+{
+  PCLASSINFO(ReferenceBenchmarkThread, PThread);
+
+ public:
+  ReferenceBenchmarkThread(PSafeObject & object, unsigned iterations, PSafetyMode mode);
+
+  /**Do the referencing */
+  void Main();
+
+ protected:
+  PSafeObject & object;
+  unsigned      iterations;
+  PSafetyMode   mode;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+/**This class is a trivial safe object, counting its destruction, used to
+   measure how quickly a PSafeCollection reclaims removed objects */
+class GarbageObject : public PSafeObject
+{
+  PCLASSINFO(GarbageObject, PSafeObject);
+
+ public:
+  GarbageObject() { }
+  ~GarbageObject() { ++deleted; }
+
+  static atomic<unsigned> deleted;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+/**Object swept by the PSafePtr enumeration benchmark. */
+class SweepObject : public PSafeObject
+{
+  PCLASSINFO(SweepObject, PSafeObject);
+
+ public:
+  SweepObject(unsigned value) : m_value(value) { }
+
+  virtual Comparison Compare(const PObject & obj) const
+  { return Compare2(m_value, dynamic_cast<const SweepObject &>(obj).m_value); }
+
+  unsigned m_value;
+};
+
 /////////////////////////////////////////////////////////////////////////////
 
 /**This class is written to avoid the usage of the PThread::Create mechanism. 
@@ -324,6 +392,22 @@ class SafeTest : public PProcess
        delaythreads */
     void OnReleased(const PString & delayThreadId);
 
+    /**Time the PReadWriteMutex algorithms with the specified number of
+       threads each doing the specified number of read locks */
+    void MutexBenchmark(unsigned threadCount, unsigned iterations, unsigned writeInterval);
+
+    /**Time up to the specified number of threads, each taking and releasing
+       the specified number of references to the same object */
+    void ReferenceBenchmark(unsigned threadCount, unsigned iterations);
+
+    /**Time the removal and deletion of the specified number of objects from
+       a PSafeList, with and without the background reclaimer */
+    void GarbageBenchmark(unsigned count);
+
+    /**Time a full enumeration, both ways, of a PSafeList and PSafeSortedList
+       of the specified number of objects */
+    template <class Coll> void SweepBenchmark(const char * name, unsigned count);
+
     /**Append this DelayThread to delayThreadsActive, cause it is a valid
        and running DelayThread */
     void AppendRunning(PSafePtr<DelayThread> delayThread, PString id);
@@ -0,0 +1,256 @@
+/*
+ * main.cxx
+ *
+ * Sample program to check and benchmark PSocketSelector against PSocket::Select().
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptlib/sockets.h>
+
+
+class SelectBench : public PProcess
+{
+  PCLASSINFO(SelectBench, PProcess)
+  public:
+    void Main();
+    bool Check();
+    void Bench(unsigned socketCount, unsigned readyCount, unsigned iterations);
+    void SelectThread();
+    void CloseThread();
+
+  protected:
+    bool Open(PUDPSocket & socket, PIPSocketAddressAndPort & ap);
+
+    PSocketSelector * m_selector;
+    PChannel::Errors  m_threadResult;
+    std::vector<PUDPSocket *> m_closing;
+};
+
+PCREATE_PROCESS(SelectBench);
+
+
+bool SelectBench::Open(PUDPSocket & socket, PIPSocketAddressAndPort & ap)
+{
+  if (!socket.Listen(PIPSocket::Address::GetLoopback(4), 0, 0)) {
+    cout << "Could not open socket: " << socket.GetErrorText() << endl;
+    return false;
+  }
+
+  socket.GetLocalAddress(ap);
+  return true;
+}
+
+
+void SelectBench::SelectThread()
+{
+  PSocket::SelectList read;
+  m_threadResult = m_selector->Select(read, 2000);
+}
+
+
+void SelectBench::CloseThread()
+{
+  for (size_t i = 0; i < m_closing.size(); ++i)
+    m_closing[i]->Close();
+}
+
+
+bool SelectBench::Check()
+{
+  PUDPSocket sender, receiver1, receiver2;
+  PIPSocketAddressAndPort senderAP, receiverAP1, receiverAP2;
+  if (!Open(sender, senderAP) || !Open(receiver1, receiverAP1) || !Open(receiver2, receiverAP2))
+    return false;
+
+  bool ok = true;
+
+  // A wake up returned with ready sockets must not lose them, edge triggered would never see them again
+  {
+    PSocketSelector selector(PSocketSelector::EdgeTriggered);
+    selector.Add(receiver1);
+    selector.Add(receiver2);
+    sender.WriteTo("1", 1, receiverAP1);
+    sender.WriteTo("2", 1, receiverAP2);
+    PThread::Sleep(10);
+    selector.Interrupt();
+
+    PSocket::SelectList read;
+    PChannel::Errors result = selector.Select(read, 1000);
+    if (result != PChannel::NoError || read.GetSize() != 2) {
+      cout << "Interrupt with ready sockets: expected 2 sockets, got " << read.GetSize() << ", result=" << result << endl;
+      ok = false;
+    }
+
+    result = selector.Select(read, 0);
+    if (result != PChannel::NoError || read.GetSize() != 0) {
+      cout << "Interrupt with ready sockets: wake up not drained, result=" << result << endl;
+      ok = false;
+    }
+
+    selector.Interrupt();
+    result = selector.Select(read, 1000);
+    if (result != PChannel::Interrupted) {
+      cout << "Interrupt alone: expected Interrupted, got result=" << result << endl;
+      ok = false;
+    }
+
+    char buf[10];
+    receiver1.Read(buf, sizeof(buf));
+    receiver2.Read(buf, sizeof(buf));
+  }
+
+  // Two threads may select on the same selector
+  {
+    PSocketSelector selector;
+    selector.Add(receiver1);
+    m_selector = &selector;
+    m_threadResult = PChannel::Miscellaneous;
+    PThread * thread = new PThreadObj<SelectBench>(*this, &SelectBench::SelectThread, false, "Selector");
+    PThread::Sleep(50);
+
+    PSocket::SelectList read;
+    PChannel::Errors result = selector.Select(read, 100);
+    if (result != PChannel::NoError) {
+      cout << "Concurrent Select failed, result=" << result << endl;
+      ok = false;
+    }
+
+    sender.WriteTo("1", 1, receiverAP1);
+    thread->WaitForTermination();
+    delete thread;
+    if (m_threadResult != PChannel::NoError) {
+      cout << "Concurrent Select in thread failed, result=" << m_threadResult << endl;
+      ok = false;
+    }
+  }
+
+  // Closing registered sockets while the selector is destroyed must not crash
+  for (unsigned loop = 0; loop < 100 && ok; ++loop) {
+    PSocketSelector * selector = new PSocketSelector;
+    for (unsigned i = 0; i < 20; ++i) {
+      PUDPSocket * socket = new PUDPSocket;
+      PIPSocketAddressAndPort ap;
+      if (!Open(*socket, ap) || !selector->Add(*socket))
+        ok = false;
+      m_closing.push_back(socket);
+    }
+
+    PThread * thread = new PThreadObj<SelectBench>(*this, &SelectBench::CloseThread, false, "Closer");
+    delete selector;
+    thread->WaitForTermination();
+    delete thread;
+
+    for (size_t i = 0; i < m_closing.size(); ++i)
+      delete m_closing[i];
+    m_closing.clear();
+  }
+  if (!ok)
+    cout << "Close while destroying selector failed" << endl;
+
+  return ok;
+}
+
+
+void SelectBench::Bench(unsigned socketCount, unsigned readyCount, unsigned iterations)
+{
+  PUDPSocket sender;
+  PIPSocketAddressAndPort senderAP;
+  if (!Open(sender, senderAP))
+    return;
+
+  PArray<PUDPSocket> sockets(socketCount);
+  std::vector<PIPSocketAddressAndPort> addresses(socketCount);
+  PSocketSelector selector;
+  for (unsigned i = 0; i < socketCount; ++i) {
+    sockets.SetAt(i, new PUDPSocket);
+    if (!Open(sockets[i], addresses[i]))
+      return;
+    selector.Add(sockets[i]);
+  }
+
+  // Leave the datagrams unread, so the same sockets are ready on every call
+  for (unsigned i = 0; i < readyCount; ++i)
+    sender.WriteTo("x", 1, addresses[i*socketCount/readyCount]);
+  PThread::Sleep(10);
+
+  PSocket::SelectList read;
+  PINDEX found = 0;
+  PTime start;
+  for (unsigned n = 0; n < iterations; ++n) {
+    for (unsigned i = 0; i < socketCount; ++i)
+      read += sockets[i];
+    PSocket::Select(read, 0);
+    found += read.GetSize();
+    read.RemoveAll();
+  }
+  PTimeInterval selectTime = PTime() - start;
+  if (found != (PINDEX)(readyCount*iterations))
+    cout << "PSocket::Select() found " << found << " ready, expected " << readyCount*iterations << endl;
+
+  found = 0;
+  start.SetCurrentTime();
+  for (unsigned n = 0; n < iterations; ++n) {
+    selector.Select(read, 0);
+    found += read.GetSize();
+  }
+  PTimeInterval selectorTime = PTime() - start;
+  if (found != (PINDEX)(readyCount*iterations))
+    cout << "PSocketSelector::Select() found " << found << " ready, expected " << readyCount*iterations << endl;
+
+  cout << setw(7) << socketCount << setw(7) << readyCount
+       << setw(16) << fixed << setprecision(1) << selectTime.GetMicroSeconds()/(double)iterations
+       << setw(16) << selectorTime.GetMicroSeconds()/(double)iterations << endl;
+}
+
+
+void SelectBench::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("i-iterations: Number of Select() calls for each case, default 2000\n"
+             "r-ready: Number of ready sockets, default 5\n"
+             "h-help.     This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  if (!Check()) {
+    SetTerminationValue(1);
+    return;
+  }
+  cout << "Selector checks passed." << endl;
+
+  unsigned iterations = std::max(args.GetOptionAs('i', 2000U), 1U);
+  unsigned readyCount = std::max(args.GetOptionAs('r', 5U), 1U);
+  cout << "UDP sockets, " << iterations << " calls, microseconds per call\n"
+          "Sockets  Ready  PSocket::Select  PSocketSelector" << endl;
+
+  static unsigned const SocketCounts[] = { 10, 50, 100, 500 };
+  for (PINDEX i = 0; i < PARRAYSIZE(SocketCounts); ++i)
+    Bench(SocketCounts[i], std::min(readyCount, SocketCounts[i]), iterations);
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////
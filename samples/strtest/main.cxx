@@ -9,6 +9,7 @@
 
 #include <ptlib.h>
 #include <ptlib/pprocess.h>
+#include <ptclib/random.h>
 #include <string>
 
 ////////////////////////////////////////////////
@@ -38,7 +39,7 @@ void Test1()
   }
 #ifdef P_HAS_WCHAR
   {
-    wchar_t widestr[] = L"Hell world";
+    wchar_t widestr[] = L"Hell\x00f2 world";
     PString pstring(widestr, sizeof(widestr)/2-1);
     cout << pstring << endl;
     PWCharArray wide = pstring.AsWide();
@@ -200,6 +201,132 @@ void Test4()
   delete thread;
 }
 
+////////////////////////////////////////////////
+//
+// test #5 - PString search, check against std::string and benchmark
+//
+
+static std::string LowerCase(const std::string & str)
+{
+  std::string lower(str);
+  for (size_t i = 0; i < lower.length(); ++i)
+    lower[i] = (char)tolower(lower[i] & 0xff);
+  return lower;
+}
+
+static PINDEX ToPINDEX(size_t pos)
+{
+  return pos == std::string::npos ? P_MAX_INDEX : (PINDEX)pos;
+}
+
+static unsigned CheckSearch(const std::string & text, const char * needle, const char * cset)
+{
+  unsigned errors = 0;
+  PString cased(text.c_str());
+  PCaselessString caseless(text.c_str());
+  std::string lowerText = LowerCase(text);
+  std::string lowerNeedle = LowerCase(needle);
+  std::string lowerSet = LowerCase(cset);
+
+  for (size_t offset = 0; offset <= text.length(); offset += 1 + offset/4) {
+    if (cased.Find(needle[0], offset) != ToPINDEX(text.find(needle[0], offset)))
+      ++errors;
+    if (cased.Find(needle, offset) != ToPINDEX(text.find(needle, offset)))
+      ++errors;
+    if (cased.FindLast(needle, offset) != ToPINDEX(text.rfind(needle, offset)))
+      ++errors;
+    if (cased.FindOneOf(cset, offset) != ToPINDEX(text.find_first_of(cset, offset)))
+      ++errors;
+    if (cased.FindSpan(cset, offset) != ToPINDEX(text.find_first_not_of(cset, offset)))
+      ++errors;
+    if (caseless.Find(needle[0], offset) != ToPINDEX(lowerText.find(lowerNeedle[0], offset)))
+      ++errors;
+    if (caseless.Find(needle, offset) != ToPINDEX(lowerText.find(lowerNeedle, offset)))
+      ++errors;
+    if (caseless.FindLast(needle, offset) != ToPINDEX(lowerText.rfind(lowerNeedle, offset)))
+      ++errors;
+    if (caseless.FindOneOf(cset, offset) != ToPINDEX(lowerText.find_first_of(lowerSet, offset)))
+      ++errors;
+  }
+
+  return errors;
+}
+
+static void BenchmarkSearch(const char * name, const PString & text, PINDEX repeat)
+{
+  static const char Needle[] = "Content-Length:";
+  PCaselessString caseless(text);
+  std::string stdText((const char *)text);
+  PINDEX found = 0;
+
+  PTime start;
+  for (PINDEX i = 0; i < repeat; ++i)
+    found += text.Find(Needle);
+  PTimeInterval findTime = PTime() - start;
+
+  start.SetCurrentTime();
+  for (PINDEX i = 0; i < repeat; ++i)
+    found += caseless.Find("content-length:");
+  PTimeInterval caselessTime = PTime() - start;
+
+  start.SetCurrentTime();
+  for (PINDEX i = 0; i < repeat; ++i)
+    found += text.FindOneOf("\r\n", text.GetLength()/2);
+  PTimeInterval oneOfTime = PTime() - start;
+
+  start.SetCurrentTime();
+  for (PINDEX i = 0; i < repeat; ++i)
+    found += (PINDEX)stdText.find(Needle);
+  PTimeInterval stdTime = PTime() - start;
+
+  cout << setw(6) << name << " (" << setw(6) << text.GetLength() << " bytes): "
+          "Find=" << setw(8) << findTime.GetMicroSeconds()*1000/repeat << "ns, "
+          "caseless Find=" << setw(8) << caselessTime.GetMicroSeconds()*1000/repeat << "ns, "
+          "FindOneOf=" << setw(8) << oneOfTime.GetMicroSeconds()*1000/repeat << "ns, "
+          "std::string::find=" << setw(8) << stdTime.GetMicroSeconds()*1000/repeat << "ns"
+          "  (" << (found != 0) << ')' << endl;
+}
+
+void Test5()
+{
+  static const char Header[] = "GET /index.html HTTP/1.1\r\n"
+                               "Host: www.example.com\r\n"
+                               "User-Agent: Mozilla/5.0 (X11; Linux x86_64)\r\n"
+                               "Accept: text/html,application/xhtml+xml\r\n"
+                               "Connection: keep-alive\r\n"
+                               "content-length: 42\r\n"
+                               "\r\n";
+
+  unsigned errors = 0;
+  errors += CheckSearch(Header, "Content-Length:", "\r\n");
+  errors += CheckSearch(Header, "eP-", " :/");
+  errors += CheckSearch(Header, "1.1", "GET ");
+  errors += CheckSearch(Header, "\r\n\r\n", "aeiou");
+  errors += CheckSearch("", "x", "xy");
+
+  PRandom rand(1);
+  for (unsigned count = 0; count < 200; ++count) {
+    std::string text;
+    unsigned length = rand.Generate(0, 100);
+    for (unsigned i = 0; i < length; ++i)
+      text += "aAbB-_"[rand.Generate(0, 5)];
+    std::string needle;
+    unsigned needleLength = rand.Generate(1, 4);
+    for (unsigned i = 0; i < needleLength; ++i)
+      needle += "aAbB-_"[rand.Generate(0, 5)];
+    errors += CheckSearch(text, needle.c_str(), needle.substr(0, 2).c_str());
+  }
+  cout << "Search check " << (errors == 0 ? "passed" : "FAILED") << ", " << errors << " errors" << endl;
+
+  PString body;
+  while (body.GetLength() < 65536)
+    body += "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor. ";
+  body += Header;
+
+  BenchmarkSearch("Header", Header, 1000000);
+  BenchmarkSearch("Body", body, 5000);
+}
+
 ////////////////////////////////////////////////
 //
 // main
@@ -221,4 +348,5 @@ void StringTest::Main()
   Test2(); cout << "End of test #2\n" << endl;
   Test3(); cout << "End of test #3\n" << endl;
   Test4(); cout << "End of test #4\n" << endl;
+  Test5(); cout << "End of test #5\n" << endl;
 }
@@ -15,12 +15,146 @@ class TestSpoolDir : public PProcess
   PCLASSINFO(TestSpoolDir, PProcess)
   public:
     void Main();
+    bool Check(bool eventDriven, unsigned workers, unsigned fileCount);
 
     bool m_verbose;
 };
 
 PCREATE_PROCESS(TestSpoolDir)
 
+
+class CountingSpoolDir : public PSpoolDirectory
+{
+  public:
+    CountingSpoolDir()
+    {
+      m_scanTimeout = 200;
+    }
+
+    // The "busy" entry is skipped twice before it is processed
+    virtual bool OnProcess(const PString & entry)
+    {
+      PWaitAndSignal lock(m_countMutex);
+      return ++m_processed[entry] > 2 || entry.Find("busy") == P_MAX_INDEX;
+    }
+
+    unsigned GetTotal()
+    {
+      PWaitAndSignal lock(m_countMutex);
+      unsigned total = 0;
+      for (std::map<PString, unsigned>::iterator it = m_processed.begin(); it != m_processed.end(); ++it)
+        total += it->second;
+      return total;
+    }
+
+    PMutex m_countMutex;
+    std::map<PString, unsigned> m_processed;
+};
+
+
+static void WriteSpoolFile(const PFilePath & path)
+{
+  PFile file(path, PFile::WriteOnly);
+  file.WriteString("spooled data\n");
+}
+
+
+static bool WaitForTotal(CountingSpoolDir & spoolDir, unsigned expected, const PTimeInterval & timeout)
+{
+  PSimpleTimer timer(timeout);
+  while (spoolDir.GetTotal() < expected) {
+    if (timer.HasExpired())
+      return false;
+    PThread::Sleep(1);
+  }
+  return true;
+}
+
+
+bool TestSpoolDir::Check(bool eventDriven, unsigned workers, unsigned fileCount)
+{
+  PDirectory dir(PDirectory::GetTemporary() + PSTRSTRM("spooltest_" << GetProcessID()));
+  if (!dir.Create()) {
+    cout << "Could not create " << dir << endl;
+    return false;
+  }
+
+  bool ok = true;
+
+  // Some already there, one is locked, one is the wrong type
+  for (unsigned i = 0; i < 10; ++i)
+    WriteSpoolFile(dir + PSTRSTRM("old" << i << ".tif"));
+  WriteSpoolFile(dir + "locked.tif");
+  PDirectory::Create(dir + "locked.tif.LCK");
+  WriteSpoolFile(dir + "other.txt");
+
+  CountingSpoolDir spoolDir;
+  spoolDir.SetEventDriven(eventDriven);
+  spoolDir.SetWorkerThreads(workers);
+  spoolDir.Open(dir, ".tif");
+
+  if (!WaitForTotal(spoolDir, 10, 5000)) {
+    cout << "Existing files not processed" << endl;
+    ok = false;
+  }
+
+  // New files, written in place or moved in from elsewhere
+  PTime start;
+  for (unsigned i = 0; i < fileCount; ++i) {
+    PFilePath path = dir + PSTRSTRM("new" << i << ".tif");
+    if (i % 4 == 0) {
+      PFilePath temp = PDirectory::GetTemporary() + PSTRSTRM("spooltemp_" << GetProcessID() << '_' << i);
+      WriteSpoolFile(temp);
+      PFile::Move(temp, path);
+    }
+    else
+      WriteSpoolFile(path);
+  }
+
+  bool allNew = WaitForTotal(spoolDir, 10 + fileCount, 30000);
+  PTimeInterval elapsed = PTime() - start;
+  if (!allNew) {
+    cout << "Only " << spoolDir.GetTotal() << " of " << 10 + fileCount << " files processed" << endl;
+    ok = false;
+  }
+
+  // Releasing the lock should let it be processed
+  PDirectory::Remove(dir + "locked.tif.LCK");
+  if (!WaitForTotal(spoolDir, 11 + fileCount, 30000)) {
+    cout << "Unlocked file not processed" << endl;
+    ok = false;
+  }
+
+  // Skipped entries get no more events, so must be retried
+  WriteSpoolFile(dir + "busy.tif");
+  if (!WaitForTotal(spoolDir, 14 + fileCount, 5000)) {
+    cout << "Skipped file not retried" << endl;
+    ok = false;
+  }
+
+  PThread::Sleep(500);
+  spoolDir.Close();
+
+  for (std::map<PString, unsigned>::iterator it = spoolDir.m_processed.begin(); it != spoolDir.m_processed.end(); ++it) {
+    if (it->second != (it->first == "busy.tif" ? 3U : 1U)) {
+      cout << "File " << it->first << " processed " << it->second << " times" << endl;
+      ok = false;
+    }
+  }
+  if (spoolDir.m_processed.find("other.txt") != spoolDir.m_processed.end()) {
+    cout << "File of wrong type processed" << endl;
+    ok = false;
+  }
+
+  cout << (eventDriven ? "Event driven" : "Scanning") << ", " << workers << " workers: "
+       << fileCount << " files processed in " << elapsed << "s" << (ok ? "" : " - FAILED") << endl;
+
+  PFile::Remove(dir + "other.txt");
+  dir.Remove();
+  return ok;
+}
+
+
 void TestSpoolDir::Main()
 {
   PArgList & args = GetArguments();
@@ -28,6 +162,10 @@ void TestSpoolDir::Main()
   args.Parse(
              "h-help."
              "v-version."
+             "c-check."
+             "e-event."
+             "w-workers:"
+             "n-files:"
 #if PTRACING
              "o-output:"             "-no-output."
              "t-trace."              "-no-trace."
@@ -40,6 +178,10 @@ void TestSpoolDir::Main()
     cout << "usage: " <<  (const char *)GetName()
          << endl
          << "  -v" << endl
+         << "  -c --check   : Check processing in a temporary directory" << endl
+         << "  -e --event   : Use event driven mode" << endl
+         << "  -w --workers : Number of worker threads, default 0" << endl
+         << "  -n --files   : Number of files for check, default 1000" << endl
 #if PTRACING
          << "  -t --trace   : Enable trace, use multiple times for more detail" << endl
          << "  -o --output  : File for trace output, default is stderr" << endl
@@ -50,12 +192,21 @@ void TestSpoolDir::Main()
 
  m_verbose = args.HasOption('v');
 
+ if (args.HasOption('c')) {
+   unsigned fileCount = args.GetOptionAs('n', 1000U);
+   if (!Check(true, 0, fileCount) || !Check(true, args.GetOptionAs('w', 4U), fileCount))
+     SetTerminationValue(1);
+   return;
+ }
+
  if (args.GetCount() < 1) {
    PError << "error: no directory specified" << endl;
    return;
  }
 
  PSpoolDirectory spoolDir;
+ spoolDir.SetEventDriven(args.HasOption('e'));
+ spoolDir.SetWorkerThreads(args.GetOptionAs('w', 0U));
  if (!spoolDir.Open(args[0], ".tif")) {
    PError << "error: unable to open spool directory '" << args[0] << "'" << endl;
    return;
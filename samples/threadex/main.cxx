@@ -33,6 +33,7 @@ PCREATE_PROCESS(Threadex);
 
 #include  <ptclib/dtmf.h>
 #include  <ptclib/random.h>
+#include  <ptclib/threadpool.h>
 
 #ifdef _WIN32
 #include <process.h>
@@ -93,6 +94,7 @@ void Threadex::Main()
              "d-delay:"              "-no-delay."
 	     "g-gap:"                "-no-gap."
              "b-busywait."           "-no-busywait."
+             "p-pool:"               "-no-pool."
 #if PTRACING
              "o-output:"             "-no-output."
              "t-trace."              "-no-trace."
@@ -125,6 +127,7 @@ void Threadex::Main()
            << "-b  or --busywait     where if specified will cause the created thread to be tested for termination using a busy wait." << endl
            << "-a  or --autodelete   where the pwlib methods for auto deleting a thread are used" << endl
            << "-c  or --create       Use the pwlib PThread::Create method to create a thread of the reqired type" << endl
+           << "-p  or --pool ##      measure thread pool throughput for ## work items, then exit" << endl
 #if PTRACING
            << "o-output              output file name for trace" << endl
            << "t-trace.              trace level to use." << endl;
@@ -137,10 +140,15 @@ void Threadex::Main()
     return;
   }
 
+  if (args.HasOption('p')) {
+    PoolBenchmark(args.GetOptionString('p').AsUnsigned());
+    return;
+  }
+
   delay = 2000;
   if (args.HasOption('d')) {
     delay = args.GetOptionString('d').AsInteger();
-    delay = PMIN(1000000, PMAX(0, delay));
+    delay = std::min<PINDEX>(1000000, delay);
     cout << "Created thread will wait for " << delay << " milliseconds before ending" << endl;
   } else
     cout << "Delay (or time each thread runs for) is not specified. Default value is 0 ms" << endl;
@@ -148,7 +156,7 @@ void Threadex::Main()
   gapIteration = 0;
   if (args.HasOption('g')) {
     gapIteration = args.GetOptionString('g').AsInteger();
-    gapIteration = PMIN(1000, PMAX(0, gapIteration));
+    gapIteration = std::min<PINDEX>(1000, gapIteration);
     cout << "A gap of " << gapIteration << " milliseconds between launching threads" << endl;  
   } else
     cout << "Gap between the launching of threads not specified. Default value is 0 milliseconds, which gives the highest launch rate of threads." << endl;
@@ -319,6 +327,201 @@ void LauncherThread::Main()
   }
 }
 
+///////////////////////////////////////////////////////////////////////////
+
+struct BenchmarkWork
+{
+  static PAtomicInteger s_remaining;
+  static PSyncPoint     s_finished;
+
+  void Work()
+  {
+    if (--s_remaining == 0)
+      s_finished.Signal();
+  }
+};
+
+PAtomicInteger BenchmarkWork::s_remaining;
+PSyncPoint     BenchmarkWork::s_finished;
+
+
+template <class Pool>
+class BenchmarkSubmitter : public PThread
+{
+    PCLASSINFO(BenchmarkSubmitter, PThread);
+  public:
+    BenchmarkSubmitter(Pool & pool, unsigned count, const PStringArray & groups)
+      : PThread(10000, NoAutoDeleteThread)
+      , m_pool(pool)
+      , m_count(count)
+      , m_groups(groups)
+    {
+    }
+
+    void Main()
+    {
+      for (unsigned i = 0; i < m_count; ++i) {
+        if (m_groups.IsEmpty())
+          m_pool.AddWork(new BenchmarkWork);
+        else
+          m_pool.AddWork(new BenchmarkWork, m_groups[i % m_groups.GetSize()]);
+      }
+    }
+
+  protected:
+    Pool       & m_pool;
+    unsigned     m_count;
+    PStringArray m_groups;
+};
+
+
+template <class Pool>
+static void PoolBenchmarkRun(const char * name, Pool & pool, unsigned count, unsigned submitters, unsigned groupCount)
+{
+  PStringArray groups;
+  for (unsigned i = 0; i < groupCount; ++i)
+    groups.AppendString(psprintf("group%u", i));
+
+  unsigned perSubmitter = count/submitters;
+  BenchmarkWork::s_remaining = perSubmitter*submitters;
+
+  PTime start;
+
+  std::vector<PThread *> threads;
+  for (unsigned i = 0; i < submitters; ++i) {
+    threads.push_back(new BenchmarkSubmitter<Pool>(pool, perSubmitter, groups));
+    threads.back()->Resume();
+  }
+
+  for (unsigned i = 0; i < submitters; ++i) {
+    threads[i]->WaitForTermination();
+    delete threads[i];
+  }
+
+  BenchmarkWork::s_finished.Wait();
+
+  PTimeInterval elapsed = PTime() - start;
+
+  // Last item may still be finishing off, wait for it before the pool is destroyed
+  pool.Shutdown();
+
+  cout << setw(16) << name
+       << setw(8) << submitters
+       << setw(8) << groupCount
+       << setw(12) << elapsed
+       << setw(14) << (PInt64)(perSubmitter*submitters*1000.0/std::max(elapsed.GetMilliSeconds(), (PInt64)1))
+       << endl;
+}
+
+
+struct ShutdownWork
+{
+  static PAtomicInteger s_alive;
+
+  ShutdownWork()  { ++s_alive; }
+  ~ShutdownWork() { --s_alive; }
+  void Work()     { PThread::Sleep(1); }
+};
+
+PAtomicInteger ShutdownWork::s_alive;
+
+
+class ShutdownSubmitter : public PThread
+{
+    PCLASSINFO(ShutdownSubmitter, PThread);
+  public:
+    ShutdownSubmitter(PWorkStealingThreadPool<ShutdownWork> & pool, unsigned index)
+      : PThread(10000, NoAutoDeleteThread)
+      , m_pool(pool)
+      , m_index(index)
+    {
+      Resume();
+    }
+
+    void Main()
+    {
+      // Keep adding, half in groups, until the pool refuses, when we still own the work
+      for (unsigned i = 0; ; ++i) {
+        ShutdownWork * work = new ShutdownWork;
+        if (!m_pool.AddWork(work, (i & 1) != 0 ? (const char *)psprintf("group%u", (i+m_index)%10) : NULL)) {
+          delete work;
+          break;
+        }
+      }
+    }
+
+  protected:
+    PWorkStealingThreadPool<ShutdownWork> & m_pool;
+    unsigned m_index;
+};
+
+
+static bool PoolShutdownCheck()
+{
+  for (unsigned pass = 0; pass < 20; ++pass) {
+    PWorkStealingThreadPool<ShutdownWork> pool(2, "Shutdown");
+
+    std::vector<PThread *> threads;
+    for (unsigned i = 0; i < 4; ++i)
+      threads.push_back(new ShutdownSubmitter(pool, i));
+
+    PThread::Sleep(10+pass);
+    pool.Shutdown();
+
+    for (size_t i = 0; i < threads.size(); ++i) {
+      threads[i]->WaitForTermination();
+      delete threads[i];
+    }
+
+    if (ShutdownWork::s_alive != 0) {
+      cout << "Work stealing pool shutdown leaked " << ShutdownWork::s_alive << " work items" << endl;
+      return false;
+    }
+  }
+
+  cout << "Work stealing pool shutdown discards all queued work." << endl;
+  return true;
+}
+
+
+void Threadex::PoolBenchmark(unsigned count)
+{
+  if (!PoolShutdownCheck()) {
+    SetTerminationValue(1);
+    return;
+  }
+
+  if (count == 0)
+    count = 1000000;
+
+  cout << "Thread pool throughput for " << count << " work items\n"
+       << setw(16) << "Pool"
+       << setw(8) << "Submit"
+       << setw(8) << "Groups"
+       << setw(12) << "Elapsed"
+       << setw(14) << "Items/sec"
+       << endl;
+
+  static const unsigned Submitters[] = { 1, 4, 16 };
+  static const unsigned Groups[] = { 0, 100 };
+
+  for (PINDEX g = 0; g < PARRAYSIZE(Groups); ++g) {
+    for (PINDEX s = 0; s < PARRAYSIZE(Submitters); ++s) {
+      {
+        PQueuedThreadPool<BenchmarkWork> pool(PThread::GetNumProcessors(), 0, "Queued");
+        PoolBenchmarkRun("Queued", pool, count, Submitters[s], Groups[g]);
+      }
+      {
+        PWorkStealingThreadPool<BenchmarkWork> pool(PThread::GetNumProcessors(), "Stealing");
+        PoolBenchmarkRun("WorkStealing", pool, count, Submitters[s], Groups[g]);
+      }
+    }
+  }
+}
+
+
+///////////////////////////////////////////////////////////////////////////
+
 void UserInterfaceThread::Main()
 {
   cout << "This program will repeatedly create and destroy a thread until terminated from the console" << endl;
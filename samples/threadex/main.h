@@ -126,6 +126,8 @@ class Threadex : public PProcess
       { return (Threadex &)PProcess::Current(); }
 
  protected:
+    void PoolBenchmark(unsigned count);
+
 
     PINDEX gapIteration;
 
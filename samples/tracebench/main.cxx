@@ -0,0 +1,210 @@
+/*
+ * main.cxx
+ *
+ * Sample program to benchmark PTrace output.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+
+
+class TraceBench : public PProcess
+{
+  PCLASSINFO(TraceBench, PProcess)
+  public:
+    void Main();
+    bool CheckBinaryAppend(const PString & filename);
+    bool CheckAsyncStop(const PString & filename);
+    PTimeInterval Run(const PString & filename, unsigned options, unsigned threadCount, unsigned lineCount);
+};
+
+PCREATE_PROCESS(TraceBench);
+
+
+class TraceThread : public PThread
+{
+  PCLASSINFO(TraceThread, PThread)
+  public:
+    TraceThread(unsigned index, unsigned lineCount, bool slow = false)
+      : PThread(1000, NoAutoDeleteThread, NormalPriority, psprintf("Tracer %u", index))
+      , m_lineCount(lineCount)
+      , m_slow(slow)
+    {
+      Resume();
+    }
+
+    virtual void Main()
+    {
+      for (unsigned i = 0; i < m_lineCount; ++i) {
+        PTRACE(4, "Bench", "Trace line " << i << " of " << m_lineCount << ", value=" << (i*7919u));
+        if (m_slow && i%10 == 0)
+          PThread::Sleep(1);
+      }
+    }
+
+  protected:
+    unsigned m_lineCount;
+    bool     m_slow;
+};
+
+
+PTimeInterval TraceBench::Run(const PString & filename, unsigned options, unsigned threadCount, unsigned lineCount)
+{
+  PTrace::Initialise(4, filename, options);
+
+  std::vector<PThread *> threads;
+  PTime start;
+  for (unsigned i = 0; i < threadCount; ++i)
+    threads.push_back(new TraceThread(i, lineCount));
+  for (unsigned i = 0; i < threadCount; ++i) {
+    threads[i]->WaitForTermination();
+    delete threads[i];
+  }
+  PTimeInterval elapsed = PTime() - start;
+
+  // Clearing the option waits for the writer thread to output everything
+  PTrace::ClearOptions(PTrace::Asynchronous|PTrace::BinaryOutput);
+  PTrace::SetLevel(0);
+  PTrace::SetStream(NULL);
+  return elapsed;
+}
+
+
+bool TraceBench::CheckBinaryAppend(const PString & filename)
+{
+  // Reopening to append must not let the file grow past the maximum each time
+  size_t savedMaximum = PTrace::MaxBinaryFileSize;
+  PTrace::MaxBinaryFileSize = 65536;
+  PFile::Remove(filename);
+
+  PUInt64 sizes[3];
+  for (int pass = 0; pass < 3; ++pass) {
+    Run(filename, PTrace::BinaryOutput|PTrace::AppendToFile, 1, 300);
+    PTrace::Initialise(0, "stderr"); // Otherwise the same file name is not reopened
+    PFileInfo info;
+    sizes[pass] = PFile::GetInfo(filename, info) ? info.size : 0;
+  }
+
+  PTrace::MaxBinaryFileSize = savedMaximum;
+  PFile::Remove(filename);
+
+  if (sizes[0] == 0 || sizes[0] >= 65536 || sizes[1] <= sizes[0] || sizes[2] > 65536) {
+    cout << "Binary trace file append sizes incorrect: " << sizes[0] << ' ' << sizes[1] << ' ' << sizes[2] << endl;
+    return false;
+  }
+
+  cout << "Binary trace file append stays within maximum size." << endl;
+  return true;
+}
+
+
+bool TraceBench::CheckAsyncStop(const PString & filename)
+{
+  // Lines being traced while asynchronous output is stopped must not be lost
+  static unsigned const ThreadCount = 4;
+  static unsigned const LineCount = 2000;
+
+  PFile::Remove(filename);
+  PTrace::Initialise(4, filename, PTrace::Asynchronous);
+  unsigned dropped = PTrace::GetDroppedLines();
+
+  std::vector<PThread *> threads;
+  for (unsigned i = 0; i < ThreadCount; ++i)
+    threads.push_back(new TraceThread(i, LineCount, true));
+  PThread::Sleep(50);
+  PTrace::ClearOptions(PTrace::Asynchronous);
+  for (unsigned i = 0; i < ThreadCount; ++i) {
+    threads[i]->WaitForTermination();
+    delete threads[i];
+  }
+
+  dropped = PTrace::GetDroppedLines() - dropped;
+  PTrace::SetLevel(0);
+  PTrace::Initialise(0, "stderr");
+
+  unsigned count = 0;
+  PTextFile file;
+  if (file.Open(filename, PFile::ReadOnly)) {
+    PString line;
+    while (file.ReadLine(line)) {
+      if (line.Find("Trace line") != P_MAX_INDEX)
+        ++count;
+    }
+    file.Close();
+  }
+  PFile::Remove(filename);
+
+  if (count + dropped != ThreadCount*LineCount) {
+    cout << "Asynchronous stop lost lines: " << count << " written, " << dropped
+         << " dropped, expected " << ThreadCount*LineCount << endl;
+    return false;
+  }
+
+  cout << "Asynchronous stop loses no lines." << endl;
+  return true;
+}
+
+
+void TraceBench::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("T-threads: Number of threads tracing, default 4\n"
+             "n-lines:   Number of lines per thread, default 100000\n"
+             "o-output:  Output file prefix, default \"tracebench\"\n"
+             "h-help.    This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  unsigned threadCount = args.GetOptionAs('T', 4U);
+  unsigned lineCount = args.GetOptionAs('n', 100000U);
+  PString prefix = args.GetOptionString('o', "tracebench");
+  unsigned options = PTrace::Timestamp|PTrace::Thread|PTrace::FileAndLine;
+
+  if (!CheckBinaryAppend(prefix + "_append.trc") || !CheckAsyncStop(prefix + "_stop.log")) {
+    SetTerminationValue(1);
+    return;
+  }
+
+  cout << "Tracing " << lineCount << " lines from each of " << threadCount << " threads" << endl;
+
+  PTimeInterval syncTime = Run(prefix + "_sync.log", options, threadCount, lineCount);
+  PTimeInterval asyncTime = Run(prefix + "_async.log", options|PTrace::Asynchronous, threadCount, lineCount);
+  unsigned asyncDropped = PTrace::GetDroppedLines();
+  PTimeInterval binaryTime = Run(prefix + "_binary.trc", options|PTrace::BinaryOutput, threadCount, lineCount);
+
+  double total = (double)threadCount*lineCount;
+  cout << "Synchronous:  " << syncTime << " seconds, "
+       << (unsigned)(total*1000/std::max(syncTime.GetMilliSeconds(), (PInt64)1)) << " lines/second\n"
+          "Asynchronous: " << asyncTime << " seconds, "
+       << (unsigned)(total*1000/std::max(asyncTime.GetMilliSeconds(), (PInt64)1)) << " lines/second, "
+       << asyncDropped << " dropped\n"
+          "Binary:       " << binaryTime << " seconds, "
+       << (unsigned)(total*1000/std::max(binaryTime.GetMilliSeconds(), (PInt64)1)) << " lines/second, "
+       << (PTrace::GetDroppedLines() - asyncDropped) << " dropped" << endl;
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////
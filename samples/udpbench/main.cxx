@@ -0,0 +1,341 @@
+/*
+ * main.cxx
+ *
+ * Sample program to check and benchmark batched UDP socket I/O.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptlib/sockets.h>
+
+
+class UDPBench : public PProcess
+{
+  PCLASSINFO(UDPBench, PProcess)
+  public:
+    void Main();
+    bool Check();
+    void Bench(unsigned packetCount, unsigned packetSize, unsigned batchSize, unsigned segmentSize);
+    void ReceiveThread();
+
+  protected:
+    bool Open(PUDPSocket & socket, PIPSocketAddressAndPort & ap);
+
+    PUDPSocket * m_receiver;
+    unsigned     m_batchSize;
+    unsigned     m_packetSize;
+    unsigned     m_received;
+    PTime        m_lastReceived;
+};
+
+PCREATE_PROCESS(UDPBench);
+
+
+bool UDPBench::Open(PUDPSocket & socket, PIPSocketAddressAndPort & ap)
+{
+  if (!socket.Listen(PIPSocket::Address::GetLoopback(4), 0, 0)) {
+    cout << "Could not open socket: " << socket.GetErrorText() << endl;
+    return false;
+  }
+
+  socket.SetOption(SO_RCVBUF, 8*1024*1024);
+  socket.SetOption(SO_SNDBUF, 8*1024*1024);
+  socket.SetReadTimeout(1000);
+  socket.GetLocalAddress(ap);
+  return true;
+}
+
+
+bool UDPBench::Check()
+{
+  PUDPSocket sender, receiver1, receiver2;
+  PIPSocketAddressAndPort senderAP, receiverAP1, receiverAP2;
+  if (!Open(sender, senderAP) || !Open(receiver1, receiverAP1) || !Open(receiver2, receiverAP2))
+    return false;
+
+  bool ok = true;
+
+  // Alternate destinations, one via the send address
+  BYTE data[10][100];
+  PUDPSocket::Datagram datagrams[10];
+  for (PINDEX i = 0; i < 10; ++i) {
+    memset(data[i], (int)i, sizeof(data[i]));
+    datagrams[i] = PUDPSocket::Datagram(data[i], 10+i, (i&1) != 0 ? receiverAP2 : PIPSocketAddressAndPort());
+  }
+  sender.SetSendAddress(receiverAP1);
+
+  if (sender.WriteBatch(datagrams, 10) != 10 || sender.GetLastWriteCount() != 10*10+45) {
+    cout << "WriteBatch failed: " << sender.GetErrorText(PChannel::LastWriteError) << endl;
+    return false;
+  }
+
+  for (int r = 0; r < 2; ++r) {
+    PUDPSocket & receiver = r == 0 ? receiver1 : receiver2;
+    BYTE buffer[5][1000];
+    PUDPSocket::Datagram received[10];
+    for (PINDEX i = 0; i < 10; ++i)
+      received[i] = PUDPSocket::Datagram(buffer[i%5], sizeof(buffer[0]));
+
+    // May take more than one read, if the kernel has not queued them all yet
+    PINDEX count = 0;
+    while (count < 5) {
+      PINDEX batch = receiver.ReadBatch(&received[count], 5 - count);
+      if (batch == 0) {
+        cout << "ReadBatch failed: " << receiver.GetErrorText(PChannel::LastReadError) << endl;
+        return false;
+      }
+      for (PINDEX i = count; i < count+batch; ++i) {
+        PINDEX expected = i*2 + r;
+        if (received[i].m_length != 10+expected || received[i].m_ipAndPort != senderAP ||
+            memcmp(received[i].m_data, data[expected], received[i].m_length) != 0) {
+          cout << "Receiver " << r+1 << " datagram " << i << " incorrect: length=" << received[i].m_length
+               << " from " << received[i].m_ipAndPort << endl;
+          ok = false;
+        }
+      }
+      count += batch;
+    }
+
+    PIPSocketAddressAndPort last;
+    receiver.GetLastReceiveAddress(last);
+    if (last != senderAP) {
+      cout << "Last receive address incorrect: " << last << endl;
+      ok = false;
+    }
+  }
+
+  // No destination stops the batch
+  datagrams[0].m_ipAndPort = receiverAP2;
+  sender.SetSendAddress(PIPSocketAddressAndPort());
+  if (sender.WriteBatch(datagrams, 10) != 2 || sender.GetErrorCode(PChannel::LastWriteError) != PChannel::BadParameter) {
+    cout << "WriteBatch without address did not stop" << endl;
+    ok = false;
+  }
+  receiver1.SetReadTimeout(0);
+  receiver2.SetReadTimeout(0);
+  while (receiver1.ReadBatch(datagrams, 10) > 0 || receiver2.ReadBatch(datagrams, 10) > 0)
+    ;
+
+  // Too big for the buffer is truncated, but still returned
+  {
+    BYTE big[200];
+    memset(big, 0x55, sizeof(big));
+    PUDPSocket::Datagram datagram(big, sizeof(big), receiverAP1);
+    if (sender.WriteBatch(&datagram, 1) != 1) {
+      cout << "WriteBatch of large datagram failed: " << sender.GetErrorText(PChannel::LastWriteError) << endl;
+      return false;
+    }
+
+    BYTE buffer[2][100];
+    PUDPSocket::Datagram received[2] = { PUDPSocket::Datagram(buffer[0], 100), PUDPSocket::Datagram(buffer[1], 100) };
+    receiver1.SetReadTimeout(1000);
+    if (receiver1.ReadBatch(received, 2) != 1 || !received[0].m_truncated || received[0].m_length != 100 ||
+        receiver1.GetErrorCode(PChannel::LastReadError) != PChannel::BufferTooSmall) {
+      cout << "Truncated datagram not reported: length=" << received[0].m_length
+           << ", " << receiver1.GetErrorText(PChannel::LastReadError) << endl;
+      ok = false;
+    }
+
+    datagram.m_size = 50;
+    sender.WriteBatch(&datagram, 1);
+    if (receiver1.ReadBatch(received, 2) != 1 || received[0].m_truncated || received[0].m_length != 50) {
+      cout << "Datagram after truncated one incorrect: length=" << received[0].m_length << endl;
+      ok = false;
+    }
+  }
+
+  // Segmentation offload, split by the kernel, then with coalescing on receive
+  BYTE segments[300];
+  for (PINDEX i = 0; i < (PINDEX)sizeof(segments); ++i)
+    segments[i] = (BYTE)(i/100 + 1);
+
+  for (int gro = 0; gro < 2; ++gro) {
+    if (gro && !receiver1.SetReceiveCoalescing(true)) {
+      cout << "Receive coalescing not supported, skipped." << endl;
+      break;
+    }
+
+    PUDPSocket::Datagram segmented(segments, sizeof(segments), receiverAP1);
+    segmented.m_segmentSize = 100;
+    if (sender.WriteBatch(&segmented, 1) != 1) {
+      cout << "Segmentation offload not supported, skipped: " << sender.GetErrorText(PChannel::LastWriteError) << endl;
+      break;
+    }
+
+    receiver1.SetReadTimeout(1000);
+    BYTE buffer[3][1000];
+    PUDPSocket::Datagram received[3];
+    for (PINDEX i = 0; i < 3; ++i)
+      received[i] = PUDPSocket::Datagram(buffer[i], sizeof(buffer[0]));
+
+    PINDEX total = 0;
+    PINDEX count = 0;
+    while (total < (PINDEX)sizeof(segments) && count < 3) {
+      PINDEX batch = receiver1.ReadBatch(&received[count], 3 - count);
+      if (batch == 0)
+        break;
+      for (PINDEX i = count; i < count+batch; ++i) {
+        PINDEX segmentSize = received[i].m_segmentSize > 0 ? received[i].m_segmentSize : received[i].m_length;
+        if (segmentSize != 100 || memcmp(received[i].m_data, segments+total, received[i].m_length) != 0)
+          ok = false;
+        total += received[i].m_length;
+      }
+      count += batch;
+    }
+
+    if (total != (PINDEX)sizeof(segments)) {
+      cout << "Segmented datagram incorrect, " << total << " bytes in " << count << " reads" << endl;
+      ok = false;
+    }
+    else
+      cout << "Segmented datagram received as " << count << " datagram(s), coalescing " << (gro ? "on" : "off") << endl;
+  }
+
+  return ok;
+}
+
+
+void UDPBench::ReceiveThread()
+{
+  std::vector< std::vector<BYTE> > buffers(m_batchSize, std::vector<BYTE>(65536));
+  std::vector<PUDPSocket::Datagram> datagrams(m_batchSize);
+  for (unsigned i = 0; i < m_batchSize; ++i)
+    datagrams[i] = PUDPSocket::Datagram(&buffers[i][0], (PINDEX)buffers[i].size());
+
+  for (;;) {
+    if (m_batchSize > 1) {
+      PINDEX count = m_receiver->ReadBatch(&datagrams[0], m_batchSize);
+      if (count == 0)
+        break;
+      for (PINDEX i = 0; i < count; ++i)
+        m_received += datagrams[i].m_segmentSize > 0 ? (datagrams[i].m_length + datagrams[i].m_segmentSize - 1)/datagrams[i].m_segmentSize : 1;
+    }
+    else {
+      PIPSocketAddressAndPort ap;
+      if (!m_receiver->ReadFrom(datagrams[0].m_data, datagrams[0].m_size, ap))
+        break;
+      ++m_received;
+    }
+    m_lastReceived.SetCurrentTime();
+  }
+}
+
+
+void UDPBench::Bench(unsigned packetCount, unsigned packetSize, unsigned batchSize, unsigned segmentSize)
+{
+  PUDPSocket sender, receiver;
+  PIPSocketAddressAndPort senderAP, receiverAP;
+  if (!Open(sender, senderAP) || !Open(receiver, receiverAP))
+    return;
+
+  if (segmentSize > 0) {
+    if (!receiver.SetReceiveCoalescing(true)) {
+      cout << "Receive coalescing not supported" << endl;
+      return;
+    }
+    if (segmentSize*packetSize > 65000)
+      segmentSize = 65000/packetSize;
+  }
+
+  receiver.SetReadTimeout(500);
+  m_receiver = &receiver;
+  m_batchSize = batchSize;
+  m_packetSize = packetSize;
+  m_received = 0;
+  PThread * thread = new PThreadObj<UDPBench>(*this, &UDPBench::ReceiveThread, false, "Receiver");
+
+  PThread::Sleep(100);
+
+  std::vector<BYTE> payload(packetSize*std::max(segmentSize, 1U));
+  std::vector<PUDPSocket::Datagram> datagrams(batchSize, PUDPSocket::Datagram(&payload[0], packetSize, receiverAP));
+  if (segmentSize > 0) {
+    for (unsigned i = 0; i < batchSize; ++i) {
+      datagrams[i].m_size = (PINDEX)payload.size();
+      datagrams[i].m_segmentSize = packetSize;
+    }
+  }
+
+  PTime start;
+  unsigned sent = 0;
+  while (sent < packetCount) {
+    if (batchSize > 1 || segmentSize > 0) {
+      PINDEX count = sender.WriteBatch(&datagrams[0], batchSize);
+      if (count == 0) {
+        cout << "WriteBatch failed: " << sender.GetErrorText(PChannel::LastWriteError) << endl;
+        break;
+      }
+      sent += count*std::max(segmentSize, 1U);
+    }
+    else {
+      if (!sender.WriteTo(&payload[0], packetSize, receiverAP)) {
+        cout << "WriteTo failed: " << sender.GetErrorText(PChannel::LastWriteError) << endl;
+        break;
+      }
+      ++sent;
+    }
+  }
+  PTimeInterval sendTime = PTime() - start;
+
+  thread->WaitForTermination();
+  delete thread;
+  PTimeInterval receiveTime = m_lastReceived - start;
+
+  cout << setw(5) << batchSize << setw(9) << segmentSize
+       << setw(12) << (PUInt64)(sent*1000.0/std::max(sendTime.GetMilliSeconds(), (PInt64)1))
+       << setw(12) << (PUInt64)(m_received*1000.0/std::max(receiveTime.GetMilliSeconds(), (PInt64)1))
+       << setw(9) << (sent > m_received ? (sent - m_received)*100.0/sent : 0.0) << '%' << endl;
+}
+
+
+void UDPBench::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("n-packets: Number of packets to send, default 1000000\n"
+             "s-size: Size of each packet, default 172 (RTP with 160 byte payload)\n"
+             "h-help.     This help\n");
+
+  if (args.HasOption('h')) {
+    args.Usage(cerr, "[ options ]");
+    return;
+  }
+
+  if (!Check()) {
+    SetTerminationValue(1);
+    return;
+  }
+  cout << "Batched UDP checks passed." << endl;
+
+  unsigned packetCount = args.GetOptionAs('n', 1000000U);
+  unsigned packetSize = std::max(args.GetOptionAs('s', 172U), 1U);
+  cout << "Loopback, " << packetCount << " packets of " << packetSize << " bytes\n"
+          "Batch  Segments  Sent pkt/s  Recv pkt/s  Lost" << endl;
+
+  static unsigned const BatchSizes[] = { 1, 8, 32, 64 };
+  for (PINDEX i = 0; i < PARRAYSIZE(BatchSizes); ++i)
+    Bench(packetCount, packetSize, BatchSizes[i], 0);
+  Bench(packetCount, packetSize, 8, 16);
+  Bench(packetCount, packetSize, 8, 64);
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////
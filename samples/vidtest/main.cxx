@@ -30,6 +30,7 @@
 
 #include  <ptlib/videoio.h>
 #include  <ptlib/vconvert.h>
+#include  <ptclib/random.h>
 
 
 PCREATE_PROCESS(VidTest);
@@ -54,6 +55,8 @@ void VidTest::Main()
              "-output-driver: video display driver to use.\n"
              "O-output-device: video display device to use.\n"
              "T-time: time in seconds to run test, no command line\n"
+             "-check. check SIMD colour converters, scaling and rotation against plain C++, then exit\n"
+             "-benchmark: benchmark colour converters, scaling and rotation at size, e.g. \"1080p\", then exit\n"
 #if PTRACING
              "o-output: file name for output of log messages\n"
              "t-trace. degree of verbosity in log (more times for more detail)\n"
@@ -85,6 +88,27 @@ void VidTest::Main()
 
   PTRACE_INITIALISE(args, PTrace::Blocks|PTrace::Timestamp|PTrace::Thread|PTrace::FileAndLine);
 
+  if (args.HasOption("check") || args.HasOption("benchmark")) {
+    if (args.HasOption("check")) {
+      if (!CheckConverters() || !CheckScaling()) {
+        SetTerminationValue(1);
+        return;
+      }
+      cout << "Colour converter checks passed." << endl;
+    }
+
+    if (args.HasOption("benchmark")) {
+      unsigned width, height;
+      if (!PVideoFrameInfo::ParseSize(args.GetOptionString("benchmark"), width, height)) {
+        cerr << "Could not parse size \"" << args.GetOptionString("benchmark") << '"' << endl;
+        return;
+      }
+      BenchmarkConverters(width, height);
+      BenchmarkScaling(width, height);
+    }
+    return;
+  }
+
 
   /////////////////////////////////////////////////////////////////////
 
@@ -371,6 +395,398 @@ void VidTest::Main()
 }
 
 
+// The converters with SIMD versions
+static struct {
+  const char * m_src;
+  const char * m_dst;
+} const ConverterFormats[] = {
+  { "RGB24",   "YUV420P" },
+  { "BGR24",   "YUV420P" },
+  { "RGB32",   "YUV420P" },
+  { "BGR32",   "YUV420P" },
+  { "YUV420P", "RGB24"   },
+  { "YUV420P", "BGR24"   },
+  { "YUV420P", "RGB32"   },
+  { "YUV420P", "BGR32"   },
+  { "YUY2",    "YUV420P" },
+  { "UYVY422", "YUV420P" }
+};
+
+static const char * const AccelerationNames[] = { "C++", "SSE4.1", "AVX2" };
+
+
+static PColourConverter * CreateConverter(const char * srcFormat, const char * dstFormat,
+                                          unsigned width, unsigned height, bool flip)
+{
+  PVideoFrameInfo src(width, height, srcFormat);
+  PVideoFrameInfo dst(width, height, dstFormat);
+  PColourConverter * converter = PColourConverter::Create(src, dst);
+  if (converter != NULL)
+    converter->SetVFlipState(flip);
+  return converter;
+}
+
+
+static bool ConvertFrame(const char * srcFormat, const char * dstFormat, unsigned width, unsigned height,
+                         bool flip, const PBYTEArray & src, PBYTEArray & dst)
+{
+  PColourConverter * converter = CreateConverter(srcFormat, dstFormat, width, height, flip);
+  if (converter == NULL) {
+    cout << "Could not create converter from " << srcFormat << " to " << dstFormat << endl;
+    return false;
+  }
+
+  // Fill with a pattern, so skipped bytes show up as differences
+  BYTE * ptr = dst.GetPointer(converter->GetMaxDstFrameBytes() + 64);
+  for (PINDEX i = 0; i < dst.GetSize(); ++i)
+    ptr[i] = (BYTE)(i * 7);
+
+  bool ok = converter->Convert(src, ptr);
+  delete converter;
+  return ok;
+}
+
+
+bool VidTest::CheckConverters()
+{
+  // Widths that leave every possible tail for the plain C++ after the SIMD
+  static unsigned const Widths[] = { 2, 6, 8, 14, 16, 18, 30, 32, 34, 48, 50, 66, 98, 176, 354, 640 };
+  static unsigned const Heights[] = { 2, 4, 6 };
+
+  PColourConverter::Acceleration supported = PColourConverter::GetAcceleration();
+  cout << "Checking colour converters, CPU supports " << AccelerationNames[supported] << endl;
+
+  PRandom random(12345);
+  bool ok = true;
+
+  for (PINDEX f = 0; f < PARRAYSIZE(ConverterFormats); ++f) {
+    const char * srcFormat = ConverterFormats[f].m_src;
+    const char * dstFormat = ConverterFormats[f].m_dst;
+    unsigned failures = 0;
+
+    for (PINDEX w = 0; w < PARRAYSIZE(Widths); ++w) {
+      for (PINDEX h = 0; h < PARRAYSIZE(Heights); ++h) {
+        unsigned width = Widths[w];
+        unsigned height = Heights[h] + (w & 1)*16;
+
+        PBYTEArray src(PVideoFrameInfo::CalculateFrameBytes(width, height, srcFormat) + 64);
+        for (PINDEX i = 0; i < src.GetSize(); ++i)
+          src[i] = (BYTE)random.Generate(255);
+
+        for (int flip = 0; flip < 2; ++flip) {
+          PColourConverter::SetAcceleration(PColourConverter::e_NoAcceleration);
+          PBYTEArray expected;
+          if (!ConvertFrame(srcFormat, dstFormat, width, height, flip != 0, src, expected)) {
+            ok = false;
+            continue;
+          }
+
+          for (int level = PColourConverter::e_SSE41; level <= supported; ++level) {
+            PColourConverter::SetAcceleration((PColourConverter::Acceleration)level);
+            PBYTEArray actual;
+            if (!ConvertFrame(srcFormat, dstFormat, width, height, flip != 0, src, actual) || actual != expected) {
+              if (++failures < 5)
+                cout << AccelerationNames[level] << ' ' << srcFormat << "->" << dstFormat << ' '
+                     << width << 'x' << height << (flip ? " flipped" : "") << " differs from plain C++" << endl;
+              ok = false;
+            }
+          }
+        }
+
+        // A flipped RGB output must be the scan lines of the unflipped one in reverse order
+        if (strncmp(dstFormat, "YUV", 3) != 0) {
+          PColourConverter::SetAcceleration(supported);
+          PBYTEArray normal, flipped;
+          ConvertFrame(srcFormat, dstFormat, width, height, false, src, normal);
+          ConvertFrame(srcFormat, dstFormat, width, height, true, src, flipped);
+          PINDEX pixelBytes = (dstFormat[3] == '2' ? 3 : 4)*width;
+          PINDEX lineSize = (pixelBytes + 3)&~3;
+          for (unsigned y = 0; y < height; ++y) {
+            if (memcmp(normal + y*lineSize, flipped + (height-1-y)*lineSize, pixelBytes) != 0) {
+              if (++failures < 5)
+                cout << srcFormat << "->" << dstFormat << ' ' << width << 'x' << height
+                     << " flipped line " << y << " incorrect" << endl;
+              ok = false;
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+
+  PColourConverter::SetAcceleration(supported);
+  return ok;
+}
+
+
+void VidTest::BenchmarkConverters(unsigned width, unsigned height)
+{
+  PColourConverter::Acceleration supported = PColourConverter::GetAcceleration();
+  cout << "Benchmarking colour converters at " << width << 'x' << height
+       << ", CPU supports " << AccelerationNames[supported] << endl;
+
+  PRandom random;
+
+  for (PINDEX f = 0; f < PARRAYSIZE(ConverterFormats); ++f) {
+    const char * srcFormat = ConverterFormats[f].m_src;
+    const char * dstFormat = ConverterFormats[f].m_dst;
+    cout << setw(8) << srcFormat << " -> " << setw(8) << left << dstFormat << right;
+
+    PBYTEArray src(PVideoFrameInfo::CalculateFrameBytes(width, height, srcFormat));
+    for (PINDEX i = 0; i < src.GetSize(); ++i)
+      src[i] = (BYTE)random.Generate(255);
+
+    double baseline = 0;
+    for (int level = PColourConverter::e_NoAcceleration; level <= supported; ++level) {
+      PColourConverter::SetAcceleration((PColourConverter::Acceleration)level);
+      PColourConverter * converter = CreateConverter(srcFormat, dstFormat, width, height, false);
+      if (converter == NULL)
+        break;
+      PBYTEArray dst(converter->GetMaxDstFrameBytes());
+
+      // Run for at least half a second
+      unsigned frames = 0;
+      PTimeInterval start = PTimer::Tick();
+      PTimeInterval elapsed;
+      do {
+        converter->Convert(src, dst.GetPointer());
+        ++frames;
+        elapsed = PTimer::Tick() - start;
+      } while (elapsed < 500);
+      delete converter;
+
+      double mpps = (double)width*height*frames/elapsed.GetMicroSeconds();
+      if (level == PColourConverter::e_NoAcceleration)
+        baseline = mpps;
+      cout << "  " << AccelerationNames[level] << ' ' << fixed << setprecision(1) << setw(7) << mpps << " Mpix/s";
+      if (level > PColourConverter::e_NoAcceleration)
+        cout << " (" << setprecision(1) << mpps/baseline << "x)";
+    }
+    cout << endl;
+  }
+
+  PColourConverter::SetAcceleration(supported);
+}
+
+
+static bool ScaleFrame(unsigned srcWidth, unsigned srcHeight, const PBYTEArray & src,
+                       unsigned dstWidth, unsigned dstHeight, bool flip, PBYTEArray & dst,
+                       PColourConverter::ScaleQuality quality = PColourConverter::e_Bilinear)
+{
+  BYTE * ptr = dst.GetPointer(PVideoFrameInfo::CalculateFrameBytes(dstWidth, dstHeight));
+  for (PINDEX i = 0; i < dst.GetSize(); ++i)
+    ptr[i] = (BYTE)(i * 7);
+
+  return PColourConverter::CopyYUV420P(0, 0, srcWidth, srcHeight, srcWidth, srcHeight, src,
+                                       0, 0, dstWidth, dstHeight, dstWidth, dstHeight, ptr,
+                                       PVideoFrameInfo::eScale, flip, NULL, quality);
+}
+
+
+static bool RotateFrame(int angle, unsigned width, unsigned height, const PBYTEArray & src, PBYTEArray & dst)
+{
+  BYTE * ptr = dst.GetPointer(src.GetSize());
+  return PColourConverter::RotateYUV420P(angle, width, height, (BYTE *)(const BYTE *)src, ptr);
+}
+
+
+bool VidTest::CheckScaling()
+{
+  static struct {
+    unsigned m_srcWidth, m_srcHeight, m_dstWidth, m_dstHeight;
+  } const Sizes[] = {
+    {   4,    4,   18,   34 },
+    {  34,   18,    6,    4 },
+    { 176,  144,  352,  288 },
+    { 352,  288,  176,  144 },
+    { 352,  288,  354,  290 },
+    { 640,  480,  102,  258 },
+    { 118,  290,  640,  360 },
+    { 1920, 1080, 1280, 720 },
+    { 1280, 720,  1920, 1080 }
+  };
+  static unsigned const RotateSizes[][2] = { { 18, 18 }, { 34, 20 }, { 176, 144 }, { 354, 290 }, { 1280, 720 } };
+
+  PColourConverter::Acceleration supported = PColourConverter::GetAcceleration();
+  cout << "Checking YUV420P scaling and rotation, CPU supports " << AccelerationNames[supported] << endl;
+
+  PRandom random(54321);
+  bool ok = true;
+
+  for (PINDEX s = 0; s < PARRAYSIZE(Sizes); ++s) {
+    unsigned srcWidth = Sizes[s].m_srcWidth, srcHeight = Sizes[s].m_srcHeight;
+    unsigned dstWidth = Sizes[s].m_dstWidth, dstHeight = Sizes[s].m_dstHeight;
+
+    // A flat colour must stay flat, as the weights always add up to one
+    PBYTEArray flat(PVideoFrameInfo::CalculateFrameBytes(srcWidth, srcHeight));
+    memset(flat.GetPointer(), 0xb7, flat.GetSize());
+    PBYTEArray scaled;
+    ScaleFrame(srcWidth, srcHeight, flat, dstWidth, dstHeight, false, scaled);
+    for (PINDEX i = 0; i < scaled.GetSize(); ++i) {
+      if (scaled[i] != 0xb7) {
+        cout << "Bilinear scale " << srcWidth << 'x' << srcHeight << "->" << dstWidth << 'x' << dstHeight
+             << " of flat colour changed byte " << i << endl;
+        ok = false;
+        break;
+      }
+    }
+
+    PBYTEArray src(flat.GetSize());
+    for (PINDEX i = 0; i < src.GetSize(); ++i)
+      src[i] = (BYTE)random.Generate(255);
+
+    for (int flip = 0; flip < 2; ++flip) {
+      PColourConverter::SetScaleThreads(0);
+      PColourConverter::SetAcceleration(PColourConverter::e_NoAcceleration);
+      PBYTEArray expected;
+      if (!ScaleFrame(srcWidth, srcHeight, src, dstWidth, dstHeight, flip != 0, expected)) {
+        cout << "Bilinear scale " << srcWidth << 'x' << srcHeight << "->" << dstWidth << 'x' << dstHeight << " failed" << endl;
+        ok = false;
+        continue;
+      }
+
+      for (unsigned threads = 0; threads <= 3; threads += 3) {
+        PColourConverter::SetScaleThreads(threads);
+        for (int level = PColourConverter::e_NoAcceleration; level <= supported; ++level) {
+          PColourConverter::SetAcceleration((PColourConverter::Acceleration)level);
+          PBYTEArray actual;
+          if (!ScaleFrame(srcWidth, srcHeight, src, dstWidth, dstHeight, flip != 0, actual) || actual != expected) {
+            cout << AccelerationNames[level] << " with " << threads << " threads, bilinear scale "
+                 << srcWidth << 'x' << srcHeight << "->" << dstWidth << 'x' << dstHeight
+                 << (flip ? " flipped" : "") << " differs from plain C++" << endl;
+            ok = false;
+          }
+        }
+      }
+    }
+  }
+
+  for (PINDEX s = 0; s < PARRAYSIZE(RotateSizes); ++s) {
+    unsigned width = RotateSizes[s][0], height = RotateSizes[s][1];
+    PBYTEArray src(PVideoFrameInfo::CalculateFrameBytes(width, height));
+    for (PINDEX i = 0; i < src.GetSize(); ++i)
+      src[i] = (BYTE)random.Generate(255);
+
+    static int const Angles[] = { 90, -90, 180 };
+    for (PINDEX a = 0; a < PARRAYSIZE(Angles); ++a) {
+      PColourConverter::SetScaleThreads(0);
+      PColourConverter::SetAcceleration(PColourConverter::e_NoAcceleration);
+      PBYTEArray expected;
+      RotateFrame(Angles[a], width, height, src, expected);
+
+      for (unsigned threads = 0; threads <= 3; threads += 3) {
+        PColourConverter::SetScaleThreads(threads);
+        for (int level = PColourConverter::e_NoAcceleration; level <= supported; ++level) {
+          PColourConverter::SetAcceleration((PColourConverter::Acceleration)level);
+          PBYTEArray actual;
+          if (!RotateFrame(Angles[a], width, height, src, actual) || actual != expected) {
+            cout << AccelerationNames[level] << " with " << threads << " threads, rotate " << Angles[a] << ' '
+                 << width << 'x' << height << " differs from plain C++" << endl;
+            ok = false;
+          }
+        }
+      }
+
+      // Rotating back must restore the original
+      PBYTEArray restored;
+      if (Angles[a] == 180)
+        RotateFrame(180, width, height, expected, restored);
+      else
+        RotateFrame(-Angles[a], height, width, expected, restored);
+      if (restored != src) {
+        cout << "Rotate " << Angles[a] << ' ' << width << 'x' << height << " and back did not restore frame" << endl;
+        ok = false;
+      }
+    }
+  }
+
+  // Scale quality is per converter, setting one must not affect another
+  {
+    PVideoFrameInfo srcInfo(176, 144), dstInfo(352, 288);
+    PAutoPtr<PColourConverter> nearest(PColourConverter::Create(srcInfo, dstInfo));
+    PAutoPtr<PColourConverter> bilinear(PColourConverter::Create(srcInfo, dstInfo));
+    if (nearest.get() == NULL || bilinear.get() == NULL) {
+      cout << "Could not create YUV420P scaling converter" << endl;
+      ok = false;
+    }
+    else {
+      bilinear->SetScaleQuality(PColourConverter::e_Bilinear);
+
+      PBYTEArray src(PVideoFrameInfo::CalculateFrameBytes(176, 144));
+      for (PINDEX i = 0; i < src.GetSize(); ++i)
+        src[i] = (BYTE)random.Generate(255);
+
+      for (int q = 0; q < 2; ++q) {
+        PColourConverter & converter = q == 0 ? *nearest : *bilinear;
+        PColourConverter::ScaleQuality quality = q == 0 ? PColourConverter::e_NearestNeighbour : PColourConverter::e_Bilinear;
+        PBYTEArray expected, actual(PVideoFrameInfo::CalculateFrameBytes(352, 288));
+        ScaleFrame(176, 144, src, 352, 288, false, expected, quality);
+        if (converter.GetScaleQuality() != quality || !converter.Convert(src, actual.GetPointer()) || actual != expected) {
+          cout << "Converter with " << (q == 0 ? "nearest neighbour" : "bilinear") << " scale quality incorrect" << endl;
+          ok = false;
+        }
+      }
+    }
+  }
+
+  PColourConverter::SetScaleThreads(0);
+  PColourConverter::SetAcceleration(supported);
+  return ok;
+}
+
+
+void VidTest::BenchmarkScaling(unsigned width, unsigned height)
+{
+  unsigned dstWidth = (width*2/3+1)&~1, dstHeight = (height*2/3+1)&~1;
+  PColourConverter::Acceleration supported = PColourConverter::GetAcceleration();
+  cout << "Benchmarking YUV420P " << width << 'x' << height << "->" << dstWidth << 'x' << dstHeight
+       << " scaling and rotation, ms/frame" << endl;
+
+  PRandom random;
+  PBYTEArray src(PVideoFrameInfo::CalculateFrameBytes(width, height));
+  for (PINDEX i = 0; i < src.GetSize(); ++i)
+    src[i] = (BYTE)random.Generate(255);
+  PBYTEArray dst(src.GetSize());
+
+  static const char * const Operations[] = { "Nearest", "Bilinear", "Rotate 90", "Rotate 180" };
+  for (PINDEX op = 0; op < PARRAYSIZE(Operations); ++op) {
+    cout << setw(10) << left << Operations[op] << right;
+
+    for (unsigned threads = 0; threads <= 3; threads += 3) {
+      PColourConverter::SetScaleThreads(threads);
+      for (int level = PColourConverter::e_NoAcceleration; level <= supported; ++level) {
+        // Nearest neighbour has no SIMD version
+        if (op == 0 && level > PColourConverter::e_NoAcceleration)
+          break;
+        PColourConverter::SetAcceleration((PColourConverter::Acceleration)level);
+
+        // Run for at least half a second
+        unsigned frames = 0;
+        PTimeInterval start = PTimer::Tick();
+        PTimeInterval elapsed;
+        do {
+          if (op < 2)
+            ScaleFrame(width, height, src, dstWidth, dstHeight, false, dst,
+                       op == 0 ? PColourConverter::e_NearestNeighbour : PColourConverter::e_Bilinear);
+          else
+            PColourConverter::RotateYUV420P(op == 2 ? 90 : 180, width, height, src.GetPointer(), dst.GetPointer());
+          ++frames;
+          elapsed = PTimer::Tick() - start;
+        } while (elapsed < 500);
+
+        cout << "  " << AccelerationNames[level] << '/' << threads+1 << "T "
+             << fixed << setprecision(2) << setw(6) << elapsed.GetMicroSeconds()/1000.0/frames;
+      }
+    }
+    cout << endl;
+  }
+
+  PColourConverter::SetScaleThreads(0);
+  PColourConverter::SetAcceleration(supported);
+}
+
+
 void VidTest::GrabAndDisplay(PThread &, P_INT_PTR)
 {
   std::vector<PBYTEArray> frames;
@@ -39,6 +39,10 @@ class VidTest : public PProcess
 
  protected:
    PDECLARE_NOTIFIER(PThread, VidTest, GrabAndDisplay);
+   bool CheckConverters();
+   void BenchmarkConverters(unsigned width, unsigned height);
+   bool CheckScaling();
+   void BenchmarkScaling(unsigned width, unsigned height);
 
   PVideoInputDevice     * m_grabber;
   PVideoOutputDevice    * m_display;
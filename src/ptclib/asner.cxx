@@ -1269,9 +1269,10 @@ void PASN_ConstrainedString::SetCharacterSet(ConstraintType ctype, const char *
 void PASN_ConstrainedString::SetCharacterSet(ConstraintType ctype, unsigned firstChar, unsigned lastChar)
 {
   char buffer[256];
-  for (unsigned i = firstChar; i < lastChar; i++)
-    buffer[i] = (char)i;
-  SetCharacterSet(buffer, lastChar - firstChar + 1, ctype);
+  PINDEX count = 0;
+  for (unsigned i = firstChar; i <= lastChar && count < (PINDEX)sizeof(buffer); i++)
+    buffer[count++] = (char)i;
+  SetCharacterSet(buffer, count, ctype);
 }
 
 
@@ -0,0 +1,1555 @@
+/*
+ * asnpertab.cxx
+ *
+ * Table driven Packed Encoding Rules codec for ASN.1
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+
+#ifdef __GNUC__
+#pragma implementation "asnpertab.h"
+#endif
+
+#include <ptclib/asnpertab.h>
+
+#if P_ASN
+
+#define new PNEW
+
+
+/* Note that everything here deliberately follows the PPER_Stream and
+   PASN_xxx::DecodePER()/EncodePER() code in asnper.cxx step by step,
+   including its handling of the corner cases, as the whole point is to be
+   a drop in replacement on the wire for the generated classes.
+ */
+
+const PPER_Type PPER_Type::OpenType = {
+  "OpenType", PPER_Type::e_OpenType, PASN_Object::Unconstrained, false, 0, UINT_MAX, 0, 0, 0, NULL, NULL, 0, 0, 0, 0
+};
+
+
+static unsigned CountBits(unsigned range)
+{
+  switch (range) {
+    case 0 :
+      return sizeof(unsigned)*8;
+    case 1:
+      return 1;
+  }
+
+  unsigned nBits = 0;
+  while (nBits < (sizeof(unsigned)*8) && range > (unsigned)(1 << nBits))
+    nBits++;
+  return nBits;
+}
+
+
+static inline bool TestBit(const BYTE * bits, unsigned bit)
+{
+  return (bits[bit>>3] & (0x80 >> (bit&7))) != 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+
+const PPER_Value * PPER_Value::GetField(const char * name) const
+{
+  if (m_type == NULL || name == NULL)
+    return NULL;
+
+  switch (m_type->m_kind) {
+    case PPER_Type::e_Sequence :
+      for (unsigned i = 0; i < m_type->m_count + m_type->m_extensions; ++i) {
+        if (strcmp(m_type->m_fields[i].m_name, name) == 0)
+          return m_children[i].IsPresent() ? &m_children[i] : NULL;
+      }
+      break;
+
+    case PPER_Type::e_Choice :
+      if (m_value < m_type->m_count + m_type->m_extensions && strcmp(m_type->m_fields[m_value].m_name, name) == 0)
+        return m_children;
+      break;
+  }
+
+  return NULL;
+}
+
+
+PString PPER_Value::AsString() const
+{
+  if (m_type != NULL) {
+    switch (m_type->m_kind) {
+      case PPER_Type::e_String :
+        return PString((const char *)m_data, m_size);
+
+      case PPER_Type::e_BMPString :
+      {
+        PWCharArray wide(m_size);
+        for (unsigned i = 0; i < m_size; ++i)
+          wide[i] = ((const WORD *)m_data)[i];
+        return PString(wide);
+      }
+    }
+  }
+  return PString::Empty();
+}
+
+
+///////////////////////////////////////////////////////////////////////
+
+PPER_Arena::PPER_Arena(size_t blockSize)
+  : m_blocks(NULL)
+  , m_start(NULL)
+  , m_next(NULL)
+  , m_end(NULL)
+  , m_blockSize(blockSize)
+  , m_used(0)
+{
+}
+
+
+PPER_Arena::~PPER_Arena()
+{
+  while (m_blocks != NULL) {
+    Block * next = m_blocks->m_next;
+    free(m_blocks);
+    m_blocks = next;
+  }
+}
+
+
+void * PPER_Arena::Allocate(size_t size)
+{
+  size = (size + 7) & ~(size_t)7;
+  if ((size_t)(m_end - m_next) < size)
+    return AllocateBlock(size);
+
+  void * ptr = m_next;
+  m_next += size;
+  return ptr;
+}
+
+
+void * PPER_Arena::AllocateBlock(size_t size)
+{
+  m_used += m_next - m_start;
+
+  size_t blockSize = std::max(m_blockSize, size + sizeof(Block));
+  Block * block = (Block *)malloc(blockSize);
+  if (block == NULL) {
+    m_start = m_next = m_end = NULL;
+    return NULL;
+  }
+
+  block->m_next = m_blocks;
+  block->m_size = blockSize;
+  m_blocks = block;
+
+  m_start = (BYTE *)(block+1);
+  m_end = (BYTE *)block + blockSize;
+  m_next = m_start + size;
+  return m_start;
+}
+
+
+PPER_Value * PPER_Arena::AllocateValues(unsigned count)
+{
+  PPER_Value * values = (PPER_Value *)Allocate(count*sizeof(PPER_Value));
+  if (values != NULL)
+    memset(values, 0, count*sizeof(PPER_Value));
+  return values;
+}
+
+
+void PPER_Arena::Reset()
+{
+  if (m_blocks != NULL && m_blocks->m_next != NULL) {
+    // Did not fit, replace with one block that would have
+    size_t total = 0;
+    while (m_blocks != NULL) {
+      Block * next = m_blocks->m_next;
+      total += m_blocks->m_size;
+      free(m_blocks);
+      m_blocks = next;
+    }
+    m_start = m_next = m_end = NULL;
+    m_blockSize = std::max(m_blockSize, total);
+    AllocateBlock(0);
+  }
+
+  m_next = m_start;
+  m_used = 0;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+
+class PPER_TableDecoder
+{
+  public:
+    PPER_TableDecoder(const BYTE * data, PINDEX size, bool aligned, PPER_Arena & arena)
+      : m_data(data)
+      , m_size(size)
+      , m_limit((size_t)size*8)
+      , m_position(0)
+      , m_aligned(aligned)
+      , m_arena(arena)
+    { }
+
+    bool DecodeValue(const PPER_Type & type, PPER_Value & value);
+
+  protected:
+    size_t GetBitsLeft() const { return m_limit - m_position; }
+    bool IsAtEnd() const { return m_position >= m_limit; }
+    size_t GetPosition() const { return m_position >> 3; }
+    void SetPosition(size_t byteOffset) { m_position = std::min(byteOffset, m_size)*8; }
+    void ByteAlign() { m_position = (m_position + 7) & ~(size_t)7; }
+
+    // Caller guarantees 0 < nBits <= 32 and nBits <= GetBitsLeft()
+    unsigned PeekBits(unsigned nBits) const
+    {
+      size_t byteOffset = m_position >> 3;
+      uint64_t word;
+      if (byteOffset + 8 <= m_size)
+        word = *(const PUInt64b *)(m_data + byteOffset);
+      else {
+        word = 0;
+        for (unsigned i = 0; byteOffset + i < m_size; ++i)
+          word |= (uint64_t)m_data[byteOffset + i] << (56 - 8*i);
+      }
+      return (unsigned)((word << (m_position & 7)) >> (64 - nBits));
+    }
+
+    unsigned GetBits(unsigned nBits)
+    {
+      unsigned value = PeekBits(nBits);
+      m_position += nBits;
+      return value;
+    }
+
+    bool SingleBit()
+    {
+      if (IsAtEnd())
+        return false;
+      bool bit = (m_data[m_position >> 3] & (0x80 >> (m_position & 7))) != 0;
+      ++m_position;
+      return bit;
+    }
+
+    bool MultiBit(unsigned nBits, unsigned & value)
+    {
+      if (nBits > 32 || nBits > GetBitsLeft())
+        return false;
+
+      if (nBits == 0)
+        value = 0;
+      else
+        value = GetBits(nBits);
+      return true;
+    }
+
+    bool Block(unsigned nBytes, const BYTE * & ptr);
+    bool SmallUnsigned(unsigned & value);
+    bool Unsigned(unsigned lower, unsigned upper, unsigned & value);
+    bool Length(unsigned lower, unsigned upper, unsigned & len);
+    bool ConstrainedLength(const PPER_Type & type, unsigned & len);
+    bool BitStringBits(unsigned nBits, BYTE * local, const BYTE * & bits);
+
+    bool DecodeInteger(const PPER_Type & type, PPER_Value & value);
+    bool DecodeEnumeration(const PPER_Type & type, PPER_Value & value);
+    bool DecodeBitString(const PPER_Type & type, PPER_Value & value);
+    bool DecodeOctetString(const PPER_Type & type, PPER_Value & value);
+    bool DecodeFixedOctets(unsigned nBytes, PPER_Value & value);
+    bool DecodeString(const PPER_Type & type, PPER_Value & value);
+    bool DecodeBMPString(const PPER_Type & type, PPER_Value & value);
+    bool DecodeChoice(const PPER_Type & type, PPER_Value & value);
+    bool DecodeSequence(const PPER_Type & type, PPER_Value & value);
+    bool DecodeArray(const PPER_Type & type, PPER_Value & value);
+
+    const BYTE * m_data;
+    size_t       m_size;
+    size_t       m_limit;
+    size_t       m_position;  // In bits
+    bool         m_aligned;
+    PPER_Arena & m_arena;
+};
+
+
+bool PPER_TableDecoder::Block(unsigned nBytes, const BYTE * & ptr)
+{
+  // Same checks as PASN_Stream::BlockDecode(), including not aligning for zero
+  if (nBytes == 0)
+    return true;
+
+  if (GetPosition() + nBytes > (size_t)PASN_Object::GetMaximumStringSize())
+    return false;
+
+  ByteAlign();
+  if (GetPosition() + nBytes > m_size)
+    return false;
+
+  ptr = m_data + GetPosition();
+  m_position += (size_t)nBytes*8;
+  return true;
+}
+
+
+bool PPER_TableDecoder::SmallUnsigned(unsigned & value)
+{
+  // X.691 Section 10.6
+
+  if (!SingleBit())
+    return MultiBit(6, value);      // 10.6.1
+
+  unsigned len = 0;
+  if (!Length(0, INT_MAX, len))  // 10.6.2
+    return false;
+
+  ByteAlign();
+  return MultiBit(len*8, value);
+}
+
+
+bool PPER_TableDecoder::Unsigned(unsigned lower, unsigned upper, unsigned & value)
+{
+  // X.691 section 10.5
+
+  if (lower == upper) { // 10.5.4
+    value = lower;
+    return true;
+  }
+
+  if (IsAtEnd())
+    return false;
+
+  unsigned range = (upper - lower) + 1;
+  unsigned nBits = CountBits(range);
+
+  if (m_aligned && (range == 0 || range > 255)) { // not 10.5.6 and not 10.5.7.1
+    if (nBits > 16) {                           // not 10.5.7.4
+      if (!Length(1, (nBits+7)/8, nBits))      // 12.2.6
+        return false;
+      nBits *= 8;
+    }
+    else if (nBits > 8)    // not 10.5.7.2
+      nBits = 16;          // 10.5.7.3
+    ByteAlign();           // 10.7.5.2 - 10.7.5.4
+  }
+
+  if (!MultiBit(nBits, value))
+    return false;
+
+  value += lower;
+
+  // clamp value to upper limit
+  if (value > upper)
+    value = upper;
+
+  return true;
+}
+
+
+bool PPER_TableDecoder::Length(unsigned lower, unsigned upper, unsigned & len)
+{
+  // X.691 section 10.9
+
+  if (upper != INT_MAX && !m_aligned) {
+    if (upper - lower > 0xffff)
+      return false; // 10.9.4.2 unsupported
+    unsigned base;
+    if (!MultiBit(CountBits(upper - lower + 1), base))
+      return false;
+    len = lower + base;   // 10.9.4.1
+    if (len > upper)
+      len = upper;
+    return true;
+  }
+
+  if (upper < 65536)  // 10.9.3.3
+    return Unsigned(lower, upper, len);
+
+  // 10.9.3.5
+  ByteAlign();
+  if (IsAtEnd())
+    return false;
+
+  if (!SingleBit()) {
+    if (!MultiBit(7, len))   // 10.9.3.6
+      return false;
+  }
+  else if (!SingleBit()) {
+    if (!MultiBit(14, len))  // 10.9.3.7
+      return false;
+  }
+  else
+    return false;            // 10.9.3.8 unsupported
+
+  if (len > upper)
+    len = upper;
+  return true;
+}
+
+
+bool PPER_TableDecoder::ConstrainedLength(const PPER_Type & type, unsigned & len)
+{
+  // The SingleBit() must be read if extendable, no matter what.
+  if ((type.m_extendable && SingleBit()) || type.m_constraint == PASN_Object::Unconstrained)
+    return Length(0, INT_MAX, len);
+  else
+    return Length(type.m_lower, type.m_upper, len);
+}
+
+
+bool PPER_TableDecoder::BitStringBits(unsigned nBits, BYTE * local, const BYTE * & bits)
+{
+  if (nBits == 0)
+    return true;   // 15.7
+
+  if (nBits > GetBitsLeft())
+    return false;
+
+  if (nBits > 16)
+    return Block((nBits+7)/8, bits);   // 15.9
+
+  if (nBits <= 8)
+    local[0] = (BYTE)(GetBits(nBits) << (8-nBits));
+  else {  // 15.8
+    local[0] = (BYTE)GetBits(8);
+    local[1] = (BYTE)(GetBits(nBits-8) << (16-nBits));
+  }
+  bits = local;
+  return true;
+}
+
+
+bool PPER_TableDecoder::DecodeValue(const PPER_Type & type, PPER_Value & value)
+{
+  value.m_type = &type;
+
+  switch (type.m_kind) {
+    case PPER_Type::e_Null :
+      return true;
+
+    case PPER_Type::e_Boolean :
+      if (IsAtEnd())
+        return false;
+      value.m_value = SingleBit();
+      return true;
+
+    case PPER_Type::e_Integer :
+      return DecodeInteger(type, value);
+
+    case PPER_Type::e_Enumeration :
+      return DecodeEnumeration(type, value);
+
+    case PPER_Type::e_Real :
+    {
+      // X.691 Section 14, skipped in the same way as PPER_Stream::RealDecode()
+      unsigned len;
+      if (IsAtEnd() || !MultiBit(8, len))
+        return false;
+      m_position += (size_t)(len+1)*8;
+      return true;
+    }
+
+    case PPER_Type::e_ObjectId :
+    {
+      // X.691 Section 23
+      unsigned len;
+      if (!Length(0, 255, len))
+        return false;
+      ByteAlign();
+      value.m_size = len;
+      return Block(len, (const BYTE * &)value.m_data);
+    }
+
+    case PPER_Type::e_BitString :
+      return DecodeBitString(type, value);
+
+    case PPER_Type::e_OctetString :
+      return DecodeOctetString(type, value);
+
+    case PPER_Type::e_String :
+      return DecodeString(type, value);
+
+    case PPER_Type::e_BMPString :
+      return DecodeBMPString(type, value);
+
+    case PPER_Type::e_Choice :
+      return DecodeChoice(type, value);
+
+    case PPER_Type::e_Sequence :
+      return DecodeSequence(type, value);
+
+    case PPER_Type::e_Array :
+      return DecodeArray(type, value);
+
+    case PPER_Type::e_OpenType :
+    {
+      value.m_size = (unsigned)(m_size - GetPosition());
+      return Block(value.m_size, (const BYTE * &)value.m_data);
+    }
+  }
+
+  PTRACE(2, "PER-Table", "Unknown kind " << (unsigned)type.m_kind << " in table " << type.m_name);
+  return false;
+}
+
+
+bool PPER_TableDecoder::DecodeInteger(const PPER_Type & type, PPER_Value & value)
+{
+  // X.691 Sections 12
+
+  switch (type.m_constraint) {
+    case PASN_Object::FixedConstraint : // 12.2.1 & 12.2.2
+      break;
+
+    case PASN_Object::ExtendableConstraint :
+      if (!SingleBit()) //  12.1
+        break;
+      // Fall into default case for unconstrained or partially constrained
+
+    default : // 12.2.6
+      unsigned len;
+      if (!Length(0, INT_MAX, len))
+        return false;
+
+      len *= 8;
+      if (!MultiBit(len, value.m_value))
+        return false;
+
+      if (type.m_constraint != PASN_Object::Unconstrained && type.m_lower >= 0)
+        value.m_value += type.m_lower;
+      else if (len > 0 && len < 32 && (value.m_value&(1<<(len-1))) != 0) // Negative
+        value.m_value |= UINT_MAX << len;                                // Sign extend
+      return true;
+  }
+
+  if ((unsigned)type.m_lower != type.m_upper)  // 12.2.2
+    return Unsigned(type.m_lower, type.m_upper, value.m_value); // which devolves to 10.5
+
+  // 12.2.1
+  value.m_value = type.m_lower;
+  return true;
+}
+
+
+bool PPER_TableDecoder::DecodeEnumeration(const PPER_Type & type, PPER_Value & value)
+{
+  // X.691 Section 13
+
+  if (type.m_extendable) {  // 13.3
+    if (SingleBit()) {
+      unsigned len = 0;
+      return SmallUnsigned(len) && len > 0 && Unsigned(0, len-1, value.m_value);
+    }
+  }
+
+  return Unsigned(0, type.m_count, value.m_value);  // 13.2
+}
+
+
+bool PPER_TableDecoder::DecodeBitString(const PPER_Type & type, PPER_Value & value)
+{
+  // X.691 Section 15
+
+  unsigned nBits;
+  if (!ConstrainedLength(type, nBits))
+    return false;
+
+  if (nBits > (unsigned)PASN_Object::GetMaximumStringSize())
+    return false;
+
+  value.m_size = nBits;
+  if (nBits == 0)
+    return true;
+
+  BYTE * local = (BYTE *)m_arena.Allocate(2);
+  return local != NULL && BitStringBits(nBits, local, (const BYTE * &)value.m_data);
+}
+
+
+bool PPER_TableDecoder::DecodeFixedOctets(unsigned nBytes, PPER_Value & value)
+{
+  value.m_size = nBytes;
+
+  switch (nBytes) {
+    case 0 :
+      return true;
+
+    case 1 :  // 16.6
+    case 2 :
+    {
+      if (nBytes*8 > GetBitsLeft())
+        return false;
+      BYTE * octets = (BYTE *)m_arena.Allocate(2);
+      if (octets == NULL)
+        return false;
+      octets[0] = (BYTE)GetBits(8);
+      if (nBytes == 2)
+        octets[1] = (BYTE)GetBits(8);
+      value.m_data = octets;
+      return true;
+    }
+
+    default: // 16.7
+      return Block(nBytes, (const BYTE * &)value.m_data);
+  }
+}
+
+
+bool PPER_TableDecoder::DecodeOctetString(const PPER_Type & type, PPER_Value & value)
+{
+  // X.691 Section 16
+
+  unsigned nBytes;
+  if (!ConstrainedLength(type, nBytes))
+    return false;
+
+  if (nBytes > (unsigned)PASN_Object::GetMaximumStringSize())   // 16.5
+    return false;
+
+  if ((int)type.m_upper != type.m_lower) {
+    value.m_size = nBytes;
+    return Block(nBytes, (const BYTE * &)value.m_data);
+  }
+
+  return DecodeFixedOctets(nBytes, value);
+}
+
+
+bool PPER_TableDecoder::DecodeString(const PPER_Type & type, PPER_Value & value)
+{
+  // X.691 Section 26
+
+  unsigned len;
+  if (!ConstrainedLength(type, len))
+    return false;
+
+  value.m_size = len;
+  if (len == 0) // 10.9.3.3
+    return true;
+
+  unsigned nBits = m_aligned ? type.m_alignedBits : type.m_unalignedBits;
+  unsigned totalBits = type.m_upper*nBits;
+
+  if (type.m_constraint == PASN_Object::Unconstrained ||
+            (type.m_lower == (int)type.m_upper ? (totalBits > 16) : (totalBits >= 16))) {
+    if (nBits == 8)
+      return Block(len, (const BYTE * &)value.m_data);
+    if (m_aligned)
+      ByteAlign();
+  }
+
+  if (len > (unsigned)PASN_Object::GetMaximumStringSize())
+    return false;
+
+  // One check for the whole string, then unchecked reads
+  if (nBits == 0 || (size_t)len*nBits > GetBitsLeft())
+    return false;
+
+  char * chars = (char *)m_arena.Allocate(len);
+  if (chars == NULL)
+    return false;
+  value.m_data = chars;
+
+  if (nBits >= type.m_canonicalBits && type.m_canonicalBits > 4) {
+    for (unsigned i = 0; i < len; ++i)
+      chars[i] = (char)GetBits(nBits);
+  }
+  else {
+    for (unsigned i = 0; i < len; ++i) {
+      unsigned index = GetBits(nBits);
+      chars[i] = index < type.m_charSetSize ? type.m_charSet[index] : '\0';
+    }
+  }
+
+  return true;
+}
+
+
+bool PPER_TableDecoder::DecodeBMPString(const PPER_Type & type, PPER_Value & value)
+{
+  // X.691 Section 26
+
+  unsigned len;
+  if (!ConstrainedLength(type, len))
+    return false;
+
+  if (len > (unsigned)PASN_Object::GetMaximumStringSize())
+    return false;
+
+  value.m_size = len;
+
+  unsigned nBits = m_aligned ? type.m_alignedBits : type.m_unalignedBits;
+  if ((type.m_constraint == PASN_Object::Unconstrained || type.m_upper*nBits > 16) && m_aligned)
+    ByteAlign();
+
+  if (len == 0)
+    return true;
+
+  if (nBits == 0 || (size_t)len*nBits > GetBitsLeft())
+    return false;
+
+  WORD * chars = (WORD *)m_arena.Allocate(len*sizeof(WORD));
+  if (chars == NULL)
+    return false;
+  value.m_data = chars;
+
+  for (unsigned i = 0; i < len; ++i)
+    chars[i] = (WORD)GetBits(nBits);
+
+  return true;
+}
+
+
+bool PPER_TableDecoder::DecodeChoice(const PPER_Type & type, PPER_Value & value)
+{
+  // X.691 Section 22
+
+  if (IsAtEnd())
+    return false;
+
+  value.m_children = m_arena.AllocateValues(1);
+  if (value.m_children == NULL)
+    return false;
+
+  if (type.m_extendable && SingleBit()) {
+    if (!SmallUnsigned(value.m_value))
+      return false;
+
+    value.m_value += type.m_count;
+
+    unsigned len = 0;
+    if (!Length(0, INT_MAX, len))
+      return false;
+
+    if (value.m_value < type.m_count + type.m_extensions) {
+      size_t nextPos = GetPosition() + len;
+      bool ok = DecodeValue(*type.m_fields[value.m_value].m_type, *value.m_children);
+      SetPosition(nextPos);
+      return ok;
+    }
+
+    // Open type, as a fixed size PASN_OctetString
+    value.m_children->m_type = &PPER_Type::OpenType;
+    unsigned dummy;
+    if (!Length(len, len, dummy) || len > (unsigned)PASN_Object::GetMaximumStringSize())
+      return false;
+    return DecodeFixedOctets(len, *value.m_children) && len > 0;
+  }
+
+  if (type.m_count < 2)
+    value.m_value = 0;
+  else {
+    if (!Unsigned(0, type.m_count-1, value.m_value))
+      return false;
+  }
+
+  return DecodeValue(*type.m_fields[value.m_value].m_type, *value.m_children);
+}
+
+
+bool PPER_TableDecoder::DecodeSequence(const PPER_Type & type, PPER_Value & value)
+{
+  // X.691 Section 18
+
+  bool hasExtensions = false;
+  if (type.m_extendable) {
+    if (IsAtEnd())
+      return false;
+    hasExtensions = SingleBit(); // 18.1
+  }
+
+  // 18.2, the option map is a fixed size PASN_BitString
+  unsigned nOptions;
+  if (!Length(type.m_options, type.m_options, nOptions))
+    return false;
+
+  BYTE localOptions[2];
+  const BYTE * options = NULL;
+  if (!BitStringBits(type.m_options, localOptions, options))
+    return false;
+
+  unsigned knownFields = type.m_count + type.m_extensions;
+  value.m_children = m_arena.AllocateValues(knownFields);
+  if (value.m_children == NULL && knownFields > 0)
+    return false;
+
+  for (unsigned i = 0; i < type.m_count; ++i) {
+    const PPER_Field & field = type.m_fields[i];
+    if (field.m_option >= 0 && !TestBit(options, field.m_option))
+      continue;
+    if (!DecodeValue(*field.m_type, value.m_children[i]))
+      return false;
+  }
+
+  if (!hasExtensions)
+    return true;
+
+  // Extension bit map, as per PASN_BitString::DecodeSequenceExtensionBitmap()
+  unsigned totalExtensions;
+  if (!SmallUnsigned(totalExtensions))
+    return false;
+
+  totalExtensions++;
+  if (totalExtensions > (unsigned)PASN_Object::GetMaximumStringSize() || totalExtensions > GetBitsLeft())
+    return false;
+
+  BYTE * extensions = (BYTE *)m_arena.Allocate((totalExtensions+7)/8);
+  if (extensions == NULL)
+    return false;
+
+  unsigned bitsLeft = totalExtensions;
+  BYTE * ptr = extensions;
+  while (bitsLeft >= 8) {
+    *ptr++ = (BYTE)GetBits(8);
+    bitsLeft -= 8;
+  }
+  if (bitsLeft > 0)
+    *ptr = (BYTE)(GetBits(bitsLeft) << (8-bitsLeft));
+
+  value.m_size = totalExtensions;
+
+  // Known extensions
+  unsigned i;
+  for (i = 0; i < type.m_extensions && i < totalExtensions; ++i) {
+    if (!TestBit(extensions, i))
+      continue;
+
+    unsigned len;
+    if (!Length(0, INT_MAX, len))
+      return false;
+
+    size_t nextPos = GetPosition() + len;
+    bool ok = DecodeValue(*type.m_fields[type.m_count+i].m_type, value.m_children[type.m_count+i]);
+    SetPosition(nextPos);
+    if (!ok)
+      return false;
+  }
+
+  if (totalExtensions <= type.m_extensions)
+    return true;
+
+  // Unknown extensions, each an unconstrained PASN_OctetString
+  unsigned unknownCount = totalExtensions - type.m_extensions;
+  if (unknownCount > (unsigned)PASN_Object::GetMaximumArraySize())
+    return false;
+
+  PPER_Value * children = m_arena.AllocateValues(knownFields + unknownCount);
+  if (children == NULL)
+    return false;
+  memcpy(children, value.m_children, knownFields*sizeof(PPER_Value));
+  value.m_children = children;
+
+  for (; i < totalExtensions; ++i) {
+    if (TestBit(extensions, i)) {
+      PPER_Value & unknown = children[type.m_count+i];
+      unknown.m_type = &PPER_Type::OpenType;
+      if (!Length(0, INT_MAX, unknown.m_size) ||
+           unknown.m_size > (unsigned)PASN_Object::GetMaximumStringSize() ||
+          !Block(unknown.m_size, (const BYTE * &)unknown.m_data))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool PPER_TableDecoder::DecodeArray(const PPER_Type & type, PPER_Value & value)
+{
+  unsigned size = 0;
+  if (!ConstrainedLength(type, size))
+    return false;
+
+  if (size > (unsigned)PASN_Object::GetMaximumArraySize())
+    return false;
+
+  value.m_size = size;
+  if (size == 0)
+    return true;
+
+  value.m_children = m_arena.AllocateValues(size);
+  if (value.m_children == NULL)
+    return false;
+
+  const PPER_Type & elementType = *type.m_fields[0].m_type;
+  for (unsigned i = 0; i < size; ++i) {
+    if (!DecodeValue(elementType, value.m_children[i]))
+      return false;
+  }
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+
+class PPER_TableEncoder
+{
+  public:
+    PPER_TableEncoder(PBYTEArray & buffer, bool aligned)
+      : m_buffer(buffer)
+      , m_data(NULL)
+      , m_capacity(0)
+      , m_size(0)
+      , m_accumulator(0)
+      , m_pending(0)
+      , m_aligned(aligned)
+    { }
+
+    bool EncodeValue(const PPER_Value & value);
+    bool Complete();
+
+  protected:
+    bool Reserve(size_t nBytes)
+    {
+      if (m_size + nBytes <= m_capacity)
+        return true;
+
+      size_t newCapacity = std::max((m_size + nBytes)*2, (size_t)256);
+      m_data = m_buffer.GetPointer((PINDEX)newCapacity);
+      if (m_data == NULL)
+        return false;
+      m_capacity = newCapacity;
+      return true;
+    }
+
+    // Write up to 32 bits, the accumulator never holds more than 7 after
+    void Bits(unsigned value, unsigned nBits)
+    {
+      if (nBits == 0)
+        return;
+
+      if (nBits < 32)
+        value &= (1U << nBits) - 1;
+      m_accumulator = (m_accumulator << nBits) | value;
+      m_pending += nBits;
+
+      if (m_pending >= 32) {
+        m_pending -= 32;
+        *(PUInt32b *)(m_data + m_size) = (uint32_t)(m_accumulator >> m_pending);
+        m_size += 4;
+      }
+      while (m_pending >= 8) {
+        m_pending -= 8;
+        m_data[m_size++] = (BYTE)(m_accumulator >> m_pending);
+      }
+    }
+
+    void Bit(bool value) { Bits(value, 1); }
+
+    void ByteAlign()
+    {
+      if (m_pending > 0)
+        Bits(0, 8 - m_pending);
+    }
+
+    bool Block(const void * data, unsigned nBytes)
+    {
+      if (nBytes == 0)
+        return true;
+      ByteAlign();
+      if (!Reserve(nBytes+8))
+        return false;
+      memcpy(m_data + m_size, data, nBytes);
+      m_size += nBytes;
+      return true;
+    }
+
+    bool SmallUnsigned(unsigned value);
+    bool Unsigned(unsigned value, unsigned lower, unsigned upper);
+    bool Length(unsigned len, unsigned lower, unsigned upper);
+    bool ConstraintEncode(const PPER_Type & type, unsigned value);
+    bool ConstrainedLength(const PPER_Type & type, unsigned len);
+    bool EncodeOpenType(const PPER_Value & value);
+
+    bool EncodeInteger(const PPER_Type & type, const PPER_Value & value);
+    bool EncodeEnumeration(const PPER_Type & type, const PPER_Value & value);
+    bool EncodeBitString(const PPER_Type & type, const PPER_Value & value);
+    bool EncodeOctetString(const PPER_Type & type, const PPER_Value & value);
+    bool EncodeString(const PPER_Type & type, const PPER_Value & value);
+    bool EncodeBMPString(const PPER_Type & type, const PPER_Value & value);
+    bool EncodeChoice(const PPER_Type & type, const PPER_Value & value);
+    bool EncodeSequence(const PPER_Type & type, const PPER_Value & value);
+    bool EncodeArray(const PPER_Type & type, const PPER_Value & value);
+
+    PBYTEArray & m_buffer;
+    BYTE       * m_data;
+    size_t       m_capacity;
+    size_t       m_size;         // Complete bytes in m_data
+    uint64_t     m_accumulator;
+    unsigned     m_pending;      // Bits in m_accumulator not yet in m_data
+    bool         m_aligned;
+};
+
+
+bool PPER_TableEncoder::Complete()
+{
+  if (!Reserve(8))
+    return false;
+  ByteAlign();
+  return m_buffer.SetSize((PINDEX)m_size);
+}
+
+
+bool PPER_TableEncoder::SmallUnsigned(unsigned value)
+{
+  // X.691 Section 10.6
+
+  if (value < 64) {
+    Bits(value, 7);
+    return true;
+  }
+
+  Bit(true);  // 10.6.2
+
+  unsigned len = 4;
+  if (value < 256)
+    len = 1;
+  else if (value < 65536)
+    len = 2;
+  else if (value < 0x1000000)
+    len = 3;
+  if (!Length(len, 0, INT_MAX))  // 10.9
+    return false;
+  ByteAlign();
+  Bits(value, len*8);
+  return true;
+}
+
+
+bool PPER_TableEncoder::Unsigned(unsigned value, unsigned lower, unsigned upper)
+{
+  // X.691 section 10.5
+
+  if (lower == upper) // 10.5.4
+    return true;
+
+  unsigned range = (upper - lower) + 1;
+  unsigned nBits = CountBits(range);
+
+  if (value < lower)
+    value = 0;
+  else
+    value -= lower;
+
+  if (m_aligned && (range == 0 || range > 255)) { // not 10.5.6 and not 10.5.7.1
+    if (nBits > 16) {                           // not 10.5.7.4
+      unsigned numBytes = value == 0 ? 1 : ((CountBits(value + 1))+7)/8;
+      if (!Length(numBytes, 1, (nBits+7)/8))    // 12.2.6
+        return false;
+      nBits = numBytes*8;
+    }
+    else if (nBits > 8)      // not 10.5.7.2
+      nBits = 16;            // 10.5.7.3
+    ByteAlign();             // 10.7.5.2 - 10.7.5.4
+  }
+
+  Bits(value, nBits);
+  return true;
+}
+
+
+bool PPER_TableEncoder::Length(unsigned len, unsigned lower, unsigned upper)
+{
+  // X.691 section 10.9
+
+  if (upper != INT_MAX && !m_aligned) {
+    if (upper - lower >= 0x10000)
+      return false;  // 10.9.4.2 unsupported
+    Bits(len - lower, CountBits(upper - lower + 1));   // 10.9.4.1
+    return true;
+  }
+
+  if (upper < 65536) // 10.9.3.3
+    return Unsigned(len, lower, upper);
+
+  ByteAlign();
+
+  if (len < 128) {
+    Bits(len, 8);   // 10.9.3.6
+    return true;
+  }
+
+  if (len < 0x4000) {
+    Bits(0x8000|len, 16);    // 10.9.3.7
+    return true;
+  }
+
+  return false;  // 10.9.3.8 unsupported
+}
+
+
+bool PPER_TableEncoder::ConstraintEncode(const PPER_Type & type, unsigned value)
+{
+  if (!type.m_extendable)
+    return type.m_constraint != PASN_Object::FixedConstraint;
+
+  bool needsExtending = value > type.m_upper;
+  if (!needsExtending) {
+    if (type.m_lower < 0)
+      needsExtending = (int)value < type.m_lower;
+    else
+      needsExtending = value < (unsigned)type.m_lower;
+  }
+
+  Bit(needsExtending);
+  return needsExtending;
+}
+
+
+bool PPER_TableEncoder::ConstrainedLength(const PPER_Type & type, unsigned len)
+{
+  if (ConstraintEncode(type, len)) // 26.4
+    return Length(len, 0, INT_MAX);
+  else
+    return Length(len, type.m_lower, type.m_upper);
+}
+
+
+bool PPER_TableEncoder::EncodeOpenType(const PPER_Value & value)
+{
+  // As PPER_Stream::AnyTypeEncode(), which always uses an aligned sub-stream
+
+  if (!Reserve(8))
+    return false;
+  ByteAlign();
+  size_t lengthPosition = m_size++;
+
+  bool wasAligned = m_aligned;
+  m_aligned = true;
+  bool ok = EncodeValue(value);
+  ByteAlign();
+  m_aligned = wasAligned;
+  if (!ok || !Reserve(1))
+    return false;
+
+  size_t nBytes = m_size - lengthPosition - 1;
+  if (nBytes == 0) {
+    m_data[m_size++] = 0;
+    nBytes = 1;
+  }
+
+  if (nBytes < 128)
+    m_data[lengthPosition] = (BYTE)nBytes;
+  else if (nBytes < 0x4000) {
+    memmove(m_data + lengthPosition + 2, m_data + lengthPosition + 1, nBytes);
+    m_data[lengthPosition] = (BYTE)(0x80 | (nBytes >> 8));
+    m_data[lengthPosition+1] = (BYTE)nBytes;
+    ++m_size;
+  }
+  else
+    return false;
+
+  return true;
+}
+
+
+bool PPER_TableEncoder::EncodeValue(const PPER_Value & value)
+{
+  if (!PAssert(value.m_type != NULL, PInvalidParameter))
+    return false;
+
+  // Enough for any of the fixed bit writes, Block() reserves for itself
+  if (!Reserve(32))
+    return false;
+
+  const PPER_Type & type = *value.m_type;
+  switch (type.m_kind) {
+    case PPER_Type::e_Null :
+      return true;
+
+    case PPER_Type::e_Boolean :
+      Bit(value.m_value != 0);
+      return true;
+
+    case PPER_Type::e_Integer :
+      return EncodeInteger(type, value);
+
+    case PPER_Type::e_Enumeration :
+      return EncodeEnumeration(type, value);
+
+    case PPER_Type::e_Real :
+      Bits(0, 16);
+      return true;
+
+    case PPER_Type::e_ObjectId :
+      return Length(value.m_size, 0, 255) && Block(value.m_data, value.m_size);
+
+    case PPER_Type::e_BitString :
+      return EncodeBitString(type, value);
+
+    case PPER_Type::e_OctetString :
+      return EncodeOctetString(type, value);
+
+    case PPER_Type::e_String :
+      return EncodeString(type, value);
+
+    case PPER_Type::e_BMPString :
+      return EncodeBMPString(type, value);
+
+    case PPER_Type::e_Choice :
+      return EncodeChoice(type, value);
+
+    case PPER_Type::e_Sequence :
+      return EncodeSequence(type, value);
+
+    case PPER_Type::e_Array :
+      return EncodeArray(type, value);
+
+    case PPER_Type::e_OpenType :
+      return Block(value.m_data, value.m_size);
+  }
+
+  PTRACE(2, "PER-Table", "Unknown kind " << (unsigned)type.m_kind << " in table " << type.m_name);
+  return false;
+}
+
+
+bool PPER_TableEncoder::EncodeInteger(const PPER_Type & type, const PPER_Value & value)
+{
+  // X.691 Sections 12
+
+  //  12.1
+  if (ConstraintEncode(type, value.m_value)) {
+    // 12.2.6
+    unsigned adjusted_value = value.m_value - type.m_lower;
+
+    unsigned nBits = 1; // Allow for sign bit
+    if (type.m_constraint != PASN_Object::Unconstrained && type.m_lower >= 0)
+      nBits = CountBits(adjusted_value+1);
+    else if ((int)adjusted_value > 0)
+      nBits += CountBits(adjusted_value+1);
+    else
+      nBits += CountBits(-(int)adjusted_value+1);
+
+    // Round up to nearest number of whole octets
+    unsigned nBytes = (nBits+7)/8;
+    if (!Length(nBytes, 0, INT_MAX))
+      return false;
+    if (nBytes > 4)
+      Bits((int)adjusted_value < 0 ? UINT_MAX : 0, (nBytes-4)*8);
+    Bits(adjusted_value, std::min(nBytes, 4U)*8);
+    return true;
+  }
+
+  if ((unsigned)type.m_lower == type.m_upper) // 12.2.1
+    return true;
+
+  // 12.2.2 which devolves to 10.5
+  return Unsigned(value.m_value, type.m_lower, type.m_upper);
+}
+
+
+bool PPER_TableEncoder::EncodeEnumeration(const PPER_Type & type, const PPER_Value & value)
+{
+  // X.691 Section 13
+
+  if (type.m_extendable) {  // 13.3
+    bool extended = value.m_value > type.m_count;
+    Bit(extended);
+    if (extended)
+      return SmallUnsigned(1+value.m_value) && Unsigned(value.m_value, 0, value.m_value);
+  }
+
+  return Unsigned(value.m_value, 0, type.m_count);  // 13.2
+}
+
+
+bool PPER_TableEncoder::EncodeBitString(const PPER_Type & type, const PPER_Value & value)
+{
+  // X.691 Section 15
+
+  unsigned nBits = value.m_size;
+  if (!ConstrainedLength(type, nBits))
+    return false;
+
+  const BYTE * bits = (const BYTE *)value.m_data;
+  if (nBits == 0)
+    return true;
+
+  if (nBits > 16)
+    return Block(bits, (nBits+7)/8);   // 15.9
+
+  if (nBits <= 8)  // 15.8
+    Bits(bits[0] >> (8 - nBits), nBits);
+  else {
+    Bits(bits[0], 8);
+    Bits(bits[1] >> (16 - nBits), nBits-8);
+  }
+  return true;
+}
+
+
+bool PPER_TableEncoder::EncodeOctetString(const PPER_Type & type, const PPER_Value & value)
+{
+  // X.691 Section 16
+
+  unsigned nBytes = value.m_size;
+  if (!ConstrainedLength(type, nBytes))
+    return false;
+
+  const BYTE * octets = (const BYTE *)value.m_data;
+  if ((int)type.m_upper != type.m_lower || nBytes > 2)
+    return Block(octets, nBytes);  // 16.7
+
+  // 16.6
+  for (unsigned i = 0; i < nBytes; ++i)
+    Bits(octets[i], 8);
+  return true;
+}
+
+
+bool PPER_TableEncoder::EncodeString(const PPER_Type & type, const PPER_Value & value)
+{
+  // X.691 Section 26
+
+  unsigned len = value.m_size;
+  if (!ConstrainedLength(type, len))
+    return false;
+
+  if (len == 0) // 10.9.3.3
+    return true;
+
+  const char * chars = (const char *)value.m_data;
+  unsigned nBits = m_aligned ? type.m_alignedBits : type.m_unalignedBits;
+  unsigned totalBits = type.m_upper*nBits;
+
+  if (type.m_constraint == PASN_Object::Unconstrained ||
+            (type.m_lower == (int)type.m_upper ? (totalBits > 16) : (totalBits >= 16))) {
+    // 26.5.7
+    if (nBits == 8)
+      return Block(chars, len);
+    if (m_aligned)
+      ByteAlign();
+  }
+
+  if (!Reserve(((size_t)len*nBits+7)/8 + 8))
+    return false;
+
+  if (nBits >= type.m_canonicalBits && type.m_canonicalBits > 4) {
+    for (unsigned i = 0; i < len; ++i)
+      Bits((BYTE)chars[i], nBits);
+  }
+  else {
+    for (unsigned i = 0; i < len; ++i) {
+      const void * ptr = memchr(type.m_charSet, chars[i], type.m_charSetSize);
+      Bits(ptr != NULL ? (unsigned)((const char *)ptr - type.m_charSet) : 0, nBits);
+    }
+  }
+
+  return true;
+}
+
+
+bool PPER_TableEncoder::EncodeBMPString(const PPER_Type & type, const PPER_Value & value)
+{
+  // X.691 Section 26
+
+  unsigned len = value.m_size;
+  if (!ConstrainedLength(type, len))
+    return false;
+
+  unsigned nBits = m_aligned ? type.m_alignedBits : type.m_unalignedBits;
+  if ((type.m_constraint == PASN_Object::Unconstrained || type.m_upper*nBits > 16) && m_aligned)
+    ByteAlign();
+
+  if (!Reserve(((size_t)len*nBits+7)/8 + 8))
+    return false;
+
+  const WORD * chars = (const WORD *)value.m_data;
+  for (unsigned i = 0; i < len; ++i)
+    Bits(chars[i], nBits);
+
+  return true;
+}
+
+
+bool PPER_TableEncoder::EncodeChoice(const PPER_Type & type, const PPER_Value & value)
+{
+  // X.691 Section 22
+
+  if (!PAssert(value.m_children != NULL && value.m_children->m_type != NULL, PInvalidParameter))
+    return false;
+
+  if (type.m_extendable) {
+    bool extended = value.m_value >= type.m_count;
+    Bit(extended);
+    if (extended)
+      return SmallUnsigned(value.m_value - type.m_count) && EncodeOpenType(*value.m_children);
+  }
+
+  if (type.m_count > 1 && !Unsigned(value.m_value, 0, type.m_count-1))
+    return false;
+
+  return EncodeValue(*value.m_children);
+}
+
+
+bool PPER_TableEncoder::EncodeSequence(const PPER_Type & type, const PPER_Value & value)
+{
+  // X.691 Section 18
+
+  unsigned totalFields = type.m_count + std::max(type.m_extensions, value.m_size);
+
+  // Extension bit map is trimmed of trailing zeros, as per PASN_BitString::EncodeSequenceExtensionBitmap()
+  unsigned totalExtensions = 0;
+  for (unsigned i = type.m_count; i < totalFields; ++i) {
+    if (value.m_children[i].IsPresent())
+      totalExtensions = i - type.m_count + 1;
+  }
+
+  if (type.m_extendable)
+    Bit(totalExtensions > 0);  // 18.1
+
+  // 18.2, the option map is a fixed size PASN_BitString
+  if (!Length(type.m_options, type.m_options, type.m_options))
+    return false;
+
+  if (type.m_options > 0) {
+    PBYTEArray optionStorage;
+    BYTE localOptions[8];
+    BYTE * options = localOptions;
+    unsigned optionBytes = (type.m_options+7)/8;
+    if (optionBytes > sizeof(localOptions))
+      options = optionStorage.GetPointer(optionBytes);
+    memset(options, 0, optionBytes);
+
+    for (unsigned i = 0; i < type.m_count; ++i) {
+      int option = type.m_fields[i].m_option;
+      if (option >= 0 && value.m_children[i].IsPresent())
+        options[option>>3] |= (BYTE)(0x80 >> (option&7));
+    }
+
+    if (type.m_options > 16) {
+      if (!Block(options, optionBytes))   // 15.9
+        return false;
+    }
+    else if (type.m_options <= 8)
+      Bits(options[0] >> (8 - type.m_options), type.m_options);
+    else {
+      Bits(options[0], 8);
+      Bits(options[1] >> (16 - type.m_options), type.m_options-8);
+    }
+  }
+
+  for (unsigned i = 0; i < type.m_count; ++i) {
+    const PPER_Value & field = value.m_children[i];
+    if (field.IsPresent()) {
+      if (!EncodeValue(field))
+        return false;
+    }
+    else if (type.m_fields[i].m_option < 0) {
+      PTRACE(2, "PER-Table", "Mandatory field " << type.m_fields[i].m_name << " missing in " << type.m_name);
+      return false;
+    }
+  }
+
+  if (totalExtensions == 0)
+    return true;
+
+  if (!Reserve(16) || !SmallUnsigned(totalExtensions-1))
+    return false;
+
+  for (unsigned i = 0; i < totalExtensions; ++i) {
+    if ((i&7) == 7 && !Reserve(8))
+      return false;
+    Bit(value.m_children[type.m_count+i].IsPresent());
+  }
+
+  for (unsigned i = 0; i < totalExtensions; ++i) {
+    const PPER_Value & field = value.m_children[type.m_count+i];
+    if (!field.IsPresent())
+      continue;
+
+    if (i < type.m_extensions) {
+      if (!EncodeOpenType(field))
+        return false;
+    }
+    else {
+      // Unknown extension, as an unconstrained PASN_OctetString
+      if (!Reserve(8) || !Length(field.m_size, 0, INT_MAX) || !Block(field.m_data, field.m_size))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+
+bool PPER_TableEncoder::EncodeArray(const PPER_Type & type, const PPER_Value & value)
+{
+  if (!ConstrainedLength(type, value.m_size))
+    return false;
+
+  for (unsigned i = 0; i < value.m_size; ++i) {
+    if (!EncodeValue(value.m_children[i]))
+      return false;
+  }
+
+  return true;
+}
+
+
+///////////////////////////////////////////////////////////////////////
+
+PPER_TableCodec::PPER_TableCodec(bool aligned)
+  : m_aligned(aligned)
+{
+}
+
+
+bool PPER_TableCodec::Decode(const PPER_Type & type,
+                             const BYTE * data,
+                             PINDEX size,
+                             PPER_Arena & arena,
+                             PPER_Value & value) const
+{
+  memset(&value, 0, sizeof(value));
+
+  PPER_TableDecoder decoder(data, size, m_aligned, arena);
+  if (decoder.DecodeValue(type, value))
+    return true;
+
+  PTRACE(4, "PER-Table", "Decode of " << type.m_name << " failed");
+  return false;
+}
+
+
+bool PPER_TableCodec::Encode(const PPER_Value & value, PBYTEArray & data) const
+{
+  PPER_TableEncoder encoder(data, m_aligned);
+  if (encoder.EncodeValue(value) && encoder.Complete())
+    return true;
+
+  PTRACE(4, "PER-Table", "Encode of " << (value.m_type != NULL ? value.m_type->m_name : "(null)") << " failed");
+  return false;
+}
+
+
+#endif // P_ASN
+
+
+// End Of File ///////////////////////////////////////////////////////////////
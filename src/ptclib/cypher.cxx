@@ -39,6 +39,27 @@
 #include <ptclib/random.h>
 
 
+/* CPU features for the SIMD and hardware accelerated versions of PBase64
+   and the message digests, determined at run time. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #include <cpuid.h>
+  #define P_CYPHER_SIMD 1
+  static bool const HasSSSE3 = __builtin_cpu_supports("ssse3");
+  static bool const HasAVX2 = __builtin_cpu_supports("avx2");
+
+  static bool CheckSHAExtensions()
+  {
+    // CPUID leaf 7, EBX bit 29, not all compilers know "sha" for __builtin_cpu_supports()
+    unsigned eax, ebx, ecx, edx;
+    return __builtin_cpu_supports("sse4.1") && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & (1 << 29)) != 0;
+  }
+  static bool const HasSHA = CheckSHAExtensions();
+#else
+  #define P_CYPHER_SIMD 0
+#endif
+
+
 
 ///////////////////////////////////////////////////////////////////////////////
 // PSASLString
@@ -152,50 +173,257 @@ void PSASLString::AppendValidated(wchar_t c)
 ///////////////////////////////////////////////////////////////////////////////
 // PBase64
 
+/* The bulk of the encoding and decoding is done on whole blocks of data
+   directly into pre-sized buffers, using SSSE3 or AVX2 where the CPU supports
+   it, as determined at run time. The SIMD algorithms are those of W. Mula and
+   D. Lemire, "Faster Base64 Encoding and Decoding using AVX2 Instructions". */
+
 static const char Alphabet[65] =
             "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 static const char AlphabetURL[65] =
             "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
 
-PBase64::PBase64(Options options, PINDEX width)
+
+#if P_CYPHER_SIMD
+
+/* Translate 16 bytes of 6 bit values to ASCII. The shift table gives the
+   offset from each value to its character, for each range in the alphabet. */
+__attribute__((target("ssse3")))
+static __m128i EncodeSSSE3(__m128i in, __m128i shiftLUT)
 {
-  StartEncoding(options, width);
-  StartDecoding();
+  in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+  __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+  __m128i indices = _mm_or_si128(t0, t1);
+
+  __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+  return _mm_add_epi8(_mm_shuffle_epi8(shiftLUT, range), indices);
 }
 
 
-void PBase64::StartEncoding(Options options, PINDEX width)
+__attribute__((target("ssse3")))
+static size_t EncodeTriplesSSSE3(const BYTE * data, size_t triples, char * out, char c62, char c63)
 {
-  m_encodedString.MakeEmpty();
-  m_currentLineLength = m_saveCount = 0;
+  __m128i shiftLUT = _mm_setr_epi8('a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52,
+                                   '0'-52, '0'-52, '0'-52, c62-62, c63-63, 'A', 0, 0);
+
+  // Reads 16 bytes to use 12, so stop before overrunning the input
+  size_t done = 0;
+  for (; (triples - done)*3 >= 16; done += 4) {
+    __m128i in = _mm_loadu_si128((const __m128i *)(data + done*3));
+    _mm_storeu_si128((__m128i *)(out + done*4), EncodeSSSE3(in, shiftLUT));
+  }
+  return done;
+}
+
+
+__attribute__((target("avx2")))
+static size_t EncodeTriplesAVX2(const BYTE * data, size_t triples, char * out, char c62, char c63)
+{
+  __m256i shiftLUT = _mm256_broadcastsi128_si256(_mm_setr_epi8('a'-26, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52, '0'-52,
+                                                               '0'-52, '0'-52, '0'-52, c62-62, c63-63, 'A', 0, 0));
+  __m256i shuffle = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+  // Each lane gets 12 bytes of input, reading 28 bytes in all
+  size_t done = 0;
+  for (; (triples - done)*3 >= 28; done += 8) {
+    const BYTE * ptr = data + done*3;
+    __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)ptr)),
+                                         _mm_loadu_si128((const __m128i *)(ptr+12)), 1);
+    in = _mm256_shuffle_epi8(in, shuffle);
+    __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+    __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+    __m256i indices = _mm256_or_si256(t0, t1);
+
+    __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices), _mm256_set1_epi8(13)));
+    _mm256_storeu_si256((__m256i *)(out + done*4), _mm256_add_epi8(_mm256_shuffle_epi8(shiftLUT, range), indices));
+  }
+  return done;
+}
+
+
+/* Decode 16 characters to 12 bytes. Characters are classified by their
+   nibbles, and any invalid character, including line endings and padding,
+   fails the whole block, which is then left to the scalar code. The URL
+   alphabet characters are first mapped to the standard ones.
+
+   Returns number of characters decoded. Whole registers are written, so
+   the output must have 16 bytes room after the last decoded byte. */
+__attribute__((target("ssse3")))
+static size_t DecodeQuadsSSSE3(const char * str, size_t length, BYTE * out, size_t room)
+{
+  __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+  __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+  size_t done = 0;
+  for (; done + 16 <= length && done/4*3 + 16 <= room; done += 16) {
+    __m128i in = _mm_loadu_si128((const __m128i *)(str + done));
+    in = _mm_add_epi8(in, _mm_and_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('-')), _mm_set1_epi8('+'-'-')));
+    in = _mm_add_epi8(in, _mm_and_si128(_mm_cmpeq_epi8(in, _mm_set1_epi8('_')), _mm_set1_epi8('/'-'_')));
+
+    __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), _mm_set1_epi8(0x0f));
+    __m128i loNibbles = _mm_and_si128(in, _mm_set1_epi8(0x0f));
+    __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lutLo, loNibbles), _mm_shuffle_epi8(lutHi, hiNibbles));
+    if (_mm_movemask_epi8(_mm_cmpgt_epi8(invalid, _mm_setzero_si128())) != 0)
+      break;
+
+    __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(in, _mm_set1_epi8('/')), hiNibbles));
+    in = _mm_maddubs_epi16(_mm_add_epi8(in, roll), _mm_set1_epi32(0x01400140));
+    in = _mm_madd_epi16(in, _mm_set1_epi32(0x00011000));
+    _mm_storeu_si128((__m128i *)(out + done/4*3), _mm_shuffle_epi8(in, pack));
+  }
+  return done;
+}
+
+
+// As above, 32 characters at a time
+__attribute__((target("avx2")))
+static size_t DecodeQuadsAVX2(const char * str, size_t length, BYTE * out, size_t room)
+{
+  __m256i lutLo = _mm256_broadcastsi128_si256(_mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                            0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a));
+  __m256i lutHi = _mm256_broadcastsi128_si256(_mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                            0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10));
+  __m256i lutRoll = _mm256_broadcastsi128_si256(_mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0));
+  __m256i pack = _mm256_broadcastsi128_si256(_mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7);
+
+  size_t done = 0;
+  for (; done + 32 <= length && done/4*3 + 32 <= room; done += 32) {
+    __m256i in = _mm256_loadu_si256((const __m256i *)(str + done));
+    in = _mm256_add_epi8(in, _mm256_and_si256(_mm256_cmpeq_epi8(in, _mm256_set1_epi8('-')), _mm256_set1_epi8('+'-'-')));
+    in = _mm256_add_epi8(in, _mm256_and_si256(_mm256_cmpeq_epi8(in, _mm256_set1_epi8('_')), _mm256_set1_epi8('/'-'_')));
+
+    __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), _mm256_set1_epi8(0x0f));
+    __m256i loNibbles = _mm256_and_si256(in, _mm256_set1_epi8(0x0f));
+    __m256i invalid = _mm256_and_si256(_mm256_shuffle_epi8(lutLo, loNibbles), _mm256_shuffle_epi8(lutHi, hiNibbles));
+    if (_mm256_movemask_epi8(_mm256_cmpgt_epi8(invalid, _mm256_setzero_si256())) != 0)
+      break;
+
+    __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, _mm256_set1_epi8('/')), hiNibbles));
+    in = _mm256_maddubs_epi16(_mm256_add_epi8(in, roll), _mm256_set1_epi32(0x01400140));
+    in = _mm256_madd_epi16(in, _mm256_set1_epi32(0x00011000));
+    // Each lane has 12 bytes, move them together
+    in = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(in, pack), lanes);
+    _mm256_storeu_si256((__m256i *)(out + done/4*3), in);
+  }
+  return done;
+}
+
+#endif // P_CYPHER_SIMD
+
+
+static char * EncodeTriples(const BYTE * data, size_t triples, char * out, const char * alphabet)
+{
+#if P_CYPHER_SIMD
+  size_t done = 0;
+  if (HasAVX2)
+    done = EncodeTriplesAVX2(data, triples, out, alphabet[62], alphabet[63]);
+  if (HasSSSE3)
+    done += EncodeTriplesSSSE3(data + done*3, triples - done, out + done*4, alphabet[62], alphabet[63]);
+  data += done*3;
+  out += done*4;
+  triples -= done;
+#endif
+
+  while (triples-- > 0) {
+    unsigned bits = (data[0] << 16) | (data[1] << 8) | data[2];
+    out[0] = alphabet[bits >> 18];
+    out[1] = alphabet[(bits >> 12) & 0x3f];
+    out[2] = alphabet[(bits >> 6) & 0x3f];
+    out[3] = alphabet[bits & 0x3f];
+    data += 3;
+    out += 4;
+  }
+  return out;
+}
+
+
+/* Encode complete triples, with an end of line after every lineQuads groups
+   of four characters, and lineQuad the number already on the current line. */
+static char * EncodeLines(const BYTE * data, size_t triples, char * out, const char * alphabet,
+                          const char * endOfLine, size_t eolLength, size_t lineQuads, size_t & lineQuad)
+{
+  if (eolLength == 0)
+    return EncodeTriples(data, triples, out, alphabet);
+
+  while (triples > 0) {
+    size_t count = std::min(triples, lineQuads - lineQuad);
+    out = EncodeTriples(data, count, out, alphabet);
+    data += count*3;
+    triples -= count;
+    lineQuad += count;
+    if (lineQuad >= lineQuads) {
+      memcpy(out, endOfLine, eolLength);
+      out += eolLength;
+      lineQuad = 0;
+    }
+  }
+  return out;
+}
+
+
+static size_t GetEncodedLinesLength(size_t triples, size_t eolLength, size_t lineQuads, size_t lineQuad)
+{
+  return triples*4 + (eolLength > 0 ? (lineQuad + triples)/lineQuads*eolLength : 0);
+}
+
+
+static size_t GetLineQuads(PINDEX maxLineLength)
+{
+  return maxLineLength > 0 ? (maxLineLength+3)/4 : 1;
+}
+
+
+static void GetEncodingParameters(PBase64::Options options, PINDEX width,
+                                  const char * & alphabet, const char * & endOfLine, PINDEX & maxLineLength)
+{
+  alphabet = Alphabet;
+  endOfLine = "";
+  maxLineLength = UINT_MAX;
 
   switch (options) {
-    case e_CRLF:
+    case PBase64::e_CRLF:
       PAssert(width > 2, PInvalidParameter);
-      m_alphabet = Alphabet;
-      m_endOfLine = "\r\n";
-      m_maxLineLength = width - 1;
+      endOfLine = "\r\n";
+      maxLineLength = width - 1;
       break;
-    case e_LF:
+    case PBase64::e_LF:
       PAssert(width > 1, PInvalidParameter);
-      m_alphabet = Alphabet;
-      m_endOfLine = "\n";
-      m_maxLineLength = width;
+      endOfLine = "\n";
+      maxLineLength = width;
       break;
-    case e_NoLF:
-      m_alphabet = Alphabet;
-      m_endOfLine = "";
-      m_maxLineLength = UINT_MAX;
+    case PBase64::e_NoLF:
       break;
-    case e_URL:
-      m_alphabet = AlphabetURL;
-      m_endOfLine = "";
-      m_maxLineLength = UINT_MAX;
+    case PBase64::e_URL:
+      alphabet = AlphabetURL;
       break;
   }
 }
 
 
+PBase64::PBase64(Options options, PINDEX width)
+{
+  StartEncoding(options, width);
+  StartDecoding();
+}
+
+
+void PBase64::StartEncoding(Options options, PINDEX width)
+{
+  m_encodedString.MakeEmpty();
+  m_currentLineLength = m_saveCount = 0;
+
+  const char * endOfLine;
+  GetEncodingParameters(options, width, m_alphabet, endOfLine, m_maxLineLength);
+  m_endOfLine = endOfLine;
+}
+
+
 void PBase64::StartEncoding(const char * eol, PINDEX width)
 {
   PAssert(eol != NULL && width > 0, PInvalidParameter);
@@ -226,55 +454,48 @@ void PBase64::ProcessEncoding(const PBYTEArray & data)
 }
 
 
-void PBase64::OutputBase64(const BYTE * data)
+void PBase64::InternalEncode(const BYTE * data, PINDEX triples)
 {
-  m_encodedString.SetMinSize(((m_encodedString.GetLength()+7)&~255) + 256);
+  size_t eolLength = m_endOfLine.GetLength();
+  size_t lineQuads = GetLineQuads(m_maxLineLength);
+  size_t lineQuad = m_currentLineLength/4;
 
-  m_encodedString += m_alphabet[data[0] >> 2];
-  m_encodedString += m_alphabet[((data[0]&3)<<4) | (data[1]>>4)];
-  m_encodedString += m_alphabet[((data[1]&15)<<2) | (data[2]>>6)];
-  m_encodedString += m_alphabet[data[2]&0x3f];
+  // Leave room for CompleteEncoding(), and grow geometrically for many small calls
+  PINDEX oldLength = m_encodedString.GetLength();
+  PINDEX newLength = oldLength + (PINDEX)GetEncodedLinesLength(triples, eolLength, lineQuads, lineQuad);
+  if (m_encodedString.GetSize() < newLength+5)
+    m_encodedString.SetMinSize(std::max(newLength+5, m_encodedString.GetSize()*2));
 
-  m_currentLineLength += 4;
-  if (m_currentLineLength >= m_maxLineLength) {
-    m_encodedString += m_endOfLine;
-    m_currentLineLength = 0;
-  }
+  char * out = m_encodedString.GetPointerAndSetLength(newLength) + oldLength;
+  EncodeLines(data, triples, out, m_alphabet, m_endOfLine, eolLength, lineQuads, lineQuad);
+  m_currentLineLength = (PINDEX)lineQuad*4;
 }
 
 
 void PBase64::ProcessEncoding(const void * dataPtr, PINDEX length)
 {
-  if (length == 0)
+  if (length <= 0)
     return;
 
   const BYTE * data = (const BYTE *)dataPtr;
-  while (m_saveCount < 3) {
-    m_saveTriple[m_saveCount++] = *data++;
-    if (--length == 0) {
-      if (m_saveCount == 3) {
-        OutputBase64(m_saveTriple);
-        m_saveCount = 0;
-      }
-      return;
+  if (m_saveCount > 0) {
+    while (m_saveCount < 3 && length > 0) {
+      m_saveTriple[m_saveCount++] = *data++;
+      --length;
     }
-  }
+    if (m_saveCount < 3)
+      return;
 
-  OutputBase64(m_saveTriple);
+    InternalEncode(m_saveTriple, 1);
+    m_saveCount = 0;
+  }
 
-  PINDEX i;
-  for (i = 0; i+2 < length; i += 3)
-    OutputBase64(data+i);
+  PINDEX triples = length/3;
+  if (triples > 0)
+    InternalEncode(data, triples);
 
-  m_saveCount = length - i;
-  switch (m_saveCount) {
-    case 2 :
-      m_saveTriple[0] = data[i++];
-      m_saveTriple[1] = data[i];
-      break;
-    case 1 :
-      m_saveTriple[0] = data[i];
-  }
+  m_saveCount = length - triples*3;
+  memcpy(m_saveTriple, data + triples*3, m_saveCount);
 }
 
 
@@ -286,27 +507,36 @@ PString PBase64::GetEncodedString()
 }
 
 
-PString PBase64::CompleteEncoding()
+static char * EncodeFinal(const BYTE * data, PINDEX count, char * out, const char * alphabet)
 {
-  m_encodedString.SetMinSize(m_encodedString.GetLength() + 5);
-
-  switch (m_saveCount) {
+  switch (count) {
     case 1 :
-      m_encodedString += m_alphabet[m_saveTriple[0] >> 2];
-      m_encodedString += m_alphabet[(m_saveTriple[0]&3)<<4];
-      if (m_alphabet == AlphabetURL)
-        return m_encodedString;
-      m_encodedString += '=';
-      m_encodedString += '=';
+      *out++ = alphabet[data[0] >> 2];
+      *out++ = alphabet[(data[0]&3)<<4];
+      if (alphabet != AlphabetURL) {
+        *out++ = '=';
+        *out++ = '=';
+      }
       break;
 
     case 2 :
-      m_encodedString += m_alphabet[m_saveTriple[0] >> 2];
-      m_encodedString += m_alphabet[((m_saveTriple[0]&3)<<4) | (m_saveTriple[1]>>4)];
-      m_encodedString += m_alphabet[((m_saveTriple[1]&15)<<2)];
-      if (m_alphabet == AlphabetURL)
-        return m_encodedString;
-      m_encodedString += '=';
+      *out++ = alphabet[data[0] >> 2];
+      *out++ = alphabet[((data[0]&3)<<4) | (data[1]>>4)];
+      *out++ = alphabet[((data[1]&15)<<2)];
+      if (alphabet != AlphabetURL)
+        *out++ = '=';
+  }
+
+  return out;
+}
+
+
+PString PBase64::CompleteEncoding()
+{
+  if (m_saveCount > 0) {
+    PINDEX oldLength = m_encodedString.GetLength();
+    char * out = m_encodedString.GetPointerAndSetLength(oldLength + 4) + oldLength;
+    m_encodedString.GetPointerAndSetLength(EncodeFinal(m_saveTriple, m_saveCount, out, m_alphabet) - m_encodedString.GetPointer());
   }
 
   return m_encodedString;
@@ -372,9 +602,9 @@ PString PBase64::Encode(const void * data, PINDEX length, Options options, PINDE
   if (length == 0)
     return PString::Empty();
 
-  PBase64 encoder(options, width);
-  encoder.ProcessEncoding(data, length);
-  return encoder.CompleteEncoding();
+  PString str;
+  EncodeBlock(data, length, str.GetPointerAndSetLength(GetEncodedLength(length, options, width)), options, width);
+  return str;
 }
 
 
@@ -390,84 +620,157 @@ PString PBase64::Encode(const void * data, PINDEX length, const char * endOfLine
 }
 
 
-void PBase64::StartDecoding()
+PINDEX PBase64::GetEncodedLength(PINDEX length, Options options, PINDEX width)
 {
-  m_perfectDecode = true;
-  m_quadPosition = 0;
-  m_decodedData.SetSize(0);
-  m_decodeSize = 0;
+  const char * alphabet, * endOfLine;
+  PINDEX maxLineLength;
+  GetEncodingParameters(options, width, alphabet, endOfLine, maxLineLength);
+
+  PINDEX remainder = length%3;
+  return (PINDEX)GetEncodedLinesLength(length/3, strlen(endOfLine), GetLineQuads(maxLineLength), 0)
+                    + (remainder == 0 ? 0 : options == e_URL ? remainder+1 : 4);
 }
 
 
-PBoolean PBase64::ProcessDecoding(const PString & str)
+PINDEX PBase64::EncodeBlock(const void * dataBlock, PINDEX length, char * output, Options options, PINDEX width)
 {
-  return ProcessDecoding((const char *)str);
+  const char * alphabet, * endOfLine;
+  PINDEX maxLineLength;
+  GetEncodingParameters(options, width, alphabet, endOfLine, maxLineLength);
+
+  const BYTE * data = (const BYTE *)dataBlock;
+  PINDEX triples = length/3;
+  size_t lineQuad = 0;
+  char * out = EncodeLines(data, triples, output, alphabet, endOfLine, strlen(endOfLine), GetLineQuads(maxLineLength), lineQuad);
+  out = EncodeFinal(data + triples*3, length - triples*3, out, alphabet);
+  return (PINDEX)(out - output);
 }
 
 
-PBoolean PBase64::ProcessDecoding(const char * cstr)
+static const BYTE Base642Binary[256] = {
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 98, 99, 99, 98, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 62, 99, 62, 99, 63,
+  52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 99, 99, 99, 97, 99, 99,
+  99,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+  15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 99, 99, 99, 99, 63,
+  99, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+  41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
+  99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99
+};
+
+
+/* Decode from str to end, returning true if the terminating '=' was found.
+   The output pointer is to the next, possibly partially filled, byte. */
+static bool DecodeBase64(const char * & str, const char * end, BYTE * & out, const BYTE * outEnd,
+                         PINDEX & quadPosition, bool & perfect)
 {
-  static const BYTE Base642Binary[256] = {
-    96, 99, 99, 99, 99, 99, 99, 99, 99, 99, 98, 99, 99, 98, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 62, 99, 62, 99, 63,
-    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 99, 99, 99, 97, 99, 99,
-    99,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 99, 99, 99, 99, 63,
-    99, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
-    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99,
-    99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99, 99
-  };
+#if P_CYPHER_SIMD
+  const char * retrySIMD = str;
+#endif
 
-  for (;;) {
-    BYTE value = Base642Binary[(BYTE)*cstr++];
-    switch (value) {
-      case 96 : // end of string
-        return false;
+  while (str < end) {
+#if P_CYPHER_SIMD
+    /* Whole blocks of characters can be done at once, until one that has a
+       line ending, padding or anything else unusual. After that block is done
+       by the code below, try again. */
+    if (quadPosition == 0 && str >= retrySIMD) {
+      size_t room = outEnd - out;
+      size_t done = 0;
+      if (HasAVX2)
+        done = DecodeQuadsAVX2(str, end - str, out, room);
+      if (HasSSSE3)
+        done += DecodeQuadsSSSE3(str + done, end - str - done, out + done/4*3, room - done/4*3);
+      str += done;
+      out += done/4*3;
+      retrySIMD = str + 16;
+      if (str >= end)
+        break;
+    }
+#endif
 
+    BYTE value = Base642Binary[(BYTE)*str++];
+    switch (value) {
       case 97 : // '=' sign
-        if (m_quadPosition == 3 || (m_quadPosition == 2 && *cstr == '=')) {
-          m_quadPosition = 0;  // Reset this to zero, as have a perfect decode
+        if (quadPosition == 3 || (quadPosition == 2 && str < end && *str == '=')) {
+          quadPosition = 0;  // Reset this to zero, as have a perfect decode
           return true; // Stop decoding now as must be at end of data
         }
-        m_perfectDecode = false;  // Ignore '=' sign but flag decode as suspect
+        perfect = false;  // Ignore '=' sign but flag decode as suspect
         break;
 
       case 98 : // CRLFs
         break;  // Ignore totally
 
       case 99 :  // Illegal characters
-        m_perfectDecode = false;  // Ignore rubbish but flag decode as suspect
+        perfect = false;  // Ignore rubbish but flag decode as suspect
         break;
 
       default : // legal value from 0 to 63
-        BYTE * out = m_decodedData.GetPointer(((m_decodeSize+1)&~255) + 256);
-        switch (m_quadPosition) {
+        switch (quadPosition) {
           case 0 :
-            out[m_decodeSize] = (BYTE)(value << 2);
+            out[0] = (BYTE)(value << 2);
             break;
           case 1 :
-            out[m_decodeSize++] |= (BYTE)(value >> 4);
-            out[m_decodeSize] = (BYTE)((value&15) << 4);
+            *out++ |= (BYTE)(value >> 4);
+            out[0] = (BYTE)((value&15) << 4);
             break;
           case 2 :
-            out[m_decodeSize++] |= (BYTE)(value >> 2);
-            out[m_decodeSize] = (BYTE)((value&3) << 6);
+            *out++ |= (BYTE)(value >> 2);
+            out[0] = (BYTE)((value&3) << 6);
             break;
           case 3 :
-            out[m_decodeSize++] |= (BYTE)value;
+            *out++ |= (BYTE)value;
             break;
         }
-        m_quadPosition = (m_quadPosition+1)&3;
+        quadPosition = (quadPosition+1)&3;
     }
   }
+
+  return false;
+}
+
+
+void PBase64::StartDecoding()
+{
+  m_perfectDecode = true;
+  m_quadPosition = 0;
+  m_decodedData.SetSize(0);
+  m_decodeSize = 0;
+}
+
+
+PBoolean PBase64::ProcessDecoding(const PString & str)
+{
+  return ProcessDecoding(str, str.GetLength());
+}
+
+
+PBoolean PBase64::ProcessDecoding(const char * cstr)
+{
+  return ProcessDecoding(cstr, (PINDEX)strlen(cstr));
+}
+
+
+PBoolean PBase64::ProcessDecoding(const char * data, PINDEX length)
+{
+  // Extra room for the partial byte and SIMD writing whole registers
+  PINDEX needed = m_decodeSize + GetDecodedLength(length) + 32;
+  if (m_decodedData.GetSize() < needed)
+    m_decodedData.SetSize(std::max(needed, m_decodedData.GetSize()*2));
+
+  BYTE * start = m_decodedData.GetPointer();
+  BYTE * out = start + m_decodeSize;
+  bool finished = DecodeBase64(data, data+length, out, start + m_decodedData.GetSize(), m_quadPosition, m_perfectDecode);
+  m_decodeSize = (PINDEX)(out - start);
+  return finished;
 }
 
 
@@ -510,10 +813,14 @@ PBoolean PBase64::Decode(const PString & str, PBYTEArray & data)
   if (str.IsEmpty())
     return false;
 
-  PBase64 decoder;
-  decoder.ProcessDecoding(str);
-  data = decoder.GetDecodedData();
-  return decoder.IsDecodeOK();
+  const char * ptr = str;
+  BYTE * start = data.GetPointer(GetDecodedLength(str.GetLength()));
+  BYTE * out = start;
+  PINDEX quadPosition = 0;
+  bool perfect = true;
+  DecodeBase64(ptr, ptr + str.GetLength(), out, start + data.GetSize(), quadPosition, perfect);
+  data.SetSize(out - start);
+  return quadPosition == 0;
 }
 
 
@@ -522,9 +829,23 @@ PBoolean PBase64::Decode(const PString & str, void * dataBlock, PINDEX length)
   if (str.IsEmpty())
     return false;
 
-  PBase64 decoder;
-  decoder.ProcessDecoding(str);
-  return decoder.GetDecodedData(dataBlock, length);
+  PBYTEArray data;
+  Decode(str, data);
+  memcpy(dataBlock, data, std::min(length, data.GetSize()));
+  return length >= data.GetSize();
+}
+
+
+PINDEX PBase64::DecodeBlock(const char * str, PINDEX length, void * output, bool * perfect)
+{
+  BYTE * start = (BYTE *)output;
+  BYTE * out = start;
+  PINDEX quadPosition = 0;
+  bool perfectDecode = true;
+  DecodeBase64(str, str + length, out, start + GetDecodedLength(length), quadPosition, perfectDecode);
+  if (perfect != NULL)
+    *perfect = perfectDecode && quadPosition == 0;
+  return (PINDEX)(out - start);
 }
 
 
@@ -614,6 +935,117 @@ PString PMessageDigest::Result::AsHex() const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+// Multi-buffer digests
+
+/* Several independent messages may be digested in parallel, each in its own
+   lane of a vector. The digest rounds are templates using only arithmetic
+   and logical operators, which work on the GCC vector extension types as
+   well as plain integers. They are forced inline so the AVX2 version is
+   compiled as AVX2 code, while the default uses the baseline instruction
+   set, e.g. SSE2 or NEON. */
+
+#if defined(__GNUC__)
+  #define P_DIGEST_INLINE __attribute__((always_inline))
+  #define P_DIGEST_LANES 8
+  typedef DWORD DigestLanes __attribute__((vector_size(P_DIGEST_LANES*sizeof(DWORD))));
+#else
+  #define P_DIGEST_INLINE
+  #define P_DIGEST_LANES 0
+#endif
+
+#if P_DIGEST_LANES
+
+typedef void (*DigestLanesTransform)(DigestLanes * state, DigestLanes * x);
+
+static void EncodeLanes(const PMessageDigest::Data * data,
+                        PINDEX count,
+                        PMessageDigest::Result * results,
+                        const DWORD * initialState,
+                        PINDEX stateWords,
+                        bool bigEndian,
+                        DigestLanesTransform transform)
+{
+  static BYTE const ZeroBlock[64] = { 0 };
+
+  for (PINDEX first = 0; first < count; first += P_DIGEST_LANES) {
+    PINDEX lanes = std::min(count - first, (PINDEX)P_DIGEST_LANES);
+
+    /* The whole blocks of each message are used in place, then one or two
+       blocks are made from the remainder, the padding and the length. */
+    const BYTE * message[P_DIGEST_LANES];
+    PINDEX wholeBlocks[P_DIGEST_LANES];
+    PINDEX totalBlocks[P_DIGEST_LANES];
+    BYTE tail[P_DIGEST_LANES][128];
+    PINDEX maxBlocks = 0;
+    for (PINDEX lane = 0; lane < lanes; ++lane) {
+      message[lane] = (const BYTE *)data[first+lane].m_data;
+      PINDEX length = data[first+lane].m_length;
+      wholeBlocks[lane] = length/64;
+
+      PINDEX remainder = length%64;
+      PINDEX tailLength = remainder < 56 ? 64 : 128;
+      memcpy(tail[lane], message[lane] + wholeBlocks[lane]*64, remainder);
+      tail[lane][remainder] = 0x80;
+      memset(&tail[lane][remainder+1], 0, tailLength - remainder - 9);
+      if (bigEndian)
+        *(PUInt64b *)&tail[lane][tailLength-8] = (PUInt64)length << 3;
+      else
+        *(PUInt64l *)&tail[lane][tailLength-8] = (PUInt64)length << 3;
+
+      totalBlocks[lane] = wholeBlocks[lane] + tailLength/64;
+      maxBlocks = std::max(maxBlocks, totalBlocks[lane]);
+    }
+
+    DigestLanes state[8];
+    for (PINDEX i = 0; i < stateWords; ++i) {
+      for (PINDEX lane = 0; lane < P_DIGEST_LANES; ++lane)
+        state[i][lane] = initialState[i];
+    }
+
+    for (PINDEX block = 0; block < maxBlocks; ++block) {
+      DigestLanes x[16];
+      for (PINDEX lane = 0; lane < P_DIGEST_LANES; ++lane) {
+        const BYTE * ptr;
+        if (lane >= lanes || block >= totalBlocks[lane])
+          ptr = ZeroBlock;
+        else if (block < wholeBlocks[lane])
+          ptr = message[lane] + block*64;
+        else
+          ptr = tail[lane] + (block - wholeBlocks[lane])*64;
+
+        if (bigEndian) {
+          for (PINDEX i = 0; i < 16; ++i)
+            x[i][lane] = ((const PUInt32b *)ptr)[i];
+        }
+        else {
+          for (PINDEX i = 0; i < 16; ++i)
+            x[i][lane] = ((const PUInt32l *)ptr)[i];
+        }
+      }
+
+      transform(state, x);
+
+      // Take the result from any lane that has just finished
+      for (PINDEX lane = 0; lane < lanes; ++lane) {
+        if (block+1 == totalBlocks[lane]) {
+          PMessageDigest::Result & result = results[first+lane];
+          result.SetSize(stateWords*sizeof(DWORD));
+          for (PINDEX i = 0; i < stateWords; ++i) {
+            if (bigEndian)
+              ((PUInt32b *)result.GetPointer())[i] = state[i][lane];
+            else
+              ((PUInt32l *)result.GetPointer())[i] = state[i][lane];
+          }
+        }
+      }
+    }
+  }
+}
+
+#endif // P_DIGEST_LANES
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // PMessageDigest5
 
@@ -673,16 +1105,14 @@ PMessageDigest5::PMessageDigest5()
  (a) += (b); \
 
 
-void PMessageDigest5::Transform(const BYTE * block)
+/* The rounds are a template so that they can also be used for several
+   messages at once in SIMD lanes, see PMessageDigest5::EncodeBatch(). */
+template <typename T> static __inline P_DIGEST_INLINE void MD5Rounds(T * state, const T * x)
 {
-  DWORD a = state[0];
-  DWORD b = state[1];
-  DWORD c = state[2];
-  DWORD d = state[3];
-
-  DWORD x[16];
-  for (PINDEX i = 0; i < 16; i++)
-    x[i] = ((PUInt32l*)block)[i];
+  T a = state[0];
+  T b = state[1];
+  T c = state[2];
+  T d = state[3];
 
   /* Round 1 */
   FF(a, b, c, d, x[ 0], S11, 0xd76aa478); /* 1 */
@@ -760,6 +1190,16 @@ void PMessageDigest5::Transform(const BYTE * block)
   state[1] += b;
   state[2] += c;
   state[3] += d;
+}
+
+
+void PMessageDigest5::Transform(const BYTE * block)
+{
+  DWORD x[16];
+  for (PINDEX i = 0; i < 16; i++)
+    x[i] = ((PUInt32l*)block)[i];
+
+  MD5Rounds(state, x);
 
   // Zeroize sensitive information.
   memset(x, 0, sizeof(x));
@@ -825,7 +1265,8 @@ void PMessageDigest5::InternalCompleteDigest(Result & result)
   Process(&countBytes, sizeof(countBytes));
 
   // Store state in digest
-  PUInt32l * valuep = (PUInt32l *)result.GetPointer(4 * sizeof(PUInt32l));
+  result.SetSize(4 * sizeof(PUInt32l));
+  PUInt32l * valuep = (PUInt32l *)result.GetPointer();
   for (PINDEX i = 0; i < PARRAYSIZE(state); i++)
     valuep[i] = state[i];
 
@@ -835,8 +1276,467 @@ void PMessageDigest5::InternalCompleteDigest(Result & result)
 }
 
 
+#if P_DIGEST_LANES
+
+static void MD5Lanes(DigestLanes * state, DigestLanes * x)
+{
+  MD5Rounds(state, (const DigestLanes *)x);
+}
+
+#if P_CYPHER_SIMD
+__attribute__((target("avx2")))
+static void MD5LanesAVX2(DigestLanes * state, DigestLanes * x)
+{
+  MD5Rounds(state, (const DigestLanes *)x);
+}
+#endif
+
+#endif // P_DIGEST_LANES
+
+
+void PMessageDigest5::EncodeBatch(const PMessageDigest::Data * data, PINDEX count, PMessageDigest::Result * results)
+{
+#if P_DIGEST_LANES
+  // Below this, the idle lanes cost more than the parallelism saves
+  if (count >= 3) {
+    static DWORD const InitialState[4] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 };
+#if P_CYPHER_SIMD
+    EncodeLanes(data, count, results, InitialState, 4, false, HasAVX2 ? MD5LanesAVX2 : MD5Lanes);
+#else
+    EncodeLanes(data, count, results, InitialState, 4, false, MD5Lanes);
+#endif
+    return;
+  }
+#endif // P_DIGEST_LANES
+
+  PMessageDigestStatics<PMessageDigest5>::EncodeBatch(data, count, results);
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
-// PMessageDigestSHA1
+// PMessageDigestSHA1 and PMessageDigestSHA256
+
+#define SHA_ROTL(x, n) (((x) << (n)) | ((x) >> (32-(n))))
+#define SHA_ROTR(x, n) (((x) >> (n)) | ((x) << (32-(n))))
+
+static DWORD const SHA256K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static DWORD const SHA256InitialState[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+
+static void SHA1Transform(DWORD * state, const BYTE * block)
+{
+  DWORD w[16];
+  for (PINDEX i = 0; i < 16; ++i)
+    w[i] = ((const PUInt32b *)block)[i];
+
+  DWORD a = state[0];
+  DWORD b = state[1];
+  DWORD c = state[2];
+  DWORD d = state[3];
+  DWORD e = state[4];
+
+  // Only the last 16 words of the message schedule are kept
+  for (PINDEX i = 0; i < 80; ++i) {
+    if (i >= 16)
+      w[i&15] = SHA_ROTL(w[(i+13)&15] ^ w[(i+8)&15] ^ w[(i+2)&15] ^ w[i&15], 1);
+
+    DWORD f;
+    if (i < 20)
+      f = ((b & c) | (~b & d)) + 0x5a827999;
+    else if (i < 40)
+      f = (b ^ c ^ d) + 0x6ed9eba1;
+    else if (i < 60)
+      f = ((b & c) | (b & d) | (c & d)) + 0x8f1bbcdc;
+    else
+      f = (b ^ c ^ d) + 0xca62c1d6;
+
+    DWORD t = SHA_ROTL(a, 5) + f + e + w[i&15];
+    e = d;
+    d = c;
+    c = SHA_ROTL(b, 30);
+    b = a;
+    a = t;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+
+  // Zeroize sensitive information.
+  memset(w, 0, sizeof(w));
+}
+
+
+/* As for MD5, the rounds are a template so that they can also be used for
+   several messages at once in SIMD lanes. */
+template <typename T> static __inline P_DIGEST_INLINE void SHA256Rounds(T * state, T * w)
+{
+  T a = state[0];
+  T b = state[1];
+  T c = state[2];
+  T d = state[3];
+  T e = state[4];
+  T f = state[5];
+  T g = state[6];
+  T h = state[7];
+
+  for (PINDEX i = 0; i < 64; ++i) {
+    if (i >= 16) {
+      T w1 = w[(i+1)&15];
+      T w14 = w[(i+14)&15];
+      w[i&15] += (SHA_ROTR(w1, 7) ^ SHA_ROTR(w1, 18) ^ (w1 >> 3)) +
+                 (SHA_ROTR(w14, 17) ^ SHA_ROTR(w14, 19) ^ (w14 >> 10)) +
+                 w[(i+9)&15];
+    }
+
+    T t1 = h + (SHA_ROTR(e, 6) ^ SHA_ROTR(e, 11) ^ SHA_ROTR(e, 25)) + ((e & f) ^ (~e & g)) + SHA256K[i] + w[i&15];
+    T t2 = (SHA_ROTR(a, 2) ^ SHA_ROTR(a, 13) ^ SHA_ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  state[0] += a;
+  state[1] += b;
+  state[2] += c;
+  state[3] += d;
+  state[4] += e;
+  state[5] += f;
+  state[6] += g;
+  state[7] += h;
+}
+
+
+static void SHA256Transform(DWORD * state, const BYTE * block)
+{
+  DWORD w[16];
+  for (PINDEX i = 0; i < 16; ++i)
+    w[i] = ((const PUInt32b *)block)[i];
+
+  SHA256Rounds(state, w);
+
+  // Zeroize sensitive information.
+  memset(w, 0, sizeof(w));
+}
+
+
+#if P_CYPHER_SIMD
+
+/* Implementations using the x86 SHA extensions, after the Intel white paper
+   "New Instructions Supporting the Secure Hash Algorithm on Intel
+   Architecture Processors". The state is kept in the registers across all
+   the blocks. The loops must be unrolled so the message schedule stays in
+   registers and the round function is an immediate. */
+
+__attribute__((target("sha,sse4.1")))
+static void SHA1BlocksNI(DWORD * state, const BYTE * data, size_t count)
+{
+  const __m128i mask = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+
+  __m128i abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)state), 0x1B);
+  __m128i e0 = _mm_set_epi32(state[4], 0, 0, 0);
+
+  while (count-- > 0) {
+    __m128i abcdSave = abcd;
+    __m128i e0Save = e0;
+
+    __m128i msg[4];
+    for (int i = 0; i < 4; ++i)
+      msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16*i)), mask);
+
+    // Twenty groups of four rounds
+    __m128i previous = abcd;
+    abcd = _mm_sha1rnds4_epu32(abcd, _mm_add_epi32(e0, msg[0]), 0);
+    #pragma GCC unroll 19
+    for (int g = 1; g < 20; ++g) {
+      if (g >= 4)
+        msg[g&3] = _mm_sha1msg2_epu32(_mm_xor_si128(_mm_sha1msg1_epu32(msg[g&3], msg[(g+1)&3]), msg[(g+2)&3]), msg[(g+3)&3]);
+      __m128i e = _mm_sha1nexte_epu32(previous, msg[g&3]);
+      previous = abcd;
+      switch (g/5) {
+        case 0 :
+          abcd = _mm_sha1rnds4_epu32(abcd, e, 0);
+          break;
+        case 1 :
+          abcd = _mm_sha1rnds4_epu32(abcd, e, 1);
+          break;
+        case 2 :
+          abcd = _mm_sha1rnds4_epu32(abcd, e, 2);
+          break;
+        default :
+          abcd = _mm_sha1rnds4_epu32(abcd, e, 3);
+      }
+    }
+
+    e0 = _mm_sha1nexte_epu32(previous, e0Save);
+    abcd = _mm_add_epi32(abcd, abcdSave);
+    data += 64;
+  }
+
+  _mm_storeu_si128((__m128i *)state, _mm_shuffle_epi32(abcd, 0x1B));
+  state[4] = _mm_extract_epi32(e0, 3);
+}
+
+
+__attribute__((target("sha,sse4.1")))
+static void SHA256BlocksNI(DWORD * state, const BYTE * data, size_t count)
+{
+  const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+
+  // Rearrange the state from ABCD EFGH into ABEF CDGH as used by the instructions
+  __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+  __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+  __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+  state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+  while (count-- > 0) {
+    __m128i state0Save = state0;
+    __m128i state1Save = state1;
+
+    __m128i msg[4];
+    for (int i = 0; i < 4; ++i)
+      msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16*i)), mask);
+
+    // Sixteen groups of four rounds
+    #pragma GCC unroll 16
+    for (int g = 0; g < 16; ++g) {
+      if (g >= 4)
+        msg[g&3] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(msg[g&3], msg[(g+1)&3]),
+                                                      _mm_alignr_epi8(msg[(g+3)&3], msg[(g+2)&3], 4)),
+                                        msg[(g+3)&3]);
+      __m128i m = _mm_add_epi32(msg[g&3], _mm_loadu_si128((const __m128i *)&SHA256K[g*4]));
+      state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+      state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(m, 0x0E));
+    }
+
+    state0 = _mm_add_epi32(state0, state0Save);
+    state1 = _mm_add_epi32(state1, state1Save);
+    data += 64;
+  }
+
+  tmp = _mm_shuffle_epi32(state0, 0x1B);
+  state1 = _mm_shuffle_epi32(state1, 0xB1);
+  _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, state1, 0xF0));
+  _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#endif // P_CYPHER_SIMD
+
+
+static void SHA1Blocks(DWORD * state, const BYTE * blocks, size_t count)
+{
+#if P_CYPHER_SIMD
+  if (HasSHA) {
+    SHA1BlocksNI(state, blocks, count);
+    return;
+  }
+#endif
+
+  while (count-- > 0) {
+    SHA1Transform(state, blocks);
+    blocks += 64;
+  }
+}
+
+
+static void SHA256Blocks(DWORD * state, const BYTE * blocks, size_t count)
+{
+#if P_CYPHER_SIMD
+  if (HasSHA) {
+    SHA256BlocksNI(state, blocks, count);
+    return;
+  }
+#endif
+
+  while (count-- > 0) {
+    SHA256Transform(state, blocks);
+    blocks += 64;
+  }
+}
+
+
+typedef void (*DigestBlocksFunction)(DWORD * state, const BYTE * blocks, size_t count);
+
+/* Common buffering for the SHA digests, whole blocks are passed directly from
+   the callers data, only partial blocks are copied. The count is in bytes. */
+static void ProcessDigestBlocks(DWORD * state,
+                                BYTE * buffer,
+                                PUInt64 & count,
+                                const void * dataPtr,
+                                PINDEX length,
+                                DigestBlocksFunction transform)
+{
+  const BYTE * data = (const BYTE *)dataPtr;
+  PINDEX index = (PINDEX)(count & 63);
+  count += length;
+
+  if (index > 0) {
+    PINDEX partLen = std::min(64 - index, length);
+    memcpy(&buffer[index], data, partLen);
+    if (index + partLen < 64)
+      return;
+    transform(state, buffer, 1);
+    data += partLen;
+    length -= partLen;
+  }
+
+  if (length >= 64) {
+    transform(state, data, length/64);
+    data += length & ~63;
+    length &= 63;
+  }
+
+  memcpy(buffer, data, length);
+}
+
+
+static void CompleteDigestBlocks(DWORD * state,
+                                 BYTE * buffer,
+                                 PUInt64 count,
+                                 DigestBlocksFunction transform,
+                                 PINDEX stateWords,
+                                 PMessageDigest::Result & result)
+{
+  // Pad with a one bit, then zeros, to 56 mod 64, then the bit count
+  PINDEX index = (PINDEX)(count & 63);
+  buffer[index++] = 0x80;
+  if (index > 56) {
+    memset(&buffer[index], 0, 64 - index);
+    transform(state, buffer, 1);
+    index = 0;
+  }
+  memset(&buffer[index], 0, 56 - index);
+  *(PUInt64b *)&buffer[56] = count << 3;
+  transform(state, buffer, 1);
+
+  result.SetSize(stateWords*sizeof(DWORD));
+  PUInt32b * valuep = (PUInt32b *)result.GetPointer();
+  for (PINDEX i = 0; i < stateWords; ++i)
+    valuep[i] = state[i];
+
+  // Zeroize sensitive information.
+  memset(buffer, 0, 64);
+  memset(state, 0, stateWords*sizeof(DWORD));
+}
+
+
+PMessageDigestSHA1::PMessageDigestSHA1()
+{
+  Start();
+}
+
+
+void PMessageDigestSHA1::InternalStart()
+{
+  m_state[0] = 0x67452301;
+  m_state[1] = 0xefcdab89;
+  m_state[2] = 0x98badcfe;
+  m_state[3] = 0x10325476;
+  m_state[4] = 0xc3d2e1f0;
+  m_count = 0;
+}
+
+
+void PMessageDigestSHA1::InternalProcess(const void * data, PINDEX length)
+{
+  ProcessDigestBlocks(m_state, m_buffer, m_count, data, length, SHA1Blocks);
+}
+
+
+void PMessageDigestSHA1::InternalCompleteDigest(Result & result)
+{
+  CompleteDigestBlocks(m_state, m_buffer, m_count, SHA1Blocks, PARRAYSIZE(m_state), result);
+}
+
+
+PMessageDigestSHA256::PMessageDigestSHA256()
+{
+  Start();
+}
+
+
+void PMessageDigestSHA256::InternalStart()
+{
+  memcpy(m_state, SHA256InitialState, sizeof(m_state));
+  m_count = 0;
+}
+
+
+void PMessageDigestSHA256::InternalProcess(const void * data, PINDEX length)
+{
+  ProcessDigestBlocks(m_state, m_buffer, m_count, data, length, SHA256Blocks);
+}
+
+
+void PMessageDigestSHA256::InternalCompleteDigest(Result & result)
+{
+  CompleteDigestBlocks(m_state, m_buffer, m_count, SHA256Blocks, PARRAYSIZE(m_state), result);
+}
+
+
+#if P_DIGEST_LANES
+
+static void SHA256Lanes(DigestLanes * state, DigestLanes * x)
+{
+  SHA256Rounds(state, x);
+}
+
+#if P_CYPHER_SIMD
+__attribute__((target("avx2")))
+static void SHA256LanesAVX2(DigestLanes * state, DigestLanes * x)
+{
+  SHA256Rounds(state, x);
+}
+#endif
+
+#endif // P_DIGEST_LANES
+
+
+void PMessageDigestSHA256::EncodeBatch(const PMessageDigest::Data * data, PINDEX count, PMessageDigest::Result * results)
+{
+#if P_DIGEST_LANES
+  // The SHA extensions on a single message are faster than eight lanes
+#if P_CYPHER_SIMD
+  if (count >= 3 && !HasSHA) {
+    EncodeLanes(data, count, results, SHA256InitialState, 8, true, HasAVX2 ? SHA256LanesAVX2 : SHA256Lanes);
+    return;
+  }
+#else
+  if (count >= 3) {
+    EncodeLanes(data, count, results, SHA256InitialState, 8, true, SHA256Lanes);
+    return;
+  }
+#endif
+#endif // P_DIGEST_LANES
+
+  PMessageDigestStatics<PMessageDigestSHA256>::EncodeBatch(data, count, results);
+}
+
+#undef SHA_ROTL
+#undef SHA_ROTR
+
+
+///////////////////////////////////////////////////////////////////////////////
+// PMessageDigestSHA
 
 #if P_SSL
 
@@ -924,18 +1824,6 @@ void PMessageDigestSHA::InternalCompleteDigest(Result & result)
 }
 
 
-PMessageDigestSHA1::PMessageDigestSHA1()
-  : PMessageDigestSHA(new PMessageDigestContextTemplate<SHA_CTX, SHA_DIGEST_LENGTH, SHA1_Init, SHA1_Update, SHA1_Final>())
-{
-}
-
-
-PMessageDigestSHA256::PMessageDigestSHA256()
-  : PMessageDigestSHA(new PMessageDigestContextTemplate<SHA256_CTX, SHA256_DIGEST_LENGTH, SHA256_Init, SHA256_Update, SHA256_Final>())
-{
-}
-
-
 PMessageDigestSHA384::PMessageDigestSHA384()
   : PMessageDigestSHA(new PMessageDigestContextTemplate<SHA512_CTX, SHA384_DIGEST_LENGTH, SHA384_Init, SHA384_Update, SHA384_Final>())
 {
@@ -1211,56 +2099,95 @@ void PHMAC::Process(const PBYTEArray & data, PHMAC::Result & result)         { I
 void PHMAC::Process(const PString & str, PHMAC::Result & result)             { InternalProcess(str.GetPointer(), str.GetLength(), result); }
 
 
-void PHMAC_MD5::InitKey(const void * key, PINDEX len)
+/* Common HMAC as per RFC 2104 for a digest with 64 byte blocks. The padded
+   keys are fed to the digest separately, so the data is not copied. */
+enum { HMACBlockSize = 64 };
+
+template <class Digestor>
+static void HMACInitKey(PBYTEArray & keyBuffer, const void * key, PINDEX len)
 {
   // Ensure the key is no longer than a block, if so, do a digest of it.
-  if (len <= BlockSize)
-    memcpy(m_key.GetPointer(len), key,  len);
-  else {
-    Result result;
-    PMessageDigest5::Encode(key, len, result);
-    m_key = result;
+  PHMAC::Result digest;
+  if (len > HMACBlockSize) {
+    Digestor::Encode(key, len, digest);
+    key = (const BYTE *)digest;
+    len = digest.GetSize();
   }
+
+  // Zero pad to exactly one block, so nothing of a previous key remains
+  keyBuffer.SetSize(HMACBlockSize);
+  BYTE * ptr = keyBuffer.GetPointer();
+  memcpy(ptr, key, len);
+  memset(ptr + len, 0, HMACBlockSize - len);
+}
+
+
+template <class Digestor>
+static void HMACProcess(const PBYTEArray & key, const void * data, PINDEX len, PHMAC::Result & result)
+{
+  BYTE pad[HMACBlockSize];
+
+  // hash key XOR ipad, then the text. Key is always a whole block, unless never set.
+  if (key.GetSize() == HMACBlockSize) {
+    for (PINDEX i = 0; i < HMACBlockSize; ++i)
+      pad[i] = 0x36 ^ key[i];
+  }
+  else
+    memset(pad, 0x36, sizeof(pad));
+
+  Digestor inner;
+  inner.Process(pad, sizeof(pad));
+  inner.Process(data, len);
+  PHMAC::Result hash;
+  inner.Complete(hash);
+
+  // hash key XOR opad, then the inner hash
+  for (PINDEX i = 0; i < HMACBlockSize; ++i)
+    pad[i] ^= 0x36 ^ 0x5c;
+
+  Digestor outer;
+  outer.Process(pad, sizeof(pad));
+  outer.Process(hash);
+  outer.Complete(result);
+
+  // Zeroize sensitive information.
+  memset(pad, 0, sizeof(pad));
+}
+
+
+void PHMAC_MD5::InitKey(const void * key, PINDEX len)
+{
+  HMACInitKey<PMessageDigest5>(m_key, key, len);
 }
 
+
 void PHMAC_MD5::InternalProcess(const void * data, PINDEX len, PHMAC::Result & result)
 {
-  PINDEX i;
-  BYTE const * k;
-  BYTE * d;
+  HMACProcess<PMessageDigest5>(m_key, data, len, result);
+}
 
-  PINDEX const keyLen = m_key.GetSize();
 
-  // construct key XOR ipad
-  PBYTEArray buffer(BlockSize + len);
-  k = m_key;
-  d = buffer.GetPointer();
-  for (i = 0; i < keyLen; ++i)
-    *d++ = 0x36 ^ *k++;
-  for (;i < BlockSize; ++i)
-    *d++ = 0x36;
+void PHMAC_SHA1::InitKey(const void * key, PINDEX len)
+{
+  HMACInitKey<PMessageDigestSHA1>(m_key, key, len);
+}
+
 
-  // append text
-  memcpy(d, data, len);
+void PHMAC_SHA1::InternalProcess(const void * data, PINDEX len, PHMAC::Result & result)
+{
+  HMACProcess<PMessageDigestSHA1>(m_key, data, len, result);
+}
 
-  // hash 
-  Result hash1;
-  PMessageDigest5::Encode(buffer, buffer.GetSize(), hash1);
 
-  // create key XOR opad
-  buffer.SetSize(BlockSize + hash1.GetSize());
-  k = m_key;
-  d = buffer.GetPointer();
-  for (i = 0; i < keyLen; ++i)
-    *d++ = 0x5c ^ *k++;
-  for (;i < BlockSize; ++i)
-    *d++ = 0x5c;
+void PHMAC_SHA256::InitKey(const void * key, PINDEX len)
+{
+  HMACInitKey<PMessageDigestSHA256>(m_key, key, len);
+}
 
-  // append hash
-  memcpy(d, hash1.GetPointer(), hash1.GetSize());
 
-  // hash 
-  PMessageDigest5::Encode(buffer.GetPointer(), buffer.GetSize(), result);
+void PHMAC_SHA256::InternalProcess(const void * data, PINDEX len, PHMAC::Result & result)
+{
+  HMACProcess<PMessageDigestSHA256>(m_key, data, len, result);
 }
 
 
@@ -1293,18 +2220,6 @@ void PHMAC_SHA::InternalProcess(const void * data, PINDEX len, PHMAC::Result & r
 }
 
 
-PHMAC_SHA1::PHMAC_SHA1()
-  : PHMAC_SHA((Algorithm)EVP_sha1())
-{
-}
-
-
-PHMAC_SHA256::PHMAC_SHA256()
-  : PHMAC_SHA((Algorithm)EVP_sha256())
-{
-}
-
-
 PHMAC_SHA384::PHMAC_SHA384()
   : PHMAC_SHA((Algorithm)EVP_sha384())
 {
@@ -86,6 +86,12 @@ const PCaselessString & PHTTP::ProxyAuthenticateTag() { static const PConstCasel
 const PCaselessString & PHTTP::ForwardedTag        () { static const PConstCaselessString s("Forwarded"); return s; }
 const PCaselessString & PHTTP::SetCookieTag        () { static const PConstCaselessString s("Set-Cookie"); return s; }
 const PCaselessString & PHTTP::CookieTag           () { static const PConstCaselessString s("Cookie"); return s; }
+const PCaselessString & PHTTP::ETagTag             () { static const PConstCaselessString s("ETag"); return s; }
+const PCaselessString & PHTTP::IfNoneMatchTag      () { static const PConstCaselessString s("If-None-Match"); return s; }
+const PCaselessString & PHTTP::IfRangeTag          () { static const PConstCaselessString s("If-Range"); return s; }
+const PCaselessString & PHTTP::RangeTag            () { static const PConstCaselessString s("Range"); return s; }
+const PCaselessString & PHTTP::ContentRangeTag     () { static const PConstCaselessString s("Content-Range"); return s; }
+const PCaselessString & PHTTP::AcceptRangesTag     () { static const PConstCaselessString s("Accept-Ranges"); return s; }
 const PCaselessString & PHTTP::FormUrlEncoded      () { static const PConstCaselessString s("application/x-www-form-urlencoded"); return s; }
 
 
@@ -600,6 +600,7 @@ static const httpStatusCodeStruct * GetStatusCodeStruct(int code)
     { "Gone",                          PHTTP::Gone, 1, 1, 1 },
     { "Length Required",               PHTTP::LengthRequired, 1, 1, 1 },
     { "Unless True",                   PHTTP::UnlessTrue, 1, 1, 1 },
+    { "Range Not Satisfiable",         PHTTP::RangeNotSatisfiable, 1, 1, 1 },
     { "Not Implemented",               PHTTP::NotImplemented, 1 },
     { "Service Unavailable",           PHTTP::ServiceUnavailable, 1, 1, 1 },
     { "Gateway Timeout",               PHTTP::GatewayTimeout, 1, 1, 1 }
@@ -2107,6 +2108,7 @@ PHTTPFileRequest::PHTTPFileRequest(const PURL & url,
                                 PHTTPResource * resource,
                                   PHTTPServer & server)
   : PHTTPRequest(url, inMIME, multipartFormInfo, resource, server)
+  , m_sendFile(false)
 {
 }
 
@@ -2122,19 +2124,181 @@ PHTTPRequest * PHTTPFile::CreateRequest(const PURL & url,
 
 PBoolean PHTTPFile::LoadHeaders(PHTTPRequest & request)
 {
-  PFile & file = ((PHTTPFileRequest&)request).m_file;
+  return LoadFileHeaders((PHTTPFileRequest&)request, m_filePath, true);
+}
+
+
+static bool MatchETag(const PString & tagList, const PString & etag)
+{
+  PStringArray tags = tagList.Tokenise(',', false);
+  for (PINDEX i = 0; i < tags.GetSize(); ++i) {
+    PString tag = tags[i].Trim();
+    if (tag == "*" || tag == etag || tag == "W/" + etag)
+      return true;
+  }
+  return false;
+}
 
-  if (!file.Open(m_filePath, PFile::ReadOnly)) {
-    PTRACE(3, "Could not open \"" << m_filePath << "\" for URL " << request.url);
+
+bool PHTTPFile::LoadFileHeaders(PHTTPFileRequest & request, const PFilePath & filePath, bool allowSendFile)
+{
+  PFile & file = request.m_file;
+
+  if (!file.Open(filePath, PFile::ReadOnly)) {
+    PTRACE(3, "Could not open \"" << filePath << "\" for URL " << request.url);
     request.code = PHTTP::NotFound;
     return false;
   }
 
-  request.contentSize = file.GetLength();
+  PInt64 length = file.GetLength();
+  request.contentSize = (PINDEX)length;
+
+  PString contentType = GetContentType();
+  if (contentType.IsEmpty())
+    contentType = PMIMEInfo::GetContentType(filePath.GetType());
+  if (!request.outMIME.Contains(PHTTP::ContentTypeTag()))
+    request.outMIME.SetAt(PHTTP::ContentTypeTag(), contentType);
+
+  // Text must go through LoadText() as OnLoadedText() may alter it
+  request.m_sendFile = allowSendFile && !(contentType(0, 4) *= "text/");
+  if (!request.m_sendFile)
+    return true;
+
+  PFileInfo info;
+  if (!file.GetInfo(info))
+    return true;
+
+  PString lastModified = info.modified.AsString(PTime::RFC1123, PTime::GMT);
+  PString etag = PSTRSTRM('"' << hex << length << '-' << info.modified.GetTimeInSeconds() << '"');
+  request.outMIME.SetAt(PHTTP::LastModifiedTag(), lastModified);
+  request.outMIME.SetAt(PHTTP::ETagTag(), etag);
+  request.outMIME.SetAt(PHTTP::AcceptRangesTag(), "bytes");
+
+  const PMIMEInfo & inMIME = request.inMIME;
+
+  bool notModified = false;
+  if (inMIME.Contains(PHTTP::IfNoneMatchTag()))
+    notModified = MatchETag(inMIME[PHTTP::IfNoneMatchTag()], etag);
+  else if (inMIME.Contains(PHTTP::IfModifiedSinceTag())) {
+    PTime since(inMIME[PHTTP::IfModifiedSinceTag()]);
+    notModified = since.IsValid() && info.modified.GetTimeInSeconds() <= since.GetTimeInSeconds();
+  }
+  if (notModified) {
+    PTRACE(4, "File \"" << filePath << "\" not modified for URL " << request.url);
+    request.code = PHTTP::NotModified;
+    return true;
+  }
+
+  if (!inMIME.Contains(PHTTP::RangeTag()))
+    return true;
+
+  // A Range is ignored, and the whole file sent, if If-Range does not match
+  if (inMIME.Contains(PHTTP::IfRangeTag())) {
+    PString ifRange = inMIME[PHTTP::IfRangeTag()].Trim();
+    if (ifRange != etag && ifRange != lastModified)
+      return true;
+  }
+
+  // Only a single range is supported, anything else sends the whole file
+  PCaselessString range = inMIME[PHTTP::RangeTag()].Trim();
+  PINDEX dash = range.Find('-');
+  if (range.NumCompare("bytes=") != EqualTo || dash == P_MAX_INDEX || range.Find(',') != P_MAX_INDEX)
+    return true;
+
+  PString first = range(6, dash-1).Trim();
+  PString last = range.Mid(dash+1).Trim();
+  PInt64 start, end = length-1;
+  if (first.IsEmpty()) {
+    if (last.IsEmpty())
+      return true;
+    PInt64 suffix = last.AsInt64();
+    start = suffix < length ? length - suffix : 0;
+    if (suffix == 0)
+      start = length;
+  }
+  else {
+    start = first.AsInt64();
+    if (!last.IsEmpty()) {
+      PInt64 lastByte = last.AsInt64();
+      if (lastByte < start)
+        return true; // Syntactically invalid, so ignored
+      if (lastByte < end)
+        end = lastByte;
+    }
+  }
+
+  if (start >= length) {
+    PTRACE(3, "Range \"" << range << "\" not satisfiable for \"" << filePath << "\" of " << length << " bytes");
+    request.code = PHTTP::RangeNotSatisfiable;
+    request.outMIME.SetAt(PHTTP::ContentRangeTag(), PSTRSTRM("bytes */" << length));
+    return true;
+  }
+
+  if (!file.SetPosition(start)) {
+    request.code = PHTTP::InternalServerError;
+    return false;
+  }
+
+  request.code = PHTTP::PartialContent;
+  request.contentSize = (PINDEX)(end - start + 1);
+  request.outMIME.SetAt(PHTTP::ContentRangeTag(), PSTRSTRM("bytes " << start << '-' << end << '/' << length));
+  PTRACE(4, "Sending range " << start << '-' << end << " of \"" << filePath << "\" for URL " << request.url);
   return true;
 }
 
 
+PBoolean PHTTPFile::OnGETData(PHTTPServer & server,
+                              const PURL & url,
+               const PHTTPConnectionInfo & connectInfo,
+                            PHTTPRequest & request)
+{
+  PHTTPFileRequest * fileRequest = dynamic_cast<PHTTPFileRequest *>(&request);
+  if (fileRequest == NULL || !fileRequest->m_sendFile)
+    return PHTTPResource::OnGETData(server, url, connectInfo, request);
+
+  PFile & file = fileRequest->m_file;
+
+  switch (request.code) {
+    case PHTTP::NotModified :
+      // Content-Length on a 304 is that of the full entity, and has no body
+      request.outMIME.SetInteger(PHTTP::ContentLengthTag, (long)file.GetLength());
+      server.StartResponse(request.code, request.outMIME, 0);
+      return true;
+
+    case PHTTP::RangeNotSatisfiable :
+      server.StartResponse(request.code, request.outMIME, 0);
+      return true;
+
+    default :
+      break;
+  }
+
+  server.StartResponse(request.code, request.outMIME, request.contentSize);
+  server.flush();
+
+  bool ok;
+
+  // Can only bypass the channel stack if there is nothing, e.g. TLS, between us and the socket
+  PTCPSocket * socket = dynamic_cast<PTCPSocket *>(server.GetWriteChannel());
+  if (socket != NULL)
+    ok = socket->WriteFile(file, request.contentSize);
+  else {
+    PBYTEArray buffer(65536);
+    PInt64 remaining = request.contentSize;
+    ok = true;
+    while (ok && remaining > 0) {
+      ok = file.Read(buffer.GetPointer(), (PINDEX)std::min(remaining, (PInt64)buffer.GetSize())) &&
+           server.Write(buffer, file.GetLastReadCount());
+      remaining -= file.GetLastReadCount();
+    }
+  }
+
+  PTRACE_IF(3, !ok, "Could not send \"" << file.GetFilePath() << "\" for URL " << url << ": " << server.GetErrorText(PChannel::LastWriteError));
+  file.Close();
+  return ok;
+}
+
+
 PBoolean PHTTPFile::LoadData(PHTTPRequest & request, PCharArray & data)
 {
   PFile & file = ((PHTTPFileRequest&)request).m_file;
@@ -2225,7 +2389,7 @@ PHTTPTailFile::PHTTPTailFile(const PURL & url,
 
 PBoolean PHTTPTailFile::LoadHeaders(PHTTPRequest & request)
 {
-  if (!PHTTPFile::LoadHeaders(request))
+  if (!LoadFileHeaders((PHTTPFileRequest&)request, m_filePath, false))
     return false;
 
   request.contentSize = P_MAX_INDEX;
@@ -2369,16 +2533,18 @@ PBoolean PHTTPDirectory::LoadHeaders(PHTTPRequest & request)
   // if the resource is a file, and the file can't be opened, then return "not found"
   PFile & file = ((PHTTPDirRequest&)request).m_file;
   if (info.type != PFileInfo::SubDirectory) {
-    if (!file.Open(realPath, PFile::ReadOnly) ||
-        (!m_authorisationRealm.IsEmpty() && realPath.GetFileName() == accessFilename)) {
+    if (!m_authorisationRealm.IsEmpty() && realPath.GetFileName() == accessFilename) {
       PTRACE(4, "No permission to access \"" << realPath << "\" for URL " << request.url);
       request.code = PHTTP::NotFound;
       return false;
     }
+
+    PTRACE(4, "Delivering file \"" << realPath << "\" for URL " << request.url);
+    return LoadFileHeaders((PHTTPDirRequest&)request, realPath, true);
   } 
 
   // resource is a directory - if index files disabled, then return "not found"
-  else if (!m_allowDirectoryListing) {
+  if (!m_allowDirectoryListing) {
     PTRACE(4, "No directory listing allowed for \"" << realPath << "\" for URL " << request.url);
     request.code = PHTTP::NotFound;
     return false;
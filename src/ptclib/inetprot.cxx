@@ -55,7 +55,8 @@ PInternetProtocol::PInternetProtocol(const char * svcName,
   SetReadTimeout(PTimeInterval(0, 0, 10));  // 10 minutes
   stuffingState = DontStuff;
   newLineToCRLF = true;
-  unReadCount = 0;
+  m_readStart = m_readEnd = 0;
+  m_readBufferSize = 65536;
 }
 
 
@@ -65,49 +66,56 @@ void PInternetProtocol::SetReadLineTimeout(const PTimeInterval & t)
 }
 
 
-PBoolean PInternetProtocol::Read(void * buf, PINDEX len)
+bool PInternetProtocol::FillReadBuffer()
 {
-  if (unReadCount == 0) {
-    char readAhead[1000];
-    if (!PIndirectChannel::Read(readAhead, sizeof(readAhead)))
-      return false;
-
-    UnRead(readAhead, GetLastReadCount());
+  PINDEX pending = m_readEnd - m_readStart;
+  if (pending == 0)
+    m_readStart = m_readEnd = 0;
+  else if (m_readStart > 0 && m_readEnd >= m_readBuffer.GetSize()) {
+    memmove(m_readBuffer.GetPointer(), m_readBuffer.GetPointer()+m_readStart, pending);
+    m_readStart = 0;
+    m_readEnd = pending;
   }
 
-  SetLastReadCount(PMIN(unReadCount, len));
-  const char * unReadPtr = ((const char *)unReadBuffer)+unReadCount;
-  char * bufptr = (char *)buf;
-  while (unReadCount > 0 && len > 0) {
-    *bufptr++ = *--unReadPtr;
-    unReadCount--;
-    len--;
-  }
+  PINDEX size = m_readBuffer.GetSize();
+  if (size < m_readBufferSize)
+    size = m_readBufferSize;
+  else if (m_readEnd >= size)
+    size *= 2; // Very long line, or lots put back
+  if (!m_readBuffer.SetMinSize(size))
+    return false;
 
-  if (len > 0) {
-    PINDEX saveCount = GetLastReadCount();
-    PIndirectChannel::Read(bufptr, len);
-    SetLastReadCount(GetLastReadCount() + saveCount);
+  if (!PIndirectChannel::Read(m_readBuffer.GetPointer()+m_readEnd, m_readBuffer.GetSize()-m_readEnd))
+    return false;
+
+  m_readEnd += GetLastReadCount();
+  return true;
+}
+
+
+PBoolean PInternetProtocol::Read(void * buf, PINDEX len)
+{
+  if (m_readStart >= m_readEnd) {
+    if (len >= m_readBufferSize)
+      return PIndirectChannel::Read(buf, len);
+    if (!FillReadBuffer())
+      return false;
   }
 
-  return GetLastReadCount() > 0;
+  PINDEX count = std::min(len, m_readEnd - m_readStart);
+  memcpy(buf, m_readBuffer.GetPointer()+m_readStart, count);
+  m_readStart += count;
+  return SetLastReadCount(count) > 0;
 }
 
 
 int PInternetProtocol::ReadChar()
 {
-  if (unReadCount == 0) {
-    char readAhead[1000];
-    if (!PIndirectChannel::Read(readAhead, sizeof(readAhead)))
-      return -1;
-
-    UnRead(readAhead, GetLastReadCount());
-    if (unReadCount == 0)
-      return -1;
-  }
+  if (m_readStart >= m_readEnd && !FillReadBuffer())
+    return -1;
 
   SetLastReadCount(1);
-  return (unReadBuffer[--unReadCount]&0xff);
+  return m_readBuffer[m_readStart++]&0xff;
 }
 
 
@@ -265,19 +273,56 @@ PBoolean PInternetProtocol::WriteLine(const PString & line)
 
 PBoolean PInternetProtocol::ReadLine(PString & line, PBoolean allowContinuation)
 {
-  if (!line.SetMinSize(1000))
+  if (m_readStart >= m_readEnd && !FillReadBuffer())
     return false;
 
+  PTimeInterval oldTimeout = GetReadTimeout();
+  SetReadTimeout(readLineTimeout);
+
+  line.MakeEmpty();
   PINDEX count = 0;
   PBoolean gotEndOfLine = false;
+  PINDEX scanned = 0;
+
+  /* Fast path, find whole lines in the read ahead buffer, only falling back
+     to character by character when there is an editing character or lone
+     CR to deal with, or the line is not complete when the channel stops. */
+  while (!gotEndOfLine) {
+    const char * base = m_readBuffer.GetPointer() + m_readStart;
+    PINDEX available = m_readEnd - m_readStart;
+    const char * eol = (const char *)memchr(base+scanned, '\n', available-scanned);
+    if (eol == NULL) {
+      scanned = available;
+      if (FillReadBuffer())
+        continue;
+      break;
+    }
 
-  int c = ReadChar();
-  if (c < 0)
-    return false;
+    PINDEX len = eol - base;
+    if (len > 0 && base[len-1] == '\r')
+      --len;
+    if (memchr(base, '\r', len) != NULL || memchr(base, '\b', len) != NULL || memchr(base, '\177', len) != NULL)
+      break;
 
-  PTimeInterval oldTimeout = GetReadTimeout();
-  SetReadTimeout(readLineTimeout);
+    memcpy(line.GetPointerAndSetLength(count+len)+count, base, len);
+    count += len;
+    m_readStart += eol - base + 1;
+    scanned = 0;
+
+    int c;
+    if (count == 0 || !allowContinuation || (c = ReadChar()) < 0)
+      gotEndOfLine = true;
+    else if (c != ' ' && c != '\t') {
+      UnRead(c);
+      gotEndOfLine = true;
+    }
+    else {
+      line.GetPointerAndSetLength(count+1)[count] = (char)c;
+      ++count;
+    }
+  }
 
+  int c = gotEndOfLine ? -1 : ReadChar();
   while (c >= 0 && !gotEndOfLine) {
     switch (c) {
       case '\b' :
@@ -317,28 +362,25 @@ PBoolean PInternetProtocol::ReadLine(PString & line, PBoolean allowContinuation)
         break;
 
       default :
-        if (count >= line.GetSize())
-          line.SetSize(count + 100);
-        line[count++] = (char)c;
+        if (count+1 >= line.GetSize())
+          line.SetMinSize(count + 100);
+        line.GetPointerAndSetLength(count+1)[count] = (char)c;
+        ++count;
         c = ReadChar();
     }
   }
 
   SetReadTimeout(oldTimeout);
 
-  if (count > 0)
-    line.MakeMinimumSize(count);
-  else
-    line.MakeEmpty();
-
+  line.GetPointerAndSetLength(count);
   return gotEndOfLine;
 }
 
 
 void PInternetProtocol::UnRead(int ch)
 {
-  unReadBuffer.SetSize((unReadCount+256)&~255);
-  unReadBuffer[unReadCount++] = (char)ch;
+  char c = (char)ch;
+  UnRead(&c, 1);
 }
 
 
@@ -350,12 +392,17 @@ void PInternetProtocol::UnRead(const PString & str)
 
 void PInternetProtocol::UnRead(const void * buffer, PINDEX len)
 {
-  char * unreadptr =
-               unReadBuffer.GetPointer((unReadCount+len+255)&~255)+unReadCount;
-  const char * bufptr = ((const char *)buffer)+len;
-  unReadCount += len;
-  while (len-- > 0)
-    *unreadptr++ = *--bufptr;
+  if (len > m_readStart) {
+    // Make room at the front of the read ahead buffer
+    PINDEX pending = m_readEnd - m_readStart;
+    m_readBuffer.SetMinSize(len + pending);
+    memmove(m_readBuffer.GetPointer()+len, m_readBuffer.GetPointer()+m_readStart, pending);
+    m_readStart = len;
+    m_readEnd = len + pending;
+  }
+
+  m_readStart -= len;
+  memcpy(m_readBuffer.GetPointer()+m_readStart, buffer, len);
 }
 
 
@@ -257,11 +257,271 @@ PBoolean PIpAccessControlEntry::Match(PIPSocket::Address & addr)
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+
+/* Compiled form of the list used for searching. Entries that are a plain
+   network with a contiguous mask (or "all") go into a path compressed binary
+   trie keyed on the host order prefix, so the longest match, which is also
+   the first in the lists sort order, is found in at most 32 steps. Anything
+   else (host names, domains, odd masks) is kept in list order and only
+   tested if it ranks ahead of what the trie found. Once built a snapshot is
+   never modified, and keeps copies of everything it needs from the entries,
+   so any number of threads may search it while the list itself changes.
+ */
+struct PIpAccessControlList::Snapshot
+{
+  struct Result
+  {
+    PIpAccessControlEntry * m_entry;   // Only for Find(), never dereferenced here
+    PINDEX                  m_order;
+    bool                    m_allowed;
+  };
+
+  // Entries not in the trie, with what PIpAccessControlEntry::Match() uses
+  struct Other : Result
+  {
+    PString            m_domain;
+    PIPSocket::Address m_address;
+    PIPSocket::Address m_mask;
+
+    bool Match(PIPSocket::Address & address) const;
+  };
+
+  struct Node
+  {
+    DWORD    m_prefix;   // Host order, bits beyond m_length are zero
+    DWORD    m_mask;
+    unsigned m_length;
+    int      m_child[2];
+    int      m_result;   // Index into m_prefixes, or -1 if not a terminal
+  };
+
+  PINDEX              m_size;
+  int                 m_root;
+  std::vector<Node>   m_nodes;
+  std::vector<Result> m_prefixes;
+  std::vector<Other>  m_others;
+
+  Snapshot(const PIpAccessControlList & list);
+
+  static DWORD PrefixMask(unsigned length) { return length > 0 ? (0xffffffff << (32 - length)) : 0; }
+  static unsigned PrefixBit(DWORD key, unsigned pos) { return (key >> (31 - pos)) & 1; }
+
+  int NewNode(DWORD key, unsigned length, int result);
+  int Insert(int index, DWORD key, unsigned length, int result);
+  const Result * Find(PIPSocket::Address & address) const;
+};
+
+
+PIpAccessControlList::Snapshot::Snapshot(const PIpAccessControlList & list)
+  : m_size(list.GetSize())
+  , m_root(-1)
+{
+  m_prefixes.reserve(m_size);
+  m_nodes.reserve(m_size*2);
+
+  PINDEX order = 0;
+  for (PIpAccessControlList::const_iterator it = list.begin(); it != list.end(); ++it, ++order) {
+    PIpAccessControlEntry & entry = const_cast<PIpAccessControlEntry &>(*it);
+    Result result = { &entry, order, entry.IsAllowed() != false };
+
+    const PString & domain = entry.GetDomain();
+    DWORD mask = PSocket::Net2Host((DWORD)entry.GetMask());
+    unsigned length = 0;
+    while (length < 32 && (mask & (0x80000000 >> length)) != 0)
+      ++length;
+
+    if (domain == "\xff")
+      length = 0;
+    else if (!domain.IsEmpty() || mask != PrefixMask(length)) {
+      Other other;
+      static_cast<Result &>(other) = result;
+      other.m_domain = domain;
+      other.m_domain.MakeUnique();
+      other.m_address = entry.GetAddress();
+      other.m_mask = entry.GetMask();
+      m_others.push_back(other);
+      continue;
+    }
+
+    DWORD key = PSocket::Net2Host((DWORD)entry.GetAddress()) & PrefixMask(length);
+    m_prefixes.push_back(result);
+    m_root = Insert(m_root, key, length, (int)m_prefixes.size()-1);
+  }
+
+  PTRACE(4, NULL, "IP-ACL", "Compiled " << m_size << " entries, "
+         << m_prefixes.size() << " prefixes in " << m_nodes.size() << " trie nodes, "
+         << m_others.size() << " searched in order");
+}
+
+
+bool PIpAccessControlList::Snapshot::Other::Match(PIPSocket::Address & address) const
+{
+  // As PIpAccessControlEntry::Match(), without resolving into the entry
+  switch (m_domain[(PINDEX)0]) {
+    case '\0' : // Must have address field set
+      return (m_address & m_mask) == (address & m_mask);
+
+    case '.' :  // Are a domain name
+      return PIPSocket::GetHostName(address).Right(m_domain.GetLength()) *= m_domain;
+
+    case '\xff' :  // Match all
+      return true;
+  }
+
+  // All else must be a hostname
+  PIPSocket::Address hostAddress;
+  if (!PIPSocket::GetHostAddress(m_domain, hostAddress))
+    return false;
+  return (hostAddress & m_mask) == (address & m_mask);
+}
+
+
+int PIpAccessControlList::Snapshot::NewNode(DWORD key, unsigned length, int result)
+{
+  Node node;
+  node.m_prefix = key;
+  node.m_mask = PrefixMask(length);
+  node.m_length = length;
+  node.m_child[0] = node.m_child[1] = -1;
+  node.m_result = result;
+  m_nodes.push_back(node);
+  return (int)m_nodes.size()-1;
+}
+
+
+int PIpAccessControlList::Snapshot::Insert(int index, DWORD key, unsigned length, int result)
+{
+  if (index < 0)
+    return NewNode(key, length, result);
+
+  // Node is copied as NewNode() may move the vector
+  Node node = m_nodes[index];
+
+  DWORD diff = key ^ node.m_prefix;
+  unsigned common = 0;
+  unsigned limit = std::min(length, node.m_length);
+  while (common < limit && PrefixBit(diff, common) == 0)
+    ++common;
+
+  if (common == node.m_length) {
+    if (length == node.m_length) {
+      // Same prefix twice, the earlier one in the list order wins
+      if (node.m_result < 0)
+        m_nodes[index].m_result = result;
+    }
+    else {
+      unsigned bit = PrefixBit(key, node.m_length);
+      int child = Insert(node.m_child[bit], key, length, result);
+      m_nodes[index].m_child[bit] = child;
+    }
+    return index;
+  }
+
+  // Diverges part way along this node, so split it at the common prefix
+  int split = NewNode(key & PrefixMask(common), common, -1);
+  m_nodes[split].m_child[PrefixBit(node.m_prefix, common)] = index;
+  if (length == common)
+    m_nodes[split].m_result = result;
+  else {
+    int leaf = NewNode(key, length, result);
+    m_nodes[split].m_child[PrefixBit(key, common)] = leaf;
+  }
+  return split;
+}
+
+
+const PIpAccessControlList::Snapshot::Result *
+        PIpAccessControlList::Snapshot::Find(PIPSocket::Address & address) const
+{
+  /* Note a IPv6 address that is not IPv4 mapped has a key of zero, which is
+     how the entries Match() function has always treated them. */
+  DWORD key = PSocket::Net2Host((DWORD)address);
+
+  int best = -1;
+  int index = m_root;
+  while (index >= 0) {
+    const Node & node = m_nodes[index];
+    if (((key ^ node.m_prefix) & node.m_mask) != 0)
+      break;
+    if (node.m_result >= 0)
+      best = node.m_result;
+    if (node.m_length >= 32)
+      break;
+    index = node.m_child[PrefixBit(key, node.m_length)];
+  }
+
+  PINDEX bestOrder = best < 0 ? P_MAX_INDEX : m_prefixes[best].m_order;
+  for (std::vector<Other>::const_iterator it = m_others.begin(); it != m_others.end() && it->m_order < bestOrder; ++it) {
+    if (it->Match(address))
+      return &*it;
+  }
+
+  return best < 0 ? NULL : &m_prefixes[best];
+}
+
+
+/* Searches count themselves in one of two reader counts while they use a
+   snapshot. The count to use is selected by the epoch, which a change flips
+   so that new searches go to the other count and the old one drains. */
+struct PIpAccessControlList::SnapshotReader
+{
+  const PIpAccessControlList & m_list;
+  unsigned                     m_epoch;
+  const Snapshot             * m_snapshot;
+
+  SnapshotReader(const PIpAccessControlList & list)
+    : m_list(list)
+    , m_epoch(list.m_snapshotEpoch)
+  {
+    ++m_list.m_snapshotReaders[m_epoch];
+    m_snapshot = m_list.m_snapshot;
+  }
+
+  ~SnapshotReader()
+  {
+    --m_list.m_snapshotReaders[m_epoch];
+  }
+
+  const Snapshot * operator->() const { return m_snapshot; }
+};
+
+
 ///////////////////////////////////////////////////////////////////////////////
 
 PIpAccessControlList::PIpAccessControlList(PBoolean defAllow)
-  : defaultAllowance(defAllow)
+  : m_snapshot(new Snapshot(*this))
+  , m_snapshotEpoch(0)
+  , m_updating(0)
+  , defaultAllowance(defAllow)
+{
+  m_snapshotReaders[0] = m_snapshotReaders[1] = 0;
+}
+
+
+PIpAccessControlList::PIpAccessControlList(const PIpAccessControlList & other)
+  : PIpAccessControlList_base(other)
+  , m_snapshot(new Snapshot(*this))
+  , m_snapshotEpoch(0)
+  , m_updating(0)
+  , defaultAllowance(other.defaultAllowance)
+{
+  m_snapshotReaders[0] = m_snapshotReaders[1] = 0;
+}
+
+
+PIpAccessControlList & PIpAccessControlList::operator=(const PIpAccessControlList & other)
+{
+  PIpAccessControlList_base::operator=(other);
+  defaultAllowance = other.defaultAllowance;
+  RebuildSnapshot();
+  return *this;
+}
+
+
+PIpAccessControlList::~PIpAccessControlList()
 {
+  delete m_snapshot.exchange(NULL);
 }
 
 
@@ -397,8 +657,11 @@ PBoolean PIpAccessControlList::LoadHostsAccess(const char * daemonName)
   else
     daemon = PProcess::Current().GetName();
 
-  return InternalLoadHostsAccess(daemon, "hosts.allow", true) &  // Really is a single &
-         InternalLoadHostsAccess(daemon, "hosts.deny", false);
+  BeginUpdate();
+  PBoolean ok = InternalLoadHostsAccess(daemon, "hosts.allow", true) &  // Really is a single &
+                InternalLoadHostsAccess(daemon, "hosts.deny", false);
+  EndUpdate();
+  return ok;
 }
 
 #ifdef P_CONFIG_LIST
@@ -415,10 +678,12 @@ PBoolean PIpAccessControlList::Load(PConfig & cfg, const PString & baseName)
 {
   PBoolean ok = true;
   PINDEX count = cfg.GetInteger(baseName & "Array Size");
+  BeginUpdate();
   for (PINDEX i = 1; i <= count; i++) {
     if (!Add(cfg.GetString(baseName & PString(PString::Unsigned, i))))
       ok = false;
   }
+  EndUpdate();
 
   return ok;
 }
@@ -521,22 +786,104 @@ PIpAccessControlEntry * PIpAccessControlList::CreateControlEntry(const PString &
 }
 
 
-PIpAccessControlEntry * PIpAccessControlList::Find(PIPSocket::Address address) const
+PINDEX PIpAccessControlList::Append(PObject * obj)
 {
-  PINDEX size = GetSize();
-  if (size == 0)
-    return NULL;
+  PINDEX idx = PIpAccessControlList_base::Append(obj);
+  RebuildSnapshot();
+  return idx;
+}
 
-  for (PINDEX i = 0; i < GetSize(); i++) {
-    PIpAccessControlEntry & entry = operator[](i);
+
+PObject * PIpAccessControlList::RemoveAt(PINDEX index)
+{
+  PObject * obj = PIpAccessControlList_base::RemoveAt(index);
+  RebuildSnapshot();
+  return obj;
+}
+
+
+void PIpAccessControlList::RemoveAll()
+{
+  PIpAccessControlList_base::RemoveAll();
+  RebuildSnapshot();
+}
+
+
+void PIpAccessControlList::BeginUpdate()
+{
+  ++m_updating;
+}
+
+
+void PIpAccessControlList::EndUpdate()
+{
+  if (PAssert(m_updating > 0, PLogicError) && --m_updating == 0)
+    RebuildSnapshot();
+}
+
+
+void PIpAccessControlList::RebuildSnapshot()
+{
+  if (m_updating > 0)
+    return;
+
+  PWaitAndSignal lock(m_snapshotMutex);
+
+  Snapshot * oldSnapshot = m_snapshot.exchange(new Snapshot(*this));
+
+  /* Wait for every search that might still be using the old snapshot. Any
+     such search incremented a reader count before it loaded the pointer, so
+     seeing each count at zero after the exchange means they have all gone.
+     Flipping the epoch first sends new searches to the other count, so the
+     one being waited on cannot be kept from zero by constant lookups. */
+  for (int pass = 0; pass < 2; ++pass) {
+    unsigned epoch = m_snapshotEpoch;
+    m_snapshotEpoch = epoch ^ 1;
+    while (m_snapshotReaders[epoch] != 0)
+      PThread::Yield();
+  }
+
+  delete oldSnapshot;
+}
+
+
+PIpAccessControlEntry * PIpAccessControlList::InternalFind(PIPSocket::Address & address) const
+{
+  // The search as done before compilation, the first match in the sort order
+  for (const_iterator it = begin(); it != end(); ++it) {
+    PIpAccessControlEntry & entry = const_cast<PIpAccessControlEntry &>(*it);
     if (entry.Match(address))
       return &entry;
   }
-
   return NULL;
 }
 
 
+PIpAccessControlEntry * PIpAccessControlList::Find(PIPSocket::Address address) const
+{
+  if (IsEmpty())
+    return NULL;
+
+#if P_HAS_IPV6
+  if (address.GetVersion() == 6 && address.IsV4Mapped())
+    address = (in_addr)address;
+#endif
+
+  /* The snapshot has the entries as they were when it was built. If the list
+     has changed since, during an update, or via a list function that is not
+     virtual, e.g. erase(), search the list itself. */
+  if (m_updating == 0) {
+    SnapshotReader snapshot(*this);
+    if (snapshot->m_size == GetSize()) {
+      const Snapshot::Result * result = snapshot->Find(address);
+      return result != NULL ? result->m_entry : NULL;
+    }
+  }
+
+  return InternalFind(address);
+}
+
+
 PBoolean PIpAccessControlList::IsAllowed(PTCPSocket & socket) const
 {
   if (IsEmpty())
@@ -552,14 +899,26 @@ PBoolean PIpAccessControlList::IsAllowed(PTCPSocket & socket) const
 
 PBoolean PIpAccessControlList::IsAllowed(PIPSocket::Address address) const
 {
-  if (IsEmpty())
-    return defaultAllowance;
+#if P_HAS_IPV6
+  if (address.GetVersion() == 6 && address.IsV4Mapped())
+    address = (in_addr)address;
+#endif
 
-  PIpAccessControlEntry * entry = Find(address);
-  if (entry == NULL)
-    return false;
+  SnapshotReader snapshot(*this);
+
+  // Changed via a list function that is not virtual, see Find()
+  if (m_updating == 0 && snapshot->m_size != GetSize()) {
+    if (IsEmpty())
+      return defaultAllowance;
+    PIpAccessControlEntry * entry = InternalFind(address);
+    return entry != NULL && entry->IsAllowed();
+  }
+
+  if (snapshot->m_size == 0)
+    return defaultAllowance;
 
-  return entry->IsAllowed();
+  const Snapshot::Result * result = snapshot->Find(address);
+  return result != NULL && result->m_allowed;
 }
 
 
@@ -38,10 +38,129 @@
   #include <tgmath.h>
 #endif
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define P_JSON_SSE2 1
+  #ifdef _MSC_VER
+    #include <intrin.h>
+    static __inline unsigned CountTrailingZeros(unsigned bits) { unsigned long idx; _BitScanForward(&idx, bits); return idx; }
+  #else
+    static __inline unsigned CountTrailingZeros(unsigned bits) { return __builtin_ctz(bits); }
+  #endif
+#else
+  #define P_JSON_SSE2 0
+#endif
+
 #define new PNEW
 #define PTraceModule() "JSON"
 
 
+// Builds the Base tree for PJSON::FromString()
+class PJSONBuilder : public PJSON::Parser
+{
+  public:
+    PJSONBuilder()
+      : m_root(NULL)
+    {
+    }
+
+    ~PJSONBuilder()
+    {
+      delete m_root;
+    }
+
+    PJSON::Base * Detach()
+    {
+      PJSON::Base * root = m_root;
+      m_root = NULL;
+      return root;
+    }
+
+    virtual bool OnStartObject()
+    {
+      PJSON::Object * obj = new PJSON::Object;
+      Add(obj);
+      m_containers.push_back(Container(obj, NULL));
+      return true;
+    }
+
+    virtual bool OnMemberName(const char * name, size_t length)
+    {
+      m_name.assign(name, length);
+      return true;
+    }
+
+    virtual bool OnEndObject()
+    {
+      m_containers.pop_back();
+      return true;
+    }
+
+    virtual bool OnStartArray()
+    {
+      PJSON::Array * arr = new PJSON::Array;
+      Add(arr);
+      m_containers.push_back(Container(NULL, arr));
+      return true;
+    }
+
+    virtual bool OnEndArray()
+    {
+      m_containers.pop_back();
+      return true;
+    }
+
+    virtual bool OnString(const char * value, size_t length)
+    {
+      Add(new PJSON::String(value, length));
+      return true;
+    }
+
+    virtual bool OnNumber(PJSON::NumberType value)
+    {
+      Add(new PJSON::Number(value));
+      return true;
+    }
+
+    virtual bool OnBoolean(bool value)
+    {
+      Add(new PJSON::Boolean(value));
+      return true;
+    }
+
+    virtual bool OnNull()
+    {
+      Add(new PJSON::Null);
+      return true;
+    }
+
+  protected:
+    // Values are always owned by the tree, so an error part way through cleans up
+    void Add(PJSON::Base * value)
+    {
+      if (m_containers.empty()) {
+        delete m_root;
+        m_root = value;
+      }
+      else if (m_containers.back().second != NULL)
+        m_containers.back().second->push_back(value);
+      else {
+        std::pair<PJSON::Object::iterator, bool> result = m_containers.back().first->insert(PJSON::Object::value_type(m_name, value));
+        if (!result.second) {
+          // Duplicate name, last one wins
+          delete result.first->second;
+          result.first->second = value;
+        }
+      }
+    }
+
+    typedef std::pair<PJSON::Object *, PJSON::Array *> Container;
+    std::vector<Container> m_containers;
+    std::string            m_name;
+    PJSON::Base          * m_root;
+};
+
+
 static PJSON::Base * CreateByType(PJSON::Types type)
 {
   switch (type) {
@@ -105,8 +224,15 @@ PJSON & PJSON::operator=(const PJSON & other)
 
 bool PJSON::FromString(const PString & str)
 {
-  PStringStream strm(str);
-  ReadFrom(strm);
+  PJSONBuilder builder;
+  m_valid = builder.Parse(str);
+  PTRACE_IF(4, !m_valid, "Invalid JSON at position " << builder.GetPosition());
+
+  delete m_root;
+  m_root = builder.Detach();
+  if (m_root == NULL)
+    m_root = new Null;
+
   return m_valid;
 }
 
@@ -900,6 +1026,418 @@ PJSON::Base * PJSON::Null::DeepClone() const
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+
+static const unsigned MaxParseDepth = 1000;
+
+
+static __inline bool IsWhiteSpace(char c)
+{
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+
+static const char * SkipWhiteSpace(const char * ptr, const char * end)
+{
+  // Usually there is none, or a single space, so check before using SIMD
+  while (ptr < end && IsWhiteSpace(*ptr)) {
+    ++ptr;
+
+#if P_JSON_SSE2
+    // Longer runs are likely to be indenting in pretty printed JSON
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i newLine = _mm_set1_epi8('\n');
+    const __m128i carriageReturn = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    while (ptr + 16 <= end) {
+      __m128i chunk = _mm_loadu_si128((const __m128i *)ptr);
+      __m128i ws = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, newLine)),
+                                _mm_or_si128(_mm_cmpeq_epi8(chunk, carriageReturn), _mm_cmpeq_epi8(chunk, tab)));
+      unsigned bits = ~_mm_movemask_epi8(ws) & 0xffff;
+      if (bits != 0)
+        return ptr + CountTrailingZeros(bits);
+      ptr += 16;
+    }
+#endif
+  }
+
+  return ptr;
+}
+
+
+static const char * FindQuoteOrEscape(const char * ptr, const char * end)
+{
+#if P_JSON_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  while (ptr + 16 <= end) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)ptr);
+    unsigned bits = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)));
+    if (bits != 0)
+      return ptr + CountTrailingZeros(bits);
+    ptr += 16;
+  }
+#endif
+
+  while (ptr < end && *ptr != '"' && *ptr != '\\')
+    ++ptr;
+  return ptr;
+}
+
+
+static bool ParseHex4(const char * ptr, const char * end, unsigned & value)
+{
+  if (end - ptr < 4)
+    return false;
+
+  value = 0;
+  for (int i = 0; i < 4; ++i) {
+    char c = ptr[i];
+    if (c >= '0' && c <= '9')
+      value = value*16 + c - '0';
+    else if (c >= 'a' && c <= 'f')
+      value = value*16 + c - 'a' + 10;
+    else if (c >= 'A' && c <= 'F')
+      value = value*16 + c - 'A' + 10;
+    else
+      return false;
+  }
+  return true;
+}
+
+
+static void AppendUTF8(std::string & str, unsigned code)
+{
+  if (code < 0x80)
+    str += (char)code;
+  else if (code < 0x800) {
+    str += (char)(0xc0 | (code >> 6));
+    str += (char)(0x80 | (code & 0x3f));
+  }
+  else if (code < 0x10000) {
+    str += (char)(0xe0 | (code >> 12));
+    str += (char)(0x80 | ((code >> 6) & 0x3f));
+    str += (char)(0x80 | (code & 0x3f));
+  }
+  else {
+    str += (char)(0xf0 | (code >> 18));
+    str += (char)(0x80 | ((code >> 12) & 0x3f));
+    str += (char)(0x80 | ((code >> 6) & 0x3f));
+    str += (char)(0x80 | (code & 0x3f));
+  }
+}
+
+
+PJSON::Parser::Parser()
+  : m_start(NULL)
+  , m_position(NULL)
+  , m_end(NULL)
+{
+}
+
+
+bool PJSON::Parser::Parse(const char * data, size_t length, size_t position)
+{
+  m_start = data;
+  m_end = data + length;
+  m_position = data + std::min(position, length);
+  return ParseValue(0);
+}
+
+
+bool PJSON::Parser::ParseValue(unsigned depth)
+{
+  m_position = SkipWhiteSpace(m_position, m_end);
+  if (m_position >= m_end)
+    return false;
+
+  switch (*m_position) {
+    case '{' :
+      if (depth >= MaxParseDepth) {
+        PTRACE(2, NULL, PTraceModule(), "Nested too deeply at position " << GetPosition());
+        return false;
+      }
+
+      ++m_position;
+      if (!OnStartObject())
+        return false;
+
+      m_position = SkipWhiteSpace(m_position, m_end);
+      if (m_position < m_end && *m_position == '}') {
+        ++m_position;
+        return OnEndObject();
+      }
+
+      for (;;) {
+        const char * name;
+        size_t length;
+        m_position = SkipWhiteSpace(m_position, m_end);
+        if (!ParseString(name, length) || !OnMemberName(name, length))
+          return false;
+
+        m_position = SkipWhiteSpace(m_position, m_end);
+        if (m_position >= m_end || *m_position != ':')
+          return false;
+        ++m_position;
+
+        if (!ParseValue(depth+1))
+          return false;
+
+        m_position = SkipWhiteSpace(m_position, m_end);
+        if (m_position >= m_end)
+          return false;
+        if (*m_position == '}') {
+          ++m_position;
+          return OnEndObject();
+        }
+        if (*m_position != ',')
+          return false;
+        ++m_position;
+      }
+
+    case '[' :
+      if (depth >= MaxParseDepth) {
+        PTRACE(2, NULL, PTraceModule(), "Nested too deeply at position " << GetPosition());
+        return false;
+      }
+
+      ++m_position;
+      if (!OnStartArray())
+        return false;
+
+      m_position = SkipWhiteSpace(m_position, m_end);
+      if (m_position < m_end && *m_position == ']') {
+        ++m_position;
+        return OnEndArray();
+      }
+
+      for (;;) {
+        if (!ParseValue(depth+1))
+          return false;
+
+        m_position = SkipWhiteSpace(m_position, m_end);
+        if (m_position >= m_end)
+          return false;
+        if (*m_position == ']') {
+          ++m_position;
+          return OnEndArray();
+        }
+        if (*m_position != ',')
+          return false;
+        ++m_position;
+      }
+
+    case '"' :
+    {
+      const char * str;
+      size_t length;
+      return ParseString(str, length) && OnString(str, length);
+    }
+
+    case 'T' :
+    case 't' :
+      return ParseLiteral("true") && OnBoolean(true);
+
+    case 'F' :
+    case 'f' :
+      return ParseLiteral("false") && OnBoolean(false);
+
+    case 'N' :
+    case 'n' :
+      return ParseLiteral("null") && OnNull();
+  }
+
+  return ParseNumber();
+}
+
+
+bool PJSON::Parser::ParseString(const char * & str, size_t & length)
+{
+  if (m_position >= m_end || *m_position != '"')
+    return false;
+
+  const char * begin = ++m_position;
+  const char * ptr = FindQuoteOrEscape(begin, m_end);
+  if (ptr < m_end && *ptr == '"') {
+    // No escapes, so can point directly into the buffer
+    str = begin;
+    length = ptr - begin;
+    m_position = ptr + 1;
+    return true;
+  }
+
+  m_unescaped.assign(begin, ptr);
+  while (ptr < m_end) {
+    if (*ptr == '"') {
+      str = m_unescaped.data();
+      length = m_unescaped.size();
+      m_position = ptr + 1;
+      return true;
+    }
+
+    if (++ptr >= m_end)
+      break;
+
+    switch (*ptr++) {
+      case '"' :
+      case '\\' :
+      case '/' :
+        m_unescaped += ptr[-1];
+        break;
+      case 'b' :
+        m_unescaped += '\b';
+        break;
+      case 'f' :
+        m_unescaped += '\f';
+        break;
+      case 'n' :
+        m_unescaped += '\n';
+        break;
+      case 'r' :
+        m_unescaped += '\r';
+        break;
+      case 't' :
+        m_unescaped += '\t';
+        break;
+      case 'u' :
+      {
+        unsigned code;
+        if (!ParseHex4(ptr, m_end, code)) {
+          m_position = ptr;
+          return false;
+        }
+        ptr += 4;
+
+        // Surrogate pair
+        unsigned low;
+        if (code >= 0xd800 && code < 0xdc00 && m_end - ptr >= 6 && ptr[0] == '\\' && ptr[1] == 'u' &&
+                ParseHex4(ptr+2, m_end, low) && low >= 0xdc00 && low < 0xe000) {
+          code = 0x10000 + ((code - 0xd800) << 10) + (low - 0xdc00);
+          ptr += 6;
+        }
+        else if (code >= 0xd800 && code < 0xe000)
+          code = 0xfffd; // Unpaired surrogate is not valid UTF-8, use replacement character
+
+        AppendUTF8(m_unescaped, code);
+        break;
+      }
+      default :
+        m_position = ptr-2;
+        return false;
+    }
+
+    const char * next = FindQuoteOrEscape(ptr, m_end);
+    m_unescaped.append(ptr, next);
+    ptr = next;
+  }
+
+  m_position = m_end;
+  return false;
+}
+
+
+bool PJSON::Parser::ParseNumber()
+{
+  const char * begin = m_position;
+  const char * ptr = begin;
+  bool negative = *ptr == '-';
+  if (negative)
+    ++ptr;
+
+  // Fast path for simple integers, which are most numbers
+  const char * digits = ptr;
+  uint64_t integer = 0;
+  while (ptr < m_end && *ptr >= '0' && *ptr <= '9')
+    integer = integer*10 + *ptr++ - '0';
+
+  if (ptr > digits && ptr - digits <= 19 && (ptr >= m_end || (*ptr != '.' && *ptr != 'e' && *ptr != 'E'))) {
+    m_position = ptr;
+    return OnNumber(negative ? -(NumberType)integer : (NumberType)integer);
+  }
+
+  while (ptr < m_end && ((*ptr >= '0' && *ptr <= '9') || *ptr == '.' || *ptr == 'e' || *ptr == 'E' || *ptr == '+' || *ptr == '-'))
+    ++ptr;
+  if (ptr == begin)
+    return false;
+
+  // Need null terminated string for strtold()
+  m_unescaped.assign(begin, ptr);
+  char * numberEnd;
+  NumberType value = strtold(m_unescaped.c_str(), &numberEnd);
+  m_position = begin + (numberEnd - m_unescaped.c_str());
+  return m_position == ptr && OnNumber(value);
+}
+
+
+bool PJSON::Parser::ParseLiteral(const char * literal)
+{
+  const char * ptr = m_position;
+  while (*literal != '\0') {
+    if (ptr >= m_end || tolower(*ptr) != *literal)
+      return false;
+    ++ptr;
+    ++literal;
+  }
+
+  m_position = ptr;
+  return true;
+}
+
+
+bool PJSON::Parser::OnStartObject()
+{
+  return true;
+}
+
+
+bool PJSON::Parser::OnMemberName(const char *, size_t)
+{
+  return true;
+}
+
+
+bool PJSON::Parser::OnEndObject()
+{
+  return true;
+}
+
+
+bool PJSON::Parser::OnStartArray()
+{
+  return true;
+}
+
+
+bool PJSON::Parser::OnEndArray()
+{
+  return true;
+}
+
+
+bool PJSON::Parser::OnString(const char *, size_t)
+{
+  return true;
+}
+
+
+bool PJSON::Parser::OnNumber(NumberType)
+{
+  return true;
+}
+
+
+bool PJSON::Parser::OnBoolean(bool)
+{
+  return true;
+}
+
+
+bool PJSON::Parser::OnNull()
+{
+  return true;
+}
+
+
 #if P_SSL
 
 PJWT::PJWT()
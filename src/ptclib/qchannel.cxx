@@ -37,41 +37,60 @@
 
 /////////////////////////////////////////////////////////
 
-PQueueChannel::PQueueChannel(PINDEX size)
+PQueueChannel::PQueueChannel(PINDEX size, Modes mode)
+  : queueBuffer(NULL)
+  , queueSize(0)
+  , queueLength(0)
+  , enqueuePos(0)
+  , dequeuePos(0)
+  , m_mode(mode)
+  , m_mask(0)
 {
-  if (size > 0) {
-    queueBuffer = new BYTE[size];
-    os_handle = 1;
-  }
-  else {
-    queueBuffer = NULL;
-    os_handle = -1;
-  }
-  queueSize = size;
-  queueLength = enqueuePos = dequeuePos = 0;
+  if (size > 0)
+    Open(size, mode);
 }
 
 
 PQueueChannel::~PQueueChannel()
 {
   Close();
+  delete [] queueBuffer;
 }
 
 
-PBoolean PQueueChannel::Open(PINDEX size)
+PBoolean PQueueChannel::Open(PINDEX size, Modes mode)
 {
   Close();
 
   if (size == 0)
     return false;
 
+  if (mode == SingleProducerConsumer) {
+    PINDEX powerOfTwo = 1;
+    while (powerOfTwo < size)
+      powerOfTwo <<= 1;
+    size = powerOfTwo;
+  }
+
   mutex.Wait();
 
-  if ((queueBuffer = new BYTE[size]) == NULL)
-    return false;
+  delete [] queueBuffer;
+  queueBuffer = new BYTE[size];
 
   queueSize = size;
   queueLength = enqueuePos = dequeuePos = 0;
+  m_mode = mode;
+
+  m_reader.m_position = 0;
+  m_reader.m_peerPosition = 0;
+  m_reader.m_peeked = 0;
+  m_reader.m_writerWaiting = false;
+  m_writer.m_position = 0;
+  m_writer.m_peerPosition = 0;
+  m_writer.m_reserved = 0;
+  m_writer.m_readerWaiting = false;
+  m_mask = size - 1;
+
   os_handle = 1;
 
   mutex.Signal();
@@ -86,9 +105,12 @@ PBoolean PQueueChannel::Close()
     return false;
 
   mutex.Wait();
-  if (queueBuffer != NULL)
+  /* Lock free reader or writer may still be looking at the buffer, so it
+     is kept until re-opened or destroyed. */
+  if (m_mode != SingleProducerConsumer) {
     delete [] queueBuffer;
-  queueBuffer = NULL;
+    queueBuffer = NULL;
+  }
   os_handle = -1;
   mutex.Signal();
   unempty.Signal();
@@ -97,8 +119,205 @@ PBoolean PQueueChannel::Close()
 }
 
 
+PINDEX PQueueChannel::GetLength() const
+{
+  if (m_mode == SingleProducerConsumer) {
+    /* Reader first, the writer can only be further ahead by the time we
+       look at it, so this cannot go negative. But the reader may have
+       moved on and the writer filled the space, so limit to the size. */
+    size_t readPosition = m_reader.m_position.load();
+    size_t writePosition = m_writer.m_position.load();
+    return (PINDEX)std::min(writePosition - readPosition, (size_t)queueSize);
+  }
+  return queueLength;
+}
+
+
+bool PQueueChannel::WaitForSpace(size_t & space)
+{
+  size_t position = m_writer.m_position.load();
+
+  for (;;) {
+    space = queueSize - (position - m_writer.m_peerPosition);
+    if (space > 0)
+      return true;
+
+    // Only look at the readers cache line when we appear to be full
+    m_writer.m_peerPosition = m_reader.m_position.load();
+    space = queueSize - (position - m_writer.m_peerPosition);
+    if (space > 0)
+      return true;
+
+    if (!IsOpen())
+      return SetErrorValues(NotOpen, EBADF, LastWriteError);
+
+    // Flag we are waiting, then check again in case the reader missed the flag
+    m_reader.m_writerWaiting = true;
+    m_writer.m_peerPosition = m_reader.m_position.load();
+    if (position - m_writer.m_peerPosition == (size_t)queueSize) {
+      PTRACE_IF(6, writeTimeout > 0, "QChan\tBlocking on full queue");
+      if (!unfull.Wait(writeTimeout)) {
+        m_reader.m_writerWaiting = false;
+        PTRACE(6, "QChan\tWrite timeout on full queue");
+        return SetErrorValues(Timeout, ETIMEDOUT, LastWriteError);
+      }
+    }
+    m_reader.m_writerWaiting = false;
+  }
+}
+
+
+bool PQueueChannel::WaitForData(size_t & available)
+{
+  size_t position = m_reader.m_position.load();
+
+  for (;;) {
+    available = m_reader.m_peerPosition - position;
+    if (available > 0)
+      return true;
+
+    // Only look at the writers cache line when we appear to be empty
+    m_reader.m_peerPosition = m_writer.m_position.load();
+    available = m_reader.m_peerPosition - position;
+    if (available > 0)
+      return true;
+
+    // Anything written before the close is still returned
+    if (!IsOpen())
+      return SetErrorValues(NotOpen, EBADF, LastReadError);
+
+    // Flag we are waiting, then check again in case the writer missed the flag
+    m_writer.m_readerWaiting = true;
+    m_reader.m_peerPosition = m_writer.m_position.load();
+    if (m_reader.m_peerPosition == position) {
+      PTRACE_IF(6, readTimeout > 0, "QChan\tBlocking on empty queue");
+      if (!unempty.Wait(readTimeout)) {
+        m_writer.m_readerWaiting = false;
+        PTRACE(6, "QChan\tRead timeout on empty queue");
+        return SetErrorValues(Timeout, ETIMEDOUT, LastReadError);
+      }
+    }
+    m_writer.m_readerWaiting = false;
+  }
+}
+
+
+BYTE * PQueueChannel::ReserveWrite(PINDEX & size)
+{
+  if (m_mode != SingleProducerConsumer || size == 0) {
+    size = 0;
+    SetErrorValues(BadParameter, EINVAL, LastWriteError);
+    return NULL;
+  }
+
+  if (!IsOpen()) {
+    size = 0;
+    SetErrorValues(NotOpen, EBADF, LastWriteError);
+    return NULL;
+  }
+
+  size_t space;
+  if (!WaitForSpace(space)) {
+    size = 0;
+    return NULL;
+  }
+
+  size_t offset = m_writer.m_position.load() & m_mask;
+  if (space > queueSize - offset)
+    space = queueSize - offset;
+  if ((size_t)size > space)
+    size = (PINDEX)space;
+
+  m_writer.m_reserved = size;
+  return queueBuffer + offset;
+}
+
+
+bool PQueueChannel::CommitWrite(PINDEX size)
+{
+  if (!PAssert((size_t)size <= m_writer.m_reserved, PInvalidParameter))
+    return false;
+
+  m_writer.m_reserved = 0;
+  m_writer.m_position += size;
+
+  if (m_writer.m_readerWaiting.load()) {
+    PTRACE(6, "QChan\tSignalling queue no longer empty");
+    unempty.Signal();
+  }
+
+  return true;
+}
+
+
+const BYTE * PQueueChannel::PeekRead(PINDEX & size)
+{
+  if (m_mode != SingleProducerConsumer || size == 0) {
+    size = 0;
+    SetErrorValues(BadParameter, EINVAL, LastReadError);
+    return NULL;
+  }
+
+  size_t available;
+  if (!WaitForData(available)) {
+    size = 0;
+    return NULL;
+  }
+
+  size_t offset = m_reader.m_position.load() & m_mask;
+  if (available > queueSize - offset)
+    available = queueSize - offset;
+  if ((size_t)size > available)
+    size = (PINDEX)available;
+
+  m_reader.m_peeked = size;
+  return queueBuffer + offset;
+}
+
+
+bool PQueueChannel::ConsumeRead(PINDEX size)
+{
+  if (!PAssert((size_t)size <= m_reader.m_peeked, PInvalidParameter))
+    return false;
+
+  m_reader.m_peeked = 0;
+  m_reader.m_position += size;
+
+  if (m_reader.m_writerWaiting.load()) {
+    PTRACE(6, "QChan\tSignalling queue no longer full");
+    unfull.Signal();
+  }
+
+  return true;
+}
+
+
 PBoolean PQueueChannel::Read(void * buf, PINDEX count)
 {
+  if (m_mode == SingleProducerConsumer) {
+    // Like the locked mode, return whatever is there, up to two copies for the wrap
+    PINDEX total = 0;
+    while (total < count) {
+      PINDEX size = count - total;
+      const BYTE * data = PeekRead(size);
+      if (data == NULL) {
+        if (total == 0) {
+          SetLastReadCount(0);
+          return false;
+        }
+        break;
+      }
+      memcpy((BYTE *)buf + total, data, size);
+      ConsumeRead(size);
+      total += size;
+      if (m_reader.m_peerPosition == m_reader.m_position.load())
+        break; // Nothing more that we know of, do not block
+    }
+
+    SetLastReadCount(total);
+    return true;
+  }
+
   mutex.Wait();
 
   SetLastReadCount(0);
@@ -185,6 +404,24 @@ PBoolean PQueueChannel::Read(void * buf, PINDEX count)
 
 PBoolean PQueueChannel::Write(const void * buf, PINDEX count)
 {
+  if (m_mode == SingleProducerConsumer) {
+    PINDEX total = 0;
+    while (total < count) {
+      PINDEX size = count - total;
+      BYTE * space = ReserveWrite(size);
+      if (space == NULL) {
+        SetLastWriteCount(total);
+        return false;
+      }
+      memcpy(space, (const BYTE *)buf + total, size);
+      CommitWrite(size);
+      total += size;
+    }
+
+    SetLastWriteCount(total);
+    return true;
+  }
+
   mutex.Wait();
 
   SetLastWriteCount(0);
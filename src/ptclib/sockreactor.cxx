@@ -0,0 +1,321 @@
+/*
+ * sockreactor.cxx
+ *
+ * Event driven socket readiness notification
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#ifdef __GNUC__
+#pragma implementation "sockreactor.h"
+#endif
+
+#include <ptlib.h>
+#include <ptclib/sockreactor.h>
+
+#if P_HAS_EPOLL
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#define PTraceModule() "Reactor"
+
+#define new PNEW
+
+
+struct PSocketReactor::Registration
+{
+  Registration(PChannel & channel, P_INT_PTR id, Events events, const Notifier & notifier)
+    : m_channel(channel)
+    , m_handle(channel.GetHandle())
+    , m_id(id)
+    , m_events(events)
+    , m_notifier(notifier)
+    , m_references(1)
+    , m_removed(false)
+  {
+  }
+
+  PChannel & m_channel;
+  int        m_handle;
+  P_INT_PTR  m_id;
+  Events     m_events;
+  Notifier   m_notifier;
+  unsigned   m_references; // Protected by PSocketReactor::m_mutex
+  bool       m_removed;
+  PDECLARE_MUTEX(m_notifierMutex);
+};
+
+
+class PSocketReactor::ReactorThread : public PThread
+{
+    PCLASSINFO(ReactorThread, PThread);
+  public:
+    ReactorThread(PSocketReactor & reactor, const char * threadName)
+      : PThread(10000, NoAutoDeleteThread, HighPriority, threadName)
+      , m_reactor(reactor)
+    {
+    }
+
+    virtual void Main()
+    {
+      m_reactor.ThreadMain();
+    }
+
+  protected:
+    PSocketReactor & m_reactor;
+};
+
+
+PSocketReactor::PSocketReactor(unsigned threadCount, const char * threadName)
+  : m_epoll(epoll_create1(EPOLL_CLOEXEC))
+  , m_wakeup(eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC))
+  , m_shutdown(false)
+  , m_nextId(1) // Zero is used for the wake up eventfd
+{
+  if (m_epoll < 0 || m_wakeup < 0) {
+    PTRACE(1, "Could not create epoll/eventfd: " << strerror(errno));
+    return;
+  }
+
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.u64 = 0;
+  if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &ev) < 0) {
+    PTRACE(1, "Could not add eventfd to epoll: " << strerror(errno));
+    return;
+  }
+
+  for (unsigned i = 0; i < std::max(threadCount, 1U); ++i) {
+    m_threads.push_back(new ReactorThread(*this, threadName));
+    m_threads.back()->Resume();
+  }
+
+  PTRACE(4, "Started " << m_threads.size() << " reactor threads");
+}
+
+
+PSocketReactor::~PSocketReactor()
+{
+  PAssert(std::find(m_threads.begin(), m_threads.end(), PThread::Current()) == m_threads.end(),
+          "PSocketReactor destroyed from within a notifier");
+  Shutdown();
+
+  for (RegistrationsById::iterator it = m_byId.begin(); it != m_byId.end(); ++it)
+    delete it->second;
+
+  if (m_wakeup >= 0)
+    ::close(m_wakeup);
+  if (m_epoll >= 0)
+    ::close(m_epoll);
+}
+
+
+void PSocketReactor::Shutdown()
+{
+  if (m_shutdown.exchange(true))
+    return;
+
+  // Level triggered, so every thread in epoll_wait() sees it
+  uint64_t one = 1;
+  if (m_wakeup >= 0 && ::write(m_wakeup, &one, sizeof(one)) < 0) {
+    PTRACE(1, "Could not write eventfd: " << strerror(errno));
+  }
+
+  PThread * current = PThread::Current();
+  for (size_t i = 0; i < m_threads.size(); ++i) {
+    if (m_threads[i] == current) {
+      // Called from a notifier, thread exits when it returns, and cleans itself up
+      current->SetAutoDelete();
+      continue;
+    }
+    PAssert(m_threads[i]->WaitForTermination(10000), "Reactor thread did not terminate promptly");
+    delete m_threads[i];
+  }
+  m_threads.clear();
+}
+
+
+bool PSocketReactor::Add(PChannel & channel, Events events, const Notifier & notifier)
+{
+  if (!channel.IsOpen() || m_shutdown)
+    return false;
+
+  PWaitAndSignal lock(m_mutex);
+
+  if (m_byChannel.find(&channel) != m_byChannel.end()) {
+    PTRACE(2, "Channel " << channel.GetHandle() << " already registered");
+    return false;
+  }
+
+  Registration * registration = new Registration(channel, m_nextId++, events, notifier);
+  if (!Arm(*registration, EPOLL_CTL_ADD)) {
+    delete registration;
+    return false;
+  }
+
+  m_byId[registration->m_id] = registration;
+  m_byChannel[&channel] = registration;
+  PTRACE(5, "Added channel " << registration->m_handle << " events=" << events.AsBits());
+  return true;
+}
+
+
+bool PSocketReactor::Modify(PChannel & channel, Events events)
+{
+  PWaitAndSignal lock(m_mutex);
+
+  RegistrationsByChannel::iterator it = m_byChannel.find(&channel);
+  if (it == m_byChannel.end())
+    return false;
+
+  it->second->m_events = events;
+  return Arm(*it->second, EPOLL_CTL_MOD);
+}
+
+
+bool PSocketReactor::Remove(PChannel & channel)
+{
+  Registration * registration;
+
+  {
+    PWaitAndSignal lock(m_mutex);
+
+    RegistrationsByChannel::iterator it = m_byChannel.find(&channel);
+    if (it == m_byChannel.end())
+      return false;
+
+    registration = it->second;
+    registration->m_removed = true;
+    m_byChannel.erase(it);
+    m_byId.erase(registration->m_id);
+
+    // Channel may already have been closed, in which case epoll has already forgotten it
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, registration->m_handle, NULL);
+  }
+
+  // Wait for any executing notifier to complete, recursive so OK if we are that notifier
+  registration->m_notifierMutex.Wait();
+  registration->m_notifierMutex.Signal();
+
+  PWaitAndSignal lock(m_mutex);
+  if (--registration->m_references == 0)
+    delete registration;
+
+  PTRACE(5, "Removed channel " << channel.GetHandle());
+  return true;
+}
+
+
+PINDEX PSocketReactor::GetCount() const
+{
+  PWaitAndSignal lock(m_mutex);
+  return m_byId.size();
+}
+
+
+bool PSocketReactor::Arm(Registration & registration, int op)
+{
+  struct epoll_event ev;
+  ev.events = EPOLLONESHOT;
+  if (registration.m_events & ReadEvent)
+    ev.events |= EPOLLIN|EPOLLRDHUP;
+  if (registration.m_events & WriteEvent)
+    ev.events |= EPOLLOUT;
+  ev.data.u64 = registration.m_id;
+
+  if (epoll_ctl(m_epoll, op, registration.m_handle, &ev) == 0)
+    return true;
+
+  PTRACE(2, "Could not " << (op == EPOLL_CTL_ADD ? "add" : "modify") << " channel "
+         << registration.m_handle << ": " << strerror(errno));
+  return false;
+}
+
+
+void PSocketReactor::Dispatch(P_INT_PTR id, unsigned epollEvents)
+{
+  Registration * registration;
+
+  {
+    PWaitAndSignal lock(m_mutex);
+    RegistrationsById::iterator it = m_byId.find(id);
+    if (it == m_byId.end())
+      return; // Removed after the event was delivered
+
+    registration = it->second;
+    ++registration->m_references;
+  }
+
+  Events events;
+  if (epollEvents & (EPOLLIN|EPOLLRDHUP))
+    events |= ReadEvent;
+  if (epollEvents & EPOLLOUT)
+    events |= WriteEvent;
+  if (epollEvents & (EPOLLERR|EPOLLHUP))
+    events |= ErrorEvent;
+
+  registration->m_notifierMutex.Wait();
+
+  if (!registration->m_removed) {
+    registration->m_notifier(registration->m_channel, events);
+
+    PWaitAndSignal lock(m_mutex);
+    if (!registration->m_removed)
+      Arm(*registration, EPOLL_CTL_MOD);
+  }
+
+  registration->m_notifierMutex.Signal();
+
+  PWaitAndSignal lock(m_mutex);
+  if (--registration->m_references == 0)
+    delete registration;
+}
+
+
+void PSocketReactor::ThreadMain()
+{
+  PTRACE(4, "Reactor thread started");
+
+  struct epoll_event events[64];
+  while (!m_shutdown) {
+    int count = epoll_wait(m_epoll, events, PARRAYSIZE(events), -1);
+    if (count < 0) {
+      if (errno == EINTR)
+        continue;
+      PTRACE(1, "epoll_wait failed: " << strerror(errno));
+      break;
+    }
+
+    for (int i = 0; i < count && !m_shutdown; ++i) {
+      if (events[i].data.u64 != 0)
+        Dispatch((P_INT_PTR)events[i].data.u64, events[i].events);
+    }
+  }
+
+  PTRACE(4, "Reactor thread ended");
+}
+
+
+#endif // P_HAS_EPOLL
+
+
+// End Of File ///////////////////////////////////////////////////////////////
@@ -32,28 +32,52 @@
 #include <ptlib.h>
 #include <ptclib/spooldir.h>
 
+#if P_HAS_INOTIFY
+  #include <sys/inotify.h>
+  #include <poll.h>
+#endif
+
 
 PSpoolDirectory::PSpoolDirectory()
   : m_thread(NULL)
   , m_threadRunning(false)
   , m_timeoutIfNoDir(10000)
   , m_scanTimeout(10000)
+  , m_eventDriven(false)
+  , m_watching(false)
+  , m_workerCount(0)
 {
+  m_wakeUpPipe[0] = m_wakeUpPipe[1] = -1;
+}
+
+PSpoolDirectory::~PSpoolDirectory()
+{
+  Close();
 }
 
 bool PSpoolDirectory::Open(const PDirectory & dir, const PString & type)
 {
+  Close();
+
   PWaitAndSignal m(m_mutex);
 
-  Close();
+  m_directory = dir;
+  m_fileType  = type;
 
   m_threadRunning = true;
 
-  PTRACE(3, "PSpoolDirectory\tThread started " << m_threadRunning);
-  m_thread = new PThreadObj<PSpoolDirectory>(*this, &PSpoolDirectory::ThreadMain);
+#if P_HAS_INOTIFY
+  if (m_eventDriven && pipe(m_wakeUpPipe) < 0) {
+    PTRACE(2, "PSpoolDirectory\tCould not create wake up pipe, using periodic scan: errno=" << errno);
+    m_wakeUpPipe[0] = m_wakeUpPipe[1] = -1;
+  }
+#endif
 
-  m_directory = dir;
-  m_fileType  = type;
+  for (unsigned i = 0; i < m_workerCount; ++i)
+    m_workers.push_back(new PThreadObj<PSpoolDirectory>(*this, &PSpoolDirectory::WorkerMain, false, "SpoolWorker"));
+
+  PTRACE(3, "PSpoolDirectory\tThread started " << m_threadRunning << ", workers=" << m_workerCount);
+  m_thread = new PThreadObj<PSpoolDirectory>(*this, &PSpoolDirectory::ThreadMain);
 
   return true;
 }
@@ -61,14 +85,52 @@ bool PSpoolDirectory::Open(const PDirectory & dir, const PString & type)
 void PSpoolDirectory::Close()
 {
   PTRACE(3, "PSpoolDirectory\tClosed");
-  PWaitAndSignal m(m_mutex);
 
-  if (m_thread != NULL) {
-    m_threadRunning = false;
-    m_thread->WaitForTermination();
-    delete m_thread;
+  // Do not hold m_mutex while waiting, the threads may need it
+  PThread * thread;
+  std::vector<PThread *> workers;
+  {
+    PWaitAndSignal m(m_mutex);
+    thread = m_thread;
     m_thread = NULL;
+    workers.swap(m_workers);
+    m_threadRunning = false;
+  }
+
+#if P_HAS_INOTIFY
+  if (m_wakeUpPipe[1] >= 0) {
+    static const char wake = 0;
+    PAssertOS(write(m_wakeUpPipe[1], &wake, 1) == 1);
   }
+#endif
+
+  if (thread != NULL) {
+    thread->WaitForTermination();
+    delete thread;
+  }
+
+  for (size_t i = 0; i < workers.size(); ++i)
+    m_queueAvailable.Signal();
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i]->WaitForTermination();
+    delete workers[i];
+  }
+
+  // Anything still queued was never locked, and will be found on next Open()
+  PWaitAndSignal lock(m_queueMutex);
+  m_queue.clear();
+  m_queuedEntries.clear();
+  m_releasedLocks.clear();
+  m_retryEntries.clear();
+
+#if P_HAS_INOTIFY
+  for (int i = 0; i < 2; ++i) {
+    if (m_wakeUpPipe[i] >= 0) {
+      ::close(m_wakeUpPipe[i]);
+      m_wakeUpPipe[i] = -1;
+    }
+  }
+#endif
 }
 
 
@@ -91,6 +153,11 @@ void PSpoolDirectory::ThreadMain()
 
   while (m_threadRunning) {
 
+#if P_HAS_INOTIFY
+    if (m_wakeUpPipe[0] >= 0 && WatchDirectory())
+      continue;
+#endif
+
     {
       PWaitAndSignal m(m_mutex);
       m_scanner = m_directory;
@@ -114,6 +181,187 @@ void PSpoolDirectory::ThreadMain()
 }
 
 
+#if P_HAS_INOTIFY
+
+void PSpoolDirectory::ScanDirectory()
+{
+  m_scanner = m_directory;
+  if (!m_scanner.Open())
+    return;
+
+  do {
+    ProcessEntry();
+  } while (m_threadRunning && m_scanner.Next());
+
+  PTRACE(4, "PSpoolDirectory\tFinished scan of '" << m_directory << '\'');
+}
+
+
+void PSpoolDirectory::RetryEntries()
+{
+  std::set<PString> entries;
+  {
+    PWaitAndSignal lock(m_queueMutex);
+    entries.swap(m_retryEntries);
+  }
+
+  for (std::set<PString>::iterator it = entries.begin(); it != entries.end() && m_threadRunning; ++it) {
+    PFilePath fn = m_directory + *it;
+    if (PFile::Exists(fn) && !IsLocked(fn)) {
+      PTRACE(4, "PSpoolDirectory\tRetrying entry '" << *it << '\'');
+      DispatchEntry(*it);
+    }
+  }
+}
+
+
+bool PSpoolDirectory::WatchDirectory()
+{
+  int fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+  if (fd < 0) {
+    PTRACE(2, "PSpoolDirectory\tCould not initialise inotify, using periodic scan: errno=" << errno);
+    return false;
+  }
+
+  static const uint32_t Events = IN_CLOSE_WRITE|IN_MOVED_TO|IN_DELETE|IN_DELETE_SELF|IN_MOVE_SELF;
+  if (inotify_add_watch(fd, m_directory.GetPointer(), Events) < 0) {
+    PTRACE(3, "PSpoolDirectory\tCould not watch directory '" << m_directory << "', using periodic scan: errno=" << errno);
+    ::close(fd);
+    return false;
+  }
+
+  PTRACE(3, "PSpoolDirectory\tWatching directory '" << m_directory << '\'');
+
+  // Pick up anything already there, events for these may also arrive, which is harmless
+  {
+    PWaitAndSignal lock(m_queueMutex);
+    m_watching = true;
+  }
+  ScanDirectory();
+
+  PSimpleTimer retryTimer(m_scanTimeout);
+  bool watching = true;
+  while (watching && m_threadRunning) {
+    // Entries left after processing get no more events, retry them at the scan interval
+    if (retryTimer.HasExpired()) {
+      RetryEntries();
+      retryTimer = m_scanTimeout;
+    }
+
+    pollfd fds[2];
+    fds[0].fd = fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeUpPipe[0];
+    fds[1].events = POLLIN;
+    int result = poll(fds, 2, (int)retryTimer.GetRemaining().GetMilliSeconds()+1);
+    if (result < 0) {
+      if (errno == EINTR)
+        continue;
+      PTRACE(1, "PSpoolDirectory\tpoll failed: errno=" << errno);
+      break;
+    }
+
+    if (result == 0)
+      continue;
+
+    if (fds[1].revents != 0)
+      break;
+
+    // Buffer aligned for the event structures, big enough for many events
+    union {
+      inotify_event m_event;
+      char          m_buffer[65536];
+    } events;
+    ssize_t length;
+    while ((length = read(fd, events.m_buffer, sizeof(events.m_buffer))) > 0) {
+      bool rescan = false;
+      for (char * ptr = events.m_buffer; ptr < events.m_buffer + length; ) {
+        const inotify_event & event = *reinterpret_cast<const inotify_event *>(ptr);
+        ptr += sizeof(inotify_event) + event.len;
+
+        if ((event.mask & IN_Q_OVERFLOW) != 0) {
+          PTRACE(2, "PSpoolDirectory\tEvent queue overflow, rescanning '" << m_directory << '\'');
+          rescan = true;
+          continue;
+        }
+
+        if ((event.mask & (IN_IGNORED|IN_DELETE_SELF|IN_MOVE_SELF|IN_UNMOUNT)) != 0) {
+          PTRACE(2, "PSpoolDirectory\tDirectory '" << m_directory << "' no longer watchable");
+          watching = false;
+          continue;
+        }
+
+        if (event.len == 0 || rescan)
+          continue;
+
+        PString entry(event.name);
+
+        if ((event.mask & IN_DELETE) != 0) {
+          /* A lock being removed may make an entry processable, unless it is
+             one of ours, when the entry has just been processed. */
+          PString ext = GetLockExtension();
+          if ((event.mask & IN_ISDIR) == 0 || entry.GetLength() <= ext.GetLength() || entry.Right(ext.GetLength()) != ext)
+            continue;
+
+          {
+            PWaitAndSignal lock(m_queueMutex);
+            if (m_releasedLocks.erase(entry) > 0)
+              continue;
+          }
+
+          entry.Delete(entry.GetLength() - ext.GetLength(), ext.GetLength());
+        }
+
+        if ((event.mask & IN_ISDIR) != 0 && (event.mask & IN_DELETE) == 0)
+          continue;
+
+        PFilePath fn = m_directory + entry;
+        if (!m_fileType.IsEmpty() && fn.GetType() != m_fileType)
+          continue;
+
+        if (PFile::Exists(fn) && !IsLocked(fn))
+          DispatchEntry(entry);
+      }
+
+      if (rescan) {
+        {
+          PWaitAndSignal lock(m_queueMutex);
+          m_releasedLocks.clear();
+        }
+        ScanDirectory();
+      }
+    }
+  }
+
+  ::close(fd);
+  PTRACE(3, "PSpoolDirectory\tStopped watching directory '" << m_directory << '\'');
+
+  // The next full scan picks up anything waiting to be retried
+  {
+    PWaitAndSignal lock(m_queueMutex);
+    m_watching = false;
+    m_retryEntries.clear();
+  }
+
+  if (watching || !m_threadRunning)
+    return true;
+
+  // Directory went away, wait a while before trying again
+  PThread::Sleep(m_timeoutIfNoDir);
+  return true;
+}
+
+#endif // P_HAS_INOTIFY
+
+
+bool PSpoolDirectory::IsLocked(const PFilePath & fn) const
+{
+  PFilePath lockDirName = fn + GetLockExtension();
+  PFileInfo info;
+  return PFile::Exists(lockDirName) && PFile::GetInfo(lockDirName, info) && ((info.type & PFileInfo::SubDirectory) != 0);
+}
+
+
 void PSpoolDirectory::ProcessEntry()
 {
   // get the name of a file
@@ -134,10 +382,70 @@ void PSpoolDirectory::ProcessEntry()
     return;
 
   // see if lock file exists for this entry
-  PFilePath lockDirName = fn + GetLockExtension();
-  if (PFile::Exists(lockDirName) && PFile::GetInfo(lockDirName, info) && ((info.type & PFileInfo::SubDirectory) != 0))
+  if (IsLocked(fn))
     return;
 
+  DispatchEntry(entry);
+}
+
+
+void PSpoolDirectory::DispatchEntry(const PString & entry)
+{
+  if (m_workerCount == 0) {
+    ProcessFile(entry);
+    return;
+  }
+
+  {
+    PWaitAndSignal lock(m_queueMutex);
+    if (!m_queuedEntries.insert(entry).second)
+      return; // Already queued or being processed
+    m_queue.push_back(entry);
+  }
+  m_queueAvailable.Signal();
+}
+
+
+void PSpoolDirectory::WorkerMain()
+{
+  for (;;) {
+    m_queueAvailable.Wait();
+
+    PString entry;
+    {
+      PWaitAndSignal lock(m_queueMutex);
+      if (!m_threadRunning)
+        break;
+      if (m_queue.empty())
+        continue;
+      entry = m_queue.front();
+      m_queue.pop_front();
+    }
+
+    // Claiming the lock stops another worker, or process, from also processing it
+    if (CreateLockFile(entry)) {
+      ProcessFile(entry);
+      {
+        PWaitAndSignal lock(m_queueMutex);
+        if (m_wakeUpPipe[0] >= 0)
+          m_releasedLocks.insert(entry + GetLockExtension());
+      }
+      DestroyLockFile(entry);
+    }
+    else {
+      PTRACE(4, "PSpoolDirectory\tEntry '" << entry << "' locked by someone else");
+    }
+
+    PWaitAndSignal lock(m_queueMutex);
+    m_queuedEntries.erase(entry);
+  }
+}
+
+
+void PSpoolDirectory::ProcessFile(const PString & entry)
+{
+  PFilePath fn = m_directory + entry;
+
   // process the entry
   if (!m_callback.IsNULL()) {
     m_callback(*this, (P_INT_PTR)&entry);
@@ -157,6 +465,15 @@ void PSpoolDirectory::ProcessEntry()
       PTRACE(1, "PSpoolDirectory\tEntry '" << entry << "' could not be removed");
     }
   }
+
+#if P_HAS_INOTIFY
+  // A periodic scan would find it again, but there will be no more events for it
+  if (PFile::Exists(fn)) {
+    PWaitAndSignal lock(m_queueMutex);
+    if (m_watching)
+      m_retryEntries.insert(entry);
+  }
+#endif
 }
 
 
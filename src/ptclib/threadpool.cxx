@@ -197,3 +197,470 @@ void PThreadPoolBase::WorkerThreadBase::Main()
   }
   PTRACE(2, PThreadPoolTraceModule, "Finished pool thread.");
 }
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+// Keep the two ends of the lock-free queues on separate cache lines
+#define P_CACHE_LINE_PADDING(name) char name[64]
+
+/* Chase-Lev work stealing deque of fixed size. Only the owning worker may
+   call Push() and Pop(), which operate at the "bottom", any other worker
+   may call Steal(), which operates at the "top". */
+class PWorkStealingThreadPoolBase::TaskDeque
+{
+  public:
+    enum { Capacity = 1024, Mask = Capacity-1 };
+
+    TaskDeque()
+      : m_top(0)
+      , m_bottom(0)
+    {
+      for (PINDEX i = 0; i < Capacity; ++i)
+        m_tasks[i].store(NULL);
+    }
+
+    bool Push(Task * task)
+    {
+      long bottom = m_bottom.load();
+      if (bottom - m_top.load() >= Capacity)
+        return false;
+
+      m_tasks[bottom & Mask].store(task);
+      m_bottom.store(bottom+1);
+      return true;
+    }
+
+    Task * Pop()
+    {
+      long bottom = m_bottom.load() - 1;
+      m_bottom.store(bottom);
+
+      long top = m_top.load();
+      if (top > bottom) {
+        m_bottom.store(bottom+1);
+        return NULL;
+      }
+
+      Task * task = m_tasks[bottom & Mask].load();
+      if (top == bottom) {
+        // Last entry, race against thieves for it
+        if (!m_top.compare_exchange_strong(top, top+1))
+          task = NULL;
+        m_bottom.store(bottom+1);
+      }
+      return task;
+    }
+
+    Task * Steal(bool & contended)
+    {
+      long top = m_top.load();
+      if (top >= m_bottom.load())
+        return NULL;
+
+      Task * task = m_tasks[top & Mask].load();
+      if (m_top.compare_exchange_strong(top, top+1))
+        return task;
+
+      contended = true;
+      return NULL;
+    }
+
+  private:
+    atomic<long>   m_top;
+    P_CACHE_LINE_PADDING(m_padding1);
+    atomic<long>   m_bottom;
+    P_CACHE_LINE_PADDING(m_padding2);
+    atomic<Task *> m_tasks[Capacity];
+};
+
+
+/* Bounded multi-producer, multi-consumer queue, as per Dmitry Vyukov. Each
+   cell has a sequence number indicating if it is ready to be written or read
+   for a given position, so producers and consumers only contend on their own
+   end of the queue. */
+class PWorkStealingThreadPoolBase::TaskQueue
+{
+  public:
+    enum { Capacity = 8192, Mask = Capacity-1 };
+
+    TaskQueue()
+      : m_enqueuePosition(0)
+      , m_dequeuePosition(0)
+    {
+      for (unsigned long i = 0; i < Capacity; ++i) {
+        m_cells[i].m_sequence.store(i);
+        m_cells[i].m_task = NULL;
+      }
+    }
+
+    bool Enqueue(Task * task)
+    {
+      unsigned long position = m_enqueuePosition.load();
+      for (;;) {
+        Cell & cell = m_cells[position & Mask];
+        long diff = (long)(cell.m_sequence.load() - position);
+        if (diff == 0) {
+          if (m_enqueuePosition.compare_exchange_strong(position, position+1)) {
+            cell.m_task = task;
+            cell.m_sequence.store(position+1);
+            return true;
+          }
+        }
+        else if (diff < 0)
+          return false; // Full
+        else
+          position = m_enqueuePosition.load();
+      }
+    }
+
+    Task * Dequeue()
+    {
+      unsigned long position = m_dequeuePosition.load();
+      for (;;) {
+        Cell & cell = m_cells[position & Mask];
+        long diff = (long)(cell.m_sequence.load() - (position+1));
+        if (diff == 0) {
+          if (m_dequeuePosition.compare_exchange_strong(position, position+1)) {
+            Task * task = cell.m_task;
+            cell.m_sequence.store(position+Capacity);
+            return task;
+          }
+        }
+        else if (diff < 0)
+          return NULL; // Empty
+        else
+          position = m_dequeuePosition.load();
+      }
+    }
+
+  private:
+    struct Cell
+    {
+      atomic<unsigned long> m_sequence;
+      Task                * m_task;
+    };
+
+    atomic<unsigned long> m_enqueuePosition;
+    P_CACHE_LINE_PADDING(m_padding1);
+    atomic<unsigned long> m_dequeuePosition;
+    P_CACHE_LINE_PADDING(m_padding2);
+    Cell                  m_cells[Capacity];
+};
+
+
+class PWorkStealingThreadPoolBase::WorkerThread : public PThread
+{
+    PCLASSINFO(WorkerThread, PThread);
+  public:
+    WorkerThread(PWorkStealingThreadPoolBase & pool, unsigned index)
+      : PThread(100, NoAutoDeleteThread, pool.m_priority, pool.m_threadName)
+      , m_pool(pool)
+      , m_random(index*2654435761U + 1)
+    {
+    }
+
+    virtual void Main()
+    {
+      m_pool.WorkerMain(*this);
+    }
+
+    unsigned NextRandom()
+    {
+      // Simple xorshift, only used to select a victim to steal from
+      m_random ^= m_random << 13;
+      m_random ^= m_random >> 17;
+      m_random ^= m_random << 5;
+      return m_random;
+    }
+
+    PWorkStealingThreadPoolBase & m_pool;
+    TaskDeque                     m_deque;
+    unsigned                      m_random;
+};
+
+
+struct PWorkStealingThreadPoolBase::GroupQueue
+{
+  GroupQueue(GroupShard & shard, const std::string & name)
+    : m_shard(shard)
+    , m_name(name)
+  {
+  }
+
+  GroupShard       & m_shard;
+  std::string        m_name;
+  std::queue<Task *> m_pending; // Waiting for the group task currently scheduled
+};
+
+
+struct PWorkStealingThreadPoolBase::GroupShard
+{
+  enum { Count = 61 };
+
+  static unsigned Hash(const char * name)
+  {
+    // FNV-1a
+    unsigned hash = 2166136261U;
+    while (*name != '\0')
+      hash = (hash ^ (BYTE)*name++) * 16777619U;
+    return hash % Count;
+  }
+
+  typedef std::map<std::string, GroupQueue *> GroupMap;
+  GroupMap       m_groups;
+  PDECLARE_MUTEX(m_mutex);
+};
+
+
+PWorkStealingThreadPoolBase::PWorkStealingThreadPoolBase(unsigned workerCount,
+                                                         const char * threadName,
+                                                         PThread::Priority priority)
+  : m_workerCount(std::max(workerCount, 1U))
+  , m_threadName(threadName != NULL ? threadName : "Pool")
+  , m_priority(priority)
+  , m_started(false)
+  , m_shutdown(false)
+  , m_addingCount(0)
+  , m_available(0, INT_MAX)
+  , m_injector(new TaskQueue)
+  , m_overflowCount(0)
+  , m_groupShards(new GroupShard[GroupShard::Count])
+{
+}
+
+
+PWorkStealingThreadPoolBase::~PWorkStealingThreadPoolBase()
+{
+  Shutdown();
+  delete m_injector;
+  delete [] m_groupShards;
+}
+
+
+void PWorkStealingThreadPoolBase::Shutdown()
+{
+  if (!m_shutdown.exchange(true)) {
+    PTRACE(3, PThreadPoolTraceModule, "Shutting down work stealing thread pool \"" << m_threadName << '"');
+  }
+
+  /* An AddTask() that got past its check of m_shutdown before we set it may
+     still be queuing its task, wait for it so the task is discarded below.
+     Any AddTask() after this sees m_shutdown and fails. This is done before
+     taking m_startMutex, as AddTask() may be waiting on it in StartWorkers(). */
+  while (m_addingCount > 0)
+    PThread::Yield();
+
+  PWaitAndSignal lock(m_startMutex);
+
+  for (size_t i = 0; i < m_workers.size(); ++i)
+    m_available.Signal();
+
+  // A worker may be in the middle of a long task, it cannot be deleted until it finishes
+  for (size_t i = 0; i < m_workers.size(); ++i) {
+    while (!m_workers[i]->WaitForTermination(10000)) {
+      PTRACE(1, PThreadPoolTraceModule, "Worker \"" << *m_workers[i] << "\" has not terminated, still waiting");
+    }
+  }
+
+  // Discard anything not yet executed, the workers have gone so we may empty their deques
+  Task * task;
+  for (size_t i = 0; i < m_workers.size(); ++i) {
+    while ((task = m_workers[i]->m_deque.Pop()) != NULL)
+      delete task;
+    delete m_workers[i];
+  }
+  m_workers.clear();
+
+  while ((task = m_injector->Dequeue()) != NULL)
+    delete task;
+
+  m_overflowMutex.Wait();
+  while (!m_overflow.empty()) {
+    delete m_overflow.front();
+    m_overflow.pop();
+  }
+  m_overflowMutex.Signal();
+
+  for (PINDEX i = 0; i < GroupShard::Count; ++i) {
+    GroupShard & shard = m_groupShards[i];
+    PWaitAndSignal lock(shard.m_mutex);
+    for (GroupShard::GroupMap::iterator it = shard.m_groups.begin(); it != shard.m_groups.end(); ++it) {
+      while (!it->second->m_pending.empty()) {
+        delete it->second->m_pending.front();
+        it->second->m_pending.pop();
+      }
+      delete it->second;
+    }
+    shard.m_groups.clear();
+  }
+}
+
+
+void PWorkStealingThreadPoolBase::StartWorkers()
+{
+  if (m_started)
+    return;
+
+  PWaitAndSignal lock(m_startMutex);
+  if (m_started || m_shutdown)
+    return;
+
+  // Create all before starting any, so m_workers is never altered while in use
+  for (unsigned i = 0; i < m_workerCount; ++i)
+    m_workers.push_back(new WorkerThread(*this, i));
+  for (unsigned i = 0; i < m_workerCount; ++i)
+    m_workers[i]->Resume();
+
+  PTRACE(4, PThreadPoolTraceModule, "Started " << m_workerCount << " workers for work stealing thread pool \"" << m_threadName << '"');
+  m_started = true;
+}
+
+
+PWorkStealingThreadPoolBase::WorkerThread * PWorkStealingThreadPoolBase::GetCurrentWorker() const
+{
+  WorkerThread * worker = dynamic_cast<WorkerThread *>(PThread::Current());
+  return worker != NULL && &worker->m_pool == this ? worker : NULL;
+}
+
+
+bool PWorkStealingThreadPoolBase::AddTask(Task * task, const char * group)
+{
+  if (PAssertNULL(task) == NULL)
+    return false;
+
+  // Shutdown() waits for this count to be zero after setting m_shutdown
+  ++m_addingCount;
+  if (m_shutdown) {
+    --m_addingCount;
+    return false;
+  }
+
+  StartWorkers();
+  InternalAddTask(task, group);
+  --m_addingCount;
+  return true;
+}
+
+
+void PWorkStealingThreadPoolBase::InternalAddTask(Task * task, const char * group)
+{
+
+  if (group != NULL && *group != '\0') {
+    GroupShard & shard = m_groupShards[GroupShard::Hash(group)];
+    PWaitAndSignal lock(shard.m_mutex);
+
+    GroupShard::GroupMap::iterator it = shard.m_groups.find(group);
+    if (it != shard.m_groups.end()) {
+      // Group already has a task scheduled, this one waits its turn
+      task->m_group = it->second;
+      it->second->m_pending.push(task);
+      return;
+    }
+
+    task->m_group = new GroupQueue(shard, group);
+    shard.m_groups.insert(GroupShard::GroupMap::value_type(group, task->m_group));
+  }
+
+  Schedule(task);
+}
+
+
+void PWorkStealingThreadPoolBase::Schedule(Task * task)
+{
+  WorkerThread * worker = GetCurrentWorker();
+  if (worker == NULL || !worker->m_deque.Push(task)) {
+    if (!m_injector->Enqueue(task)) {
+      PWaitAndSignal lock(m_overflowMutex);
+      m_overflow.push(task);
+      ++m_overflowCount;
+    }
+  }
+
+  // Every task scheduled is followed by exactly one Signal()
+  m_available.Signal();
+}
+
+
+PWorkStealingThreadPoolBase::Task * PWorkStealingThreadPoolBase::FindTask(WorkerThread & worker)
+{
+  for (;;) {
+    Task * task = worker.m_deque.Pop();
+    if (task != NULL)
+      return task;
+
+    if ((task = m_injector->Dequeue()) != NULL)
+      return task;
+
+    if (m_overflowCount > 0) {
+      PWaitAndSignal lock(m_overflowMutex);
+      if (!m_overflow.empty()) {
+        task = m_overflow.front();
+        m_overflow.pop();
+        --m_overflowCount;
+        return task;
+      }
+    }
+
+    bool contended = false;
+    size_t count = m_workers.size();
+    size_t start = worker.NextRandom() % count;
+    for (size_t i = 0; i < count; ++i) {
+      WorkerThread * victim = m_workers[(start + i) % count];
+      if (victim != &worker && (task = victim->m_deque.Steal(contended)) != NULL)
+        return task;
+    }
+
+    /* Only give up if every queue was seen to be empty. If we lost a race
+       for a task, there may be more, so go around again. Any task added
+       after we looked will have its own Signal() to wake a worker. */
+    if (!contended)
+      return NULL;
+  }
+}
+
+
+void PWorkStealingThreadPoolBase::RunTask(Task * task)
+{
+  GroupQueue * group = task->m_group;
+
+  task->Work();
+  delete task;
+
+  if (group == NULL)
+    return;
+
+  Task * next = NULL;
+  {
+    PWaitAndSignal lock(group->m_shard.m_mutex);
+    if (group->m_pending.empty()) {
+      group->m_shard.m_groups.erase(group->m_name);
+      delete group;
+    }
+    else {
+      next = group->m_pending.front();
+      group->m_pending.pop();
+    }
+  }
+
+  if (next != NULL)
+    Schedule(next);
+}
+
+
+void PWorkStealingThreadPoolBase::WorkerMain(WorkerThread & worker)
+{
+  PTRACE(4, PThreadPoolTraceModule, "Started work stealing pool thread \"" << worker << '"');
+
+  for (;;) {
+    m_available.Wait();
+    if (m_shutdown)
+      break;
+
+    Task * task = FindTask(worker);
+    if (task != NULL)
+      RunTask(task);
+  }
+
+  PTRACE(4, PThreadPoolTraceModule, "Finished work stealing pool thread \"" << worker << '"');
+}
@@ -1119,183 +1119,226 @@ void PAbstractSortedList::DeleteSubTrees(PSortedListElement * node, PBoolean del
 
 ///////////////////////////////////////////////////////////////////////////////
 
+PHashTableInfo::PHashTableInfo(PINDEX initialSize)
+  : deleteKeys(true)
+  , m_head(NULL)
+  , m_tail(NULL)
+  , m_count(0)
+{
+  if (initialSize > 0) {
+    PINDEX size = 8;
+    while (size < initialSize)
+      size *= 2;
+    SetSize(size);
+  }
+}
+
+
+PObject * PHashTableInfo::Clone() const
+{
+  // Copying the slots would share the elements, so rebuild them all
+  PHashTableInfo * clone = new PHashTableInfo(GetSize());
+  PAssert(clone != NULL, POutOfMemory);
+  clone->deleteKeys = deleteKeys;
+
+  for (PHashTableElement * element = m_head; element != NULL; element = element->m_next) {
+    PHashTableElement * copy = new PHashTableElement;
+    PAssert(copy != NULL, POutOfMemory);
+    copy->m_key = element->m_key->Clone();
+    copy->m_data = element->m_data != NULL ? element->m_data->Clone() : NULL;
+    copy->m_hash = element->m_hash;
+    clone->LinkElement(copy);
+  }
+
+  return clone;
+}
+
+
 void PHashTableInfo::DestroyContents()
 {
-  for (PINDEX i = 0; i < GetSize(); i++) {
-    PHashTableElement * elmt = GetAt(i).m_head;
-    while (elmt != NULL) {
-      PHashTableElement * nextElmt = elmt->m_next;
-      if (elmt->m_data != NULL && reference->deleteObjects)
-        delete elmt->m_data;
-      if (deleteKeys)
-        delete elmt->m_key;
-      delete elmt;
-      elmt = nextElmt;
-    }
+  PHashTableElement * elmt = m_head;
+  while (elmt != NULL) {
+    PHashTableElement * nextElmt = elmt->m_next;
+    if (elmt->m_data != NULL && reference->deleteObjects)
+      delete elmt->m_data;
+    if (deleteKeys)
+      delete elmt->m_key;
+    delete elmt;
+    elmt = nextElmt;
   }
+  m_head = m_tail = NULL;
+  m_count = 0;
   PAbstractArray::DestroyContents();
 }
 
 
+unsigned PHashTableInfo::MixHash(const PObject & key)
+{
+  /* Part of the MurmurHash3 finaliser, spreads the bits of hash functions
+     that return small or sequential values, as the low bits select the slot. */
+  uint64_t hash = (uint64_t)key.HashFunction();
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return (unsigned)hash;
+}
+
+
+PINDEX PHashTableInfo::InsertSlot(PHashTableElement * element)
+{
+  // Robin Hood insertion, take the slot of any entry that is closer to its home
+  PHashTableSlot * slots = GetSlots();
+  PINDEX mask = GetSize() - 1;
+  PHashTableSlot entry;
+  entry.m_element = element;
+  entry.m_hash = element->m_hash;
+  PINDEX slot = entry.m_hash & mask;
+  PINDEX distance = 0;
+  PINDEX maxDistance = 0;
+  while (slots[slot].m_element != NULL) {
+    PINDEX existing = ProbeDistance(slot);
+    if (existing < distance) {
+      std::swap(entry, slots[slot]);
+      distance = existing;
+    }
+    slot = (slot + 1) & mask;
+    if (++distance > maxDistance)
+      maxDistance = distance;
+  }
+  slots[slot] = entry;
+  return maxDistance;
+}
+
+
+void PHashTableInfo::Rehash(PINDEX newSize)
+{
+  SetSize(0);
+  SetSize(newSize);
+  memset(theArray, 0, newSize*sizeof(PHashTableSlot));
+
+  for (PHashTableElement * element = m_head; element != NULL; element = element->m_next)
+    InsertSlot(element);
+}
+
+
 void PHashTableInfo::AppendElement(PObject * key, PObject * data PTRACE_PARAM(, PHashTable * owner))
 {
-  PINDEX bucket = PAssertNULL(key)->HashFunction();
-  if (bucket >= GetSize())
-    SetSize(bucket+1);
+  // Keep load factor at or below 3/4
+  if ((m_count+1)*4 > GetSize()*3)
+    Rehash(GetSize() > 0 ? GetSize()*2 : 8);
 
-  PHashTableList & list = operator[](bucket);
   PHashTableElement * element = new PHashTableElement;
   PAssert(element != NULL, POutOfMemory);
   element->m_key = key;
   element->m_data = data;
-  element->m_bucket = bucket;
-  element->m_next = NULL;
-
-  if (list.m_head == NULL) {
-    element->m_prev = NULL;
-    list.m_head = list.m_tail = element;
-  }
-  else {
-    element->m_prev = list.m_tail;
-    list.m_tail->m_next = element;
-    list.m_tail =  element;
-  }
+  element->m_hash = MixHash(*PAssertNULL(key));
 
 #if PTRACING
-  ++list.m_size;
+  PINDEX distance = LinkElement(element);
   PINDEX totalSize = owner->GetSize();
-  PTRACE_IF(m_throttlePoorHashFunction, list.m_size > 20 && list.m_size > totalSize/2, owner, "PTLib",
+  PTRACE_IF(m_throttlePoorHashFunction, distance > 20 && distance > totalSize/2, owner, "PTLib",
             "Poor hash function used, more than 50% of " << totalSize <<
-            " items in same bucket for class=\"" << owner->GetClass() << "\""
-            " key=\"" << *key << "\" bucket=" << bucket);
+            " items searched for class=\"" << owner->GetClass() << "\""
+            " key=\"" << *key << "\" hash=" << key->HashFunction());
+#else
+  LinkElement(element);
 #endif
 }
 
 
-PObject * PHashTableInfo::RemoveElement(const PObject & key)
+PINDEX PHashTableInfo::LinkElement(PHashTableElement * element)
 {
-  PObject * obj = NULL;
-  PHashTableElement * element = GetElementAt(key);
-  if (element != NULL) {
-    PHashTableList & list = operator[](element->m_bucket);
-    if (element == list.m_head) {
-      if (element == list.m_tail)
-        list.m_head = list.m_tail = NULL;
-      else {
-        list.m_head = list.m_head->m_next;
-        list.m_head->m_prev = NULL;
-      }
-    }
-    else {
-      if (element == list.m_tail) {
-        list.m_tail = list.m_tail->m_prev;
-        list.m_tail->m_next = NULL;
-      }
-      else {
-        element->m_prev->m_next = element->m_next;
-        element->m_next->m_prev = element->m_prev;
-      }
-    }
-#if PTRACING
-    --list.m_size;
-#endif
+  element->m_next = NULL;
+  element->m_prev = m_tail;
 
-    obj = element->m_data;
-    if (deleteKeys)
-      delete element->m_key;
-    delete element;
+  if (m_tail == NULL)
+    m_head = m_tail = element;
+  else {
+    m_tail->m_next = element;
+    m_tail = element;
   }
-  return obj;
+  ++m_count;
+
+  return InsertSlot(element);
 }
 
 
-PHashTableElement * PHashTableInfo::GetElementAt(PINDEX index)
+PObject * PHashTableInfo::RemoveElement(const PObject & key)
 {
-  PHashTableElement * element;
-  PINDEX bucket = 0;
-  while ((element = GetAt(bucket).m_head) == NULL) {
-    if (bucket >= GetSize())
-      return NULL;
-    bucket++;
-  }
+  PHashTableElement * element = GetElementAt(key);
+  if (element == NULL)
+    return NULL;
 
-  for (PINDEX i = 0; i < index; ++i) {
-    if (element->m_next != NULL)
-      element = element->m_next;
-    else {
-      do {
-        if (++bucket >= GetSize())
-          return NULL;
-      } while ((element = GetAt(bucket).m_head) == NULL);
-    }
+  PHashTableSlot * slots = GetSlots();
+  PINDEX mask = GetSize() - 1;
+  PINDEX slot = element->m_hash & mask;
+  while (slots[slot].m_element != element)
+    slot = (slot + 1) & mask;
+
+  // Backward shift deletion, so no tombstones are needed
+  PINDEX next = (slot + 1) & mask;
+  while (slots[next].m_element != NULL && ProbeDistance(next) > 0) {
+    slots[slot] = slots[next];
+    slot = next;
+    next = (next + 1) & mask;
   }
+  slots[slot] = PHashTableSlot();
 
-  return element;
-}
-
+  if (element->m_prev != NULL)
+    element->m_prev->m_next = element->m_next;
+  else
+    m_head = element->m_next;
+  if (element->m_next != NULL)
+    element->m_next->m_prev = element->m_prev;
+  else
+    m_tail = element->m_prev;
+  --m_count;
 
-PHashTableElement * PHashTableInfo::GetElementAt(const PObject & key)
-{
-  PHashTableElement * element = GetAt(key.HashFunction()).m_head;
-  while (element != NULL) {
-    if (*element->m_key == key) 
-      return element;
-    element = element->m_next;
-  }
-  return NULL;
+  PObject * obj = element->m_data;
+  if (deleteKeys)
+    delete element->m_key;
+  delete element;
+  return obj;
 }
 
 
-PINDEX PHashTableInfo::GetElementsIndex(const PObject * obj, PBoolean byValue, PBoolean keys) const
+PHashTableElement * PHashTableInfo::GetElementAt(PINDEX index)
 {
-  PINDEX index = 0;
-  for (PINDEX i = 0; i < GetSize(); i++) {
-    PHashTableElement * element = GetAt(i).m_head;
-    while (element != NULL) {
-      PObject * keydata = keys ? element->m_key : element->m_data;
-      if (byValue ? (*keydata == *obj) : (keydata == obj))
-        return index;
-      element = element->m_next;
-      index++;
-    }
-  }
-  return P_MAX_INDEX;
+  PHashTableElement * element = m_head;
+  while (element != NULL && index-- > 0)
+    element = element->m_next;
+  return element;
 }
 
 
-PHashTableElement * PHashTableInfo::NextElement(PHashTableElement * element) const
+PHashTableElement * PHashTableInfo::GetElementAt(const PObject & key)
 {
-  if (element == NULL)
+  if (m_count == 0)
     return NULL;
 
-  PINDEX bucket = element->m_bucket;
-  if (element->m_next != NULL)
-    element = element->m_next;
-  else {
-    do {
-      if (++bucket >= GetSize())
-        return NULL;
-    } while ((element = GetAt(bucket).m_head) == NULL);
+  unsigned hash = MixHash(key);
+  const PHashTableSlot * slots = GetSlots();
+  PINDEX mask = GetSize() - 1;
+  PINDEX slot = hash & mask;
+  for (PINDEX distance = 0; slots[slot].m_element != NULL && ProbeDistance(slot) >= distance; ++distance) {
+    if (slots[slot].m_hash == hash && *slots[slot].m_element->m_key == key)
+      return slots[slot].m_element;
+    slot = (slot + 1) & mask;
   }
-  return element;
+  return NULL;
 }
 
 
-PHashTableElement * PHashTableInfo::PrevElement(PHashTableElement * element) const
+PINDEX PHashTableInfo::GetElementsIndex(const PObject * obj, PBoolean byValue, PBoolean keys) const
 {
-  if (element == NULL)
-    return NULL;
-
-  PINDEX bucket = element->m_bucket;
-  if (element->m_prev != NULL)
-    element = element->m_prev;
-  else {
-    do {
-      if (bucket-- == 0)
-        return NULL;
-    } while ((element = GetAt(bucket).m_tail) == NULL);
+  PINDEX index = 0;
+  for (PHashTableElement * element = m_head; element != NULL; element = element->m_next) {
+    PObject * keydata = keys ? element->m_key : element->m_data;
+    if (byValue ? (*keydata == *obj) : (keydata == obj))
+      return index;
+    index++;
   }
-  return element;
+  return P_MAX_INDEX;
 }
 
 
@@ -1326,20 +1369,7 @@ void PHashTable::CopyContents(const PHashTable & hash)
   
 void PHashTable::CloneContents(const PHashTable * hash)
 {
-  PINDEX sz = PAssertNULL(hash)->GetSize();
-  PHashTableInfo * original = PAssertNULL(hash->hashTable);
-
-  hashTable = new PHashTableInfo(original->GetSize());
-  PAssert(hashTable != NULL, POutOfMemory);
-  hashTable->deleteKeys = original->deleteKeys;
-
-  for (PINDEX i = 0; i < sz; i++) {
-    PHashTableElement * lastElement = original->GetElementAt(i);
-    PObject * data = lastElement->m_data;
-    if (data != NULL)
-      data = data->Clone();
-    hashTable->AppendElement(lastElement->m_key->Clone(), data PTRACE_PARAM(, this));
-  }
+  hashTable = (PHashTableInfo *)PAssertNULL(PAssertNULL(hash)->hashTable)->Clone();
 }
 
 
@@ -1215,26 +1215,19 @@ PObject::Comparison PString::Compare(const PObject & obj) const
 
 PINDEX PString::HashFunction() const
 {
-  /* Hash function from "Data Structures and Algorithm Analysis in C++" by
-     Mark Allen Weiss, with limit of only executing over at most the first and
-     last characters to increase speed when dealing with large strings. */
-
-  switch (GetLength()) { // Use virtual function so PStringStream recalculates length
-    case 0:
-      return 0;
-    case 1:
-      return tolower(theArray[0] & 0xff) % 127;
-  }
+  /* FNV-1a hash, case insensitive so PCaselessString keys work, with limit of
+     only executing over at most the first and last characters to increase
+     speed when dealing with large strings. */
 
+  PINDEX length = GetLength(); // Use virtual function so PStringStream recalculates length
   static const PINDEX MaxCount = 18; // Make sure big enough to cover whole PGloballyUniqueID::AsString()
-  PINDEX count = std::min(m_length / 2, MaxCount);
-  unsigned hash = 0;
-  PINDEX i;
-  for (i = 0; i < count; i++)
-    hash = (hash << 5) ^ tolower(theArray[i] & 0xff) ^ hash;
-  for (i = m_length - count - 1; i < m_length; i++)
-    hash = (hash << 5) ^ tolower(theArray[i] & 0xff) ^ hash;
-  return hash % 127;
+  unsigned hash = 2166136261U;
+  for (PINDEX i = 0; i < length; i++) {
+    if (i == MaxCount && length > MaxCount*2)
+      i = length - MaxCount;
+    hash = (hash ^ tolower(theArray[i] & 0xff)) * 16777619U;
+  }
+  return (PINDEX)hash;
 }
 
 
@@ -1558,6 +1551,160 @@ int PString::internal_strncmp(const char * s1, const char *s2, size_t n) const
 }
 
 
+bool PString::InternalIsCaseless() const
+{
+  return false;
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Search primitives for PString::Find() and friends. The case sensitive
+// single character and character set searches use the C library, which is
+// already vectorised on most platforms. The others use SSE2 where available.
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define P_STRING_SSE2 1
+  #ifdef _MSC_VER
+    #include <intrin.h>
+    static __inline unsigned CountTrailingZeros(unsigned bits) { unsigned long idx; _BitScanForward(&idx, bits); return idx; }
+  #else
+    static __inline unsigned CountTrailingZeros(unsigned bits) { return __builtin_ctz(bits); }
+  #endif
+#else
+  #define P_STRING_SSE2 0
+#endif
+
+#if P_STRING_SSE2 && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define P_STRING_AVX2 1
+#else
+  #define P_STRING_AVX2 0
+#endif
+
+
+static __inline bool IsAsciiAlpha(char ch)
+{
+  char lower = ch | 0x20;
+  return lower >= 'a' && lower <= 'z';
+}
+
+
+static __inline bool CharEqual(char c1, char c2, bool caseless)
+{
+  return c1 == c2 || (caseless && tolower(c1 & 0xff) == tolower(c2 & 0xff));
+}
+
+
+static __inline bool StringEqual(const char * s1, const char * s2, size_t len, bool caseless)
+{
+  return caseless ? strncasecmp(s1, s2, len) == 0 : memcmp(s1, s2, len) == 0;
+}
+
+
+static const char * FindCharInString(const char * str, size_t len, char ch, bool caseless)
+{
+  if (!caseless || !IsAsciiAlpha(ch))
+    return (const char *)memchr(str, ch, len);
+
+  // Setting bit 5 makes ASCII upper case into lower case, and nothing else can then match a letter
+  char lower = ch | 0x20;
+  size_t i = 0;
+#if P_STRING_SSE2
+  __m128i caseBit = _mm_set1_epi8(0x20);
+  __m128i target = _mm_set1_epi8(lower);
+  for (; i + 16 <= len; i += 16) {
+    __m128i block = _mm_or_si128(_mm_loadu_si128((const __m128i *)(str+i)), caseBit);
+    unsigned bits = _mm_movemask_epi8(_mm_cmpeq_epi8(block, target));
+    if (bits != 0)
+      return str + i + CountTrailingZeros(bits);
+  }
+#endif
+  for (; i < len; ++i) {
+    if ((str[i] | 0x20) == lower)
+      return str + i;
+  }
+  return NULL;
+}
+
+
+#if P_STRING_AVX2
+/* As for the SSE2 loop in FindSubStringInString(), but 32 positions at a
+   time. Only called if the CPU supports it, determined at run time. */
+__attribute__((target("avx2")))
+static const char * FindSubStringAVX2(const char * str, size_t len, const char * cstr, size_t clen,
+                                      bool caseless, char firstCaseBit, char lastCaseBit, size_t & i)
+{
+  size_t last = clen - 1;
+  __m256i firstMask = _mm256_set1_epi8(firstCaseBit);
+  __m256i lastMask = _mm256_set1_epi8(lastCaseBit);
+  __m256i firstTarget = _mm256_set1_epi8(cstr[0] | firstCaseBit);
+  __m256i lastTarget = _mm256_set1_epi8(cstr[last] | lastCaseBit);
+  for (; i + last + 32 <= len; i += 32) {
+    __m256i firstBlock = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(str+i)), firstMask);
+    __m256i lastBlock = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(str+i+last)), lastMask);
+    unsigned bits = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(firstBlock, firstTarget),
+                                                          _mm256_cmpeq_epi8(lastBlock, lastTarget)));
+    while (bits != 0) {
+      size_t pos = i + CountTrailingZeros(bits);
+      if (StringEqual(str+pos+1, cstr+1, clen-2, caseless))
+        return str + pos;
+      bits &= bits - 1;
+    }
+  }
+  return NULL;
+}
+
+static bool const HasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+
+
+static const char * FindSubStringInString(const char * str, size_t len, const char * cstr, size_t clen, bool caseless)
+{
+  if (clen == 1)
+    return FindCharInString(str, len, *cstr, caseless);
+
+  size_t last = clen - 1;
+  size_t i = 0;
+
+#if P_STRING_SSE2
+  /* Compare the first and last characters of the substring against 16
+     positions at a time, only fully comparing where both match. */
+  char firstCaseBit = caseless && IsAsciiAlpha(cstr[0]) ? 0x20 : 0;
+  char lastCaseBit = caseless && IsAsciiAlpha(cstr[last]) ? 0x20 : 0;
+#if P_STRING_AVX2
+  if (HasAVX2 && len >= 64) {
+    const char * found = FindSubStringAVX2(str, len, cstr, clen, caseless, firstCaseBit, lastCaseBit, i);
+    if (found != NULL)
+      return found;
+  }
+#endif
+  __m128i firstMask = _mm_set1_epi8(firstCaseBit);
+  __m128i lastMask = _mm_set1_epi8(lastCaseBit);
+  __m128i firstTarget = _mm_set1_epi8(cstr[0] | firstCaseBit);
+  __m128i lastTarget = _mm_set1_epi8(cstr[last] | lastCaseBit);
+  for (; i + last + 16 <= len; i += 16) {
+    __m128i firstBlock = _mm_or_si128(_mm_loadu_si128((const __m128i *)(str+i)), firstMask);
+    __m128i lastBlock = _mm_or_si128(_mm_loadu_si128((const __m128i *)(str+i+last)), lastMask);
+    unsigned bits = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstBlock, firstTarget),
+                                                    _mm_cmpeq_epi8(lastBlock, lastTarget)));
+    while (bits != 0) {
+      size_t pos = i + CountTrailingZeros(bits);
+      if (StringEqual(str+pos+1, cstr+1, clen-2, caseless))
+        return str + pos;
+      bits &= bits - 1;
+    }
+  }
+#endif
+
+  for (; i + clen <= len; ++i) {
+    if (CharEqual(str[i], cstr[0], caseless) && StringEqual(str+i, cstr, clen, caseless))
+      return str + i;
+  }
+  return NULL;
+}
+
+
 PINDEX PString::Find(char ch, PINDEX offset) const
 {
 #if PINDEX_SIGNED
@@ -1566,12 +1713,11 @@ PINDEX PString::Find(char ch, PINDEX offset) const
 #endif
 
   PINDEX len = GetLength();
-  while (offset < len) {
-    if (InternalCompare(offset, 1, &ch) == EqualTo)
-      return offset;
-    offset++;
-  }
-  return P_MAX_INDEX;
+  if (offset >= len)
+    return P_MAX_INDEX;
+
+  const char * found = FindCharInString(theArray+offset, len-offset, ch, InternalIsCaseless());
+  return found != NULL ? (PINDEX)(found - theArray) : P_MAX_INDEX;
 }
 
 
@@ -1593,32 +1739,8 @@ PINDEX PString::Find(const char * cstr, PINDEX offset) const
   if (offset > len - clen)
     return P_MAX_INDEX;
 
-  if (len - clen < 10) {
-    while (offset+clen <= len) {
-      if (InternalCompare(offset, clen, cstr) == EqualTo)
-        return offset;
-      offset++;
-    }
-    return P_MAX_INDEX;
-  }
-
-  int strSum = 0;
-  int cstrSum = 0;
-  for (PINDEX i = 0; i < clen; i++) {
-    strSum += toupper(theArray[offset+i] & 0xff);
-    cstrSum += toupper(cstr[i] & 0xff);
-  }
-
-  // search for a matching substring
-  while (offset+clen <= len) {
-    if (strSum == cstrSum && InternalCompare(offset, clen, cstr) == EqualTo)
-      return offset;
-    strSum += toupper(theArray[offset+clen] & 0xff);
-    strSum -= toupper(theArray[offset] & 0xff);
-    offset++;
-  }
-
-  return P_MAX_INDEX;
+  const char * found = FindSubStringInString(theArray+offset, len-offset, cstr, clen, InternalIsCaseless());
+  return found != NULL ? (PINDEX)(found - theArray) : P_MAX_INDEX;
 }
 
 
@@ -1636,7 +1758,8 @@ PINDEX PString::FindLast(char ch, PINDEX offset) const
   if (offset >= len)
     offset = len-1;
 
-  while (InternalCompare(offset, 1, &ch) != EqualTo) {
+  bool caseless = InternalIsCaseless();
+  while (!CharEqual(theArray[offset], ch, caseless)) {
     if (offset == 0)
       return P_MAX_INDEX;
     offset--;
@@ -1664,26 +1787,39 @@ PINDEX PString::FindLast(const char * cstr, PINDEX offset) const
   if (offset > len - clen)
     offset = len - clen;
 
-  int strSum = 0;
-  int cstrSum = 0;
-  for (PINDEX i = 0; i < clen; i++) {
-    strSum += toupper(theArray[offset+i] & 0xff);
-    cstrSum += toupper(cstr[i] & 0xff);
-  }
-
-  // search for a matching substring
-  while (strSum != cstrSum || InternalCompare(offset, clen, cstr) != EqualTo) {
+  bool caseless = InternalIsCaseless();
+  while (!CharEqual(theArray[offset], *cstr, caseless) || !StringEqual(theArray+offset, cstr, clen, caseless)) {
     if (offset == 0)
       return P_MAX_INDEX;
     --offset;
-    strSum += toupper(theArray[offset] & 0xff);
-    strSum -= toupper(theArray[offset+clen] & 0xff);
   }
 
   return offset;
 }
 
 
+// Table of characters in a set, including both cases if caseless
+struct PStringCharSet
+{
+  PStringCharSet(const char * cset, bool caseless)
+  {
+    memset(m_member, 0, sizeof(m_member));
+    while (*cset != '\0') {
+      unsigned ch = *cset++ & 0xff;
+      m_member[ch] = true;
+      if (caseless) {
+        m_member[tolower(ch)] = true;
+        m_member[toupper(ch)] = true;
+      }
+    }
+  }
+
+  bool operator[](char ch) const { return m_member[ch & 0xff]; }
+
+  bool m_member[256];
+};
+
+
 PINDEX PString::FindOneOf(const char * cset, PINDEX offset) const
 {
 #if PINDEX_SIGNED
@@ -1695,13 +1831,23 @@ PINDEX PString::FindOneOf(const char * cset, PINDEX offset) const
     return P_MAX_INDEX;
 
   PINDEX len = GetLength();
-  while (offset < len) {
-    const char * p = cset;
-    while (*p != '\0') {
-      if (InternalCompare(offset, 1, p) == EqualTo)
+  if (offset >= len)
+    return P_MAX_INDEX;
+
+  if (!InternalIsCaseless()) {
+    // Loop is only for the rare case of embedded '\0' characters
+    while ((offset += strcspn(theArray+offset, cset)) < len) {
+      if (theArray[offset] != '\0')
         return offset;
-      p++;
+      offset++;
     }
+    return P_MAX_INDEX;
+  }
+
+  PStringCharSet set(cset, true);
+  while (offset < len) {
+    if (set[theArray[offset]])
+      return offset;
     offset++;
   }
   return P_MAX_INDEX;
@@ -1719,12 +1865,18 @@ PINDEX PString::FindSpan(const char * cset, PINDEX offset) const
     return P_MAX_INDEX;
 
   PINDEX len = GetLength();
+  if (offset >= len)
+    return P_MAX_INDEX;
+
+  if (!InternalIsCaseless()) {
+    offset += strspn(theArray+offset, cset);
+    return offset < len ? offset : P_MAX_INDEX;  // '\0' is never in cset, so embedded ones stop the span
+  }
+
+  PStringCharSet set(cset, true);
   while (offset < len) {
-    const char * p = cset;
-    while (InternalCompare(offset, 1, p) != EqualTo) {
-      if (*++p == '\0')
-        return offset;
-    }
+    if (!set[theArray[offset]])
+      return offset;
     offset++;
   }
   return P_MAX_INDEX;
@@ -2468,6 +2620,12 @@ int PCaselessString::internal_strncmp(const char * s1, const char *s2, size_t n)
 }
 
 
+bool PCaselessString::InternalIsCaseless() const
+{
+  return true;
+}
+
+
 ///////////////////////////////////////////////////////////////////////////////
 
 PStringStream::Buffer::Buffer(PStringStream & str, PINDEX size)
@@ -42,16 +42,22 @@
 #include <ptlib/pluginmgr.h>
 #include <ptlib/syslog.h>
 #include <ptclib/random.h>
+#include <ptlib/tracebinary.h>
 #include "../../../version.h"
 #include "../../../revision.h"
 
 #ifdef _WIN32
   #include <ptlib/msos/ptlib/debstrm.h>
+  #include <io.h>
 #elif defined(P_MACOSX)
   #include <mach-o/dyld.h>
   #include <ptlib/videoio.h>
 #endif
 
+#if PTRACING && !defined(_WIN32)
+  #include <sys/mman.h>
+#endif
+
 
 #define PTraceModule() "PTLib"
 
@@ -185,6 +191,309 @@ void PSetErrorStream(ostream * s)
 #if PTRACING
 
 unsigned PTrace::MaxStackWalk = 32;
+size_t PTrace::MaxBinaryFileSize = 256*1024*1024;
+
+
+/* Trace output stream for the BinaryOutput option. Normal trace lines are
+   written directly into the memory mapped file, lock free, by WriteLine().
+   Anything written via the ostream interface becomes a pre-formatted text
+   record when flushed. */
+class PTraceBinaryStream : public std::ostream
+{
+  public:
+    // Captured by PTrace::Begin()
+    struct Context
+    {
+      bool         m_binary;
+      unsigned     m_level;
+      PInt64       m_tick;
+      PThread    * m_thread;
+      const char * m_fileName;
+      int          m_lineNum;
+      const void * m_object;
+      const char * m_className;
+      unsigned     m_contextId;
+      const char * m_module;
+    };
+
+    // Per thread cache of identifiers, so WriteLine() does not need a lock
+    struct ThreadCache
+    {
+      ThreadCache() : m_generation(0) { }
+
+      unsigned                           m_generation;
+      std::map<const char *, unsigned>   m_pointers; // File names & class names are static
+      std::map<std::string, unsigned>    m_strings;  // Module names may not be
+    };
+
+    PTraceBinaryStream()
+      : std::ostream(&m_buffer)
+      , m_buffer(*this)
+      , m_base(NULL)
+      , m_size(0)
+      , m_position(0)
+      , m_generation(++s_generation)
+    {
+    }
+
+    ~PTraceBinaryStream()
+    {
+      flush();
+      Close();
+    }
+
+    bool Open(const PFilePath & filename,
+              PFile::OpenOptions options,
+              PFileInfo::Permissions permissions,
+              const PTimeInterval & startTick,
+              unsigned traceOptions)
+    {
+      if (!m_file.Open(filename, PFile::ReadWrite, options, permissions))
+        return false;
+
+      // The maximum is for the whole file, including any existing records appended to
+      unsigned long existing = (unsigned long)m_file.GetLength();
+      m_size = std::max(existing, (unsigned long)PTraceBinary::RecordSize(PTrace::MaxBinaryFileSize, 0));
+      if (!m_file.SetLength(m_size)) {
+        m_file.Close();
+        return false;
+      }
+
+#ifdef _WIN32
+      HANDLE mapping = CreateFileMapping((HANDLE)_get_osfhandle(m_file.GetHandle()), NULL, PAGE_READWRITE, 0, 0, NULL);
+      if (mapping != NULL) {
+        m_base = (BYTE *)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, m_size);
+        CloseHandle(mapping); // View keeps mapping open
+      }
+#else
+      m_base = (BYTE *)mmap(NULL, m_size, PROT_READ|PROT_WRITE, MAP_SHARED, m_file.GetHandle(), 0);
+      if (m_base == MAP_FAILED)
+        m_base = NULL;
+#endif
+      if (m_base == NULL) {
+        m_file.SetLength(existing);
+        m_file.Close();
+        return false;
+      }
+
+      PTraceBinary::FileHeader & header = *(PTraceBinary::FileHeader *)m_base;
+      if (existing > 0) {
+        // Appending, so find the end of the existing records
+        if (existing < sizeof(header) || memcmp(header.m_magic, PTraceBinary::Magic(), sizeof(header.m_magic)) != 0) {
+          m_size = existing;
+          Close();
+          return false;
+        }
+
+        unsigned long position = header.m_headerSize;
+        while (position + sizeof(PTraceBinary::Record) <= existing) {
+          unsigned long size = ((PTraceBinary::Record *)(m_base + position))->m_size;
+          if (size == 0)
+            break;
+          position += size;
+        }
+        m_position = position;
+      }
+      else {
+        memcpy(header.m_magic, PTraceBinary::Magic(), sizeof(header.m_magic));
+        header.m_version = PTraceBinary::Version;
+        header.m_headerSize = sizeof(header);
+        header.m_startTime = PTime().GetTimestamp() - (PTimer::Tick() - startTick).GetMicroSeconds();
+        header.m_options = traceOptions;
+        header.m_processId = PProcess::GetCurrentProcessID();
+        strncpy(header.m_processName, PProcess::Current().GetName(), sizeof(header.m_processName)-1);
+        m_position = PTraceBinary::RecordSize(sizeof(header), 0);
+      }
+
+      return true;
+    }
+
+    void Close()
+    {
+      if (m_base == NULL)
+        return;
+
+      unsigned long used = std::min(m_position.load(), m_size);
+#ifdef _WIN32
+      UnmapViewOfFile(m_base);
+#else
+      munmap(m_base, m_size);
+#endif
+      m_base = NULL;
+      m_file.SetLength(used);
+      m_file.Close();
+    }
+
+    PFilePath GetFilePath() const { return m_file.GetFilePath(); }
+    PString GetErrorText() const { return m_file.GetErrorText(); }
+
+    bool WriteLine(const Context & context, const char * text, PINDEX length, ThreadCache & cache)
+    {
+      if (cache.m_generation != m_generation) {
+        cache.m_pointers.clear();
+        cache.m_strings.clear();
+        cache.m_generation = m_generation;
+        if (context.m_thread != NULL && !WriteThread(*context.m_thread))
+          return false;
+      }
+
+      unsigned fileId = Intern(cache.m_pointers, context.m_fileName, context.m_fileName);
+      unsigned classId = Intern(cache.m_pointers, context.m_className, context.m_className);
+      unsigned moduleId = context.m_module != NULL ? Intern(cache.m_strings, std::string(context.m_module), context.m_module) : 0;
+
+      PTraceBinary::LineRecord * record = Reserve<PTraceBinary::LineRecord>(length);
+      if (record == NULL)
+        return false;
+
+      record->m_tick = context.m_tick;
+      record->m_threadId = context.m_thread != NULL ? context.m_thread->GetUniqueIdentifier() : 0;
+      record->m_object = (uintptr_t)context.m_object;
+      record->m_fileId = fileId;
+      record->m_lineNum = context.m_lineNum;
+      record->m_moduleId = moduleId;
+      record->m_classId = classId;
+      record->m_contextId = context.m_contextId;
+      record->m_textLength = length;
+      Commit(record, PTraceBinary::LineType, context.m_level, text, length);
+      return true;
+    }
+
+  protected:
+    template <class Record>
+    Record * Reserve(PINDEX length)
+    {
+      if (m_base == NULL)
+        return NULL;
+
+      uint32_t size = PTraceBinary::RecordSize(sizeof(Record), length);
+      unsigned long position = (m_position += size) - size;
+      if (position + size > m_size)
+        return NULL; // Full, record with zero size left at end marks end of file
+
+      return (Record *)(m_base + position);
+    }
+
+    template <class Record>
+    void Commit(Record * record, unsigned type, unsigned level, const char * text, PINDEX length)
+    {
+      record->m_type = (uint16_t)type;
+      record->m_level = (uint16_t)level;
+      memcpy((BYTE *)(record+1), text, length);
+      // Size last, so an incomplete record looks like the end of file to the decoder
+      record->m_size = PTraceBinary::RecordSize(sizeof(Record), length);
+    }
+
+    template <typename Key>
+    unsigned Intern(std::map<Key, unsigned> & cache, const Key & key, const char * str)
+    {
+      if (str == NULL)
+        return 0;
+
+      typename std::map<Key, unsigned>::iterator it = cache.find(key);
+      if (it != cache.end())
+        return it->second;
+
+      PWaitAndSignal lock(m_mutex);
+
+      std::map<std::string, unsigned>::iterator global = m_strings.find(str);
+      if (global != m_strings.end())
+        return cache[key] = global->second;
+
+      unsigned id = m_strings.size()+1;
+
+      PINDEX length = strlen(str);
+      PTraceBinary::StringRecord * record = Reserve<PTraceBinary::StringRecord>(length);
+      if (record == NULL)
+        return 0;
+
+      record->m_id = id;
+      record->m_length = length;
+      Commit(record, PTraceBinary::StringType, 0, str, length);
+
+      m_strings[str] = id;
+      return cache[key] = id;
+    }
+
+    bool WriteThread(PThread & thread)
+    {
+      PString name = thread.GetThreadName();
+      PTraceBinary::ThreadRecord * record = Reserve<PTraceBinary::ThreadRecord>(name.GetLength());
+      if (record == NULL)
+        return false;
+
+      record->m_threadId = thread.GetUniqueIdentifier();
+      record->m_threadAddress = (uintptr_t)&thread;
+      record->m_length = name.GetLength();
+      record->m_reserved = 0;
+      Commit(record, PTraceBinary::ThreadType, 0, name, name.GetLength());
+      return true;
+    }
+
+    void WriteText(const std::string & text)
+    {
+      PTraceBinary::LineRecord * record = Reserve<PTraceBinary::LineRecord>(text.length());
+      if (record != NULL) {
+        record->m_tick = 0;
+        record->m_threadId = 0;
+        record->m_object = 0;
+        record->m_fileId = 0;
+        record->m_lineNum = 0;
+        record->m_moduleId = 0;
+        record->m_classId = 0;
+        record->m_contextId = 0;
+        record->m_textLength = text.length();
+        Commit(record, PTraceBinary::TextType, 0, text.data(), text.length());
+      }
+    }
+
+    class Buffer : public std::streambuf
+    {
+      public:
+        Buffer(PTraceBinaryStream & stream) : m_stream(stream) { }
+
+        virtual int_type overflow(int_type c)
+        {
+          if (c != EOF)
+            m_text += (char)c;
+          return 0;
+        }
+
+        virtual std::streamsize xsputn(const char * s, std::streamsize n)
+        {
+          m_text.append(s, (size_t)n);
+          return n;
+        }
+
+        virtual int sync()
+        {
+          while (!m_text.empty() && (m_text[m_text.length()-1] == '\n' || m_text[m_text.length()-1] == '\0'))
+            m_text.erase(m_text.length()-1);
+          if (!m_text.empty()) {
+            m_stream.WriteText(m_text);
+            m_text.clear();
+          }
+          return 0;
+        }
+
+      protected:
+        PTraceBinaryStream & m_stream;
+        std::string          m_text;
+    };
+
+    Buffer                m_buffer;
+    PFile                 m_file;
+    BYTE                * m_base;
+    unsigned long         m_size;
+    atomic<unsigned long> m_position;
+    unsigned              m_generation;
+    std::map<std::string, unsigned> m_strings;
+    PDECLARE_MUTEX(m_mutex);
+
+    static atomic<unsigned> s_generation;
+};
+
+atomic<unsigned> PTraceBinaryStream::s_generation(0);
+
 
 class PTraceInfo : public PTrace
 {
@@ -240,15 +549,77 @@ PTHREAD_MUTEX_RECURSIVE_NP
       : m_traceLevel(1)
       , m_traceBlockIndentLevel(0)
       , m_prefixLength(0)
+      , m_spareStream(NULL)
     { }
 
+    ~ThreadLocalInfo()
+    {
+      delete m_spareStream;
+    }
+
+    // Re-use the last stream, and its buffer, rather than allocate every line
+    PStringStream * AcquireStream()
+    {
+      PStringStream * stream = m_spareStream;
+      if (stream == NULL)
+        return new PStringStream;
+      m_spareStream = NULL;
+      return stream;
+    }
+
+    void ReleaseStream(PStringStream * stream)
+    {
+      if (m_spareStream != NULL || stream->GetSize() > 4096)
+        delete stream;
+      else {
+        stream->MakeEmpty();
+        stream->flags(ios::dec|ios::skipws);
+        stream->fill(' ');
+        stream->precision(6);
+        stream->width(0);
+        m_spareStream = stream;
+      }
+    }
+
     PStack<PStringStream> m_traceStreams;
     unsigned              m_traceLevel;
     unsigned              m_traceBlockIndentLevel;
     PINDEX                m_prefixLength;
+    PStringStream       * m_spareStream;
+    std::vector<PTraceBinaryStream::Context> m_binaryContexts; // Parallel to m_traceStreams
+    PTraceBinaryStream::ThreadCache          m_binaryCache;
   };
   PThreadLocalStorage<ThreadLocalInfo> m_threadStorage;
 
+  /* Asynchronous mode, the formatted lines are passed through a lock free,
+     multiple producer, single consumer, ring to a background thread. */
+  struct AsyncSlot
+  {
+    atomic<unsigned long> m_sequence;
+    std::string           m_line;
+  };
+  enum {
+    AsyncQueueSize = 4096,
+    AsyncQueueMask = AsyncQueueSize-1,
+    AsyncBatchSize = 65536
+  };
+  AsyncSlot           * m_asyncQueue;
+  atomic<unsigned long> m_asyncEnqueuePosition;
+  unsigned long         m_asyncDequeuePosition;
+  atomic<bool>          m_asyncRunning;
+  atomic<bool>          m_asyncWriterIdle;
+  atomic<unsigned>      m_asyncEnqueuers; // Threads inside AsyncEnqueue()
+  atomic<unsigned>      m_asyncDropped;
+  atomic<unsigned>      m_droppedLines;  // Asynchronous, or BinaryOutput full
+  bool                  m_asyncBusy;     // Protected by Lock()
+  bool                  m_asyncDisabled; // Protected by Lock()
+  PSyncPoint          * m_asyncSignal;
+  PThread             * m_asyncWriter;
+
+  // Set when m_stream is a PTraceBinaryStream, lines are then written without any lock
+  atomic<PTraceBinaryStream *> m_binaryStream;
+  atomic<unsigned>             m_binaryUsers;
+
   PTraceInfo()
     : m_currentLevel(0)
     , m_thresholdLevel(0)
@@ -262,6 +633,20 @@ PTHREAD_MUTEX_RECURSIVE_NP
     , m_rolloverPattern(DefaultRollOverPattern)
     , m_lastRotate(0)
     , m_maxLength(10000)
+    , m_asyncQueue(NULL)
+    , m_asyncEnqueuePosition(0)
+    , m_asyncDequeuePosition(0)
+    , m_asyncRunning(false)
+    , m_asyncWriterIdle(false)
+    , m_asyncEnqueuers(0)
+    , m_asyncDropped(0)
+    , m_droppedLines(0)
+    , m_asyncBusy(false)
+    , m_asyncDisabled(false)
+    , m_asyncSignal(NULL)
+    , m_asyncWriter(NULL)
+    , m_binaryStream(NULL)
+    , m_binaryUsers(0)
   {
     InitMutex();
   }
@@ -325,9 +710,14 @@ PTHREAD_MUTEX_RECURSIVE_NP
     if (m_stream != &cerr && m_stream != &cout)
       oldStream = m_stream;
     m_stream = newStream;
+    m_binaryStream = dynamic_cast<PTraceBinaryStream *>(newStream);
 
     Unlock();
 
+    // Wait for any thread still writing a binary line to the old stream
+    while (m_binaryUsers > 0)
+      PThread::Yield();
+
     delete oldStream;
   }
 
@@ -343,6 +733,9 @@ PTHREAD_MUTEX_RECURSIVE_NP
     if (m_options.exchange(newOptions) == newOptions)
       return false;
 
+    if ((newOptions&Asynchronous) == 0 && m_asyncRunning)
+      StopAsynchronous(false);
+
 #if P_SYSTEMLOG
     bool syslogBit = (newOptions&SystemLogStream) != 0;
     bool syslogStrm = dynamic_cast<PSystemLog *>(m_stream) != NULL;
@@ -358,6 +751,13 @@ PTHREAD_MUTEX_RECURSIVE_NP
 
   bool HasOption(unsigned options) const { return (m_options & options) != 0; }
 
+  bool IsAsynchronous()
+  {
+    return HasOption(Asynchronous) && (m_asyncRunning || StartAsynchronous());
+  }
+
+  void CheckRotate();
+
   void OpenTraceFile(const char * newFilename, bool outputFirstLog, const PTime & now = PTime())
   {
     PMEMORY_IGNORE_ALLOCATIONS_FOR_SCOPE;
@@ -429,26 +829,28 @@ PTHREAD_MUTEX_RECURSIVE_NP
       if ((m_options & HasFilePermissions) != 0)
         permissions.FromBits((m_options&FilePermissionMask)>>FilePermissionShift);
 
-      PFile * traceOutput = new PTextFile();
-      if (traceOutput->Open(fn, PFile::WriteOnly, options, permissions)) {
-        traceOutput->SetPosition(0, PFile::End);
-        SetStream(traceOutput);
-        outputFirstLog = true;
+      if (HasOption(BinaryOutput)) {
+        PTraceBinaryStream * binaryOutput = new PTraceBinaryStream();
+        if (binaryOutput->Open(fn, options, permissions, m_startTick, m_options)) {
+          SetStream(binaryOutput);
+          outputFirstLog = true;
+        }
+        else {
+          OpenTraceFileFailed(fn, binaryOutput->GetErrorText());
+          delete binaryOutput;
+        }
       }
       else {
-        ostringstream msgstrm;
-        if (PProcess::IsInitialised())
-          msgstrm << PProcess::Current().GetName() << ": ";
-        msgstrm << "Could not open trace output file  \"" << fn << "\"\n"
-                << traceOutput->GetErrorText();
-#ifdef WIN32
-        PVarString msg(msgstrm.str().c_str());
-        MessageBox(NULL, msg, NULL, MB_OK|MB_ICONERROR);
-#else
-        fputs(msgstrm.str().c_str(), stderr);
-#endif
-        delete traceOutput;
-        SetStream(&cerr);
+        PFile * traceOutput = new PTextFile();
+        if (traceOutput->Open(fn, PFile::WriteOnly, options, permissions)) {
+          traceOutput->SetPosition(0, PFile::End);
+          SetStream(traceOutput);
+          outputFirstLog = true;
+        }
+        else {
+          OpenTraceFileFailed(fn, traceOutput->GetErrorText());
+          delete traceOutput;
+        }
       }
     }
 
@@ -493,12 +895,211 @@ PTHREAD_MUTEX_RECURSIVE_NP
     }
   }
 
+  void OpenTraceFileFailed(const PFilePath & fn, const PString & error)
+  {
+    ostringstream msgstrm;
+    if (PProcess::IsInitialised())
+      msgstrm << PProcess::Current().GetName() << ": ";
+    msgstrm << "Could not open trace output file  \"" << fn << "\"\n" << error;
+#ifdef WIN32
+    PVarString msg(msgstrm.str().c_str());
+    MessageBox(NULL, msg, NULL, MB_OK|MB_ICONERROR);
+#else
+    fputs(msgstrm.str().c_str(), stderr);
+#endif
+    SetStream(&cerr);
+  }
+
   void InternalInitialise(unsigned level, const char * filename, const char * rolloverPattern, unsigned options);
   std::ostream & InternalBegin(bool topLevel, unsigned level, const char * fileName, int lineNum, const PObject * instance, const char * module);
   std::ostream & InternalEnd(std::ostream & stream);
+
+  bool StartAsynchronous();
+  void StopAsynchronous(bool permanently);
+  bool AsyncEnqueue(const char * line, PINDEX length);
+  bool AsyncOutput(std::string & batch);
+  void AsyncWriterMain();
+};
+
+
+class PTraceAsyncWriter : public PThread
+{
+    PCLASSINFO(PTraceAsyncWriter, PThread);
+  public:
+    PTraceAsyncWriter()
+      : PThread(1000, NoAutoDeleteThread, NormalPriority, "Trace Writer")
+    {
+      Resume();
+    }
+
+    virtual void Main()
+    {
+      PTraceInfo::Instance().AsyncWriterMain();
+    }
 };
 
 
+bool PTraceInfo::StartAsynchronous()
+{
+  Lock();
+
+  // Note, m_asyncBusy also prevents recursion from any PTRACE during thread start
+  if (!m_asyncRunning && !m_asyncBusy && !m_asyncDisabled && m_asyncWriter == NULL && PProcess::IsInitialised()) {
+    m_asyncBusy = true;
+
+    if (m_asyncQueue == NULL) {
+      PMEMORY_IGNORE_ALLOCATIONS_FOR_SCOPE;
+      m_asyncQueue = new AsyncSlot[AsyncQueueSize];
+      for (unsigned long i = 0; i < AsyncQueueSize; ++i) {
+        m_asyncQueue[i].m_sequence.store(i);
+        m_asyncQueue[i].m_line.reserve(256);
+      }
+      m_asyncSignal = new PSyncPoint;
+    }
+
+    m_asyncRunning = true;
+    m_asyncWriter = new PTraceAsyncWriter;
+    m_asyncBusy = false;
+  }
+
+  Unlock();
+
+  return m_asyncRunning;
+}
+
+
+void PTraceInfo::StopAsynchronous(bool permanently)
+{
+  Lock();
+
+  if (permanently)
+    m_asyncDisabled = true;
+
+  PThread * writer = NULL;
+  if (!m_asyncBusy) {
+    writer = m_asyncWriter;
+    m_asyncBusy = writer != NULL;
+  }
+  m_asyncRunning = false;
+
+  Unlock();
+
+  if (writer == NULL)
+    return;
+
+  // Writer thread outputs everything that is queued before exiting
+  m_asyncSignal->Signal();
+  writer->WaitForTermination();
+
+  Lock();
+  delete writer;
+  m_asyncWriter = NULL;
+  m_asyncBusy = false;
+  Unlock();
+}
+
+
+bool PTraceInfo::AsyncEnqueue(const char * line, PINDEX length)
+{
+  /* Count ourselves in before checking, so the writer thread, once stopped,
+     waits for us to publish the line before its final output. */
+  ++m_asyncEnqueuers;
+  if (!m_asyncRunning) {
+    --m_asyncEnqueuers;
+    return false;
+  }
+
+  unsigned long position = m_asyncEnqueuePosition.load();
+  AsyncSlot * slot;
+  for (;;) {
+    slot = &m_asyncQueue[position & AsyncQueueMask];
+    long diff = (long)(slot->m_sequence.load() - position);
+    if (diff == 0) {
+      if (m_asyncEnqueuePosition.compare_exchange_strong(position, position+1))
+        break;
+    }
+    else if (diff < 0) {
+      // Full, writer thread is not keeping up, so drop rather than block
+      ++m_asyncDropped;
+      ++m_droppedLines;
+      --m_asyncEnqueuers;
+      return true;
+    }
+    else
+      position = m_asyncEnqueuePosition.load();
+  }
+
+  slot->m_line.assign(line, length);
+  slot->m_line += '\n';
+  slot->m_sequence.store(position+1);
+
+  if (m_asyncWriterIdle.exchange(false))
+    m_asyncSignal->Signal();
+
+  --m_asyncEnqueuers;
+  return true;
+}
+
+
+bool PTraceInfo::AsyncOutput(std::string & batch)
+{
+  batch.clear();
+
+  // Only one thread, the writer, ever dequeues, so no compare/exchange required
+  while (batch.size() < AsyncBatchSize) {
+    AsyncSlot & slot = m_asyncQueue[m_asyncDequeuePosition & AsyncQueueMask];
+    if (slot.m_sequence.load() != m_asyncDequeuePosition+1)
+      break;
+    batch += slot.m_line;
+    slot.m_sequence.store(m_asyncDequeuePosition+AsyncQueueSize);
+    ++m_asyncDequeuePosition;
+  }
+
+  unsigned dropped = m_asyncDropped.exchange(0);
+  if (dropped > 0) {
+    char msg[100];
+    snprintf(msg, sizeof(msg), "Trace output overflow, %u lines dropped\n", dropped);
+    batch += msg;
+  }
+
+  if (batch.empty())
+    return false;
+
+  Lock();
+  CheckRotate();
+  if (m_stream != NULL) {
+    m_stream->write(batch.data(), batch.size());
+    m_stream->flush();
+  }
+  Unlock();
+  return true;
+}
+
+
+void PTraceInfo::AsyncWriterMain()
+{
+  std::string batch;
+  batch.reserve(AsyncBatchSize+1000);
+
+  while (m_asyncRunning) {
+    if (!AsyncOutput(batch)) {
+      m_asyncWriterIdle = true;
+      // Check again after setting idle flag, to avoid race with AsyncEnqueue()
+      if (m_asyncQueue[m_asyncDequeuePosition & AsyncQueueMask].m_sequence.load() != m_asyncDequeuePosition+1)
+        m_asyncSignal->Wait(1000); // Timeout so file rotation happens even if quiet
+      m_asyncWriterIdle = false;
+    }
+  }
+
+  // Lines still being added would otherwise be left in the ring and lost
+  while (m_asyncEnqueuers > 0)
+    PThread::Yield();
+
+  while (AsyncOutput(batch))
+    ;
+}
+
+
 void PTrace::SetStream(ostream * s)
 {
   PTraceInfo & info = PTraceInfo::Instance();
@@ -539,7 +1140,9 @@ static std::string OptionsToString(unsigned options)
        << PlusMinus(options, PTrace::TraceLevel) << "level "
        << PlusMinus(options, PTrace::Blocks) << "block "
        << PlusMinus(options, PTrace::AppendToFile) << "append "
-       << PlusMinus(options, PTrace::SingleLine) << "single ";
+       << PlusMinus(options, PTrace::SingleLine) << "single "
+       << PlusMinus(options, PTrace::Asynchronous) << "async "
+       << PlusMinus(options, PTrace::BinaryOutput) << "binary ";
 
   switch (options&PTrace::RotateLogMask) {
     case PTrace::RotateDaily :
@@ -571,6 +1174,8 @@ ostream & PTrace::PrintInfo(ostream & strm, bool crlf)
     strm << "stderr";
   else if (dynamic_cast<PFile *>(info.m_stream) != NULL)
     strm << dynamic_cast<PFile *>(info.m_stream)->GetFilePath();
+  else if (dynamic_cast<PTraceBinaryStream *>(info.m_stream) != NULL)
+    strm << "binary: " << dynamic_cast<PTraceBinaryStream *>(info.m_stream)->GetFilePath();
 #ifdef _WIN32
   else if (dynamic_cast<PDebugStream *>(info.m_stream) != NULL)
     strm << "debugstream";
@@ -660,6 +1265,10 @@ static unsigned OptionsFromString(const PCaselessString & optStr, unsigned optio
       operation(options, PTrace::RotateMinutely);
     else if (optStr.NumCompare("append", P_MAX_INDEX, pos) == PObject::EqualTo)
       operation(options, PTrace::AppendToFile);
+    else if (optStr.NumCompare("async", P_MAX_INDEX, pos) == PObject::EqualTo)
+      operation(options, PTrace::Asynchronous);
+    else if (optStr.NumCompare("binary", P_MAX_INDEX, pos) == PObject::EqualTo)
+      operation(options, PTrace::BinaryOutput);
     else if (optStr.NumCompare("ax", P_MAX_INDEX, pos) == PObject::EqualTo)
       operation(options, (PFileInfo::WorldExecute|PFileInfo::GroupExecute|PFileInfo::UserExecute) << PTrace::FilePermissionShift);
     else if (optStr.NumCompare("aw", P_MAX_INDEX, pos) == PObject::EqualTo)
@@ -741,6 +1350,18 @@ static unsigned GetRotateVal(unsigned options)
 }
 
 
+void PTraceInfo::CheckRotate()
+{
+  if (!m_filename.IsEmpty() && HasOption(RotateLogMask)) {
+    unsigned rotateVal = GetRotateVal(m_options);
+    if (rotateVal != m_lastRotate || GetStream() == &cerr) {
+      m_lastRotate = rotateVal;
+      OpenTraceFile(m_filename, true);
+    }
+  }
+}
+
+
 void PTraceInfo::InternalInitialise(unsigned level, const char * filename, const char * rolloverPattern, unsigned options)
 {
   m_rolloverPattern = rolloverPattern;
@@ -777,9 +1398,18 @@ PINDEX PTrace::GetMaxLength()
 }
 
 
+unsigned PTrace::GetDroppedLines()
+{
+  return PTraceInfo::Instance().m_droppedLines;
+}
+
+
 void PTrace::SetOptionsByName(const char * options)
 {
-  SetOptions(OptionsFromString(options, GetOptions()));
+  unsigned oldOptions = GetOptions();
+  unsigned newOptions = OptionsFromString(options, oldOptions);
+  ClearOptions(oldOptions & ~newOptions);
+  SetOptions(newOptions);
 }
 
 
@@ -844,6 +1474,7 @@ ostream & PTraceInfo::InternalBegin(bool topLevel, unsigned level, const char *
   PThread * thread = NULL;
   PTraceInfo::ThreadLocalInfo * threadInfo = NULL;
   ostream * streamPtr = NULL;
+  bool locked = true;
 
   if (topLevel) {
     if (PProcess::IsInitialised()) {
@@ -851,21 +1482,52 @@ ostream & PTraceInfo::InternalBegin(bool topLevel, unsigned level, const char *
 
       threadInfo = m_threadStorage.Get();
       if (threadInfo != NULL) {
-        PStringStream * stringStreamPtr = new PStringStream;
+        PStringStream * stringStreamPtr = threadInfo->AcquireStream();
         threadInfo->m_traceStreams.Push(stringStreamPtr);
         streamPtr = stringStreamPtr;
-      }
-    }
 
-    Lock();
+        PTraceBinaryStream::Context context;
+        context.m_binary = m_binaryStream.load() != NULL;
+        if (context.m_binary) {
+          // No prefix formatting at all, just capture what the binary record needs
+          context.m_level = level;
+          context.m_tick = (PTimer::Tick() - m_startTick).GetNanoSeconds();
+          context.m_thread = thread;
+          context.m_fileName = fileName;
+          context.m_lineNum = lineNum;
+          context.m_object = instance;
+          context.m_className = instance != NULL ? instance->GetClass() : NULL;
+          context.m_contextId = 0;
+#if PTRACING==2
+          context.m_contextId = instance != NULL ? instance->GetTraceContextIdentifier() : 0;
+          if (context.m_contextId == 0 && thread != NULL)
+            context.m_contextId = thread->GetTraceContextIdentifier();
+#endif
+          context.m_module = module;
+        }
+        threadInfo->m_binaryContexts.push_back(context);
 
-    if (!m_filename.IsEmpty() && HasOption(RotateLogMask)) {
-      unsigned rotateVal = GetRotateVal(m_options);
-      if (rotateVal != m_lastRotate || GetStream() == &cerr) {
-        m_lastRotate = rotateVal;
-        OpenTraceFile(m_filename, true);
+        if (context.m_binary) {
+          if (HasOption(RotateLogMask)) {
+            Lock();
+            CheckRotate();
+            Unlock();
+          }
+          threadInfo->m_traceLevel = level;
+          threadInfo->m_prefixLength = 0;
+          stringStreamPtr->clear();
+          return *stringStreamPtr;
+        }
       }
     }
+
+    // Formatting into thread local stream needs no lock, writer thread does rotation
+    if (threadInfo != NULL && m_asyncRunning)
+      locked = false;
+    else {
+      Lock();
+      CheckRotate();
+    }
   }
 
   ostream & stream = *(streamPtr ? streamPtr : m_stream);
@@ -970,7 +1632,8 @@ ostream & PTraceInfo::InternalBegin(bool topLevel, unsigned level, const char *
   else {
     threadInfo->m_traceLevel = level;
     threadInfo->m_prefixLength = threadInfo->m_traceStreams.Top().GetLength();
-    Unlock();
+    if (locked)
+      Unlock();
   }
 
   return stream;
@@ -996,6 +1659,19 @@ ostream & PTraceInfo::InternalEnd(ostream & paramStream)
 
     *stackStream << ends << flush;
 
+    PTraceBinaryStream::Context context = threadInfo->m_binaryContexts.back();
+    threadInfo->m_binaryContexts.pop_back();
+    if (context.m_binary) {
+      PINDEX length = std::min(stackStream->GetLength(), m_maxLength.load());
+      ++m_binaryUsers;
+      PTraceBinaryStream * binaryStream = m_binaryStream;
+      if (binaryStream == NULL || !binaryStream->WriteLine(context, *stackStream, length, threadInfo->m_binaryCache))
+        ++m_droppedLines;
+      --m_binaryUsers;
+      threadInfo->ReleaseStream(stackStream);
+      return paramStream;
+    }
+
     PINDEX tab = stackStream->Find('\t', threadInfo->m_prefixLength);
     if (tab != P_MAX_INDEX) {
       PINDEX len = tab - threadInfo->m_prefixLength;
@@ -1012,6 +1688,12 @@ ostream & PTraceInfo::InternalEnd(ostream & paramStream)
     if (stackStream->GetLength() > m_maxLength)
       stackStream->Splice("...", m_maxLength - 4, P_MAX_INDEX);
 
+    // If stopped since the check, falls through to synchronous output
+    if (!HasOption(SystemLogStream) && IsAsynchronous() && AsyncEnqueue(*stackStream, stackStream->GetLength())) {
+      threadInfo->ReleaseStream(stackStream);
+      return paramStream;
+    }
+
     Lock();
 
     if (HasOption(SystemLogStream)) {
@@ -1023,7 +1705,7 @@ ostream & PTraceInfo::InternalEnd(ostream & paramStream)
       currentLevel = threadInfo->m_traceLevel;
     }
 
-    delete stackStream;
+    threadInfo->ReleaseStream(stackStream);
   }
   else {
     if (!PAssert(&paramStream == m_stream, PLogicError)) {
@@ -1580,7 +2262,7 @@ void PTimer::InternalStart(bool once, int64_t resetTime)
   if (resetTime > 0) {
     m_absoluteTime = Tick() + GetResetTime();
     list->m_timersMutex.Wait();
-    list->m_timers[m_handle] = this;
+    list->InternalAdd(*this);
     m_running = true;
     list->m_timersMutex.Signal();
 
@@ -1601,7 +2283,7 @@ void PTimer::Stop(bool wait)
        completion it cannot then be called again. Note, the bitwise OR is
        intentional! We don't want McCarthy breaking things. */
     list->m_timersMutex.Wait();
-    PAssert((list->m_timers.erase(m_handle) == 1) | !m_running.exchange(false), PLogicError);
+    PAssert(list->InternalRemove(m_handle) | !m_running.exchange(false), PLogicError);
     list->m_timersMutex.Signal();
 
     if (wait) {
@@ -1672,7 +2354,7 @@ bool PTimer::List::OnTimeout(PIdGenerator::Handle handle)
     if (it == m_timers.end())
       return true; // Don't try again
 
-    timer = it->second;
+    timer = it->second.m_timer;
 
     if (!timer->m_oneshot && !timer->m_running)
       return true; // Was recurring timer and was stopped
@@ -1697,6 +2379,26 @@ bool PTimer::List::OnTimeout(PIdGenerator::Handle handle)
 }
 
 
+void PTimer::List::InternalAdd(PTimer & timer)
+{
+  ExpiryMap::iterator expiry = m_expiries.insert(ExpiryMap::value_type(timer.m_absoluteTime, timer.m_handle));
+  m_timers.insert(TimerMap::value_type(timer.m_handle, ActiveTimer(&timer, expiry)));
+}
+
+
+bool PTimer::List::InternalRemove(PIdGenerator::Handle handle)
+{
+  TimerMap::iterator it = m_timers.find(handle);
+  if (it == m_timers.end())
+    return false;
+
+  if (it->second.m_expiry != m_expiries.end())
+    m_expiries.erase(it->second.m_expiry);
+  m_timers.erase(it);
+  return true;
+}
+
+
 PTimeInterval PTimer::List::Process()
 {
   PTimeInterval now = PTimer::Tick();
@@ -1706,31 +2408,47 @@ PTimeInterval PTimer::List::Process()
 
   m_timersMutex.Wait();
 
-  for (TimerMap::iterator it = m_timers.begin(); it != m_timers.end(); ++it) {
-    PTimer & timer = *it->second;
-    if (timer.m_running) {
-      PTimeInterval delta = timer.m_absoluteTime - now;
-      if (delta > 0) {
-        if (nextInterval > delta)
-          nextInterval = delta;
-      }
-      else if (timer.m_callbackMutex.Try()) {
-        /* PTimer is stopped and completely removed from the list before it's
-           properties are changed from the external code, making this thread
-           safe without a mutex. */
-        if (timer.m_oneshot)
-          timer.m_running = false;
-        else {
-          timer.m_absoluteTime = now + timer.GetResetTime();
-          if (nextInterval > timer.GetResetTime())
-            nextInterval = timer.GetResetTime();
-        }
-        timer.m_callbackMutex.Signal();
+  PINDEX expired = 0;
+  ExpiryMap::iterator it = m_expiries.begin();
+  while (it != m_expiries.end() && it->first <= now) {
+    TimerMap::iterator active = m_timers.find(it->second);
+    if (!PAssert(active != m_timers.end(), PLogicError)) {
+      m_expiries.erase(it++);
+      continue;
+    }
 
-        m_threadPool.AddWork(new Timeout(it->first));
-        PTRACE(6, &timer, "Timer: " << timer << " work added, lateness=" << -delta);
-      }
+    PTimer & timer = *active->second.m_timer;
+    if (!timer.m_callbackMutex.Try()) {
+      ++it; // Still in previous OnTimeout(), leave it for next time around
+      continue;
+    }
+
+    PTimeInterval lateness = now - it->first;
+    m_expiries.erase(it++);
+
+    /* PTimer is stopped and completely removed from the list before it's
+       properties are changed from the external code, making this thread
+       safe without a mutex. */
+    if (timer.m_oneshot) {
+      timer.m_running = false;
+      active->second.m_expiry = m_expiries.end();
     }
+    else {
+      // Always after "now", so will be beyond the end of this loop
+      timer.m_absoluteTime = now + timer.GetResetTime();
+      active->second.m_expiry = m_expiries.insert(ExpiryMap::value_type(timer.m_absoluteTime, timer.m_handle));
+    }
+    timer.m_callbackMutex.Signal();
+
+    m_threadPool.AddWork(new Timeout(active->first));
+    PTRACE(6, &timer, "Timer: " << timer << " work added, lateness=" << lateness);
+    ++expired;
+  }
+
+  if (!m_expiries.empty()) {
+    PTimeInterval delta = m_expiries.begin()->first - now;
+    if (nextInterval > delta)
+      nextInterval = delta;
   }
 
   m_timersMutex.Signal();
@@ -1738,7 +2456,7 @@ PTimeInterval PTimer::List::Process()
   if (nextInterval < 10)
     nextInterval = 10;
 
-  PTRACE(6, NULL, PTraceModule(), m_timers.size() << " timers processed, next=" << nextInterval);
+  PTRACE(6, NULL, PTraceModule(), m_timers.size() << " timers, " << expired << " expired, next=" << nextInterval);
   return nextInterval;
 }
 
@@ -2701,6 +3419,11 @@ PProcess::~PProcess()
 #endif
   }
 
+#if PTRACING
+  // Output anything queued and revert to synchronous output, before threads are killed
+  PTraceInfo::Instance().StopAsynchronous(true);
+#endif
+
   // Clean up factories
   PProcessStartupFactory::KeyList_T list = PProcessStartupFactory::GetKeyList();
   for (PProcessStartupFactory::KeyList_T::const_reverse_iterator it = list.rbegin(); it != list.rend(); ++it)
@@ -3918,7 +4641,8 @@ void PMutexExcessiveLockInfo::ReleasedLock(const PObject & mutex,
                                            bool,
                                            const PDebugLocation & PTRACE_PARAM(location))
 {
-  if (m_excessiveLockActive.exchange(false)) {
+  // Check before exchange, so normal case does not write to shared memory
+  if (m_excessiveLockActive && m_excessiveLockActive.exchange(false)) {
 #if PTRACING
     PTime releaseTime;
     PNanoSeconds heldDuration(PProfiling::CyclesToNanoseconds(PProfiling::GetCycles() - startHeldSamplePoint));
@@ -4287,8 +5011,99 @@ PIntCondMutex & PIntCondMutex::operator-=(int dec)
 
 /////////////////////////////////////////////////////////////////////////////
 
-PReadWriteMutex::PReadWriteMutex()
+PReadWriteMutex::Algorithm PReadWriteMutex::DefaultAlgorithm = PReadWriteMutex::StandardAlgorithm;
+
+#if P_READ_WRITE_FAST
+
+/* Per thread nesting information for FastAlgorithm mutexes. A thread rarely
+   holds more than a few read/write mutexes at once, so a small array with a
+   linear search is used. Should a thread hold more, the extra ones revert to
+   using the mutex protected m_nestedThreads map. */
+struct PReadWriteMutex::FastNests
+{
+  enum { MaxEntries = 16 };
+
+  struct Entry
+  {
+    Entry() : m_mutex(NULL), m_nest(0) { }
+
+    const PReadWriteMutex * m_mutex;
+    Nest                    m_nest;
+  };
+
+  FastNests()
+    : m_count(0)
+    , m_overflow(0)
+  {
+    PUniqueThreadIdentifier uniqueId = PThread::GetCurrentUniqueIdentifier();
+    for (unsigned i = 0; i < MaxEntries; ++i)
+      m_entries[i].m_nest.m_uniqueId = uniqueId;
+  }
+
+  Nest * Find(const PReadWriteMutex * mutex)
+  {
+    for (unsigned i = 0; i < m_count; ++i) {
+      if (m_entries[i].m_mutex == mutex)
+        return &m_entries[i].m_nest;
+    }
+    return NULL;
+  }
+
+  Nest * Add(const PReadWriteMutex * mutex)
+  {
+    if (m_count >= MaxEntries)
+      return NULL;
+
+    // Counts are always zero when removed, so only need to set the mutex
+    Entry & entry = m_entries[m_count++];
+    entry.m_mutex = mutex;
+    return &entry.m_nest;
+  }
+
+  bool Remove(const PReadWriteMutex * mutex)
+  {
+    for (unsigned i = 0; i < m_count; ++i) {
+      if (m_entries[i].m_mutex == mutex) {
+        if (i != --m_count)
+          m_entries[i] = m_entries[m_count];
+        return true;
+      }
+    }
+    return false;
+  }
+
+  Entry    m_entries[MaxEntries];
+  unsigned m_count;
+  unsigned m_overflow; // Number of entries in m_nestedThreads maps for this thread
+};
+
+
+PReadWriteMutex::FastNests & PReadWriteMutex::GetFastNests()
+{
+  static thread_local FastNests nests;
+  return nests;
+}
+
+
+static void InitFastLock(pthread_rwlock_t & lock)
+{
+  pthread_rwlockattr_t attr;
+  pthread_rwlockattr_init(&attr);
+#ifdef __GLIBC__
+  // Prevent writer starvation, as the standard algorithm does
+  pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+  int err = pthread_rwlock_init(&lock, &attr);
+  PAssert(err == 0, psprintf("pthread_rwlock_init error = %i", err));
+  pthread_rwlockattr_destroy(&attr);
+}
+
+#endif // P_READ_WRITE_FAST
+
+
+PReadWriteMutex::PReadWriteMutex(Algorithm algorithm)
   : PMutexExcessiveLockInfo()
+  , m_algorithm(algorithm)
 #if P_READ_WRITE_ALGO2
   , m_inSemaphore(1, 1)
   , m_inCount(0)
@@ -4306,11 +5121,22 @@ PReadWriteMutex::PReadWriteMutex()
   , m_writerCount(0)
 #endif
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    InitFastLock(m_fastLock);
+    m_fastWriterId = PNullThreadIdentifier;
+    m_fastWriterUniqueId = 0;
+    m_fastHolders = 0;
+  }
+#else
+  m_algorithm = StandardAlgorithm;
+#endif
   PMUTEX_CONSTRUCTED();
 }
 
-PReadWriteMutex::PReadWriteMutex(const PDebugLocation & location, unsigned timeout)
+PReadWriteMutex::PReadWriteMutex(const PDebugLocation & location, unsigned timeout, Algorithm algorithm)
   : PMutexExcessiveLockInfo(location, timeout)
+  , m_algorithm(algorithm)
 #if P_READ_WRITE_ALGO2
   , m_inSemaphore(1, 1)
   , m_inCount(0)
@@ -4328,12 +5154,33 @@ PReadWriteMutex::PReadWriteMutex(const PDebugLocation & location, unsigned timeo
   , m_writerCount(0)
 #endif
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    InitFastLock(m_fastLock);
+    m_fastWriterId = PNullThreadIdentifier;
+    m_fastWriterUniqueId = 0;
+    m_fastHolders = 0;
+  }
+#else
+  m_algorithm = StandardAlgorithm;
+#endif
   PMUTEX_CONSTRUCTED();
 }
 
 
 PReadWriteMutex::~PReadWriteMutex()
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    // Destruction while current thread has a lock is OK, but the real lock must be released
+    Nest * nest = GetNest();
+    if (nest != NULL && (nest->m_readerCount > 0 || nest->m_writerCount > 0)) {
+      FastUnlock(nest->m_writerCount > 0);
+      nest->m_readerCount = nest->m_writerCount = 0; // Slot is reused by next Add()
+    }
+  }
+#endif
+
   EndNest(); // Destruction while current thread has a lock is OK
 
   /* There is a small window during destruction where another thread is on the
@@ -4358,6 +5205,16 @@ PReadWriteMutex::~PReadWriteMutex()
     PThread::Sleep(10);
   }
 
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    /* Fast path holders are only known to their own threads, so wait for any
+       thread still on its way out of FastUnlock() before the lock is gone. */
+    while (m_fastHolders > 0)
+      PThread::Sleep(10);
+    pthread_rwlock_destroy(&m_fastLock);
+  }
+#endif
+
   PMUTEX_DESTROYED();
 }
 
@@ -4372,6 +5229,16 @@ PReadWriteMutex::Nest::Nest()
 }
 
 
+PReadWriteMutex::Nest::Nest(PUniqueThreadIdentifier uniqueId)
+  : m_readerCount(0)
+  , m_writerCount(0)
+  , m_waiting(false)
+  , m_startHeldCycle(0)
+  , m_uniqueId(uniqueId)
+{
+}
+
+
 PReadWriteMutex::Nest::Nest(const Nest & other)
   : m_readerCount(other.m_readerCount.load())
   , m_writerCount(other.m_writerCount.load())
@@ -4395,6 +5262,15 @@ PReadWriteMutex::Nest & PReadWriteMutex::Nest::operator=(const Nest & other)
 
 PReadWriteMutex::Nest * PReadWriteMutex::GetNest()
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    FastNests & nests = GetFastNests();
+    Nest * nest = nests.Find(this);
+    if (nest != NULL || nests.m_overflow == 0)
+      return nest;
+  }
+#endif
+
   PWaitAndSignal mutex(m_nestingMutex);
   NestMap::iterator it = m_nestedThreads.find(PThread::GetCurrentThreadId());
   return it != m_nestedThreads.end() ? &it->second : NULL;
@@ -4403,6 +5279,20 @@ PReadWriteMutex::Nest * PReadWriteMutex::GetNest()
 
 void PReadWriteMutex::EndNest()
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    FastNests & nests = GetFastNests();
+    if (nests.Remove(this) || nests.m_overflow == 0)
+      return;
+
+    m_nestingMutex.Wait();
+    if (m_nestedThreads.erase(PThread::GetCurrentThreadId()) > 0)
+      --nests.m_overflow;
+    m_nestingMutex.Signal();
+    return;
+  }
+#endif
+
   m_nestingMutex.Wait();
   m_nestedThreads.erase(PThread::GetCurrentThreadId());
   m_nestingMutex.Signal();
@@ -4411,6 +5301,30 @@ void PReadWriteMutex::EndNest()
 
 PReadWriteMutex::Nest & PReadWriteMutex::StartNest()
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    FastNests & nests = GetFastNests();
+    Nest * nest = nests.Find(this);
+    if (nest != NULL)
+      return *nest;
+
+    if (nests.m_overflow > 0) {
+      PWaitAndSignal mutex(m_nestingMutex);
+      NestMap::iterator it = m_nestedThreads.find(PThread::GetCurrentThreadId());
+      if (it != m_nestedThreads.end())
+        return it->second;
+    }
+
+    nest = nests.Add(this);
+    if (nest != NULL)
+      return *nest;
+
+    PWaitAndSignal mutex(m_nestingMutex);
+    ++nests.m_overflow;
+    return m_nestedThreads[PThread::GetCurrentThreadId()];
+  }
+#endif
+
   PWaitAndSignal mutex(m_nestingMutex);
   // The std::map will create the entry if it doesn't exist
   return m_nestedThreads[PThread::GetCurrentThreadId()];
@@ -4419,8 +5333,6 @@ PReadWriteMutex::Nest & PReadWriteMutex::StartNest()
 
 void PReadWriteMutex::InternalStartRead(const PDebugLocation * location)
 {
-  uint64_t startWaitCycle = PProfiling::GetCycles();
-
   // Get the nested thread info structure, create one it it doesn't exist
   Nest & nest = StartNest();
 
@@ -4432,6 +5344,7 @@ void PReadWriteMutex::InternalStartRead(const PDebugLocation * location)
   // previous call to StartWrite() then actually do the text book read only
   // lock, otherwise we leave it as just having incremented the reader count.
   if (nest.m_readerCount == 1 && nest.m_writerCount == 0) {
+    uint64_t startWaitCycle = PProfiling::GetCycles();
     InternalStartReadWithNest(nest, location);
     AcquiredLock(startWaitCycle, true, location);
     nest.m_startHeldCycle = PProfiling::GetCycles();
@@ -4528,8 +5441,6 @@ void PReadWriteMutex::InternalEndRead(const PDebugLocation * location)
 
 void PReadWriteMutex::InternalStartWrite(const PDebugLocation * location)
 {
-  uint64_t startWaitCycle = PProfiling::GetCycles();
-
   // Get the nested thread info structure, create one it it doesn't exist
   Nest & nest = StartNest();
 
@@ -4542,6 +5453,8 @@ void PReadWriteMutex::InternalStartWrite(const PDebugLocation * location)
   if (nest.m_writerCount > 1)
     return;
 
+  uint64_t startWaitCycle = PProfiling::GetCycles();
+
   // If have a read lock already in this thread then do the "real" unlock code
   // but do not change the lock count, calls to EndRead() will now just
   // decrement the count instead of doing the unlock (its already done!)
@@ -4592,8 +5505,101 @@ void PReadWriteMutex::InternalEndWrite(const PDebugLocation * location)
 }
 
 
+#if P_READ_WRITE_FAST
+void PReadWriteMutex::FastLock(Nest & nest, bool write, const PDebugLocation & location)
+{
+  int err = write ? pthread_rwlock_trywrlock(&m_fastLock) : pthread_rwlock_tryrdlock(&m_fastLock);
+  if (err == 0) {
+    ++m_fastHolders;
+    return;
+  }
+
+  nest.m_waiting = true;
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += m_excessiveLockTimeout/1000;
+  deadline.tv_nsec += (m_excessiveLockTimeout%1000)*1000000;
+  if (deadline.tv_nsec >= 1000000000) {
+    deadline.tv_nsec -= 1000000000;
+    ++deadline.tv_sec;
+  }
+
+  do {
+    err = write ? pthread_rwlock_timedwrlock(&m_fastLock, &deadline) : pthread_rwlock_timedrdlock(&m_fastLock, &deadline);
+  } while (err == EINTR);
+
+  if (err == 0) {
+    ++m_fastHolders;
+    nest.m_waiting = false;
+    return;
+  }
+
+  PAssert(err == ETIMEDOUT, psprintf("pthread_rwlock_timedlock error = %i", err));
+
+  m_excessiveLockActive = true;
+
+  PThreadIdentifier writerId = m_fastWriterId;
+  PUniqueThreadIdentifier writerUniqueId = m_fastWriterUniqueId;
+#if PTRACING
+  {
+    ostream & trace = PTRACE_BEGIN(0, "PTLib");
+    trace << "Assertion fail: Possible deadlock in " << *this << " :\n"
+             "  thread-id=" << PThread::GetCurrentThreadId() << " waiting for " << (write ? "write" : "read") << " lock, ";
+    if (writerId == PNullThreadIdentifier)
+      trace << "held by readers";
+    else {
+      trace << "held by writer thread-id=" << writerId << " (0x" << std::hex << writerId << std::dec << "),"
+               " unique-id=" << writerUniqueId;
+      switch (PTimedMutex::DeadlockStackWalkMode) {
+      case PTimedMutex::DeadlockStackWalkEnabled:
+        PTrace::WalkStack(trace, writerId, writerUniqueId);
+        break;
+      case PTimedMutex::DeadlockStackWalkNoSymbols:
+        trace << ", stack: ";
+        PTrace::WalkStack(trace, writerId, writerUniqueId, true);
+        break;
+      default:
+        break;
+      }
+    }
+    trace << PTrace::End;
+  }
+#else
+  PAssertAlways(PSTRSTRM("Possible deadlock in " << *this));
+#endif
+
+  do {
+    err = write ? pthread_rwlock_wrlock(&m_fastLock) : pthread_rwlock_rdlock(&m_fastLock);
+  } while (err == EINTR);
+  ++m_fastHolders;
+  ExcessiveLockPhantom(*this);
+
+  nest.m_waiting = false;
+}
+
+
+void PReadWriteMutex::FastUnlock(bool write)
+{
+  if (write) {
+    m_fastWriterId = PNullThreadIdentifier;
+    m_fastWriterUniqueId = 0;
+  }
+  pthread_rwlock_unlock(&m_fastLock);
+  --m_fastHolders; // Must be after unlock, see destructor
+}
+#endif // P_READ_WRITE_FAST
+
+
 void PReadWriteMutex::InternalStartReadWithNest(Nest & nest, const PDebugLocation & location)
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    FastLock(nest, false, location);
+    return;
+  }
+#endif
+
 #if P_READ_WRITE_ALGO2
   InternalWait(nest, m_inSemaphore);
   ++m_inCount;
@@ -4616,6 +5622,13 @@ void PReadWriteMutex::InternalStartReadWithNest(Nest & nest, const PDebugLocatio
 
 void PReadWriteMutex::InternalEndReadWithNest(Nest & nest, const PDebugLocation & location)
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    FastUnlock(false);
+    return;
+  }
+#endif
+
 #if P_READ_WRITE_ALGO2
   InternalWait(nest, m_outSemaphore);
   ++m_outCount;
@@ -4636,6 +5649,15 @@ void PReadWriteMutex::InternalEndReadWithNest(Nest & nest, const PDebugLocation
 
 void PReadWriteMutex::InternalStartWriteWithNest(Nest & nest, const PDebugLocation & location)
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    FastLock(nest, true, location);
+    m_fastWriterId = PThread::GetCurrentThreadId();
+    m_fastWriterUniqueId = nest.m_uniqueId.load();
+    return;
+  }
+#endif
+
 #if P_READ_WRITE_ALGO2
   InternalWait(nest, m_inSemaphore);
   InternalWait(nest, m_outSemaphore);
@@ -4663,6 +5685,13 @@ void PReadWriteMutex::InternalStartWriteWithNest(Nest & nest, const PDebugLocati
 
 void PReadWriteMutex::InternalEndWriteWithNest(Nest & nest, const PDebugLocation & location)
 {
+#if P_READ_WRITE_FAST
+  if (m_algorithm == FastAlgorithm) {
+    FastUnlock(true);
+    return;
+  }
+#endif
+
 #if P_READ_WRITE_ALGO2
   m_inSemaphore.Signal();
 #else
@@ -4680,7 +5709,7 @@ void PReadWriteMutex::InternalEndWriteWithNest(Nest & nest, const PDebugLocation
 
 void PReadWriteMutex::PrintOn(ostream & strm) const
 {
-  strm << "read/write mutex " << this;
+  strm << (m_algorithm == FastAlgorithm ? "fast " : "") << "read/write mutex " << this;
   PMutexExcessiveLockInfo::PrintOn(strm);
 }
 
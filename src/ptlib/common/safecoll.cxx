@@ -39,28 +39,40 @@
 /////////////////////////////////////////////////////////////////////////////
 
 PSafeObject::PSafeObject()
-  : m_safeReferenceCount(0)
-  , m_safelyBeingRemoved(false)
+  : m_safeState(0)
   , m_safeMutexCreated(true)
   , m_safeInUseMutex(NULL)
+  , m_safeRemovalOwner(NULL)
+  , m_safeRemovalPrev(NULL)
+  , m_safeRemovalNext(NULL)
+  , m_safeDeferredNext(NULL)
+  , m_safeDeferredTick(0)
 {
 }
 
 
 PSafeObject::PSafeObject(const PSafeObject & other)
   : PObject(other)
-  , m_safeReferenceCount(0)
-  , m_safelyBeingRemoved(false)
+  , m_safeState(0)
   , m_safeMutexCreated(true)
   , m_safeInUseMutex(NULL)
+  , m_safeRemovalOwner(NULL)
+  , m_safeRemovalPrev(NULL)
+  , m_safeRemovalNext(NULL)
+  , m_safeDeferredNext(NULL)
+  , m_safeDeferredTick(0)
 {
 }
 
 
 PSafeObject::PSafeObject(PSafeObject * indirectLock)
-  : m_safeReferenceCount(0)
-  , m_safelyBeingRemoved(false)
+  : m_safeState(0)
   , m_safeMutexCreated(false)
+  , m_safeRemovalOwner(NULL)
+  , m_safeRemovalPrev(NULL)
+  , m_safeRemovalNext(NULL)
+  , m_safeDeferredNext(NULL)
+  , m_safeDeferredTick(0)
 {
   if (PAssert(indirectLock != NULL, PNullPointerReference))
     m_safeInUseMutex = &indirectLock->InternalGetMutex();
@@ -70,10 +82,14 @@ PSafeObject::PSafeObject(PSafeObject * indirectLock)
 
 
 PSafeObject::PSafeObject(PReadWriteMutex & mutex)
-  : m_safeReferenceCount(0)
-  , m_safelyBeingRemoved(false)
+  : m_safeState(0)
   , m_safeMutexCreated(false)
   , m_safeInUseMutex(&mutex)
+  , m_safeRemovalOwner(NULL)
+  , m_safeRemovalPrev(NULL)
+  , m_safeRemovalNext(NULL)
+  , m_safeDeferredNext(NULL)
+  , m_safeDeferredTick(0)
 {
 }
 
@@ -81,20 +97,27 @@ PSafeObject::PSafeObject(PReadWriteMutex & mutex)
 PSafeObject::~PSafeObject()
 {
   if (m_safeMutexCreated)
-    delete m_safeInUseMutex;
+    delete m_safeInUseMutex.load();
 }
 
 
 PBoolean PSafeObject::SafeReference()
 {
-#if PTRACING
-  unsigned count = 0;
-  {
-    PWaitAndSignal mutex(m_safetyMutex);
-    if (!m_safelyBeingRemoved)
-      count = ++m_safeReferenceCount;
+  unsigned state;
+  for (;;) {
+    state = m_safeState.load();
+    if ((state & SafeRemovedFlag) != 0) {
+      state = 0;
+      break;
+    }
+    if (m_safeState.compare_exchange_strong(state, state+1)) {
+      ++state;
+      break;
+    }
   }
 
+#if PTRACING
+  unsigned count = state & SafeCountMask;
   unsigned level = count == 0  || m_traceContextIdentifier == 1234567890 ? 3 : 7;
   if (PTrace::CanTrace(level)) {
     ostream & trace = PTRACE_BEGIN(level);
@@ -108,61 +131,82 @@ PBoolean PSafeObject::SafeReference()
     }
     trace << PTrace::End;
   }
-  return count > 0;
-#else
-  PWaitAndSignal mutex(m_safetyMutex);
-  if (m_safelyBeingRemoved)
-    return false;
-  ++m_safeReferenceCount;
-  return true;
 #endif
+
+  return state != 0;
 }
 
 
 PBoolean PSafeObject::SafeDereference()
 {
-  bool mayBeDeleted = false;
-
-  m_safetyMutex.Wait();
-  if (PAssert(m_safeReferenceCount > 0, PLogicError)) {
-    m_safeReferenceCount--;
-    mayBeDeleted = m_safeReferenceCount == 0 && !m_safelyBeingRemoved;
-  }
 #if PTRACING
-  unsigned count = m_safeReferenceCount;
+  // Once decremented, another thread may delete us
   unsigned level = m_traceContextIdentifier == 1234567890 ? 3 : 7;
+  const char * className = GetClass();
 #endif
+
+  unsigned state;
+  for (;;) {
+    state = m_safeState.load();
+    if (!PAssert((state & SafeCountMask) > 0, PLogicError))
+      return false;
+    if (m_safeState.compare_exchange_strong(state, state-1))
+      break;
+  }
+  --state;
+
+  PTRACE(level, PTraceModule(), className << ' ' << (void *)this << " decremented reference count to " << (state & SafeCountMask));
+
+  if (state == 0)
+    return true;
+
+  if (state != SafeRemovedFlag)
+    return false;
+
+  /* Last reference gone from a removed object, hand to collection for
+     deletion. The owner is taken under the mutex, so the collection can
+     not be destroyed before we queue, and no one else queues it. */
+  m_safetyMutex.Wait();
+  PSafeCollection * owner = m_safeRemovalOwner;
+  if (owner != NULL) {
+    m_safeRemovalOwner = NULL;
+    ++owner->m_deferredQueueing;
+  }
   m_safetyMutex.Signal();
 
-  PTRACE(level, GetClass() << ' ' << (void *)this << " decremented reference count to " << count);
+  if (owner != NULL)
+    owner->QueueDeletion(this);
 
-  // At this point the object could be deleted in another trhead, do not use it anymore!
-  return mayBeDeleted;
+  // At this point the object could be deleted in another thread, do not use it anymore!
+  return false;
 }
 
 
 PReadWriteMutex & PSafeObject::InternalGetMutex() const
 {
-  PWaitAndSignal lock(m_safetyMutex);
-  if (m_safeInUseMutex == NULL)
-    const_cast<PSafeObject *>(this)->m_safeInUseMutex = new PReadWriteMutex(typeid(*this).name());
-  return *m_safeInUseMutex;
+  PReadWriteMutex * mutex = m_safeInUseMutex.load();
+  if (mutex != NULL)
+    return *mutex;
+
+  // Racing threads may both create one, only the first is published
+  PReadWriteMutex * newMutex = new PReadWriteMutex(typeid(*this).name());
+  if (m_safeInUseMutex.compare_exchange_strong(mutex, newMutex))
+    return *newMutex;
+
+  delete newMutex;
+  return *m_safeInUseMutex.load();
 }
 
 
 bool PSafeObject::InternalLockReadOnly(const PDebugLocation * location) const
 {
   PTRACE(m_traceContextIdentifier == 1234567890 ? 3 : 7, "Waiting read ("<<(void *)this<<")");
-  m_safetyMutex.Wait();
 
-  if (m_safelyBeingRemoved) {
-    m_safetyMutex.Signal();
+  if (IsSafelyBeingRemoved()) {
     PTRACE(6, "Being removed while waiting read ("<<(void *)this<<")");
     return false;
   }
 
-  m_safetyMutex.Signal();
-
   InternalGetMutex().StartRead(location);
   PTRACE(m_traceContextIdentifier == 1234567890 ? 3 : 7, "Locked read ("<<(void *)this<<")");
   return true;
@@ -179,16 +223,12 @@ void PSafeObject::InternalUnlockReadOnly(const PDebugLocation * location) const
 bool PSafeObject::InternalLockReadWrite(const PDebugLocation * location) const
 {
   PTRACE(m_traceContextIdentifier == 1234567890 ? 3 : 7, "Waiting readWrite ("<<(void *)this<<")");
-  m_safetyMutex.Wait();
 
-  if (m_safelyBeingRemoved) {
-    m_safetyMutex.Signal();
+  if (IsSafelyBeingRemoved()) {
     PTRACE(6, "Being removed while waiting readWrite ("<<(void *)this<<")");
     return false;
   }
 
-  m_safetyMutex.Signal();
-
   InternalGetMutex().StartWrite(location);
   PTRACE(m_traceContextIdentifier == 1234567890 ? 3 : 7, "Locked readWrite ("<<(void *)this<<")");
   return true;
@@ -202,18 +242,24 @@ void PSafeObject::InternalUnlockReadWrite(const PDebugLocation * location) const
 }
 
 
+void PSafeObject::SetSafelyBeingRemoved()
+{
+  unsigned state;
+  do {
+    state = m_safeState.load();
+  } while ((state & SafeRemovedFlag) == 0 && !m_safeState.compare_exchange_strong(state, state | SafeRemovedFlag));
+}
+
+
 void PSafeObject::SafeRemove()
 {
-  m_safetyMutex.Wait();
-  m_safelyBeingRemoved = true;
-  m_safetyMutex.Signal();
+  SetSafelyBeingRemoved();
 }
 
 
 PBoolean PSafeObject::SafelyCanBeDeleted() const
 {
-  PWaitAndSignal mutex(m_safetyMutex);
-  return m_safelyBeingRemoved && m_safeReferenceCount == 0;
+  return m_safeState.load() == SafeRemovedFlag;
 }
 
 
@@ -263,35 +309,100 @@ PSafeCollection::PSafeCollection(PCollection * coll)
   , m_collectionMutex(PDebugLocation(__FILE__, __LINE__, "SafeCollection"))
   , m_deleteObjects(true)
   , m_removalMutex(PDebugLocation(__FILE__, __LINE__, "SafeRemoval"))
-#if P_TIMERS
-  , m_deleteObjectsTimer(NULL)
-#endif
+  , m_toBeRemoved(NULL)
+  , m_toBeRemovedCount(0)
+  , m_garbageRetry(NULL)
+  , m_reclaimedCount(0)
+  , m_reclaimedLatency(0)
+  , m_reclaimedMaxLatency(0)
+  , m_deferredDeletion(NULL)
+  , m_deferredCount(0)
+  , m_deferredQueueing(0)
+  , m_deleteObjectsThread(NULL)
+  , m_deleteObjectsSignal(NULL)
+  , m_deleteObjectsShutdown(false)
 {
   m_collection->DisallowDeleteObjects();
-  m_toBeRemoved.DisallowDeleteObjects();
 }
 
 
 PSafeCollection::~PSafeCollection()
 {
-#if P_TIMERS
-  delete m_deleteObjectsTimer;
-#endif
+  if (m_deleteObjectsThread != NULL) {
+    m_deleteObjectsShutdown = true;
+    m_deleteObjectsSignal.load()->Signal();
+    m_deleteObjectsThread->WaitForTermination();
+    delete m_deleteObjectsThread;
+  }
 
   RemoveAll();
 
-  /* Delete objects moved to deleted list in RemoveAll(), we don't use
+  /* If anything still has a PSafePtr .. "detach" it from the collection so
+     will be deleted whan that PSafePtr finally goes out of scope. This is done
+     under the objects mutex, so after this nothing new can be queued to us. */
+  m_removalMutex.Wait();
+  PSafeObject * obj = m_toBeRemoved;
+  std::vector<PSafeObject *> inFlight;
+  while (obj != NULL) {
+    PSafeObject * next = obj->m_safeRemovalNext;
+    obj->m_safetyMutex.Wait();
+    if (obj->m_safeRemovalOwner == this) {
+      /* Clear the removed flag while still referenced, so the last
+         SafeDereference() says to delete it. If the count got to zero first,
+         that SafeDereference() is about to take the owner and queue it. */
+      unsigned state;
+      do {
+        state = obj->m_safeState.load();
+      } while (state != PSafeObject::SafeRemovedFlag &&
+               !obj->m_safeState.compare_exchange_strong(state, state & PSafeObject::SafeCountMask));
+
+      if (state == PSafeObject::SafeRemovedFlag)
+        inFlight.push_back(obj);
+      else
+        obj->m_safeRemovalOwner = NULL;
+    }
+    obj->m_safetyMutex.Signal();
+    obj = next;
+  }
+  m_toBeRemoved = NULL;
+  obj = m_garbageRetry;
+  m_garbageRetry = NULL;
+  m_removalMutex.Signal();
+
+  // Wait for those to be handed over, after which m_deferredQueueing covers them
+  for (std::vector<PSafeObject *>::iterator it = inFlight.begin(); it != inFlight.end(); ++it) {
+    for (;;) {
+      (*it)->m_safetyMutex.Wait();
+      bool pending = (*it)->m_safeRemovalOwner == this;
+      (*it)->m_safetyMutex.Signal();
+      if (!pending)
+        break;
+      PThread::Yield();
+    }
+  }
+
+  // Wait for anything that had its last reference go while we were detaching
+  while (m_deferredQueueing > 0)
+    PThread::Yield();
+
+  delete m_deleteObjectsSignal.exchange(NULL);
+
+  /* Delete everything else, which is now unreferenced, we don't use
      DeleteObjectsToBeRemoved() as that will do a garbage collection which might
      prevent deletion. Need to be a bit more forceful here. */
-  for (PList<PSafeObject>::iterator i = m_toBeRemoved.begin(); i != m_toBeRemoved.end(); ++i) {
-    i->GarbageCollection();
-    if (i->SafelyCanBeDeleted())
-      delete &*i;
-    else {
-      // If anything still has a PSafePtr .. "detach" it from the collection so
-      // will be deleted whan that PSafePtr finally goes out of scope.
-      i->m_safelyBeingRemoved = false;
-    }
+  PSafeObject * list = m_deferredDeletion.exchange(NULL);
+  while (obj != NULL) {
+    PSafeObject * next = obj->m_safeDeferredNext;
+    obj->m_safeDeferredNext = list;
+    list = obj;
+    obj = next;
+  }
+
+  while (list != NULL) {
+    obj = list;
+    list = obj->m_safeDeferredNext;
+    obj->GarbageCollection();
+    delete obj;
   }
 
   delete m_collection;
@@ -372,11 +483,23 @@ void PSafeCollection::SafeRemoveObject(PSafeObject * obj)
 
   // Make sure SfeRemove() called before SafeDereference() to avoid race condition
   if (m_deleteObjects) {
-    obj->SafeRemove();
-
-    m_removalMutex.Wait();
-    m_toBeRemoved.Append(obj);
-    m_removalMutex.Signal();
+    obj->m_safetyMutex.Wait();
+    bool owned = obj->m_safeRemovalOwner == NULL;
+    if (owned)
+      obj->m_safeRemovalOwner = this;
+    obj->SetSafelyBeingRemoved();
+    obj->m_safetyMutex.Signal();
+
+    if (PAssert(owned, "Safe object removed from two collections")) {
+      m_removalMutex.Wait();
+      obj->m_safeRemovalPrev = NULL;
+      obj->m_safeRemovalNext = m_toBeRemoved;
+      if (m_toBeRemoved != NULL)
+        m_toBeRemoved->m_safeRemovalPrev = obj;
+      m_toBeRemoved = obj;
+      ++m_toBeRemovedCount;
+      m_removalMutex.Signal();
+    }
   }
 
   /* Even though we are marked as not to delete objects, we still need to obey
@@ -384,34 +507,94 @@ void PSafeCollection::SafeRemoveObject(PSafeObject * obj)
      the object is still "owned" by a PSafeCollection that has NOT got
      deleteObjects false, then SafeDereference returns false so we don't delete
      is here. If there are no PSafePtr()s or PSafeCollections()'s anywhere we
-     need to delete it.
+     need to delete it. If we are the owner, and this was the last reference,
+     SafeDereference() will have queued it for DeleteObjectsToBeRemoved().
      */
   if (obj->SafeDereference() && !m_deleteObjects)
     delete obj;
 }
 
 
+void PSafeCollection::QueueDeletion(PSafeObject * obj)
+{
+  obj->m_safeDeferredTick = PTimer::Tick().GetNanoSeconds();
+  ++m_deferredCount;
+
+  PSafeObject * head;
+  do {
+    head = m_deferredDeletion.load();
+    obj->m_safeDeferredNext = head;
+  } while (!m_deferredDeletion.compare_exchange_strong(head, obj));
+
+  // Object may be deleted by now, but we are still safe
+  if (head == NULL) {
+    PSyncPoint * signal = m_deleteObjectsSignal.load();
+    if (signal != NULL)
+      signal->Signal();
+  }
+
+  --m_deferredQueueing;
+}
+
+
 PBoolean PSafeCollection::DeleteObjectsToBeRemoved()
 {
+  // Take everything that has become unreferenced in one go
+  PSafeObject * list = m_deferredDeletion.exchange(NULL);
+
+  m_removalMutex.Wait();
+  if (m_garbageRetry != NULL) {
+    PSafeObject * tail = m_garbageRetry;
+    while (tail->m_safeDeferredNext != NULL)
+      tail = tail->m_safeDeferredNext;
+    tail->m_safeDeferredNext = list;
+    list = m_garbageRetry;
+    m_garbageRetry = NULL;
+  }
+  m_removalMutex.Signal();
+
+  PSafeObject * retry = NULL;
+  while (list != NULL) {
+    PSafeObject * obj = list;
+    list = obj->m_safeDeferredNext;
+
+    if (!obj->GarbageCollection()) {
+      obj->m_safeDeferredNext = retry;
+      retry = obj;
+      continue;
+    }
+
+    PInt64 latency = PTimer::Tick().GetNanoSeconds() - obj->m_safeDeferredTick;
+
+    m_removalMutex.Wait();
+    if (obj->m_safeRemovalPrev != NULL)
+      obj->m_safeRemovalPrev->m_safeRemovalNext = obj->m_safeRemovalNext;
+    else
+      m_toBeRemoved = obj->m_safeRemovalNext;
+    if (obj->m_safeRemovalNext != NULL)
+      obj->m_safeRemovalNext->m_safeRemovalPrev = obj->m_safeRemovalPrev;
+    --m_toBeRemovedCount;
+    --m_deferredCount;
+    ++m_reclaimedCount;
+    m_reclaimedLatency += latency;
+    if (m_reclaimedMaxLatency < latency)
+      m_reclaimedMaxLatency = latency;
+    m_removalMutex.Signal();
+
+    DeleteObject(obj);
+  }
+
   {
     PWaitAndSignal lock(m_removalMutex);
 
-    PList<PSafeObject>::iterator it = m_toBeRemoved.begin();
-    while (it != m_toBeRemoved.end()) {
-      if (it->GarbageCollection() && it->SafelyCanBeDeleted()) {
-        PObject * obj = &*it;
-        m_toBeRemoved.Remove(obj);
-        m_removalMutex.Signal();
-        DeleteObject(obj);
-        m_removalMutex.Wait();
-
-        it = m_toBeRemoved.begin(); // Restart looking through list
-      }
-      else
-        ++it;
+    while (retry != NULL) {
+      PSafeObject * obj = retry;
+      retry = obj->m_safeDeferredNext;
+      obj->m_safeDeferredNext = m_garbageRetry;
+      m_garbageRetry = obj;
     }
 
-    if (!m_toBeRemoved.IsEmpty())
+    if (m_toBeRemoved != NULL)
       return false;
   }
 
@@ -428,23 +611,58 @@ void PSafeCollection::DeleteObject(PObject * object) const
 
 void PSafeCollection::SetAutoDeleteObjects()
 {
-#if P_TIMERS
-  if (m_deleteObjectsTimer != NULL)
+  PWaitAndSignal lock(m_removalMutex);
+
+  if (m_deleteObjectsThread != NULL)
     return;
 
-  m_deleteObjectsTimer = new PTimer();
-  m_deleteObjectsTimer->SetNotifier(PCREATE_NOTIFIER(DeleteObjectsTimeout), "SafeDelObj");
-  m_deleteObjectsTimer->RunContinuous(1000); // Every second
-#endif
+  m_deleteObjectsSignal = new PSyncPoint();
+  m_deleteObjectsThread = new PThreadObj<PSafeCollection>(*this, &PSafeCollection::DeleteObjectsMain, false, "SafeDelObj");
+}
+
+
+void PSafeCollection::DeleteObjectsMain()
+{
+  PSyncPoint & signal = *m_deleteObjectsSignal.load();
+
+  while (!m_deleteObjectsShutdown) {
+    DeleteObjectsToBeRemoved();
+
+    // Only poll if something is waiting on GarbageCollection()
+    m_removalMutex.Wait();
+    bool retry = m_garbageRetry != NULL;
+    m_removalMutex.Signal();
+
+    if (retry)
+      signal.Wait(100);
+    else
+      signal.Wait();
+  }
 }
 
 
-#if P_TIMERS
-void PSafeCollection::DeleteObjectsTimeout(PTimer &, P_INT_PTR)
+PSafeCollection::GarbageStatistics::GarbageStatistics()
+  : m_pendingReferenced(0)
+  , m_pendingDeletion(0)
+  , m_reclaimed(0)
 {
-  DeleteObjectsToBeRemoved();
 }
-#endif
+
+
+PSafeCollection::GarbageStatistics PSafeCollection::GetGarbageStatistics() const
+{
+  GarbageStatistics stats;
+
+  PWaitAndSignal lock(m_removalMutex);
+  stats.m_pendingDeletion = m_deferredCount;
+  if (stats.m_pendingDeletion < m_toBeRemovedCount)
+    stats.m_pendingReferenced = m_toBeRemovedCount - stats.m_pendingDeletion;
+  stats.m_reclaimed = m_reclaimedCount;
+  if (m_reclaimedCount > 0)
+    stats.m_averageLatency = PTimeInterval::NanoSeconds(m_reclaimedLatency / (PInt64)m_reclaimedCount);
+  stats.m_maximumLatency = PTimeInterval::NanoSeconds(m_reclaimedMaxLatency);
+  return stats;
+}
 
 
 PINDEX PSafeCollection::GetSize() const
@@ -466,6 +684,34 @@ void PSafeCollection::CopySafeCollection(PCollection * other)
 }
 
 
+void PSafeCollection::CopySafeCollection(const PSafeCollection & other)
+{
+  DisallowDeleteObjects();
+
+  ObjectArray objects;
+  other.GetObjectsInOrder(objects);
+  for (ObjectArray::iterator it = objects.begin(); it != objects.end(); ++it) {
+    PSafeObject * obj = *it;
+    if (obj != NULL && obj->SafeReference())
+      m_collection->Append(obj);
+  }
+}
+
+
+void PSafeCollection::GetObjectsInOrder(ObjectArray & objects) const
+{
+  AddObjectsInOrder(*m_collection, objects);
+}
+
+
+void PSafeCollection::AddObjectsInOrder(const PCollection & coll, ObjectArray & objects)
+{
+  objects.reserve(objects.size() + coll.GetSize());
+  for (PINDEX i = 0; i < coll.GetSize(); ++i)
+    objects.push_back(dynamic_cast<PSafeObject *>(coll.GetAt(i)));
+}
+
+
 void PSafeCollection::CopySafeDictionary(PAbstractDictionary * other)
 {
   DisallowDeleteObjects();
@@ -484,6 +730,7 @@ PSafePtrBase::PSafePtrBase(PSafeObject * obj, PSafetyMode mode)
   : m_collection(NULL)
   , m_currentObject(obj)
   , m_lockMode(mode)
+  , m_enumerationIndex(P_MAX_INDEX)
 {
   EnterSafetyMode(WithReference);
 }
@@ -495,6 +742,7 @@ PSafePtrBase::PSafePtrBase(const PSafeCollection & safeCollection,
   : m_collection(safeCollection.CloneAs<PSafeCollection>())
   , m_currentObject(NULL)
   , m_lockMode(mode)
+  , m_enumerationIndex(P_MAX_INDEX)
 {
   Assign(idx);
 }
@@ -506,6 +754,7 @@ PSafePtrBase::PSafePtrBase(const PSafeCollection & safeCollection,
   : m_collection(safeCollection.CloneAs<PSafeCollection>())
   , m_currentObject(NULL)
   , m_lockMode(mode)
+  , m_enumerationIndex(P_MAX_INDEX)
 {
   Assign(obj);
 }
@@ -515,6 +764,7 @@ PSafePtrBase::PSafePtrBase(const PSafePtrBase & enumerator)
   : m_collection(enumerator.m_collection != NULL ? enumerator.m_collection->CloneAs<PSafeCollection>() : NULL)
   , m_currentObject(enumerator.m_currentObject)
   , m_lockMode(enumerator.m_lockMode)
+  , m_enumerationIndex(enumerator.m_enumerationIndex)
 {
   EnterSafetyMode(WithReference);
 }
@@ -559,6 +809,8 @@ void PSafePtrBase::Assign(const PSafePtrBase & enumerator)
   m_collection = enumerator.m_collection != NULL ? enumerator.m_collection->CloneAs<PSafeCollection>() : NULL;
   m_currentObject = enumerator.m_currentObject;
   m_lockMode = enumerator.m_lockMode;
+  m_enumeration.clear();
+  m_enumerationIndex = enumerator.m_enumerationIndex;
 
   EnterSafetyMode(WithReference);
 }
@@ -573,6 +825,7 @@ void PSafePtrBase::Assign(const PSafeCollection & safeCollection)
   m_collection = safeCollection.CloneAs<PSafeCollection>();
   m_currentObject = NULL;
   m_lockMode = PSafeReadWrite;
+  m_enumeration.clear();
 
   Assign((PINDEX)0);
 }
@@ -596,10 +849,12 @@ void PSafePtrBase::Assign(PSafeObject * newObj)
 
   m_collection->m_collectionMutex.Wait();
 
-  if (m_collection->m_collection->GetObjectsIndex(newObj) == P_MAX_INDEX) {
+  m_enumerationIndex = m_collection->m_collection->GetObjectsIndex(newObj);
+  if (m_enumerationIndex == P_MAX_INDEX) {
     m_collection->m_collectionMutex.Signal();
     delete m_collection;
     m_collection = NULL;
+    m_enumeration.clear();
     m_lockMode = PSafeReference;
     if (!EnterSafetyMode(WithReference))
       m_currentObject = NULL;
@@ -633,6 +888,7 @@ void PSafePtrBase::Assign(PINDEX idx)
     }
     idx++;
   }
+  m_enumerationIndex = idx;
 
   m_collection->m_collectionMutex.Signal();
 
@@ -640,6 +896,25 @@ void PSafePtrBase::Assign(PINDEX idx)
 }
 
 
+bool PSafePtrBase::LocateCurrentObject()
+{
+  if (m_enumeration.empty())
+    m_collection->GetObjectsInOrder(m_enumeration);
+
+  PINDEX size = (PINDEX)m_enumeration.size();
+  if (m_enumerationIndex < size && m_enumeration[m_enumerationIndex] == m_currentObject)
+    return true;
+
+  // Only if the position is unknown, e.g. after a copy of the pointer
+  for (m_enumerationIndex = 0; m_enumerationIndex < size; ++m_enumerationIndex) {
+    if (m_enumeration[m_enumerationIndex] == m_currentObject)
+      return true;
+  }
+
+  return false;
+}
+
+
 void PSafePtrBase::Next()
 {
   if (PAssertNULL(m_collection) == NULL || m_currentObject == NULL)
@@ -649,14 +924,14 @@ void PSafePtrBase::Next()
 
   m_collection->m_collectionMutex.Wait();
 
-  PINDEX idx = m_collection->m_collection->GetObjectsIndex(m_currentObject);
+  bool found = LocateCurrentObject();
 
   m_currentObject->SafeDereference();
   m_currentObject = NULL;
 
-  if (idx != P_MAX_INDEX) {
-    while (++idx < m_collection->m_collection->GetSize()) {
-      m_currentObject = dynamic_cast<PSafeObject *>(m_collection->m_collection->GetAt(idx));
+  if (found) {
+    while (++m_enumerationIndex < (PINDEX)m_enumeration.size()) {
+      m_currentObject = m_enumeration[m_enumerationIndex];
       if (m_currentObject != NULL) {
         if (!m_currentObject->IsSafelyBeingRemoved() && m_currentObject->SafeReference())
           break;
@@ -680,14 +955,14 @@ void PSafePtrBase::Previous()
 
   m_collection->m_collectionMutex.Wait();
 
-  PINDEX idx = m_collection->m_collection->GetObjectsIndex(m_currentObject);
+  bool found = LocateCurrentObject();
 
   m_currentObject->SafeDereference();
   m_currentObject = NULL;
 
-  if (idx != P_MAX_INDEX) {
-    while (idx-- > 0) {
-      m_currentObject = dynamic_cast<PSafeObject *>(m_collection->m_collection->GetAt(idx));
+  if (found) {
+    while (m_enumerationIndex-- > 0) {
+      m_currentObject = m_enumeration[m_enumerationIndex];
       if (m_currentObject != NULL) {
         if (!m_currentObject->IsSafelyBeingRemoved() && m_currentObject->SafeReference())
           break;
@@ -711,6 +986,7 @@ void PSafePtrBase::SetNULL()
   m_collection = NULL;
   m_currentObject = NULL;
   m_lockMode = PSafeReference;
+  m_enumeration.clear();
 }
 
 
@@ -33,6 +33,14 @@
 
 #include <ctype.h>
 
+#if P_HAS_SENDFILE
+#include <sys/sendfile.h>
+#endif
+
+#if P_HAS_RECVMMSG
+#include <netinet/udp.h>
+#endif
+
 #define PTraceModule() "Socket"
 
 #ifdef P_VXWORKS
@@ -275,18 +283,70 @@ class PIPCacheData : public PObject
 
 
 
-PDICTIONARY(PHostByName_private, PCaselessString, PIPCacheData);
-
-class PHostByName : PHostByName_private
+/* Cache of host name lookups. The names are spread over a number of shards,
+   each with its own mutex, so threads looking up different names do not
+   contend with each other. Only one lookup of a given name is ever in
+   progress, anyone else wanting it waits for that lookup to complete. */
+class PHostByName : public PObject
 {
+  PCLASSINFO(PHostByName, PObject)
   public:
-    PBoolean GetHostName(const PString & name, PString & hostname);
-    PBoolean GetHostAddress(const PString & name, PIPSocket::Address & address);
-    PBoolean GetHostAliases(const PString & name, PStringArray & aliases);
+    template <class Output> bool GetHost(const PString & name, Output & output);
+    void GetHostAsync(const PString & name, const PIPSocket::HostLookupNotifier & notifier);
+    void SetTimeouts(const PTimeInterval & positive, const PTimeInterval & negative, const PTimeInterval & refresh);
+    void SetResolver(const PIPSocket::HostResolver & resolver);
+    void RemoveAll();
+
   private:
-    PIPCacheData * GetHost(const PString & name);
-    PDECLARE_MUTEX(mutex);
-  friend void PIPSocket::ClearNameCache();
+    struct InFlight
+    {
+      InFlight() : m_waiters(0) { }
+
+      PIPSocket::HostLookup m_result;
+      unsigned              m_waiters;
+      PSemaphore            m_done;
+      std::vector<PIPSocket::HostLookupNotifier> m_notifiers;
+    };
+
+    struct Entry
+    {
+      Entry() : m_expiry(0), m_inFlight(NULL), m_refreshing(false) { }
+
+      PIPSocket::HostLookup m_lookup;
+      PTime                 m_expiry;
+      InFlight            * m_inFlight;   // Set while the name has no result yet
+      bool                  m_refreshing; // Set while a background refresh is in progress
+    };
+
+    typedef std::map<PString, Entry> EntryMap;
+
+    // Configuration is copied into every shard, so a lookup never takes a global lock
+    struct Shard
+    {
+      Shard();
+
+      PDECLARE_MUTEX(m_mutex);
+      EntryMap                m_entries;
+      PTime                   m_nextPurge;
+      PTimeInterval           m_positiveTimeout;
+      PTimeInterval           m_negativeTimeout;
+      PTimeInterval           m_refreshTime;
+      PIPSocket::HostResolver m_resolver;
+    };
+
+    enum { NumShards = 16 };
+    Shard m_shards[NumShards];
+
+    static bool MakeKey(const PString & name, PString & key);
+    Shard & GetShard(const PString & key);
+    bool IsCached(Shard & shard, Entry & entry, const PTime & now, PString & refreshName);
+    static bool CopyResult(const PIPSocket::HostLookup & lookup, PIPSocket::HostLookup & output);
+    static bool CopyResult(const PIPSocket::HostLookup & lookup, PIPSocket::Address & output);
+    void StartLookup(const PIPSocket::HostLookup & lookup, bool refresh);
+    void LookupThread(PIPSocket::HostLookup lookup, bool refresh);
+    void Resolve(const PString & key, PIPSocket::HostLookup & lookup);
+    void Complete(const PString & key, const PIPSocket::HostLookup & lookup, bool refresh);
+    static void SystemResolve(PIPSocket::HostLookup & lookup);
 };
 
 static PHostByName s_HostByName;
@@ -303,7 +363,7 @@ class PIPCacheKey : public PObject
       { return new PIPCacheKey(*this); }
 
     PINDEX HashFunction() const
-      { return (addr[1] + addr[2] + addr[3])%41; }
+      { return (addr[1] << 16) | (addr[2] << 8) | addr[3]; }
 
   private:
     PIPSocket::Address addr;
@@ -444,172 +504,387 @@ PBoolean PIPCacheData::HasAged() const
 }
 
 
-PBoolean PHostByName::GetHostName(const PString & name, PString & hostname)
+PHostByName::Shard::Shard()
+  : m_positiveTimeout(GetConfigTime("Age Limit", 300000)) // 5 minutes
+  , m_negativeTimeout(GetConfigTime("Negative Age Limit", 30000))
+  , m_refreshTime(GetConfigTime("Refresh Time", 30000))
 {
-  PIPCacheData * host = GetHost(name);
+}
 
-  if (host != NULL) {
-    hostname = host->GetHostName();
-    hostname.MakeUnique();
+
+bool PHostByName::MakeKey(const PString & name, PString & key)
+{
+  key = name;
+  PINDEX len = key.GetLength();
+
+  // Check for a legal hostname as per RFC952
+  // but drop the requirement for leading alpha as per RFC 1123
+  if (key.IsEmpty() ||
+      key.FindSpan("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-.") != P_MAX_INDEX ||
+      key[len-1] == '-') {
+    PTRACE_IF(3, key[(PINDEX)0] != '[', &s_HostByName, "Illegal RFC952 characters in DNS name \"" << key << '"');
+    return false;
   }
 
-  mutex.Signal();
+  // We lowercase this way rather than toupper() as that is locale dependent, and DNS names aren't.
+  for (PINDEX i = 0; i < len; i++) {
+    if (key[i] >= 'a')
+      key[i] &= 0x5f;
+  }
 
-  return host != NULL;
+  return true;
 }
 
 
-PBoolean PHostByName::GetHostAddress(const PString & name, PIPSocket::Address & address)
+PHostByName::Shard & PHostByName::GetShard(const PString & key)
 {
-  PIPCacheData * host = GetHost(name);
+  unsigned hash = 0;
+  for (const char * ptr = key; *ptr != '\0'; ++ptr)
+    hash = hash*31 + (BYTE)*ptr;
+  return m_shards[hash%NumShards];
+}
 
-  if (host != NULL)
-    address = host->GetHostAddress();
 
-  mutex.Signal();
+// Must be called with shard mutex locked, the caller starts the refresh of refreshName after unlocking
+bool PHostByName::IsCached(Shard & shard, Entry & entry, const PTime & now, PString & refreshName)
+{
+  if (entry.m_inFlight != NULL || now >= entry.m_expiry)
+    return false;
 
-  return host != NULL;
+  // Refresh a good entry in use near the end of its life, so no-one has to wait for it
+  if (!entry.m_refreshing && entry.m_lookup.IsValid() && now >= entry.m_expiry - shard.m_refreshTime) {
+    entry.m_refreshing = true;
+    refreshName = entry.m_lookup.m_name;
+  }
+
+  return true;
 }
 
 
-PBoolean PHostByName::GetHostAliases(const PString & name, PStringArray & aliases)
+bool PHostByName::CopyResult(const PIPSocket::HostLookup & lookup, PIPSocket::HostLookup & output)
 {
-  PIPCacheData * host = GetHost(name);
+  output.m_canonicalName = lookup.m_canonicalName;
+  output.m_address = lookup.m_address;
+  output.m_aliases = lookup.m_aliases;
+  return lookup.IsValid();
+}
 
-  if (host != NULL)
-    aliases = host->GetHostAliases();
 
-  mutex.Signal();
-  return host != NULL;
+bool PHostByName::CopyResult(const PIPSocket::HostLookup & lookup, PIPSocket::Address & output)
+{
+  if (!lookup.IsValid())
+    return false;
+
+  output = lookup.m_address;
+  return true;
 }
 
 
-PIPCacheData * PHostByName::GetHost(const PString & name)
+template <class Output> bool PHostByName::GetHost(const PString & name, Output & output)
 {
-  mutex.Wait();
+  PString key;
+  if (!MakeKey(name, key))
+    return false;
 
-  PString key = name;
-  PINDEX len = key.GetLength();
+  Shard & shard = GetShard(key);
+  PTime now;
 
-  // Check for a legal hostname as per RFC952
-  // but drop the requirement for leading alpha as per RFC 1123
-  if (key.IsEmpty() ||
-      key.FindSpan("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-.") != P_MAX_INDEX ||
-      key[len-1] == '-') {
-    PTRACE_IF(3, key[(PINDEX)0] != '[', "Illegal RFC952 characters in DNS name \"" << key << '"');
-    return NULL;
+  shard.m_mutex.Wait();
+
+  Entry & entry = shard.m_entries[key];
+  PString refreshName;
+  if (IsCached(shard, entry, now, refreshName)) {
+    bool ok = CopyResult(entry.m_lookup, output);
+    shard.m_mutex.Signal();
+    if (!refreshName.IsEmpty())
+      StartLookup(refreshName, true);
+    return ok;
   }
 
-  // We lowercase this way rather than toupper() as that is locale dependent, and DNS names aren't.
-  for (PINDEX i = 0; i < len; i++) {
-    if (key[i] >= 'a')
-      key[i] &= 0x5f;
+  // Someone else is looking it up, or the entry expired while being refreshed, wait for them
+  InFlight * inFlight = entry.m_inFlight;
+  if (inFlight == NULL && entry.m_refreshing)
+    inFlight = entry.m_inFlight = new InFlight;
+  if (inFlight != NULL) {
+    ++inFlight->m_waiters;
+    shard.m_mutex.Signal();
+
+    inFlight->m_done.Wait();
+
+    shard.m_mutex.Wait();
+    bool ok = CopyResult(inFlight->m_result, output);
+    bool last = --inFlight->m_waiters == 0;
+    shard.m_mutex.Signal();
+
+    if (last)
+      delete inFlight;
+    return ok;
   }
 
-  PIPCacheData * host = GetAt(key);
-  int localErrNo = NO_DATA;
+  // Not cached or expired, look it up in this thread
+  entry.m_inFlight = new InFlight;
+  shard.m_mutex.Signal();
 
-  if (host != NULL && host->HasAged()) {
-    SetAt(key, NULL);
-    host = NULL;
+  PIPSocket::HostLookup lookup(name);
+  Resolve(key, lookup);
+  Complete(key, lookup, false);
+  return CopyResult(lookup, output);
+}
+
+
+void PHostByName::GetHostAsync(const PString & name, const PIPSocket::HostLookupNotifier & notifier)
+{
+  PIPSocket::HostLookup lookup(name);
+
+  PString key;
+  if (!MakeKey(name, key)) {
+    notifier(*this, lookup);
+    return;
   }
 
-  if (host == NULL) {
-    mutex.Signal();
+  Shard & shard = GetShard(key);
+  PTime now;
+
+  shard.m_mutex.Wait();
+
+  Entry & entry = shard.m_entries[key];
+  PString refreshName;
+  if (IsCached(shard, entry, now, refreshName)) {
+    CopyResult(entry.m_lookup, lookup);
+    shard.m_mutex.Signal();
+    if (!refreshName.IsEmpty())
+      StartLookup(refreshName, true);
+    notifier(*this, lookup);
+    return;
+  }
+
+  // An expired entry still being refreshed gets its result from the refresh
+  bool start = entry.m_inFlight == NULL && !entry.m_refreshing;
+  if (entry.m_inFlight == NULL)
+    entry.m_inFlight = new InFlight;
+  entry.m_inFlight->m_notifiers.push_back(notifier);
+
+  shard.m_mutex.Signal();
+
+  if (start)
+    StartLookup(lookup, false);
+}
+
+
+void PHostByName::StartLookup(const PIPSocket::HostLookup & lookup, bool refresh)
+{
+  PTRACE(4, "Starting background lookup of \"" << lookup.m_name << '"');
+  new PThreadObj2Arg<PHostByName, PIPSocket::HostLookup, bool>(*this, lookup, refresh,
+                                                              &PHostByName::LookupThread, true, "DNS Lookup");
+}
+
+
+void PHostByName::LookupThread(PIPSocket::HostLookup lookup, bool refresh)
+{
+  PString key;
+  MakeKey(lookup.m_name, key);
+  Resolve(key, lookup);
+  Complete(key, lookup, refresh);
+}
+
+
+void PHostByName::Resolve(const PString & key, PIPSocket::HostLookup & lookup)
+{
+  Shard & shard = GetShard(key);
+  shard.m_mutex.Wait();
+  PIPSocket::HostResolver resolver = shard.m_resolver;
+  shard.m_mutex.Signal();
+
+  if (resolver.IsNULL())
+    SystemResolve(lookup);
+  else
+    resolver(*this, lookup);
+}
+
+
+void PHostByName::Complete(const PString & key, const PIPSocket::HostLookup & lookup, bool refresh)
+{
+  std::vector<PIPSocket::HostLookupNotifier> notifiers;
+
+  Shard & shard = GetShard(key);
+  PTime now;
+
+  shard.m_mutex.Wait();
+
+  EntryMap::iterator it = shard.m_entries.find(key);
+  if (it != shard.m_entries.end()) {
+    Entry & entry = it->second;
+
+    // A failed refresh leaves the old entry to expire normally, unless someone is waiting for it
+    if (refresh)
+      entry.m_refreshing = false;
+    if (!refresh || lookup.IsValid() || entry.m_inFlight != NULL) {
+      entry.m_lookup = lookup;
+      entry.m_expiry = now + (lookup.IsValid() ? shard.m_positiveTimeout : shard.m_negativeTimeout);
+    }
+
+    // Waiters are on either a foreground lookup, or the refresh of an expired entry
+    InFlight * inFlight = entry.m_inFlight;
+    if (inFlight != NULL) {
+      entry.m_inFlight = NULL;
+      notifiers.swap(inFlight->m_notifiers);
+      if (inFlight->m_waiters == 0)
+        delete inFlight;
+      else {
+        inFlight->m_result = lookup;
+        for (unsigned i = 0; i < inFlight->m_waiters; ++i)
+          inFlight->m_done.Signal();
+      }
+    }
+  }
+
+  // Remove expired entries now and then, rather than only when looked up
+  if (now >= shard.m_nextPurge) {
+    for (it = shard.m_entries.begin(); it != shard.m_entries.end(); ) {
+      if (it->second.m_inFlight == NULL && !it->second.m_refreshing && now >= it->second.m_expiry)
+        shard.m_entries.erase(it++);
+      else
+        ++it;
+    }
+    shard.m_nextPurge = now + shard.m_negativeTimeout;
+  }
+
+  shard.m_mutex.Signal();
+
+  for (size_t i = 0; i < notifiers.size(); ++i)
+    notifiers[i](*this, lookup);
+}
+
+
+void PHostByName::SetTimeouts(const PTimeInterval & positive, const PTimeInterval & negative, const PTimeInterval & refresh)
+{
+  for (PINDEX i = 0; i < NumShards; ++i) {
+    PWaitAndSignal lock(m_shards[i].m_mutex);
+    m_shards[i].m_positiveTimeout = positive;
+    m_shards[i].m_negativeTimeout = negative;
+    m_shards[i].m_refreshTime = refresh;
+  }
+}
+
+
+void PHostByName::SetResolver(const PIPSocket::HostResolver & resolver)
+{
+  for (PINDEX i = 0; i < NumShards; ++i) {
+    PWaitAndSignal lock(m_shards[i].m_mutex);
+    m_shards[i].m_resolver = resolver;
+  }
+}
+
+
+void PHostByName::RemoveAll()
+{
+  // Entries with a lookup in progress have waiters, so leave those
+  for (PINDEX i = 0; i < NumShards; ++i) {
+    PWaitAndSignal lock(m_shards[i].m_mutex);
+    EntryMap & entries = m_shards[i].m_entries;
+    for (EntryMap::iterator it = entries.begin(); it != entries.end(); ) {
+      if (it->second.m_inFlight == NULL)
+        entries.erase(it++);
+      else
+        ++it;
+    }
+  }
+}
+
+
+void PHostByName::SystemResolve(PIPSocket::HostLookup & lookup)
+{
+  const PString & name = lookup.m_name;
+  int localErrNo = NO_DATA;
 
 #if HAS_GETADDRINFO
 
-    struct addrinfo *res = NULL;
-    struct addrinfo hints;
-    memset(&hints, 0, sizeof(hints));
-    if (!g_suppressCanonicalName)
-      hints.ai_flags = AI_CANONNAME;
-    hints.ai_family = g_defaultIpAddressFamily;
+  struct addrinfo *res = NULL;
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  if (!g_suppressCanonicalName)
+    hints.ai_flags = AI_CANONNAME;
+  hints.ai_family = g_defaultIpAddressFamily;
+  localErrNo = getaddrinfo((const char *)name, NULL , &hints, &res);
+  if (localErrNo != 0) {
+    hints.ai_family = g_defaultIpAddressFamily == AF_INET6 ? AF_INET : AF_INET6;
     localErrNo = getaddrinfo((const char *)name, NULL , &hints, &res);
-    if (localErrNo != 0) {
-      hints.ai_family = g_defaultIpAddressFamily == AF_INET6 ? AF_INET : AF_INET6;
-      localErrNo = getaddrinfo((const char *)name, NULL , &hints, &res);
-    }
-    host = new PIPCacheData(localErrNo != NETDB_SUCCESS ? NULL : res, name);
-    if (res != NULL)
-      freeaddrinfo(res);
+  }
+  PIPCacheData host(localErrNo != NETDB_SUCCESS ? NULL : res, name);
+  if (res != NULL)
+    freeaddrinfo(res);
 
 #else // HAS_GETADDRINFO
 
-    int retry = 3;
-    struct hostent * host_info;
+  int retry = 3;
+  struct hostent * host_info;
 
 #ifdef P_AIX
 
-    struct hostent_data ht_data;
-    memset(&ht_data, 0, sizeof(ht_data));
-    struct hostent hostEnt;
-    do {
-      host_info = &hostEnt;
-      ::gethostbyname_r(name,
-                        host_info,
-                        &ht_data);
-      localErrNo = h_errno;
-    } while (localErrNo == TRY_AGAIN && --retry > 0);
+  struct hostent_data ht_data;
+  memset(&ht_data, 0, sizeof(ht_data));
+  struct hostent hostEnt;
+  do {
+    host_info = &hostEnt;
+    ::gethostbyname_r(name,
+                      host_info,
+                      &ht_data);
+    localErrNo = h_errno;
+  } while (localErrNo == TRY_AGAIN && --retry > 0);
 
 #elif defined(P_RTEMS) || defined(P_CYGWIN) || defined(P_MINGW)
 
-    host_info = ::gethostbyname(name);
-    localErrNo = h_errno;
+  host_info = ::gethostbyname(name);
+  localErrNo = h_errno;
 
 #elif defined P_VXWORKS
 
-    struct hostent hostEnt;
-    host_info = Vx_gethostbyname((char *)name, &hostEnt);
-    localErrNo = h_errno;
+  struct hostent hostEnt;
+  host_info = Vx_gethostbyname((char *)name, &hostEnt);
+  localErrNo = h_errno;
 
 #elif defined P_LINUX || defined(P_GNU_HURD) || defined(P_ANDROID)
 
-    char buffer[REENTRANT_BUFFER_LEN];
-    struct hostent hostEnt;
-    do {
-      if (::gethostbyname_r(name,
-                            &hostEnt,
-                            buffer, REENTRANT_BUFFER_LEN,
-                            &host_info,
-                            &localErrNo) == 0)
-        localErrNo = NETDB_SUCCESS;
-    } while (localErrNo == TRY_AGAIN && --retry > 0);
+  char buffer[REENTRANT_BUFFER_LEN];
+  struct hostent hostEnt;
+  do {
+    if (::gethostbyname_r(name,
+                          &hostEnt,
+                          buffer, REENTRANT_BUFFER_LEN,
+                          &host_info,
+                          &localErrNo) == 0)
+      localErrNo = NETDB_SUCCESS;
+  } while (localErrNo == TRY_AGAIN && --retry > 0);
 
 #elif (defined(P_PTHREADS) && !defined(P_THREAD_SAFE_LIBC)) || defined(__NUCLEUS_PLUS__)
 
-    char buffer[REENTRANT_BUFFER_LEN];
-    struct hostent hostEnt;
-    do {
-      host_info = ::gethostbyname_r(name,
-                                    &hostEnt,
-                                    buffer, REENTRANT_BUFFER_LEN,
-                                    &localErrNo);
-    } while (localErrNo == TRY_AGAIN && --retry > 0);
+  char buffer[REENTRANT_BUFFER_LEN];
+  struct hostent hostEnt;
+  do {
+    host_info = ::gethostbyname_r(name,
+                                  &hostEnt,
+                                  buffer, REENTRANT_BUFFER_LEN,
+                                  &localErrNo);
+  } while (localErrNo == TRY_AGAIN && --retry > 0);
 
 #else
 
-    host_info = ::gethostbyname(name);
-    localErrNo = h_errno;
+  host_info = ::gethostbyname(name);
+  localErrNo = h_errno;
 
 #endif
 
-    if (localErrNo != NETDB_SUCCESS || retry == 0)
-      host_info = NULL;
-    host = new PIPCacheData(host_info, name);
+  if (localErrNo != NETDB_SUCCESS || retry == 0)
+    host_info = NULL;
+  PIPCacheData host(host_info, name);
 
 #endif //HAS_GETADDRINFO
 
-    mutex.Wait();
-
-    SetAt(key, host);
-  }
-
-  if (host->GetHostAddress().IsValid())
-    return host;
+  lookup.m_canonicalName = host.GetHostName();
+  lookup.m_address = host.GetHostAddress();
+  lookup.m_aliases = host.GetHostAliases();
 
-  PTRACE(4, "Name lookup of \"" << name << "\" failed: errno=" << localErrNo);
-  return NULL;
+  PTRACE_IF(4, !lookup.IsValid(), &s_HostByName, "Name lookup of \"" << name << "\" failed: errno=" << localErrNo);
 }
 
 
@@ -1012,9 +1287,7 @@ PBoolean PSocket::ConvertOSError(P_INT_PTR libcReturnValue, ErrorGroup group)
 
 void PIPSocket::ClearNameCache()
 {
-  s_HostByName.mutex.Wait();
   s_HostByName.RemoveAll();
-  s_HostByName.mutex.Signal();
 
   s_HostByAddr.mutex.Wait();
   s_HostByAddr.RemoveAll();
@@ -1093,9 +1366,12 @@ PString PIPSocket::GetHostName(const PString & hostname)
   if (temp.IsValid())
     return GetHostName(temp);
 
-  PString canonicalname;
-  if (s_HostByName.GetHostName(hostname, canonicalname))
+  HostLookup lookup;
+  if (s_HostByName.GetHost(hostname, lookup)) {
+    PString canonicalname = lookup.m_canonicalName;
+    canonicalname.MakeUnique();
     return canonicalname;
+  }
 
   return hostname;
 }
@@ -1116,7 +1392,7 @@ PString PIPSocket::GetHostName(const Address & addr)
 
 PBoolean PIPSocket::GetHostAddress(Address & addr)
 {
-  return s_HostByName.GetHostAddress(GetHostName(), addr);
+  return GetHostAddress(GetHostName(), addr);
 }
 
 
@@ -1130,7 +1406,34 @@ PBoolean PIPSocket::GetHostAddress(const PString & hostname, Address & addr)
     return true;
 
   // otherwise lookup the name as a host name
-  return s_HostByName.GetHostAddress(hostname, addr);
+  return s_HostByName.GetHost(hostname, addr);
+}
+
+
+void PIPSocket::GetHostAddressAsync(const PString & hostname, const HostLookupNotifier & notifier)
+{
+  HostLookup lookup(hostname);
+  if (hostname.IsEmpty() || lookup.m_address.FromString(hostname)) {
+    if (lookup.IsValid()) {
+      lookup.m_canonicalName = hostname;
+      lookup.m_aliases.AppendString(hostname);
+    }
+    notifier(s_HostByName, lookup);
+  }
+  else
+    s_HostByName.GetHostAsync(hostname, notifier);
+}
+
+
+void PIPSocket::SetNameCacheTimeouts(const PTimeInterval & positive, const PTimeInterval & negative, const PTimeInterval & refresh)
+{
+  s_HostByName.SetTimeouts(positive, negative, refresh);
+}
+
+
+void PIPSocket::SetHostResolver(const HostResolver & resolver)
+{
+  s_HostByName.SetResolver(resolver);
 }
 
 
@@ -1142,8 +1445,11 @@ PStringArray PIPSocket::GetHostAliases(const PString & hostname)
   Address addr(hostname);
   if (addr.IsValid())
     s_HostByAddr.GetHostAliases(addr, aliases);
-  else
-    s_HostByName.GetHostAliases(hostname, aliases);
+  else {
+    HostLookup lookup;
+    if (s_HostByName.GetHost(hostname, lookup))
+      aliases = lookup.m_aliases;
+  }
 
   return aliases;
 }
@@ -2396,6 +2702,70 @@ PBoolean PTCPSocket::WriteOutOfBand(void const * buf, PINDEX len)
 }
 
 
+bool PTCPSocket::WriteFile(PFile & file, PInt64 length)
+{
+  SetLastWriteCount(0);
+
+  if (CheckNotOpen())
+    return false;
+
+  if (!file.IsOpen())
+    return SetErrorValues(NotOpen, EBADF, LastWriteError);
+
+  flush();
+
+  PInt64 written = 0;
+
+#if P_HAS_SENDFILE
+  off_t offset = file.GetPosition();
+  while (written < length) {
+    ssize_t result = ::sendfile(os_handle, file.GetHandle(), &offset, (size_t)std::min(length - written, (PInt64)0x40000000));
+    if (result > 0) {
+      written += result;
+      continue;
+    }
+
+    if (result == 0)
+      break; // File truncated underneath us
+
+    if (errno == EINTR)
+      continue;
+
+    if (errno == EWOULDBLOCK && writeTimeout > 0) {
+      if (PXSetIOBlock(PXWriteBlock, writeTimeout))
+        continue;
+      return false;
+    }
+
+    // Some file systems cannot do sendfile(), fall back to reading
+    if (written == 0 && (errno == EINVAL || errno == ENOSYS)) {
+      PTRACE(4, "sendfile() not supported for " << file.GetFilePath() << ", using read/write");
+      break;
+    }
+
+    return ConvertOSError(-1, LastWriteError);
+  }
+
+  if (!file.SetPosition(offset))
+    return false;
+#endif // P_HAS_SENDFILE
+
+  if (written < length) {
+    PBYTEArray buffer((PINDEX)std::min(length - written, (PInt64)65536));
+    while (written < length) {
+      if (!file.Read(buffer.GetPointer(), (PINDEX)std::min(length - written, (PInt64)buffer.GetSize())))
+        return false;
+      if (!Write(buffer, file.GetLastReadCount()))
+        return false;
+      written += file.GetLastReadCount();
+    }
+  }
+
+  SetLastWriteCount((PINDEX)written);
+  return written == length;
+}
+
+
 void PTCPSocket::OnOutOfBand(const void *, PINDEX)
 {
 }
@@ -2568,6 +2938,7 @@ bool PIPDatagramSocket::InternalWriteTo(const Slice * slices, size_t sliceCount,
 // PUDPSocket
 
 PUDPSocket::PUDPSocket(WORD newPort, int iAddressFamily)
+  : m_receiveCoalescing(false)
 {
   SetPort(newPort);
   OpenSocket(iAddressFamily);
@@ -2575,6 +2946,7 @@ PUDPSocket::PUDPSocket(WORD newPort, int iAddressFamily)
 
 
 PUDPSocket::PUDPSocket(const PString & service, int iAddressFamily)
+  : m_receiveCoalescing(false)
 {
   SetPort(service);
   OpenSocket(iAddressFamily);
@@ -2582,6 +2954,7 @@ PUDPSocket::PUDPSocket(const PString & service, int iAddressFamily)
 
 
 PUDPSocket::PUDPSocket(const PString & address, WORD newPort)
+  : m_receiveCoalescing(false)
 {
   SetSendAddress(PIPSocketAddressAndPort());
   SetPort(newPort);
@@ -2590,6 +2963,7 @@ PUDPSocket::PUDPSocket(const PString & address, WORD newPort)
 
 
 PUDPSocket::PUDPSocket(const PString & address, const PString & service)
+  : m_receiveCoalescing(false)
 {
   SetSendAddress(PIPSocketAddressAndPort());
   SetPort(service);
@@ -2795,6 +3169,243 @@ int PUDPSocket::GetCurrentMTU()
 }
 
 
+PINDEX PUDPSocket::ReadBatch(Datagram * datagrams, PINDEX count)
+{
+  SetLastReadCount(0);
+
+  if (count <= 0 || CheckNotOpen())
+    return 0;
+
+#if P_HAS_RECVMMSG
+  if (count > MaxBatchSize)
+    count = MaxBatchSize;
+
+  PIPSocket::sockaddr_wrapper addresses[MaxBatchSize];
+  struct iovec vectors[MaxBatchSize];
+  struct mmsghdr messages[MaxBatchSize];
+#ifdef UDP_GRO
+  char controls[MaxBatchSize][CMSG_SPACE(sizeof(int))];
+#endif
+
+  memset(messages, 0, count*sizeof(messages[0]));
+  for (PINDEX i = 0; i < count; ++i) {
+    vectors[i].iov_base = datagrams[i].m_data;
+    vectors[i].iov_len  = datagrams[i].m_size;
+    msghdr & hdr = messages[i].msg_hdr;
+    hdr.msg_name    = (sockaddr *)addresses[i];
+    hdr.msg_namelen = sizeof(sockaddr_storage);
+    hdr.msg_iov     = &vectors[i];
+    hdr.msg_iovlen  = 1;
+#ifdef UDP_GRO
+    if (m_receiveCoalescing) {
+      hdr.msg_control    = controls[i];
+      hdr.msg_controllen = sizeof(controls[i]);
+    }
+#endif
+  }
+
+  int result;
+  do {
+    PPROFILE_SYSTEM(
+      result = ::recvmmsg(os_handle, messages, count, 0, NULL);
+    );
+    if (ConvertOSError(result, LastReadError))
+      break;
+  } while (GetErrorNumber(LastReadError) == EWOULDBLOCK && PXSetIOBlock(PXReadBlock, readTimeout));
+
+  if (result <= 0)
+    return 0;
+
+  PINDEX total = 0;
+  bool anyTruncated = false;
+  for (int i = 0; i < result; ++i) {
+    Datagram & datagram = datagrams[i];
+    datagram.m_length = messages[i].msg_len;
+    datagram.m_ipAndPort.SetAddress(addresses[i].GetIP());
+    datagram.m_ipAndPort.SetPort(addresses[i].GetPort());
+    datagram.m_segmentSize = 0;
+    datagram.m_truncated = (messages[i].msg_hdr.msg_flags&MSG_TRUNC) != 0;
+    total += datagram.m_length;
+
+#ifdef UDP_GRO
+    msghdr & hdr = messages[i].msg_hdr;
+    for (struct cmsghdr * cmsg = CMSG_FIRSTHDR(&hdr); cmsg != NULL; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+      if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+        int segmentSize;
+        memcpy(&segmentSize, CMSG_DATA(cmsg), sizeof(segmentSize));
+        datagram.m_segmentSize = segmentSize;
+      }
+    }
+#endif
+
+    if (datagram.m_truncated) {
+      PTRACE(4, "Truncated packet read in batch from " << datagram.m_ipAndPort);
+      anyTruncated = true;
+    }
+  }
+
+  if (anyTruncated)
+    SetErrorValues(BufferTooSmall, EMSGSIZE, LastReadError);
+
+  SetLastReadCount(total);
+  InternalSetLastReceiveAddress(datagrams[result-1].m_ipAndPort);
+  return result;
+#else
+  datagrams[0].m_segmentSize = 0;
+  datagrams[0].m_truncated = false;
+  if (!ReadFrom(datagrams[0].m_data, datagrams[0].m_size, datagrams[0].m_ipAndPort)) {
+    if (GetErrorCode(LastReadError) != BufferTooSmall)
+      return 0;
+    datagrams[0].m_truncated = true;
+  }
+  datagrams[0].m_length = GetLastReadCount();
+  return 1;
+#endif
+}
+
+
+#if P_HAS_RECVMMSG && PTRACING
+static PTrace::Throttle<2, 10000, 5> s_NoBufsBatchThrottle;
+#endif
+
+PINDEX PUDPSocket::WriteBatch(Datagram * datagrams, PINDEX count)
+{
+  SetLastWriteCount(0);
+
+  if (count <= 0 || CheckNotOpen())
+    return 0;
+
+#if P_HAS_RECVMMSG
+  PIPSocketAddressAndPort sendAddress;
+  InternalGetSendAddress(sendAddress);
+
+  sockaddr_storage addresses[MaxBatchSize];
+  struct iovec vectors[MaxBatchSize];
+  struct mmsghdr messages[MaxBatchSize];
+#ifdef UDP_SEGMENT
+  char controls[MaxBatchSize][CMSG_SPACE(sizeof(uint16_t))];
+#endif
+
+  PINDEX total = 0;
+  PINDEX sent = 0;
+  while (sent < count) {
+    PINDEX batch = std::min(count - sent, (PINDEX)MaxBatchSize);
+
+    memset(messages, 0, batch*sizeof(messages[0]));
+    for (PINDEX i = 0; i < batch; ++i) {
+      Datagram & datagram = datagrams[sent+i];
+      datagram.m_length = 0;
+
+      const PIPSocketAddressAndPort & ap = datagram.m_ipAndPort.IsValid() ? datagram.m_ipAndPort : sendAddress;
+      if (!ap.IsValid() || ap.GetPort() == 0) {
+        SetErrorValues(BadParameter, EINVAL, LastWriteError);
+        batch = i;
+        break;
+      }
+
+      PIPSocket::sockaddr_wrapper sa(ap);
+      memcpy(&addresses[i], (sockaddr *)sa, sa.GetSize());
+
+      vectors[i].iov_base = datagram.m_data;
+      vectors[i].iov_len  = datagram.m_size;
+      msghdr & hdr = messages[i].msg_hdr;
+      hdr.msg_name    = &addresses[i];
+      hdr.msg_namelen = sa.GetSize();
+      hdr.msg_iov     = &vectors[i];
+      hdr.msg_iovlen  = 1;
+
+#ifdef UDP_SEGMENT
+      if (datagram.m_segmentSize > 0 && datagram.m_segmentSize < datagram.m_size) {
+        hdr.msg_control    = controls[i];
+        hdr.msg_controllen = sizeof(controls[i]);
+        struct cmsghdr * cmsg = CMSG_FIRSTHDR(&hdr);
+        cmsg->cmsg_level = SOL_UDP;
+        cmsg->cmsg_type  = UDP_SEGMENT;
+        cmsg->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+        uint16_t segmentSize = (uint16_t)datagram.m_segmentSize;
+        memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+      }
+#endif
+    }
+
+    if (batch == 0)
+      break;
+
+    int result;
+    unsigned noBufferRetry = 0;
+    for (;;) {
+      PPROFILE_SYSTEM(
+        result = ::sendmmsg(os_handle, messages, batch, 0);
+      );
+      if (ConvertOSError(result, LastWriteError))
+        break;
+
+      // Same handling as PSocket::os_vwrite() for a single datagram
+      if (GetErrorNumber(LastWriteError) == ENOBUFS) {
+        if (NoBufferRetryCount == 0 || ++noBufferRetry > NoBufferRetryCount)
+          break;
+        usleep(100);
+      }
+      else if (GetErrorNumber(LastWriteError) != EWOULDBLOCK || !PXSetIOBlock(PXWriteBlock, writeTimeout))
+        break;
+    }
+
+    PTRACE_IF(s_NoBufsBatchThrottle, noBufferRetry > 0, "PTLib",
+              "WARNING: No buffer space available for " << noBufferRetry << " retries of socket batch write" << s_NoBufsBatchThrottle);
+
+    if (result < 0 && NoBufferRetryCount == 0 && GetErrorNumber(LastWriteError) == ENOBUFS) {
+      // Ignore error if retries disabled, the first datagram is dropped
+      messages[0].msg_len = 0;
+      result = 1;
+    }
+
+    if (result <= 0)
+      break;
+
+    for (int i = 0; i < result; ++i) {
+      datagrams[sent+i].m_length = messages[i].msg_len;
+      total += messages[i].msg_len;
+    }
+    sent += result;
+  }
+
+  SetLastWriteCount(total);
+  return sent;
+#else
+  PIPSocketAddressAndPort sendAddress;
+  InternalGetSendAddress(sendAddress);
+
+  PINDEX total = 0;
+  PINDEX sent;
+  for (sent = 0; sent < count; ++sent) {
+    Datagram & datagram = datagrams[sent];
+    Slice slice(datagram.m_data, datagram.m_size);
+    if (!PIPDatagramSocket::InternalWriteTo(&slice, 1, datagram.m_ipAndPort.IsValid() ? datagram.m_ipAndPort : sendAddress))
+      break;
+    datagram.m_length = GetLastWriteCount();
+    total += datagram.m_length;
+  }
+
+  SetLastWriteCount(total);
+  return sent;
+#endif
+}
+
+
+bool PUDPSocket::SetReceiveCoalescing(bool enable)
+{
+#if P_HAS_RECVMMSG && defined(UDP_GRO)
+  if (!SetOption(UDP_GRO, enable ? 1 : 0, SOL_UDP))
+    return false;
+
+  m_receiveCoalescing = enable;
+  return true;
+#else
+  return !enable;
+#endif
+}
+
+
 //////////////////////////////////////////////////////////////////////////////
 
 PBoolean PICMPSocket::OpenSocket(int)
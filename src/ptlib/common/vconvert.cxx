@@ -37,6 +37,7 @@
 #endif
 
 #include <ptlib/vconvert.h>
+#include <ptlib/pprocess.h>
 
 #if P_TINY_JPEG
   #include "tinyjpeg.h"
@@ -103,6 +104,22 @@
 #endif
 
 
+/* The same size RGB/YUV420P and packed YUV 4:2:2 conversions have SSE4.1
+   and AVX2 versions, used according to the CPU, determined at run time. */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  #include <immintrin.h>
+  #define P_VCONVERT_SIMD 1
+  static PColourConverter::Acceleration const SupportedAcceleration =
+                __builtin_cpu_supports("avx2")   ? PColourConverter::e_AVX2
+              : __builtin_cpu_supports("sse4.1") ? PColourConverter::e_SSE41
+                                                 : PColourConverter::e_NoAcceleration;
+#else
+  #define P_VCONVERT_SIMD 0
+  static PColourConverter::Acceleration const SupportedAcceleration = PColourConverter::e_NoAcceleration;
+#endif
+static PColourConverter::Acceleration CurrentAcceleration = SupportedAcceleration;
+
+
 class PStandardColourConverter : public PColourConverter
 {
     PCLASSINFO(PStandardColourConverter, PColourConverter);
@@ -320,6 +337,7 @@ PColourConverter::PColourConverter(const PColourPair & colours)
   , m_dstFrameHeight(0)
   , m_dstFrameBytes(0)
   , m_resizeMode(PVideoFrameInfo::eScale)
+  , m_scaleQuality(e_NearestNeighbour)
   , m_verticalFlip(false)
 {
 }
@@ -333,6 +351,20 @@ void PColourConverter::PrintOn(ostream & strm) const
 }
 
 
+PColourConverter::Acceleration PColourConverter::SetAcceleration(Acceleration maximum)
+{
+  CurrentAcceleration = std::min(maximum, SupportedAcceleration);
+  PTRACE(4, NULL, PTraceModule(), "Set acceleration to " << CurrentAcceleration << ", supported " << SupportedAcceleration);
+  return CurrentAcceleration;
+}
+
+
+PColourConverter::Acceleration PColourConverter::GetAcceleration()
+{
+  return CurrentAcceleration;
+}
+
+
 PBoolean PColourConverter::SetFrameSize(unsigned width, unsigned height)
 {
   if (m_srcFrameWidth == width && m_srcFrameHeight == height &&
@@ -495,6 +527,215 @@ void PColourConverter::RGBtoYUV(unsigned r, unsigned g, unsigned b,
 }
 
 
+#if P_VCONVERT_SIMD
+
+/* The SIMD versions give exactly the same results as the functions above.
+   Red and green are put in the two 16 bit halves of each 32 bit lane, blue
+   in a separate vector, so _mm_madd_epi16() does most of the arithmetic. */
+
+// Pack two 16 bit multipliers for _mm_madd_epi16()
+#define P_PAIR16(lo, hi) ((int)(((unsigned)(lo) & 0xffff) | ((unsigned)(hi) << 16)))
+
+static void MakeRGBShuffles(char rg[16], char b[16], unsigned rgbIncrement, unsigned redOffset, unsigned blueOffset)
+{
+  for (unsigned i = 0; i < 4; ++i) {
+    rg[i*4+0] = (char)(i*rgbIncrement + redOffset);
+    rg[i*4+1] = -1;
+    rg[i*4+2] = (char)(i*rgbIncrement + 1);
+    rg[i*4+3] = -1;
+    b[i*4+0] = (char)(i*rgbIncrement + blueOffset);
+    b[i*4+1] = b[i*4+2] = b[i*4+3] = -1;
+  }
+}
+
+
+// Exact for 0 to 300000, which covers all the possible values
+__attribute__((target("sse4.1")))
+static __inline __m128i DivideBy1000SSE41(__m128i x)
+{
+  return _mm_srli_epi32(_mm_mullo_epi32(_mm_srli_epi32(x, 3), _mm_set1_epi32(33555)), 22);
+}
+
+
+// As RGBtoU() and RGBtoV(), truncating towards zero, values over 255 saturate when packed
+__attribute__((target("sse4.1")))
+static __inline __m128i ChromaSSE41(__m128i rg, __m128i b, int rCoeff, int gCoeff, int bCoeff)
+{
+  __m128i c = _mm_add_epi32(_mm_madd_epi16(rg, _mm_set1_epi32(P_PAIR16(rCoeff, gCoeff))),
+                            _mm_madd_epi16(b, _mm_set1_epi32(bCoeff)));
+  __m128i q = _mm_add_epi32(_mm_sign_epi32(DivideBy1000SSE41(_mm_abs_epi32(c)), c), _mm_set1_epi32(128));
+  return _mm_andnot_si128(_mm_cmplt_epi32(c, _mm_set1_epi32(-127000)), q);
+}
+
+
+__attribute__((target("sse4.1")))
+static __inline __m128i LumaSSE41(__m128i rg, __m128i b)
+{
+  return DivideBy1000SSE41(_mm_add_epi32(_mm_madd_epi16(rg, _mm_set1_epi32(P_PAIR16(299, 587))),
+                                         _mm_madd_epi16(b, _mm_set1_epi32(114))));
+}
+
+
+/* Convert a pair of scan lines, 16 pixels at a time, from pixel x, returning
+   where it got up to. RGB24 reads four bytes past the last pixel used. */
+__attribute__((target("sse4.1")))
+static unsigned RGBtoYUV420PSSE41(const BYTE * rgb1, const BYTE * rgb2, BYTE * y1, BYTE * y2, BYTE * u, BYTE * v,
+                                  unsigned x, unsigned width, unsigned rgbIncrement, unsigned redOffset, unsigned blueOffset)
+{
+  char rgShuffle[16], bShuffle[16];
+  MakeRGBShuffles(rgShuffle, bShuffle, rgbIncrement, redOffset, blueOffset);
+  __m128i rgMask = _mm_loadu_si128((const __m128i *)rgShuffle);
+  __m128i bMask = _mm_loadu_si128((const __m128i *)bShuffle);
+
+  unsigned spare = rgbIncrement == 3 ? 2 : 0;
+  for (; x + 16 + spare <= width; x += 16) {
+    __m128i luma1[4], luma2[4], rgSum[4], bSum[4];
+    for (unsigned i = 0; i < 4; ++i) {
+      unsigned offset = (x + i*4)*rgbIncrement;
+      __m128i pixels1 = _mm_loadu_si128((const __m128i *)(rgb1 + offset));
+      __m128i pixels2 = _mm_loadu_si128((const __m128i *)(rgb2 + offset));
+      __m128i rg1 = _mm_shuffle_epi8(pixels1, rgMask);
+      __m128i rg2 = _mm_shuffle_epi8(pixels2, rgMask);
+      __m128i b1 = _mm_shuffle_epi8(pixels1, bMask);
+      __m128i b2 = _mm_shuffle_epi8(pixels2, bMask);
+      luma1[i] = LumaSSE41(rg1, b1);
+      luma2[i] = LumaSSE41(rg2, b2);
+      rgSum[i] = _mm_add_epi16(rg1, rg2);
+      bSum[i] = _mm_add_epi16(b1, b2);
+    }
+
+    _mm_storeu_si128((__m128i *)(y1 + x), _mm_packus_epi16(_mm_packus_epi32(luma1[0], luma1[1]),
+                                                           _mm_packus_epi32(luma1[2], luma1[3])));
+    _mm_storeu_si128((__m128i *)(y2 + x), _mm_packus_epi16(_mm_packus_epi32(luma2[0], luma2[1]),
+                                                           _mm_packus_epi32(luma2[2], luma2[3])));
+
+    // Add horizontal neighbours, the 16 bit halves cannot carry, then average the 2x2 block
+    __m128i rgAvg1 = _mm_srli_epi16(_mm_hadd_epi32(rgSum[0], rgSum[1]), 2);
+    __m128i rgAvg2 = _mm_srli_epi16(_mm_hadd_epi32(rgSum[2], rgSum[3]), 2);
+    __m128i bAvg1 = _mm_srli_epi16(_mm_hadd_epi32(bSum[0], bSum[1]), 2);
+    __m128i bAvg2 = _mm_srli_epi16(_mm_hadd_epi32(bSum[2], bSum[3]), 2);
+
+    __m128i uValues = _mm_packus_epi32(ChromaSSE41(rgAvg1, bAvg1, -147, -289, 436),
+                                       ChromaSSE41(rgAvg2, bAvg2, -147, -289, 436));
+    __m128i vValues = _mm_packus_epi32(ChromaSSE41(rgAvg1, bAvg1, 615, -515, -100),
+                                       ChromaSSE41(rgAvg2, bAvg2, 615, -515, -100));
+    _mm_storel_epi64((__m128i *)(u + x/2), _mm_packus_epi16(uValues, uValues));
+    _mm_storel_epi64((__m128i *)(v + x/2), _mm_packus_epi16(vValues, vValues));
+  }
+
+  return x;
+}
+
+
+__attribute__((target("avx2")))
+static __inline __m256i DivideBy1000AVX2(__m256i x)
+{
+  return _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_srli_epi32(x, 3), _mm256_set1_epi32(33555)), 22);
+}
+
+
+__attribute__((target("avx2")))
+static __inline __m256i ChromaAVX2(__m256i rg, __m256i b, int rCoeff, int gCoeff, int bCoeff)
+{
+  __m256i c = _mm256_add_epi32(_mm256_madd_epi16(rg, _mm256_set1_epi32(P_PAIR16(rCoeff, gCoeff))),
+                               _mm256_madd_epi16(b, _mm256_set1_epi32(bCoeff)));
+  __m256i q = _mm256_add_epi32(_mm256_sign_epi32(DivideBy1000AVX2(_mm256_abs_epi32(c)), c), _mm256_set1_epi32(128));
+  return _mm256_andnot_si256(_mm256_cmpgt_epi32(_mm256_set1_epi32(-127000), c), q);
+}
+
+
+__attribute__((target("avx2")))
+static __inline __m256i LumaAVX2(__m256i rg, __m256i b)
+{
+  return DivideBy1000AVX2(_mm256_add_epi32(_mm256_madd_epi16(rg, _mm256_set1_epi32(P_PAIR16(299, 587))),
+                                           _mm256_madd_epi16(b, _mm256_set1_epi32(114))));
+}
+
+
+// Four pixels in each 128 bit lane, as the shuffles cannot cross lanes
+__attribute__((target("avx2")))
+static __inline __m256i LoadRGBAVX2(const BYTE * rgb, unsigned rgbIncrement)
+{
+  return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)rgb)),
+                                 _mm_loadu_si128((const __m128i *)(rgb + 4*rgbIncrement)), 1);
+}
+
+
+// As RGBtoYUV420PSSE41() but 32 pixels at a time
+__attribute__((target("avx2")))
+static unsigned RGBtoYUV420PAVX2(const BYTE * rgb1, const BYTE * rgb2, BYTE * y1, BYTE * y2, BYTE * u, BYTE * v,
+                                 unsigned x, unsigned width, unsigned rgbIncrement, unsigned redOffset, unsigned blueOffset)
+{
+  char rgShuffle[16], bShuffle[16];
+  MakeRGBShuffles(rgShuffle, bShuffle, rgbIncrement, redOffset, blueOffset);
+  __m256i rgMask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)rgShuffle));
+  __m256i bMask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)bShuffle));
+
+  // Undo the interleaving of 128 bit lanes by the pack instructions
+  __m256i packOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+  unsigned spare = rgbIncrement == 3 ? 2 : 0;
+  for (; x + 32 + spare <= width; x += 32) {
+    __m256i luma1[4], luma2[4], rgSum[4], bSum[4];
+    for (unsigned i = 0; i < 4; ++i) {
+      unsigned offset = (x + i*8)*rgbIncrement;
+      __m256i pixels1 = LoadRGBAVX2(rgb1 + offset, rgbIncrement);
+      __m256i pixels2 = LoadRGBAVX2(rgb2 + offset, rgbIncrement);
+      __m256i rg1 = _mm256_shuffle_epi8(pixels1, rgMask);
+      __m256i rg2 = _mm256_shuffle_epi8(pixels2, rgMask);
+      __m256i b1 = _mm256_shuffle_epi8(pixels1, bMask);
+      __m256i b2 = _mm256_shuffle_epi8(pixels2, bMask);
+      luma1[i] = LumaAVX2(rg1, b1);
+      luma2[i] = LumaAVX2(rg2, b2);
+      rgSum[i] = _mm256_add_epi16(rg1, rg2);
+      bSum[i] = _mm256_add_epi16(b1, b2);
+    }
+
+    _mm256_storeu_si256((__m256i *)(y1 + x),
+                        _mm256_permutevar8x32_epi32(_mm256_packus_epi16(_mm256_packus_epi32(luma1[0], luma1[1]),
+                                                                        _mm256_packus_epi32(luma1[2], luma1[3])), packOrder));
+    _mm256_storeu_si256((__m256i *)(y2 + x),
+                        _mm256_permutevar8x32_epi32(_mm256_packus_epi16(_mm256_packus_epi32(luma2[0], luma2[1]),
+                                                                        _mm256_packus_epi32(luma2[2], luma2[3])), packOrder));
+
+    // The horizontal add interleaves 64 bit blocks across the lanes, put them back in order
+    __m256i rgAvg1 = _mm256_permute4x64_epi64(_mm256_srli_epi16(_mm256_hadd_epi32(rgSum[0], rgSum[1]), 2), _MM_SHUFFLE(3, 1, 2, 0));
+    __m256i rgAvg2 = _mm256_permute4x64_epi64(_mm256_srli_epi16(_mm256_hadd_epi32(rgSum[2], rgSum[3]), 2), _MM_SHUFFLE(3, 1, 2, 0));
+    __m256i bAvg1 = _mm256_permute4x64_epi64(_mm256_srli_epi16(_mm256_hadd_epi32(bSum[0], bSum[1]), 2), _MM_SHUFFLE(3, 1, 2, 0));
+    __m256i bAvg2 = _mm256_permute4x64_epi64(_mm256_srli_epi16(_mm256_hadd_epi32(bSum[2], bSum[3]), 2), _MM_SHUFFLE(3, 1, 2, 0));
+
+    __m256i uValues = _mm256_packus_epi32(ChromaAVX2(rgAvg1, bAvg1, -147, -289, 436),
+                                          ChromaAVX2(rgAvg2, bAvg2, -147, -289, 436));
+    __m256i vValues = _mm256_packus_epi32(ChromaAVX2(rgAvg1, bAvg1, 615, -515, -100),
+                                          ChromaAVX2(rgAvg2, bAvg2, 615, -515, -100));
+    _mm_storeu_si128((__m128i *)(u + x/2),
+                     _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_packus_epi16(uValues, uValues), packOrder)));
+    _mm_storeu_si128((__m128i *)(v + x/2),
+                     _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(_mm256_packus_epi16(vValues, vValues), packOrder)));
+  }
+
+  return x;
+}
+
+#endif // P_VCONVERT_SIMD
+
+
+/* Convert as much of a pair of scan lines as the SIMD versions can do,
+   returning the pixel the plain C++ needs to continue from. */
+static unsigned RGBtoYUV420PSIMD(const BYTE * rgb1, const BYTE * rgb2, BYTE * y1, BYTE * y2, BYTE * u, BYTE * v,
+                                 unsigned width, unsigned rgbIncrement, unsigned redOffset, unsigned blueOffset)
+{
+  unsigned x = 0;
+#if P_VCONVERT_SIMD
+  if (CurrentAcceleration >= PColourConverter::e_AVX2)
+    x = RGBtoYUV420PAVX2(rgb1, rgb2, y1, y2, u, v, x, width, rgbIncrement, redOffset, blueOffset);
+  if (CurrentAcceleration >= PColourConverter::e_SSE41)
+    x = RGBtoYUV420PSSE41(rgb1, rgb2, y1, y2, u, v, x, width, rgbIncrement, redOffset, blueOffset);
+#endif
+  return x;
+}
+
+
 class PRasterDutyCycle
 {
   public:
@@ -787,11 +1028,501 @@ static bool ValidateDimensions(unsigned srcFrameWidth, unsigned srcFrameHeight,
 }
 
 
+///////////////////////////////////////////////////////////////////////////////
+
+/* A pool of threads to do large frames in horizontal stripes. The calling
+   thread does stripes of its own job too, so a busy pool, e.g. with lots of
+   streams converting at once, just means the caller does more of the work. */
+class PColourConverterThreadPool
+{
+  public:
+    typedef void (*StripeFunction)(void * context, unsigned stripe, unsigned stripes);
+
+    PColourConverterThreadPool()
+      : m_shuttingDown(false)
+    {
+    }
+
+    ~PColourConverterThreadPool()
+    {
+      SetSize(0);
+    }
+
+    void SetSize(unsigned count)
+    {
+      std::vector<PThread *> threads;
+      m_mutex.Wait();
+      threads.swap(m_threads);
+      m_shuttingDown = true;
+      m_mutex.Signal();
+
+      for (size_t i = 0; i < threads.size(); ++i)
+        m_available.Signal();
+      for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i]->WaitForTermination();
+        delete threads[i];
+      }
+
+      m_mutex.Wait();
+      m_shuttingDown = false;
+      for (unsigned i = 0; i < count; ++i)
+        m_threads.push_back(new PThreadObj<PColourConverterThreadPool>(*this, &PColourConverterThreadPool::WorkerMain,
+                                                                       false, "ColourConvert"));
+      m_mutex.Signal();
+      PTRACE(4, NULL, PTraceModule(), "Thread pool set to " << count << " threads");
+    }
+
+    unsigned GetSize() const
+    {
+      PWaitAndSignal lock(m_mutex);
+      return (unsigned)m_threads.size();
+    }
+
+    // Call function for each stripe, returning when all are done
+    void Run(StripeFunction function, void * context, unsigned stripes)
+    {
+      Job job(function, context, stripes);
+
+      m_mutex.Wait();
+      unsigned helpers = std::min(stripes-1, (unsigned)m_threads.size());
+      if (helpers > 0)
+        m_jobs.push_back(&job);
+      m_mutex.Signal();
+
+      for (unsigned i = 0; i < helpers; ++i)
+        m_available.Signal();
+
+      while (DoStripe(&job))
+        ;
+
+      job.m_finished.Wait();
+    }
+
+  protected:
+    struct Job
+    {
+      Job(StripeFunction function, void * context, unsigned stripes)
+        : m_function(function)
+        , m_context(context)
+        , m_stripes(stripes)
+        , m_next(0)
+        , m_done(0)
+      {
+      }
+
+      StripeFunction   m_function;
+      void           * m_context;
+      unsigned         m_stripes;
+      unsigned         m_next;  // Protected by pool mutex
+      atomic<unsigned> m_done;
+      PSyncPoint       m_finished;
+    };
+
+    // Claim and do a stripe of the job, or if NULL, of the first queued job
+    bool DoStripe(Job * job)
+    {
+      m_mutex.Wait();
+
+      if (job == NULL) {
+        if (m_jobs.empty()) {
+          m_mutex.Signal();
+          return false;
+        }
+        job = m_jobs.front();
+      }
+
+      unsigned stripe = job->m_next;
+      if (stripe >= job->m_stripes) {
+        m_mutex.Signal();
+        return false;
+      }
+
+      // Last stripe claimed, no-one else may use the job
+      if (++job->m_next == job->m_stripes)
+        m_jobs.remove(job);
+
+      m_mutex.Signal();
+
+      job->m_function(job->m_context, stripe, job->m_stripes);
+      if (++job->m_done == job->m_stripes)
+        job->m_finished.Signal();
+      return true;
+    }
+
+    void WorkerMain()
+    {
+      for (;;) {
+        m_available.Wait();
+
+        m_mutex.Wait();
+        bool shuttingDown = m_shuttingDown;
+        m_mutex.Signal();
+        if (shuttingDown)
+          break;
+
+        while (DoStripe(NULL))
+          ;
+      }
+    }
+
+    PDECLARE_MUTEX(m_mutex);
+    std::list<Job *>       m_jobs;
+    PSemaphore             m_available;
+    std::vector<PThread *> m_threads;
+    bool                   m_shuttingDown;
+};
+
+static PColourConverterThreadPool ColourConverterThreadPool;
+
+
+// Stop the threads while the rest of the process is still there
+class PColourConverterStartup : public PProcessStartup
+{
+  PCLASSINFO(PColourConverterStartup, PProcessStartup);
+  public:
+    virtual void OnShutdown()
+    {
+      ColourConverterThreadPool.SetSize(0);
+    }
+};
+
+PFACTORY_CREATE(PProcessStartupFactory, PColourConverterStartup, "PColourConverterStartup", true);
+
+
+void PColourConverter::SetScaleThreads(unsigned count)
+{
+  ColourConverterThreadPool.SetSize(count);
+}
+
+
+unsigned PColourConverter::GetScaleThreads()
+{
+  return ColourConverterThreadPool.GetSize();
+}
+
+
+// Number of stripes to use for a frame, at least this many rows in each
+static unsigned const MinimumStripeRows = 64;
+
+static unsigned CalculateStripes(unsigned rows)
+{
+  return std::max(1U, std::min(ColourConverterThreadPool.GetSize()+1, rows/MinimumStripeRows));
+}
+
+
+///////////////////////////////////////////////////////////////////////////////
+
+/* The bilinear/area scaler is separable, first each output row is made from
+   a weighted sum of source rows, then each output pixel from a weighted sum
+   of pixels in that row. The weights are fixed point, adding up to one, so
+   each step rounds once. The SIMD versions give exactly the same result. */
+
+#define ScaleWeightBits 14
+static int const ScaleWeightOne = 1 << ScaleWeightBits;
+static int const ScaleWeightHalf = 1 << (ScaleWeightBits-1);
+
+class PScaleAxis
+{
+  public:
+    /* The weights for each output pixel, m_taps of them from m_offset,
+       arranged in groups of m_group taps, all of one group for every
+       output, then the next group. */
+    PScaleAxis(unsigned srcSize, unsigned dstSize, unsigned group)
+      : m_size(dstSize)
+      , m_group(group)
+      , m_identity(srcSize == dstSize)
+    {
+      std::vector< std::vector<int> > weights(dstSize);
+      m_offset.resize(dstSize);
+
+      unsigned maxTaps = 1;
+      for (unsigned i = 0; i < dstSize; ++i) {
+        if (dstSize >= srcSize) {
+          // Bilinear, the centre of output pixel is at ((2i+1)*src/dst - 1)/2 in the source
+          int position = (int)((2*i+1)*srcSize) - (int)dstSize;
+          unsigned first = 0, fraction = 0;
+          if (position > 0) {
+            first = position / (2*dstSize);
+            fraction = position % (2*dstSize);
+          }
+          m_offset[i] = first;
+          int weight = (int)(((uint64_t)fraction*ScaleWeightOne + dstSize) / (2*dstSize));
+          if (weight == 0 || first + 1 >= srcSize)
+            weights[i].push_back(ScaleWeightOne);
+          else {
+            weights[i].push_back(ScaleWeightOne - weight);
+            weights[i].push_back(weight);
+          }
+        }
+        else {
+          // Area, output pixel i covers i*src to (i+1)*src, and source pixel j covers j*dst to (j+1)*dst
+          unsigned start = i*srcSize;
+          unsigned end = start + srcSize;
+          unsigned first = start / dstSize;
+          unsigned last = (end - 1) / dstSize;
+          m_offset[i] = first;
+          int total = 0;
+          size_t largest = 0;
+          for (unsigned j = first; j <= last; ++j) {
+            unsigned overlap = std::min(end, (j+1)*dstSize) - std::max(start, j*dstSize);
+            int weight = (int)(((uint64_t)overlap*ScaleWeightOne + srcSize/2) / srcSize);
+            if (!weights[i].empty() && weight > weights[i][largest])
+              largest = weights[i].size();
+            weights[i].push_back(weight);
+            total += weight;
+          }
+          // Rounding may not add up to exactly one
+          weights[i][largest] += ScaleWeightOne - total;
+        }
+        maxTaps = std::max(maxTaps, (unsigned)weights[i].size());
+      }
+
+      m_taps = (maxTaps + group - 1)/group*group;
+      m_weights.resize(dstSize*m_taps);
+      for (unsigned i = 0; i < dstSize; ++i) {
+        for (unsigned t = 0; t < weights[i].size(); ++t)
+          m_weights[((t/group)*dstSize + i)*group + t%group] = (int16_t)weights[i][t];
+      }
+    }
+
+    int GetWeight(unsigned i, unsigned t) const { return m_weights[((t/m_group)*m_size + i)*m_group + t%m_group]; }
+
+    // For the SIMD, the weights of all outputs for group g
+    const int16_t * GetGroup(unsigned g) const { return &m_weights[g*m_size*m_group]; }
+
+    std::vector<int>     m_offset;
+    std::vector<int16_t> m_weights;
+    unsigned             m_size;
+    unsigned             m_group;
+    unsigned             m_taps;
+    bool                 m_identity;
+};
+
+
+#if P_VCONVERT_SIMD
+
+/* Weighted sum of rows, pairs of rows are interleaved as 16 bit values for
+   _mm_madd_epi16(). There are an even number of rows, the last weight may
+   be zero. */
+__attribute__((target("sse4.1")))
+static unsigned ScaleColumnSSE41(const BYTE * const * rows, const int * weights, unsigned count,
+                                 BYTE * dst, unsigned x, unsigned width)
+{
+  __m128i half = _mm_set1_epi32(ScaleWeightHalf);
+  for (; x + 8 <= width; x += 8) {
+    __m128i sum1 = half, sum2 = half;
+    for (unsigned r = 0; r < count; r += 2) {
+      __m128i pair = _mm_set1_epi32(P_PAIR16(weights[r], weights[r+1]));
+      __m128i row1 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(rows[r] + x)));
+      __m128i row2 = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)(rows[r+1] + x)));
+      sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpacklo_epi16(row1, row2), pair));
+      sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpackhi_epi16(row1, row2), pair));
+    }
+    __m128i value = _mm_packs_epi32(_mm_srai_epi32(sum1, ScaleWeightBits), _mm_srai_epi32(sum2, ScaleWeightBits));
+    _mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(value, value));
+  }
+  return x;
+}
+
+
+/* Weighted sum of four consecutive pixels from the offset, for each group of
+   four taps. Pairs of taps are added by _mm_madd_epi16(), then pairs of those
+   by _mm_hadd_epi32(), giving a value for each of four output pixels. */
+__attribute__((target("sse4.1")))
+static unsigned ScaleRowSSE41(const BYTE * src, const PScaleAxis & axis, BYTE * dst, unsigned x, unsigned width)
+{
+  __m128i half = _mm_set1_epi32(ScaleWeightHalf);
+  const int * offset = &axis.m_offset[0];
+  for (; x + 4 <= width; x += 4) {
+    __m128i sum = half;
+    for (unsigned g = 0; g < axis.m_taps; g += 4) {
+      uint32_t taps[4];
+      for (unsigned i = 0; i < 4; ++i)
+        memcpy(&taps[i], src + offset[x+i] + g, 4);
+      __m128i pixels = _mm_loadu_si128((const __m128i *)taps);
+      const int16_t * weights = axis.GetGroup(g/4) + x*4;
+      __m128i sum1 = _mm_madd_epi16(_mm_cvtepu8_epi16(pixels), _mm_loadu_si128((const __m128i *)weights));
+      __m128i sum2 = _mm_madd_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(pixels, 8)), _mm_loadu_si128((const __m128i *)(weights+8)));
+      sum = _mm_add_epi32(sum, _mm_hadd_epi32(sum1, sum2));
+    }
+    __m128i value = _mm_packs_epi32(_mm_srai_epi32(sum, ScaleWeightBits), _mm_setzero_si128());
+    uint32_t bytes = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(value, value));
+    memcpy(dst + x, &bytes, 4);
+  }
+  return x;
+}
+
+
+// As ScaleColumnSSE41() but 16 pixels at a time
+__attribute__((target("avx2")))
+static unsigned ScaleColumnAVX2(const BYTE * const * rows, const int * weights, unsigned count,
+                                BYTE * dst, unsigned x, unsigned width)
+{
+  __m256i half = _mm256_set1_epi32(ScaleWeightHalf);
+  for (; x + 16 <= width; x += 16) {
+    __m256i sum1 = half, sum2 = half;
+    for (unsigned r = 0; r < count; r += 2) {
+      __m256i pair = _mm256_set1_epi32(P_PAIR16(weights[r], weights[r+1]));
+      __m256i row1 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[r] + x)));
+      __m256i row2 = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(rows[r+1] + x)));
+      sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(_mm256_unpacklo_epi16(row1, row2), pair));
+      sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(_mm256_unpackhi_epi16(row1, row2), pair));
+    }
+    // The unpacks and packs both work within 128 bit lanes, so cancel out
+    __m256i value = _mm256_packs_epi32(_mm256_srai_epi32(sum1, ScaleWeightBits), _mm256_srai_epi32(sum2, ScaleWeightBits));
+    value = _mm256_permute4x64_epi64(_mm256_packus_epi16(value, value), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i *)(dst + x), _mm256_castsi256_si128(value));
+  }
+  return x;
+}
+
+
+// As ScaleRowSSE41() but 8 pixels at a time, using a gather for the taps
+__attribute__((target("avx2")))
+static unsigned ScaleRowAVX2(const BYTE * src, const PScaleAxis & axis, BYTE * dst, unsigned x, unsigned width)
+{
+  __m256i half = _mm256_set1_epi32(ScaleWeightHalf);
+  __m256i haddOrder = _mm256_setr_epi32(0, 1, 4, 5, 2, 3, 6, 7);
+  const int * offset = &axis.m_offset[0];
+  for (; x + 8 <= width; x += 8) {
+    __m256i sum = _mm256_setzero_si256();
+    __m256i offsets = _mm256_loadu_si256((const __m256i *)(offset + x));
+    for (unsigned g = 0; g < axis.m_taps; g += 4) {
+      __m256i pixels = _mm256_i32gather_epi32((const int *)(src + g), offsets, 1);
+      const int16_t * weights = axis.GetGroup(g/4) + x*4;
+      __m256i sum1 = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(pixels)),
+                                       _mm256_loadu_si256((const __m256i *)weights));
+      __m256i sum2 = _mm256_madd_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(pixels, 1)),
+                                       _mm256_loadu_si256((const __m256i *)(weights+16)));
+      // Outputs are in order 0, 1, 4, 5, 2, 3, 6, 7
+      sum = _mm256_add_epi32(sum, _mm256_hadd_epi32(sum1, sum2));
+    }
+    sum = _mm256_add_epi32(_mm256_permutevar8x32_epi32(sum, haddOrder), half);
+    __m128i value = _mm_packs_epi32(_mm256_castsi256_si128(_mm256_srai_epi32(sum, ScaleWeightBits)),
+                                    _mm256_extracti128_si256(_mm256_srai_epi32(sum, ScaleWeightBits), 1));
+    _mm_storel_epi64((__m128i *)(dst + x), _mm_packus_epi16(value, value));
+  }
+  return x;
+}
+
+#endif // P_VCONVERT_SIMD
+
+
+static void ScaleColumn(const BYTE * const * rows, const int * weights, unsigned count, BYTE * dst, unsigned width)
+{
+  unsigned x = 0;
+#if P_VCONVERT_SIMD
+  if (CurrentAcceleration >= PColourConverter::e_AVX2)
+    x = ScaleColumnAVX2(rows, weights, count, dst, x, width);
+  if (CurrentAcceleration >= PColourConverter::e_SSE41)
+    x = ScaleColumnSSE41(rows, weights, count, dst, x, width);
+#endif
+
+  for (; x < width; ++x) {
+    int sum = ScaleWeightHalf;
+    for (unsigned r = 0; r < count; ++r)
+      sum += weights[r]*rows[r][x];
+    dst[x] = (BYTE)(sum >> ScaleWeightBits);
+  }
+}
+
+
+// The source must have m_taps bytes readable past the last pixel
+static void ScaleRow(const BYTE * src, const PScaleAxis & axis, BYTE * dst)
+{
+  unsigned x = 0;
+#if P_VCONVERT_SIMD
+  if (CurrentAcceleration >= PColourConverter::e_AVX2)
+    x = ScaleRowAVX2(src, axis, dst, x, axis.m_size);
+  if (CurrentAcceleration >= PColourConverter::e_SSE41)
+    x = ScaleRowSSE41(src, axis, dst, x, axis.m_size);
+#endif
+
+  for (; x < axis.m_size; ++x) {
+    const BYTE * pixel = src + axis.m_offset[x];
+    int sum = ScaleWeightHalf;
+    for (unsigned t = 0; t < axis.m_taps; ++t)
+      sum += axis.GetWeight(x, t)*pixel[t];
+    dst[x] = (BYTE)(sum >> ScaleWeightBits);
+  }
+}
+
+
+struct PScalePlane
+{
+  PScalePlane(const BYTE * srcPtr, unsigned srcWidth, unsigned srcHeight, unsigned srcLineSpan,
+              BYTE * dstPtr, unsigned dstWidth, unsigned dstHeight, int dstLineSpan)
+    : m_srcPtr(srcPtr)
+    , m_srcWidth(srcWidth)
+    , m_srcLineSpan(srcLineSpan)
+    , m_dstPtr(dstPtr)
+    , m_dstLineSpan(dstLineSpan)
+    , m_horizontal(srcWidth, dstWidth, 4)
+    , m_vertical(srcHeight, dstHeight, 1)
+  {
+  }
+
+  void ScaleRows(unsigned firstRow, unsigned lastRow) const
+  {
+    // Intermediate row, padded for reading unused taps
+    std::vector<BYTE> intermediate(m_srcWidth + m_horizontal.m_taps);
+    std::vector<const BYTE *> rows(m_vertical.m_taps+1);
+    std::vector<int> weights(m_vertical.m_taps+1);
+
+    for (unsigned y = firstRow; y < lastRow; ++y) {
+      BYTE * dstRow = m_dstPtr + (int)y*m_dstLineSpan;
+      BYTE * columnOutput = m_horizontal.m_identity ? dstRow : &intermediate[0];
+
+      unsigned count = 0;
+      for (unsigned t = 0; t < m_vertical.m_taps; ++t) {
+        int weight = m_vertical.GetWeight(y, t);
+        if (weight != 0) {
+          rows[count] = m_srcPtr + (m_vertical.m_offset[y] + t)*m_srcLineSpan;
+          weights[count++] = weight;
+        }
+      }
+
+      if (count == 1)
+        memcpy(columnOutput, rows[0], m_srcWidth);
+      else {
+        if (count & 1) {
+          rows[count] = rows[0];
+          weights[count] = 0;
+        }
+        ScaleColumn(&rows[0], &weights[0], (count+1)&~1, columnOutput, m_srcWidth);
+      }
+
+      if (!m_horizontal.m_identity)
+        ScaleRow(&intermediate[0], m_horizontal, dstRow);
+    }
+  }
+
+  const BYTE * m_srcPtr;
+  unsigned     m_srcWidth;
+  unsigned     m_srcLineSpan;
+  BYTE       * m_dstPtr;
+  int          m_dstLineSpan;
+  PScaleAxis   m_horizontal;
+  PScaleAxis   m_vertical;
+};
+
+
+static void ScaleStripe(void * context, unsigned stripe, unsigned stripes)
+{
+  const PScalePlane * planes = (const PScalePlane *)context;
+  for (unsigned p = 0; p < 3; ++p) {
+    unsigned height = planes[p].m_vertical.m_size;
+    planes[p].ScaleRows(height*stripe/stripes, height*(stripe+1)/stripes);
+  }
+}
+
+
 bool PColourConverter::CopyYUV420P(unsigned srcX, unsigned srcY, unsigned srcWidth, unsigned srcHeight,
                                    unsigned srcFrameWidth, unsigned srcFrameHeight, const BYTE * srcYUV,
                                    unsigned dstX, unsigned dstY, unsigned dstWidth, unsigned dstHeight,
                                    unsigned dstFrameWidth, unsigned dstFrameHeight, BYTE * dstYUV,
-                                   PVideoFrameInfo::ResizeMode resizeMode, bool verticalFlip, std::ostream * error)
+                                   PVideoFrameInfo::ResizeMode resizeMode, bool verticalFlip, std::ostream * error,
+                                   ScaleQuality scaleQuality)
 {
   if (srcX == 0 && srcY == 0 && dstX == 0 && dstY == 0 &&
       srcWidth == dstWidth && srcHeight == dstHeight &&
@@ -811,7 +1542,7 @@ bool PColourConverter::CopyYUV420P(unsigned srcX, unsigned srcY, unsigned srcWid
       FillYUV420P(dstX+dstWidth-ouputX, dstY, ouputX, dstHeight, dstFrameWidth, dstFrameHeight, dstYUV, 0, 0, 0);
       return CopyYUV420P(srcX, srcY, srcWidth, srcHeight, srcFrameWidth, srcFrameHeight, srcYUV,
                          dstX+ouputX, dstY, outputWidth, dstHeight, dstFrameWidth, dstFrameHeight, dstYUV,
-                         PVideoFrameInfo::eScale, verticalFlip, error);
+                         PVideoFrameInfo::eScale, verticalFlip, error, scaleQuality);
     }
     else if (srcWidthByDstHeight > dstWidthBySrcHeight) {
       unsigned outputHeight = (dstWidthBySrcHeight/srcWidth)&~1;
@@ -820,7 +1551,7 @@ bool PColourConverter::CopyYUV420P(unsigned srcX, unsigned srcY, unsigned srcWid
       FillYUV420P(dstX, dstY+dstHeight-outputY, dstWidth, outputY, dstFrameWidth, dstFrameHeight, dstYUV, 0, 0, 0);
       return CopyYUV420P(srcX, srcY, srcWidth, srcHeight, srcFrameWidth, srcFrameHeight, srcYUV,
                          dstX, dstY+outputY, dstWidth, outputHeight, dstFrameWidth, dstFrameHeight, dstYUV,
-                         PVideoFrameInfo::eScale, verticalFlip, error);
+                         PVideoFrameInfo::eScale, verticalFlip, error, scaleQuality);
     }
   }
 
@@ -904,10 +1635,13 @@ bool PColourConverter::CopyYUV420P(unsigned srcX, unsigned srcY, unsigned srcWid
 
   void(*rowFunction)(const BYTE * srcPtr, unsigned srcWidth, unsigned srcHeight, unsigned srcLineSpan,
                      BYTE * dstPtr, unsigned dstWidth, unsigned dstHeight, int dstFrameWidth) = CropYUV420P;
+  bool bilinear = false;
 
   switch (resizeMode) {
     default : // Scaling options
-      if (srcWidth > dstWidth)
+      if (scaleQuality == e_Bilinear && srcWidth > 1 && srcHeight > 1 && (srcWidth != dstWidth || srcHeight != dstHeight))
+        bilinear = true;
+      else if (srcWidth > dstWidth)
         rowFunction = ShrinkBothYUV420P;
       else if (srcWidth < dstWidth)
         rowFunction = GrowBothYUV420P;
@@ -969,8 +1703,15 @@ bool PColourConverter::CopyYUV420P(unsigned srcX, unsigned srcY, unsigned srcWid
     dstLineSpan = -dstLineSpan;
   }
 
+  std::vector<PScalePlane> planes;
+  if (bilinear)
+    planes.reserve(3);
+
   // Copy plane Y
-  rowFunction(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan);
+  if (bilinear)
+    planes.push_back(PScalePlane(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan));
+  else
+    rowFunction(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan);
 
   srcYUV += srcFrameWidth*srcFrameHeight;
   dstYUV += dstFrameWidth*dstFrameHeight;
@@ -996,18 +1737,150 @@ bool PColourConverter::CopyYUV420P(unsigned srcX, unsigned srcY, unsigned srcWid
     dstPtr += (dstHeight - 1) * dstFrameWidth;
 
   // Copy plane U
-  rowFunction(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan);
+  if (bilinear)
+    planes.push_back(PScalePlane(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan));
+  else
+    rowFunction(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan);
 
   srcPtr += srcFrameWidth*srcFrameHeight;
   dstPtr += dstFrameWidth*dstFrameHeight;
 
   // Copy plane V
-  rowFunction(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan);
+  if (bilinear) {
+    planes.push_back(PScalePlane(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan));
+
+    unsigned stripes = CalculateStripes(planes[0].m_vertical.m_size);
+    if (stripes > 1)
+      ColourConverterThreadPool.Run(ScaleStripe, &planes[0], stripes);
+    else
+      ScaleStripe(&planes[0], 0, 1);
+  }
+  else
+    rowFunction(srcPtr, srcWidth, srcHeight, srcFrameWidth, dstPtr, dstWidth, dstHeight, dstLineSpan);
 
   return true;
 }
 
 
+/* Rotation by 90 degrees is done in square tiles, so the source rows and
+   destination columns being used stay in the cache, and whole tiles are
+   transposed with SIMD. */
+static int const RotateTileSize = 16;
+
+struct PRotatePlanes
+{
+  int m_angle;
+  struct {
+    unsigned m_width;
+    unsigned m_height;
+    const BYTE * m_src;
+    BYTE * m_dst;
+  } m_plane[3];
+};
+
+
+#if P_VCONVERT_SIMD
+
+/* Four rounds of interleaving row i with row i+8 transposes a 16x16 tile.
+   A negative srcSpan reverses the order of the source rows. */
+__attribute__((target("sse4.1")))
+static void TransposeTileSSE41(const BYTE * src, int srcSpan, BYTE * dst, int dstSpan)
+{
+  __m128i rows[16], next[16];
+  for (int i = 0; i < 16; ++i)
+    rows[i] = _mm_loadu_si128((const __m128i *)(src + i*srcSpan));
+
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < 8; ++i) {
+      next[2*i]   = _mm_unpacklo_epi8(rows[i], rows[i+8]);
+      next[2*i+1] = _mm_unpackhi_epi8(rows[i], rows[i+8]);
+    }
+    for (int i = 0; i < 16; ++i)
+      rows[i] = next[i];
+  }
+
+  for (int i = 0; i < 16; ++i)
+    _mm_storeu_si128((__m128i *)(dst + i*dstSpan), rows[i]);
+}
+
+
+// Reverse a scan line 16 pixels at a time, returning how many were done
+__attribute__((target("sse4.1")))
+static unsigned ReverseRowSSE41(const BYTE * src, BYTE * dstEnd, unsigned width)
+{
+  __m128i reverse = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+  unsigned x = 0;
+  for (; x + 16 <= width; x += 16)
+    _mm_storeu_si128((__m128i *)(dstEnd - x - 16), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + x)), reverse));
+  return x;
+}
+
+#endif // P_VCONVERT_SIMD
+
+
+static void RotateStripe(void * context, unsigned stripe, unsigned stripes)
+{
+  const PRotatePlanes & planes = *(const PRotatePlanes *)context;
+  bool simd = CurrentAcceleration >= PColourConverter::e_SSE41;
+
+  for (int p = 0; p < 3; ++p) {
+    int width = planes.m_plane[p].m_width;
+    int height = planes.m_plane[p].m_height;
+    const BYTE * src = planes.m_plane[p].m_src;
+    BYTE * dst = planes.m_plane[p].m_dst;
+
+    // Stripes are whole rows of tiles
+    int tileRows = (height + RotateTileSize - 1)/RotateTileSize;
+    int firstRow = tileRows*stripe/stripes*RotateTileSize;
+    int lastRow = std::min(height, (int)(tileRows*(stripe+1)/stripes*RotateTileSize));
+
+    if (planes.m_angle == 180) {
+      for (int y = firstRow; y < lastRow; ++y) {
+        const BYTE * srcRow = src + y*width;
+        BYTE * dstEnd = dst + (height-y)*width;
+        int x = 0;
+#if P_VCONVERT_SIMD
+        if (simd)
+          x = ReverseRowSSE41(srcRow, dstEnd, width);
+#endif
+        for (; x < width; ++x)
+          *(dstEnd - x - 1) = srcRow[x];
+      }
+      continue;
+    }
+
+    for (int y0 = firstRow; y0 < lastRow; y0 += RotateTileSize) {
+      int y1 = std::min(y0 + RotateTileSize, lastRow);
+      for (int x0 = 0; x0 < width; x0 += RotateTileSize) {
+        int x1 = std::min(x0 + RotateTileSize, width);
+
+#if P_VCONVERT_SIMD
+        if (simd && x1 - x0 == RotateTileSize && y1 - y0 == RotateTileSize) {
+          if (planes.m_angle == 90)
+            TransposeTileSSE41(src + (y1-1)*width + x0, -width, dst + x0*height + height - y1, height);
+          else
+            TransposeTileSSE41(src + y0*width + x0, width, dst + (width-1-x0)*height + y0, -height);
+          continue;
+        }
+#endif
+
+        for (int y = y0; y < y1; ++y) {
+          const BYTE * srcRow = src + y*width;
+          if (planes.m_angle == 90) {
+            for (int x = x0; x < x1; ++x)
+              dst[x*height + height-1-y] = srcRow[x];
+          }
+          else {
+            for (int x = x0; x < x1; ++x)
+              dst[(width-1-x)*height + y] = srcRow[x];
+          }
+        }
+      }
+    }
+  }
+}
+
+
 PRAGMA_OPTIMISE_ON()
 bool PColourConverter::RotateYUV420P(int angle, unsigned width, unsigned height, BYTE * srcYUV, BYTE * dstYUV)
 {
@@ -1031,53 +1904,19 @@ bool PColourConverter::RotateYUV420P(int angle, unsigned width, unsigned height,
 
   width  = (width+1)&~1;
   height = (height+1)&~1;
-  struct PlaneInfo {
-    unsigned int width;
-    unsigned int height;
-    BYTE * src;
-    BYTE * dst;
-  } plane[3] = {
-    { width,   height,   srcYUV,                  dstYUV                  },
-    { width/2, height/2, srcYUV+width*height,     dstYUV+width*height     },
-    { width/2, height/2, srcYUV+width*height*5/4, dstYUV+width*height*5/4 }
+  PRotatePlanes planes = {
+    angle, {
+      { width,   height,   srcYUV,                  dstYUV                  },
+      { width/2, height/2, srcYUV+width*height,     dstYUV+width*height     },
+      { width/2, height/2, srcYUV+width*height*5/4, dstYUV+width*height*5/4 }
+    }
   };
 
-  switch (angle) {
-    case -90 :
-      for (int p = 0; p < 3; ++p) {
-        plane[p].dst += plane[p].width*plane[p].height;
-        for (int y = plane[p].height; y > 0; --y) {
-          BYTE * tempY = plane[p].dst - y;
-          for (int x = plane[p].width; x > 0; --x) {
-            *tempY = *plane[p].src++;
-            tempY -= plane[p].height;
-          }
-        }
-      }
-      break;
-
-    case 90 :
-      for (int p = 0; p < 3; ++p) {
-        for (int y = plane[p].height-1; y >= 0; --y) {
-          BYTE * tempY = plane[p].dst + y;
-          for (int x = plane[p].width; x > 0; --x) {
-            *tempY = *plane[p].src++;
-            tempY += plane[p].height;
-          }
-        }
-      }
-      break;
-
-    case 180 :
-      for (int p = 0; p < 3; ++p) {
-        plane[p].dst += plane[p].width*plane[p].height;
-        for (int y = plane[p].height; y > 0; --y) {
-          for (int x = plane[p].width; x > 0; --x)
-            *--plane[p].dst = *plane[p].src++;
-        }
-      }
-      break;
-  }
+  unsigned stripes = CalculateStripes(height);
+  if (stripes > 1)
+    ColourConverterThreadPool.Run(RotateStripe, &planes, stripes);
+  else
+    RotateStripe(&planes, 0, 1);
 
   if (!storage.IsEmpty())
     memcpy(srcYUV, dstYUV, size);
@@ -1304,16 +2143,21 @@ bool PStandardColourConverter::RGBtoYUV420P(const BYTE * srcFrameBuffer,
   if (m_srcFrameWidth == scanLineSizeY && m_srcFrameHeight == planeHeight) {
     int RGBOffset[4] = { 0, (int)rgbIncrement, scanLineSizeRGB, scanLineSizeRGB+(int)rgbIncrement };
     unsigned YUVOffset[4] = { 0, 1, scanLineSizeY, scanLineSizeY + 1 };
-    scanLineSizeRGB *= 2;
-    rgbIncrement *= 2;
     for (unsigned y = 0; y < m_srcFrameHeight; y += 2) {
-      const BYTE * pixelPtrRGB = scanLinePtrRGB;
-      for (unsigned x = 0; x < m_srcFrameWidth; x += 2) {
+      unsigned x = RGBtoYUV420PSIMD(scanLinePtrRGB, scanLinePtrRGB + RGBOffset[2],
+                                    scanLinePtrY, scanLinePtrY + scanLineSizeY, scanLinePtrU, scanLinePtrV,
+                                    m_srcFrameWidth, rgbIncrement, redOffset, blueOffset);
+      const BYTE * pixelPtrRGB = scanLinePtrRGB + x*rgbIncrement;
+      scanLinePtrY += x;
+      scanLinePtrU += x/2;
+      scanLinePtrV += x/2;
+      for (; x < m_srcFrameWidth; x += 2) {
         unsigned rSum = 0, gSum = 0, bSum = 0;
         for (unsigned p = 0; p < 4; ++p) {
-          unsigned r = pixelPtrRGB[RGBOffset[p] +  redOffset];
-          unsigned g = pixelPtrRGB[RGBOffset[p] + greenOffset];
-          unsigned b = pixelPtrRGB[RGBOffset[p] +  blueOffset];
+          const BYTE * pixel = pixelPtrRGB + RGBOffset[p]; // Signed offset, negative when flipped
+          unsigned r = pixel[  redOffset];
+          unsigned g = pixel[greenOffset];
+          unsigned b = pixel[ blueOffset];
           scanLinePtrY[YUVOffset[p]] = RGBtoY(r, g, b);
           rSum += r;
           gSum += g;
@@ -1324,11 +2168,11 @@ bool PStandardColourConverter::RGBtoYUV420P(const BYTE * srcFrameBuffer,
         bSum /= 4;
         *scanLinePtrU++ = RGBtoU(rSum, gSum, bSum);
         *scanLinePtrV++ = RGBtoV(rSum, gSum, bSum);
-        pixelPtrRGB += rgbIncrement;
+        pixelPtrRGB += rgbIncrement*2;
         scanLinePtrY += 2;
       }
       scanLinePtrY += m_srcFrameWidth;
-      scanLinePtrRGB += scanLineSizeRGB;
+      scanLinePtrRGB += scanLineSizeRGB*2;
     }
   }
   else {
@@ -1415,6 +2259,84 @@ PSTANDARD_COLOUR_CONVERTER(BGR32,YUV420P)
   return RGBtoYUV420P(srcFrameBuffer, dstFrameBuffer, bytesReturned, 4, 2, 0);
 }
 
+
+#if P_VCONVERT_SIMD
+
+/* Shuffle eight pixels of packed YUV 4:2:2, as used by YUY2 and UYVY, into
+   eight Y values, then four U and four V. */
+static void MakePacked422Shuffle(char shuffle[16], unsigned yOffset, unsigned uOffset, unsigned vOffset)
+{
+  for (unsigned i = 0; i < 8; ++i)
+    shuffle[i] = (char)(i*2 + yOffset);
+  for (unsigned i = 0; i < 4; ++i) {
+    shuffle[i+8] = (char)(i*4 + uOffset);
+    shuffle[i+12] = (char)(i*4 + vOffset);
+  }
+}
+
+
+/* Convert a pair of scan lines, 16 pixels at a time, from pixel x, returning
+   where it got up to. As in the plain C++, the second line U and V is dropped. */
+__attribute__((target("sse4.1")))
+static unsigned Packed422toYUV420PSSE41(const BYTE * src1, const BYTE * src2, BYTE * y1, BYTE * y2, BYTE * u, BYTE * v,
+                                        unsigned x, unsigned width, const char * shuffle)
+{
+  __m128i mask = _mm_loadu_si128((const __m128i *)shuffle);
+  for (; x + 16 <= width; x += 16) {
+    __m128i a1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src1 + x*2)), mask);
+    __m128i b1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src1 + x*2 + 16)), mask);
+    __m128i a2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src2 + x*2)), mask);
+    __m128i b2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src2 + x*2 + 16)), mask);
+    _mm_storeu_si128((__m128i *)(y1 + x), _mm_unpacklo_epi64(a1, b1));
+    _mm_storeu_si128((__m128i *)(y2 + x), _mm_unpacklo_epi64(a2, b2));
+    __m128i uv = _mm_unpackhi_epi32(a1, b1);
+    _mm_storel_epi64((__m128i *)(u + x/2), uv);
+    _mm_storel_epi64((__m128i *)(v + x/2), _mm_unpackhi_epi64(uv, uv));
+  }
+  return x;
+}
+
+
+// As Packed422toYUV420PSSE41() but 32 pixels at a time
+__attribute__((target("avx2")))
+static unsigned Packed422toYUV420PAVX2(const BYTE * src1, const BYTE * src2, BYTE * y1, BYTE * y2, BYTE * u, BYTE * v,
+                                       unsigned x, unsigned width, const char * shuffle)
+{
+  __m256i mask = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)shuffle));
+  __m256i uvOrder = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+  for (; x + 32 <= width; x += 32) {
+    __m256i a1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src1 + x*2)), mask);
+    __m256i b1 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src1 + x*2 + 32)), mask);
+    __m256i a2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src2 + x*2)), mask);
+    __m256i b2 = _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i *)(src2 + x*2 + 32)), mask);
+    _mm256_storeu_si256((__m256i *)(y1 + x), _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a1, b1), _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm256_storeu_si256((__m256i *)(y2 + x), _mm256_permute4x64_epi64(_mm256_unpacklo_epi64(a2, b2), _MM_SHUFFLE(3, 1, 2, 0)));
+    __m256i uv = _mm256_permutevar8x32_epi32(_mm256_unpackhi_epi32(a1, b1), uvOrder);
+    _mm_storeu_si128((__m128i *)(u + x/2), _mm256_castsi256_si128(uv));
+    _mm_storeu_si128((__m128i *)(v + x/2), _mm256_extracti128_si256(uv, 1));
+  }
+  return x;
+}
+
+#endif // P_VCONVERT_SIMD
+
+
+static unsigned Packed422toYUV420PSIMD(const BYTE * src1, const BYTE * src2, BYTE * y1, BYTE * y2, BYTE * u, BYTE * v,
+                                       unsigned width, unsigned yOffset, unsigned uOffset, unsigned vOffset)
+{
+  unsigned x = 0;
+#if P_VCONVERT_SIMD
+  char shuffle[16];
+  MakePacked422Shuffle(shuffle, yOffset, uOffset, vOffset);
+  if (CurrentAcceleration >= PColourConverter::e_AVX2)
+    x = Packed422toYUV420PAVX2(src1, src2, y1, y2, u, v, x, width, shuffle);
+  if (CurrentAcceleration >= PColourConverter::e_SSE41)
+    x = Packed422toYUV420PSSE41(src1, src2, y1, y2, u, v, x, width, shuffle);
+#endif
+  return x;
+}
+
+
 /*
  * Format YUY2 or YUV422(non planar):
  *
@@ -1448,17 +2370,26 @@ void  PStandardColourConverter::YUY2toYUV420PSameSize(const BYTE *yuy2, BYTE *yu
   u = yuv420p + npixels;
   v = u + npixels/4;
 
+  unsigned lineWidth = (m_srcFrameWidth+1)&~1;
   for (h=0; h<m_srcFrameHeight; h+=2) {
+     unsigned done = Packed422toYUV420PSIMD(s, s + lineWidth*2, y, y + lineWidth, u, v, m_srcFrameWidth, 0, 1, 3);
+     s += done*2;
+     y += done;
+     u += done/2;
+     v += done/2;
 
      /* Copy the first line keeping all information */
-     for (x=0; x<m_srcFrameWidth; x+=2) {
+     for (x=done; x<m_srcFrameWidth; x+=2) {
         *y++ = *s++;
         *u++ = *s++;
         *y++ = *s++;
         *v++ = *s++;
      }
+     s += done*2;
+     y += done;
+
      /* Copy the second line discarding u and v information */
-     for (x=0; x<m_srcFrameWidth; x+=2) {
+     for (x=done; x<m_srcFrameWidth; x+=2) {
         *y++ = *s++;
         s++;
         *y++ = *s++;
@@ -1731,7 +2662,7 @@ PSTANDARD_COLOUR_CONVERTER(YUV420P,YUV420P)
 
   return CopyYUV420P(0, 0, m_srcFrameWidth, m_srcFrameHeight, m_srcFrameWidth, m_srcFrameHeight, srcFrameBuffer,
                      0, 0, m_dstFrameWidth, m_dstFrameHeight, m_dstFrameWidth, m_dstFrameHeight, dstFrameBuffer,
-                     m_resizeMode, m_verticalFlip);
+                     m_resizeMode, m_verticalFlip, NULL, m_scaleQuality);
 }
 
 /*
@@ -2018,6 +2949,178 @@ void PColourConverter::YUVtoRGB(unsigned y, unsigned u, unsigned v,
 }
 
 
+#if P_VCONVERT_SIMD
+
+/* The SIMD versions give exactly the same results as YUVtoRGB(). The U and V
+   are put in the two 16 bit halves of each 32 bit lane for _mm_madd_epi16(),
+   CLAMP() is done by the saturation of the pack instructions. The alpha byte
+   of RGB32 is zero, as in the plain C++. */
+
+__attribute__((target("sse4.1")))
+static __inline __m128i YUVtoRGBSSE41(__m128i y1, __m128i y2, __m128i d1, __m128i d2)
+{
+  __m128i value = _mm_packs_epi32(_mm_srai_epi32(_mm_add_epi32(y1, d1), ScaleBitShift),
+                                  _mm_srai_epi32(_mm_add_epi32(y2, d2), ScaleBitShift));
+  return _mm_packus_epi16(value, value);
+}
+
+
+// Eight pixels of one scan line
+__attribute__((target("sse4.1")))
+static __inline void YUV420PtoRGBPixelsSSE41(const BYTE * y, BYTE * rgb, unsigned rgbIncrement, unsigned redOffset,
+                                             const __m128i rd[2], const __m128i gd[2], const __m128i bd[2])
+{
+  __m128i luma = _mm_loadl_epi64((const __m128i *)y);
+  __m128i y1 = _mm_slli_epi32(_mm_cvtepu8_epi32(luma), ScaleBitShift);
+  __m128i y2 = _mm_slli_epi32(_mm_cvtepu8_epi32(_mm_srli_si128(luma, 4)), ScaleBitShift);
+  __m128i r = YUVtoRGBSSE41(y1, y2, rd[0], rd[1]);
+  __m128i g = YUVtoRGBSSE41(y1, y2, gd[0], gd[1]);
+  __m128i b = YUVtoRGBSSE41(y1, y2, bd[0], bd[1]);
+
+  __m128i firstGreen = _mm_unpacklo_epi8(redOffset == 0 ? r : b, g);
+  __m128i thirdAlpha = _mm_unpacklo_epi8(redOffset == 0 ? b : r, _mm_setzero_si128());
+  __m128i pixels1 = _mm_unpacklo_epi16(firstGreen, thirdAlpha);
+  __m128i pixels2 = _mm_unpackhi_epi16(firstGreen, thirdAlpha);
+  if (rgbIncrement == 4) {
+    _mm_storeu_si128((__m128i *)rgb, pixels1);
+    _mm_storeu_si128((__m128i *)(rgb + 16), pixels2);
+  }
+  else {
+    // Drop the alpha bytes, overlapping stores write four bytes past the last pixel
+    __m128i compact = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    _mm_storeu_si128((__m128i *)rgb, _mm_shuffle_epi8(pixels1, compact));
+    _mm_storeu_si128((__m128i *)(rgb + 12), _mm_shuffle_epi8(pixels2, compact));
+  }
+}
+
+
+/* Convert a pair of scan lines, 8 pixels at a time, from pixel x, returning
+   where it got up to. */
+__attribute__((target("sse4.1")))
+static unsigned YUV420PtoRGBSSE41(const BYTE * y1, const BYTE * y2, const BYTE * u, const BYTE * v, BYTE * rgb1, BYTE * rgb2,
+                                  unsigned x, unsigned width, unsigned rgbIncrement, unsigned redOffset)
+{
+  __m128i rCoeff = _mm_set1_epi32(P_PAIR16(0, YUVtoR_Coeff));
+  __m128i gCoeff = _mm_set1_epi32(P_PAIR16(YUVtoG_Coeff1, -YUVtoG_Coeff2));
+  __m128i bCoeff = _mm_set1_epi32(P_PAIR16(YUVtoB_Coeff, 0));
+  __m128i half = _mm_set1_epi32(HalfFixedScaling);
+  __m128i bias = _mm_set1_epi16(128);
+
+  unsigned spare = rgbIncrement == 3 ? 2 : 0;
+  for (; x + 8 + spare <= width; x += 8) {
+    uint32_t uBytes, vBytes;
+    memcpy(&uBytes, u + x/2, 4);
+    memcpy(&vBytes, v + x/2, 4);
+    __m128i cbcr = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(uBytes), _mm_cvtsi32_si128(vBytes))), bias);
+    __m128i rd = _mm_add_epi32(_mm_madd_epi16(cbcr, rCoeff), half);
+    __m128i gd = _mm_add_epi32(_mm_madd_epi16(cbcr, gCoeff), half);
+    __m128i bd = _mm_add_epi32(_mm_madd_epi16(cbcr, bCoeff), half);
+
+    // Each U and V is used for two horizontally adjacent pixels
+    __m128i rd2[2] = { _mm_unpacklo_epi32(rd, rd), _mm_unpackhi_epi32(rd, rd) };
+    __m128i gd2[2] = { _mm_unpacklo_epi32(gd, gd), _mm_unpackhi_epi32(gd, gd) };
+    __m128i bd2[2] = { _mm_unpacklo_epi32(bd, bd), _mm_unpackhi_epi32(bd, bd) };
+    YUV420PtoRGBPixelsSSE41(y1 + x, rgb1 + x*rgbIncrement, rgbIncrement, redOffset, rd2, gd2, bd2);
+    YUV420PtoRGBPixelsSSE41(y2 + x, rgb2 + x*rgbIncrement, rgbIncrement, redOffset, rd2, gd2, bd2);
+  }
+
+  return x;
+}
+
+
+// Values in 16 bits, clamped to 0..255
+__attribute__((target("avx2")))
+static __inline __m256i YUVtoRGBAVX2(__m256i y1, __m256i y2, __m256i d1, __m256i d2)
+{
+  __m256i value = _mm256_packs_epi32(_mm256_srai_epi32(_mm256_add_epi32(y1, d1), ScaleBitShift),
+                                     _mm256_srai_epi32(_mm256_add_epi32(y2, d2), ScaleBitShift));
+  return _mm256_max_epi16(_mm256_min_epi16(value, _mm256_set1_epi16(255)), _mm256_setzero_si256());
+}
+
+
+/* Sixteen pixels of one scan line. The pack interleaves 128 bit lanes, so
+   the 16 bit values are for pixels 0-3, 8-11, 4-7, 12-15, which the unpack
+   to 32 bits puts back into order. */
+__attribute__((target("avx2")))
+static __inline void YUV420PtoRGBPixelsAVX2(const BYTE * y, BYTE * rgb, unsigned rgbIncrement, unsigned redOffset,
+                                            const __m256i rd[2], const __m256i gd[2], const __m256i bd[2])
+{
+  __m128i luma = _mm_loadu_si128((const __m128i *)y);
+  __m256i y1 = _mm256_slli_epi32(_mm256_cvtepu8_epi32(luma), ScaleBitShift);
+  __m256i y2 = _mm256_slli_epi32(_mm256_cvtepu8_epi32(_mm_srli_si128(luma, 8)), ScaleBitShift);
+  __m256i r = YUVtoRGBAVX2(y1, y2, rd[0], rd[1]);
+  __m256i g = YUVtoRGBAVX2(y1, y2, gd[0], gd[1]);
+  __m256i b = YUVtoRGBAVX2(y1, y2, bd[0], bd[1]);
+
+  __m256i firstGreen = _mm256_or_si256(redOffset == 0 ? r : b, _mm256_slli_epi16(g, 8));
+  __m256i thirdAlpha = redOffset == 0 ? b : r;
+  __m256i pixels1 = _mm256_unpacklo_epi16(firstGreen, thirdAlpha);
+  __m256i pixels2 = _mm256_unpackhi_epi16(firstGreen, thirdAlpha);
+  if (rgbIncrement == 4) {
+    _mm256_storeu_si256((__m256i *)rgb, pixels1);
+    _mm256_storeu_si256((__m256i *)(rgb + 32), pixels2);
+  }
+  else {
+    __m256i compact = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                       0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    pixels1 = _mm256_shuffle_epi8(pixels1, compact);
+    pixels2 = _mm256_shuffle_epi8(pixels2, compact);
+    _mm_storeu_si128((__m128i *)rgb, _mm256_castsi256_si128(pixels1));
+    _mm_storeu_si128((__m128i *)(rgb + 12), _mm256_extracti128_si256(pixels1, 1));
+    _mm_storeu_si128((__m128i *)(rgb + 24), _mm256_castsi256_si128(pixels2));
+    _mm_storeu_si128((__m128i *)(rgb + 36), _mm256_extracti128_si256(pixels2, 1));
+  }
+}
+
+
+// As YUV420PtoRGBSSE41() but 16 pixels at a time
+__attribute__((target("avx2")))
+static unsigned YUV420PtoRGBAVX2(const BYTE * y1, const BYTE * y2, const BYTE * u, const BYTE * v, BYTE * rgb1, BYTE * rgb2,
+                                 unsigned x, unsigned width, unsigned rgbIncrement, unsigned redOffset)
+{
+  __m256i rCoeff = _mm256_set1_epi32(P_PAIR16(0, YUVtoR_Coeff));
+  __m256i gCoeff = _mm256_set1_epi32(P_PAIR16(YUVtoG_Coeff1, -YUVtoG_Coeff2));
+  __m256i bCoeff = _mm256_set1_epi32(P_PAIR16(YUVtoB_Coeff, 0));
+  __m256i half = _mm256_set1_epi32(HalfFixedScaling);
+  __m256i bias = _mm256_set1_epi16(128);
+  __m256i firstHalf = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+  __m256i secondHalf = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+  unsigned spare = rgbIncrement == 3 ? 2 : 0;
+  for (; x + 16 + spare <= width; x += 16) {
+    __m128i uv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(u + x/2)), _mm_loadl_epi64((const __m128i *)(v + x/2)));
+    __m256i cbcr = _mm256_sub_epi16(_mm256_cvtepu8_epi16(uv), bias);
+    __m256i rd = _mm256_add_epi32(_mm256_madd_epi16(cbcr, rCoeff), half);
+    __m256i gd = _mm256_add_epi32(_mm256_madd_epi16(cbcr, gCoeff), half);
+    __m256i bd = _mm256_add_epi32(_mm256_madd_epi16(cbcr, bCoeff), half);
+
+    __m256i rd2[2] = { _mm256_permutevar8x32_epi32(rd, firstHalf), _mm256_permutevar8x32_epi32(rd, secondHalf) };
+    __m256i gd2[2] = { _mm256_permutevar8x32_epi32(gd, firstHalf), _mm256_permutevar8x32_epi32(gd, secondHalf) };
+    __m256i bd2[2] = { _mm256_permutevar8x32_epi32(bd, firstHalf), _mm256_permutevar8x32_epi32(bd, secondHalf) };
+    YUV420PtoRGBPixelsAVX2(y1 + x, rgb1 + x*rgbIncrement, rgbIncrement, redOffset, rd2, gd2, bd2);
+    YUV420PtoRGBPixelsAVX2(y2 + x, rgb2 + x*rgbIncrement, rgbIncrement, redOffset, rd2, gd2, bd2);
+  }
+
+  return x;
+}
+
+#endif // P_VCONVERT_SIMD
+
+
+static unsigned YUV420PtoRGBSIMD(const BYTE * y1, const BYTE * y2, const BYTE * u, const BYTE * v, BYTE * rgb1, BYTE * rgb2,
+                                 unsigned width, unsigned rgbIncrement, unsigned redOffset)
+{
+  unsigned x = 0;
+#if P_VCONVERT_SIMD
+  if (CurrentAcceleration >= PColourConverter::e_AVX2)
+    x = YUV420PtoRGBAVX2(y1, y2, u, v, rgb1, rgb2, x, width, rgbIncrement, redOffset);
+  if (CurrentAcceleration >= PColourConverter::e_SSE41)
+    x = YUV420PtoRGBSSE41(y1, y2, u, v, rgb1, rgb2, x, width, rgbIncrement, redOffset);
+#endif
+  return x;
+}
+
+
 bool PStandardColourConverter::YUV420PtoRGB(const BYTE * srcFrameBuffer,
                                             BYTE * dstFrameBuffer,
                                             PINDEX * bytesReturned,
@@ -2089,20 +3192,20 @@ bool PStandardColourConverter::YUV420PtoRGB(const BYTE * srcFrameBuffer,
 #endif // P_FFMPEG_SWSCALE
 
   unsigned srcPixpos[4] = { 0, 1, planeWidth, planeWidth + 1 };
-  unsigned dstPixpos[4];
+  int dstPixpos[4];
 
   if (m_verticalFlip) {
-    scanLinePtrRGB -= scanLineSizeRGB; // We do two scan lines at a time
-    dstPixpos[0] = (unsigned)scanLineSizeRGB;
-    dstPixpos[1] =  (unsigned)scanLineSizeRGB+rgbIncrement;
+    scanLinePtrRGB += scanLineSizeRGB; // We do two scan lines at a time
+    dstPixpos[0] = -scanLineSizeRGB;
+    dstPixpos[1] = -scanLineSizeRGB+(int)rgbIncrement;
     dstPixpos[2] = 0;
     dstPixpos[3] = rgbIncrement;
   }
   else {
     dstPixpos[0] = 0;
     dstPixpos[1] = rgbIncrement;
-    dstPixpos[2] = (unsigned)scanLineSizeRGB;
-    dstPixpos[3] = (unsigned)scanLineSizeRGB+rgbIncrement;
+    dstPixpos[2] = scanLineSizeRGB;
+    dstPixpos[3] = scanLineSizeRGB+(int)rgbIncrement;
   }
 
   scanLineSizeRGB *= 2;
@@ -2126,8 +3229,14 @@ bool PStandardColourConverter::YUV420PtoRGB(const BYTE * srcFrameBuffer,
 
   if (m_srcFrameWidth == m_dstFrameWidth && m_srcFrameHeight == m_dstFrameHeight) {
     for (unsigned y = 0; y < m_srcFrameHeight; y += 2) {
-      BYTE * pixelRGB = scanLinePtrRGB;
-      for (unsigned x = 0; x < m_srcFrameWidth; x += 2) {
+      unsigned x = YUV420PtoRGBSIMD(scanLinePtrY, scanLinePtrY + planeWidth, scanLinePtrU, scanLinePtrV,
+                                    scanLinePtrRGB + dstPixpos[0], scanLinePtrRGB + dstPixpos[2],
+                                    m_srcFrameWidth, rgbIncrement, redOffset);
+      BYTE * pixelRGB = scanLinePtrRGB + x*rgbIncrement;
+      scanLinePtrY += x;
+      scanLinePtrU += x/2;
+      scanLinePtrV += x/2;
+      for (; x < m_srcFrameWidth; x += 2) {
         unsigned pixels = x < m_srcFrameWidth-1 ? 4 : 2;
         YUV420PtoRGB_PIXEL_UV(scanLinePtrU, scanLinePtrV);
         for (unsigned p = 0; p < pixels; p++) {
@@ -2849,17 +3958,26 @@ void  PStandardColourConverter::UYVY422toYUV420PSameSize(const BYTE *uyvy, BYTE
   u = yuv420p + npixels;
   v = u + npixels/4;
 
+  unsigned lineWidth = (m_srcFrameWidth+1)&~1;
   for (h=0; h<m_srcFrameHeight; h+=2) {
+     unsigned done = Packed422toYUV420PSIMD(s, s + lineWidth*2, y, y + lineWidth, u, v, m_srcFrameWidth, 1, 0, 2);
+     s += done*2;
+     y += done;
+     u += done/2;
+     v += done/2;
 
      /* Copy the first line keeping all information */
-     for (x=0; x<m_srcFrameWidth; x+=2) {
+     for (x=done; x<m_srcFrameWidth; x+=2) {
         *u++ = *s++;
         *y++ = *s++;
         *v++ = *s++;
         *y++ = *s++;
      }
+     s += done*2;
+     y += done;
+
      /* Copy the second line discarding u and v information */
-     for (x=0; x<m_srcFrameWidth; x+=2) {
+     for (x=done; x<m_srcFrameWidth; x+=2) {
         s++;
         *y++ = *s++;
         s++;
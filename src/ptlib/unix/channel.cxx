@@ -31,6 +31,7 @@
 #pragma implementation "indchan.h"
 
 #include <ptlib.h>
+#include <ptlib/socket.h>
 #include <sys/ioctl.h>
 
 #if defined(P_SOLARIS)
@@ -49,6 +50,9 @@ void PChannel::Construct()
   px_selectThread[0] = NULL;
   px_selectThread[1] = NULL;
   px_selectThread[2] = NULL;
+#if P_HAS_EPOLL
+  px_selector = NULL;
+#endif
 }
 
 
@@ -342,6 +346,14 @@ int PChannel::PXClose()
   for (PINDEX i = 0; i < 3; ++i)
     AbortIO(px_selectThread[i], px_threadMutex);
 
+#if P_HAS_EPOLL
+  // Remove with the lock held, so the selector cannot be destroyed under us
+  px_threadMutex.Wait();
+  if (px_selector != NULL)
+    px_selector->InternalRemove(*this, true);
+  px_threadMutex.Signal();
+#endif
+
   int stat;
   do {
     stat = ::close(handle);
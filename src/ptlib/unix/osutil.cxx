@@ -530,8 +530,8 @@ bool PDirectory::Exists(const PString & p)
 bool PDirectory::Remove(const PString & p)
 {
   PAssert(!p.IsEmpty(), "attempt to remove dir with empty name");
-  PString str = p.Left(p.GetLength()-1);
-  return rmdir(str) == 0;
+  PDirectory dir = p; // Make sure has trailing slash, as for Create()
+  return rmdir(dir.Left(dir.GetLength()-1)) == 0;
 }
 
 PString PDirectory::GetVolume() const
@@ -440,6 +440,247 @@ PChannel::Errors PSocket::Select(SelectList & read,
 }
 
 
+#if P_HAS_EPOLL
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+PSocketSelector::PSocketSelector(Triggering triggering)
+  : m_triggering(triggering)
+  , m_epoll(epoll_create1(EPOLL_CLOEXEC))
+  , m_wakeup(eventfd(0, EFD_NONBLOCK|EFD_CLOEXEC))
+  , m_nextId(1) // Zero is used for the wake up eventfd
+  , m_events(16)
+{
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.u64 = 0;
+  PAssertOS(m_epoll >= 0 && m_wakeup >= 0 && epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeup, &ev) == 0);
+}
+
+
+PSocketSelector::~PSocketSelector()
+{
+  // Cannot hold m_mutex while removing, as the socket lock must come first
+  m_mutex.Wait();
+  while (!m_byId.empty()) {
+    PSocket * socket = m_byId.begin()->second.m_socket;
+    m_mutex.Signal();
+    InternalRemove(*socket, false);
+    m_mutex.Wait();
+  }
+  m_mutex.Signal();
+
+  if (m_wakeup >= 0)
+    ::close(m_wakeup);
+  if (m_epoll >= 0)
+    ::close(m_epoll);
+}
+
+
+bool PSocketSelector::Add(PSocket & socket, Events events)
+{
+  // Always socket then selector, see PChannel::PXClose()
+  PWaitAndSignal lock(socket.px_threadMutex);
+  if (!socket.IsOpen() || socket.px_selector != NULL)
+    return false;
+
+  PWaitAndSignal lock2(m_mutex);
+
+  P_INT_PTR id = m_nextId++;
+  Registration & registration = m_byId[id];
+  registration.m_socket = &socket;
+  registration.m_handle = socket.GetHandle();
+  registration.m_events = events;
+
+  if (!Arm(id, registration, EPOLL_CTL_ADD)) {
+    m_byId.erase(id);
+    return false;
+  }
+
+  socket.px_selector = this;
+  m_byChannel[&socket] = id;
+
+  // Make sure all ready sockets can be returned by one epoll_wait()
+  if (m_events.size() < m_byId.size())
+    m_events.resize(m_byId.size()*2);
+  return true;
+}
+
+
+bool PSocketSelector::Modify(PSocket & socket, Events events)
+{
+  PWaitAndSignal lock(m_mutex);
+
+  IdsByChannel::iterator it = m_byChannel.find(&socket);
+  if (it == m_byChannel.end())
+    return false;
+
+  Registration & registration = m_byId[it->second];
+  registration.m_events = events;
+  return Arm(it->second, registration, EPOLL_CTL_MOD);
+}
+
+
+bool PSocketSelector::Remove(PSocket & socket)
+{
+  return InternalRemove(socket, false);
+}
+
+
+bool PSocketSelector::InternalRemove(PChannel & channel, bool interrupt)
+{
+  PWaitAndSignal lock(channel.px_threadMutex);
+  PWaitAndSignal lock2(m_mutex);
+
+  IdsByChannel::iterator it = m_byChannel.find(&channel);
+  if (it == m_byChannel.end())
+    return false;
+
+  RegistrationsById::iterator reg = m_byId.find(it->second);
+  epoll_ctl(m_epoll, EPOLL_CTL_DEL, reg->second.m_handle, NULL);
+  m_byId.erase(reg);
+  m_byChannel.erase(it);
+  channel.px_selector = NULL;
+
+  // Still under m_mutex, so the destructor cannot have closed the eventfd
+  if (interrupt)
+    Interrupt();
+  return true;
+}
+
+
+PINDEX PSocketSelector::GetCount() const
+{
+  PWaitAndSignal lock(m_mutex);
+  return m_byId.size();
+}
+
+
+bool PSocketSelector::Arm(P_INT_PTR id, const Registration & registration, int op)
+{
+  struct epoll_event ev;
+  ev.events = m_triggering == EdgeTriggered ? EPOLLET : 0;
+  if (registration.m_events & ReadEvent)
+    ev.events |= EPOLLIN|EPOLLRDHUP;
+  if (registration.m_events & WriteEvent)
+    ev.events |= EPOLLOUT;
+  if (registration.m_events & ExceptEvent)
+    ev.events |= EPOLLPRI;
+  ev.data.u64 = id;
+
+  if (epoll_ctl(m_epoll, op, registration.m_handle, &ev) == 0)
+    return true;
+
+  PTRACE(2, "Could not " << (op == EPOLL_CTL_ADD ? "add" : "modify") << " socket "
+         << registration.m_handle << " in selector: " << strerror(errno));
+  return false;
+}
+
+
+PChannel::Errors PSocketSelector::Select(PSocket::SelectList & read, const PTimeInterval & timeout)
+{
+  PSocket::SelectList dummy1, dummy2;
+  return Select(read, dummy1, dummy2, timeout);
+}
+
+
+PChannel::Errors PSocketSelector::Select(PSocket::SelectList & read, PSocket::SelectList & write, const PTimeInterval & timeout)
+{
+  PSocket::SelectList dummy1;
+  return Select(read, write, dummy1, timeout);
+}
+
+
+PChannel::Errors PSocketSelector::Select(PSocket::SelectList & read,
+                                         PSocket::SelectList & write,
+                                         PSocket::SelectList & except,
+                                         const PTimeInterval & timeout)
+{
+  read.RemoveAll();
+  write.RemoveAll();
+  except.RemoveAll();
+
+  int waitTime = timeout == PMaxTimeInterval ? -1 : (int)std::min(timeout.GetMilliSeconds(), (PInt64)INT_MAX);
+
+  /* Take the shared buffer, so Add() cannot resize it while we are using it.
+     If another thread is in Select() and already has it, use our own. */
+  m_mutex.Wait();
+  std::vector<struct epoll_event> events;
+  if (m_events.empty())
+    events.resize(m_byId.size()*2+16);
+  else
+    events.swap(m_events);
+  m_mutex.Signal();
+
+  int count;
+  do {
+    PPROFILE_SYSTEM(
+      count = epoll_wait(m_epoll, events.data(), events.size(), waitTime);
+    );
+  } while (count < 0 && errno == EINTR);
+
+  PWaitAndSignal lock(m_mutex);
+
+  PChannel::Errors lastError = PChannel::NoError;
+  if (count < 0) {
+    PTRACE(2, "Select epoll_wait failed: " << strerror(errno));
+    lastError = errno == EBADF ? PChannel::NotOpen : PChannel::Miscellaneous;
+  }
+
+  /* Must process every returned event, even after a wake up, as in edge
+     triggered mode the ready sockets would not be returned again. */
+  bool interrupted = false, anyReady = false;
+  for (int i = 0; i < count; ++i) {
+    if (events[i].data.u64 == 0) {
+      PTRACE(6, "Select unblocked fd=" << m_wakeup);
+      uint64_t value;
+      if (::read(m_wakeup, &value, sizeof(value)) < 0) {
+        PTRACE(2, "Could not read selector eventfd: " << strerror(errno));
+      }
+      interrupted = true;
+      continue;
+    }
+
+    RegistrationsById::iterator it = m_byId.find((P_INT_PTR)events[i].data.u64);
+    if (it == m_byId.end())
+      continue; // Removed while we were waiting
+
+    Registration & registration = it->second;
+    unsigned revents = events[i].events;
+    bool failed = (revents & (EPOLLERR|EPOLLHUP)) != 0;
+    if ((registration.m_events & ReadEvent) && (failed || (revents & (EPOLLIN|EPOLLRDHUP)) != 0))
+      read += *registration.m_socket;
+    if ((registration.m_events & WriteEvent) && (failed || (revents & EPOLLOUT) != 0))
+      write += *registration.m_socket;
+    if ((registration.m_events & ExceptEvent) && (failed || (revents & EPOLLPRI) != 0))
+      except += *registration.m_socket;
+    anyReady = true;
+  }
+
+  // Only report the interrupt if there is nothing else to return
+  if (interrupted && !anyReady)
+    lastError = PChannel::Interrupted;
+
+  // Give back the buffer, if it is bigger than any other thread returned
+  if (events.size() > m_events.size())
+    m_events.swap(events);
+
+  return lastError;
+}
+
+
+void PSocketSelector::Interrupt()
+{
+  uint64_t one = 1;
+  if (::write(m_wakeup, &one, sizeof(one)) < 0) {
+    PTRACE(1, "Could not write selector eventfd: " << strerror(errno));
+  }
+}
+
+#endif // P_HAS_EPOLL
+
+
 #if P_HAS_RECVMSG
 
 #if P_HAS_RECVMSG_MSG_ERRQUEUE
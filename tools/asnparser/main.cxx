@@ -33,6 +33,7 @@
 #include <ptlib.h>
 
 #include <ptlib/pprocess.h>
+#include <ptclib/asner.h>
 
 #include "main.h"
 #include "asn_grammar.h"
@@ -242,6 +243,7 @@ void App::Main()
              "o-output:"
              "r-rename:"
              "s-split;"
+             "t-per-tables."
              "V-version."
              "v-verbose."
              "x-xml."
@@ -283,6 +285,7 @@ void App::Main()
               "  --no-operators      Generate functions instead of operators for choice\n"
               "                        sub-object extraction.\n"
               "  -x --xml            X.693 support (XER)\n"
+              "  -t --per-tables     Generate PER codec tables (<file>_per.cxx)\n"
               "  -o --output file    Output filename/directory\n"
            << endl;
     return;
@@ -469,10 +472,9 @@ void NamedNumber::PrintOn(ostream & strm) const
 
 void NamedNumber::SetAutoNumber(const NamedNumber & prev)
 {
-  if (autonumber) {
+  // Flag is left set, so may be renumbered if moved to another list
+  if (autonumber)
     number = prev.number + 1;
-    autonumber = FALSE;
-  }
 }
 
 
@@ -917,6 +919,289 @@ void UserDefinedConstraintElement::GenerateCplusplus(const PString &, ostream &,
 }
 
 
+/////////////////////////////////////////////////////////
+
+// Only used for its constraints, never encodes anything
+class PerTableArray : public PASN_Array
+{
+    PCLASSINFO(PerTableArray, PASN_Array);
+  public:
+    PASN_Object * CreateObject() const { return NULL; }
+    PObject * Clone() const { return new PerTableArray(*this); }
+};
+
+
+PerTableEntry::PerTableEntry(const PString & nam)
+  : name(nam)
+{
+  object = NULL;
+  extendable = FALSE;
+  count = options = extensions = 0;
+}
+
+
+PerTableEntry::~PerTableEntry()
+{
+  delete object;
+}
+
+
+PBoolean PerTableEntry::SetAncestor(const PString & ancestor)
+{
+  delete object;
+  object = NULL;
+
+  if (ancestor == "PASN_Null") {
+    kind = "e_Null";
+    return TRUE;
+  }
+
+  if (ancestor == "PASN_Boolean") {
+    kind = "e_Boolean";
+    return TRUE;
+  }
+
+  if (ancestor == "PASN_Real") {
+    kind = "e_Real";
+    return TRUE;
+  }
+
+  if (ancestor == "PASN_ObjectId") {
+    kind = "e_ObjectId";
+    return TRUE;
+  }
+
+  if (ancestor == "PASN_Integer") {
+    kind = "e_Integer";
+    object = new PASN_Integer;
+  }
+  else if (ancestor == "PASN_BitString") {
+    kind = "e_BitString";
+    object = new PASN_BitString;
+  }
+  else if (ancestor == "PASN_OctetString") {
+    kind = "e_OctetString";
+    object = new PASN_OctetString;
+  }
+  else if (ancestor == "PASN_BMPString") {
+    kind = "e_BMPString";
+    object = new PASN_BMPString;
+  }
+  else if (ancestor == "PASN_Array") {
+    kind = "e_Array";
+    object = new PerTableArray;
+  }
+  else {
+    kind = "e_String";
+    if (ancestor == "PASN_NumericString")
+      object = new PASN_NumericString;
+    else if (ancestor == "PASN_PrintableString")
+      object = new PASN_PrintableString;
+    else if (ancestor == "PASN_VisibleString")
+      object = new PASN_VisibleString;
+    else if (ancestor == "PASN_IA5String")
+      object = new PASN_IA5String;
+    else if (ancestor == "PASN_GeneralString")
+      object = new PASN_GeneralString;
+    else if (ancestor == "PASN_GeneralisedTime")
+      object = new PASN_GeneralisedTime;
+    else if (ancestor == "PASN_UniversalTime")
+      object = new PASN_UniversalTime;
+    else
+      return FALSE;
+  }
+
+  return TRUE;
+}
+
+
+void PerTableEntry::SetStructure(const char * knd, PBoolean ext, unsigned cnt, unsigned opts, unsigned exts)
+{
+  delete object;
+  object = NULL;
+
+  kind = knd;
+  extendable = ext;
+  count = cnt;
+  options = opts;
+  extensions = exts;
+}
+
+
+static PBoolean GetPerConstraintValue(const PString & str, int & value, PBoolean & isMin, PBoolean & isMax)
+{
+  isMin = str == "MinimumValue";
+  isMax = str == "MaximumValue";
+  if (isMin || isMax)
+    return TRUE;
+
+  PString number = str;
+  if (number.Right(1) == "U")
+    number.Delete(number.GetLength()-1, 1);
+
+  PINDEX start = number[0] == '-' ? 1 : 0;
+  if (number.GetLength() <= start || number.FindSpan("0123456789", start) != P_MAX_INDEX)
+    return FALSE;
+
+  value = (int)number.AsInt64();
+  return TRUE;
+}
+
+
+void PerTableEntry::ApplyConstraint(const PString & statement)
+{
+  // Parse what TypeBase::GenerateCplusplusConstraints() produced, and then do
+  // exactly that to an instance of the class, so the table matches the class.
+  PINDEX open = statement.Find('(');
+  PINDEX close = statement.FindLast(')');
+  if (open == P_MAX_INDEX || close == P_MAX_INDEX || close < open)
+    return;
+
+  PString function = statement.Left(open).Trim();
+  if (function == "IncludeOptionalField")
+    return;
+
+  if (object == NULL) // Sequence, choice etc has no constraints
+    return;
+
+  PString args = statement(open+1, close-1);
+  PINDEX comma = args.Find(',');
+  if (comma == P_MAX_INDEX)
+    return;
+
+  PASN_Object::ConstraintType ctype = args.Left(comma).Find("Extendable") != P_MAX_INDEX
+                                            ? PASN_Object::ExtendableConstraint : PASN_Object::FixedConstraint;
+  args = args.Mid(comma+1).Trim();
+
+  if (function == "SetCharacterSet") {
+    if (kind != "e_String") {
+      PError << StdError(Warning) << "PER table for " << name << " does not support FROM constraint, ignored." << endl;
+      return;
+    }
+
+    if (args[0] == '"') {
+      args.Replace("\"", "", TRUE);
+      object->SetCharacterSet(ctype, args);
+      return;
+    }
+
+    PStringArray range = args.Tokenise(",", FALSE);
+    int first, last;
+    PBoolean isMin, isMax;
+    if (range.GetSize() == 2 &&
+        GetPerConstraintValue(range[0].Trim(), first, isMin, isMax) && !isMin && !isMax &&
+        GetPerConstraintValue(range[1].Trim(), last,  isMin, isMax) && !isMin && !isMax)
+      object->SetCharacterSet(ctype, first, last);
+    else
+      PError << StdError(Warning) << "PER table for " << name << " has unsupported FROM constraint " << args << endl;
+    return;
+  }
+
+  if (function != "SetConstraints")
+    return;
+
+  PStringArray values = args.Tokenise(",", FALSE);
+  int lower = 0, upper = 0;
+  PBoolean lowerMin = FALSE, lowerMax = FALSE, upperMin = FALSE, upperMax = FALSE;
+  if (values.IsEmpty() || values.GetSize() > 2 ||
+      !GetPerConstraintValue(values[0].Trim(), lower, lowerMin, lowerMax) ||
+      (values.GetSize() == 2 && !GetPerConstraintValue(values[1].Trim(), upper, upperMin, upperMax)) ||
+      lowerMax || upperMin) {
+    PError << StdError(Warning) << "PER table for " << name << " has unsupported constraint " << args << endl;
+    return;
+  }
+
+  // Same overload resolution as the compiler would do for the class
+  if (values.GetSize() == 1)
+    object->SetConstraints(ctype, lower);
+  else if (lowerMin && upperMax)
+    object->SetConstraints(ctype, PASN_Object::MinimumValue, PASN_Object::MaximumValue);
+  else if (lowerMin)
+    object->SetConstraints(ctype, PASN_Object::MinimumValue, (unsigned)upper);
+  else if (upperMax)
+    object->SetConstraints(ctype, lower, PASN_Object::MaximumValue);
+  else
+    object->SetConstraints(ctype, lower, (unsigned)upper);
+}
+
+
+static const char * const PerConstraintNames[] = {
+  "Unconstrained", "PartiallyConstrained", "FixedConstraint", "ExtendableConstraint"
+};
+
+static void PrintPerLimits(ostream & strm, int lower, unsigned upper)
+{
+  if (lower == INT_MIN)
+    strm << "INT_MIN";
+  else
+    strm << lower;
+  strm << ", ";
+  if (upper == UINT_MAX)
+    strm << "UINT_MAX";
+  else
+    strm << upper << 'U';
+}
+
+
+void PerTableEntry::PrintOn(ostream & strm) const
+{
+  PASN_Object::ConstraintType constraint = PASN_Object::Unconstrained;
+  int lower = 0;
+  unsigned upper = UINT_MAX;
+  PBoolean ext = extendable;
+  PString charSet;
+  unsigned unalignedBits = 0, alignedBits = 0, canonicalBits = 0;
+
+  const PASN_ConstrainedObject * constrained = dynamic_cast<const PASN_ConstrainedObject *>(object);
+  if (constrained != NULL) {
+    constraint = constrained->GetConstraint();
+    lower = constrained->GetLowerLimit();
+    upper = constrained->GetUpperLimit();
+    ext = constrained->IsExtendable();
+  }
+
+  const PASN_ConstrainedString * str = dynamic_cast<const PASN_ConstrainedString *>(object);
+  if (str != NULL) {
+    const PCharArray & set = str->GetCharacterSet();
+    charSet = '"';
+    for (PINDEX i = 0; i < set.GetSize(); i++) {
+      char c = set[i];
+      if (c == '"' || c == '\\')
+        charSet += psprintf("\\%c", c);
+      else if (c >= ' ' && c < 0x7f)
+        charSet += c;
+      else
+        charSet += psprintf("\\%03o", (BYTE)c);
+    }
+    charSet += '"';
+    unalignedBits = str->GetCharSetUnalignedBits();
+    alignedBits = str->GetCharSetAlignedBits();
+    canonicalBits = str->GetCanonicalSetBits();
+    strm << "{\n"
+            "  \"" << name << "\", PPER_Type::" << kind << ", PASN_Object::" << PerConstraintNames[constraint] << ", "
+         << (ext ? "true" : "false") << ", ";
+    PrintPerLimits(strm, lower, upper);
+    strm << ", 0, 0, 0, NULL,\n"
+            "  " << charSet << ", " << set.GetSize() << ", "
+         << unalignedBits << ", " << alignedBits << ", " << canonicalBits << "\n"
+            "}";
+    return;
+  }
+
+  if (kind == "e_BMPString")
+    unalignedBits = alignedBits = canonicalBits = 16;
+
+  strm << "{\n"
+          "  \"" << name << "\", PPER_Type::" << kind << ", PASN_Object::" << PerConstraintNames[constraint] << ", "
+       << (ext ? "true" : "false") << ", ";
+  PrintPerLimits(strm, lower, upper);
+  strm << ", " << count << ", " << options << ", " << extensions << ", "
+       << (fields.IsEmpty() ? PString("NULL") : fields) << ",\n"
+          "  NULL, 0, " << unalignedBits << ", " << alignedBits << ", " << canonicalBits << "\n"
+          "}";
+}
+
+
 /////////////////////////////////////////////////////////
 
 TypeBase::TypeBase(unsigned tagNum)
@@ -956,7 +1241,7 @@ void TypeBase::PrintOn(ostream & strm) const
 void TypeBase::PrintStart(ostream & strm) const
 {
   strm << indent();
-  if (!name) {
+  if (!name.IsEmpty()) {
     strm << name;
     if (!parameters.IsEmpty()) {
       strm << " { ";
@@ -1228,6 +1513,68 @@ void TypeBase::GenerateCplusplusConstraints(const PString & prefix, ostream & hd
 }
 
 
+PBoolean TypeBase::GetPerTableEntry(PerTableEntry & entry)
+{
+  // The class, as per GetTypeName(), then what our constructor does to it
+  if (!GetPerStructure(entry))
+    return FALSE;
+
+  PStringStream hdr, cxx;
+  GenerateCplusplusConstraints(PString(), hdr, cxx);
+
+  PStringArray statements = cxx.Lines();
+  for (PINDEX i = 0; i < statements.GetSize(); i++)
+    entry.ApplyConstraint(statements[i]);
+
+  return TRUE;
+}
+
+
+PBoolean TypeBase::GetPerStructure(PerTableEntry & entry)
+{
+  return entry.SetAncestor(GetAncestorClass());
+}
+
+
+PString TypeBase::GetPerTableReference(const PString & tableName, ostream & decl, ostream & defs)
+{
+  PerTableEntry entry(GetName());
+  if (!GetPerTableEntry(entry)) {
+    PError << StdError(Warning) << "cannot generate PER table for " << GetName() << " (" << GetTypeName() << ')' << endl;
+    return "&PPER_Type::OpenType";
+  }
+
+  decl << "extern const PPER_Type " << tableName << ";\n";
+  defs << "const PPER_Type " << tableName << " = " << entry << ";\n"
+          "\n";
+  return '&' + tableName;
+}
+
+
+void TypeBase::GeneratePerTable(ostream & decl, ostream & defs)
+{
+  PerTableEntry entry(GetName());
+  if (!GetPerTableEntry(entry)) {
+    PError << StdError(Warning) << "cannot generate PER table for " << GetName() << " (" << GetTypeName() << ')' << endl;
+    return;
+  }
+
+  defs << "//\n"
+          "// " << GetName() << "\n"
+          "//\n"
+          "\n";
+  GeneratePerFields(decl, defs);
+  defs << "const PPER_Type " << GetIdentifier() << "_Table = " << entry << ";\n"
+          "\n"
+          "\n";
+}
+
+
+void TypeBase::GeneratePerFields(ostream &, ostream &)
+{
+}
+
+
 /////////////////////////////////////////////////////////
 
 DefinedType::DefinedType(PString * name, PBoolean parameter)
@@ -1262,7 +1609,7 @@ DefinedType::DefinedType(TypeBase * refType, const PString & refName)
 DefinedType::DefinedType(TypeBase * refType, const TypeBase & parent)
   : TypeBase(refType)
 {
-  if (!name)
+  if (!name.IsEmpty())
     ConstructFromType(refType, parent.GetName() + '_' + name);
   else
     ConstructFromType(refType, parent.GetName() + "_subtype");
@@ -1355,6 +1702,60 @@ PString DefinedType::GetTypeName() const
 }
 
 
+PBoolean DefinedType::GetPerStructure(PerTableEntry & entry)
+{
+  if (baseType == NULL)
+    return FALSE;
+
+  // Follow GetTypeName(), either the ancestor of a primitive, or the complete base class
+  if (HasConstraints() && baseType->IsPrimitiveType())
+    return baseType->GetPerStructure(entry);
+
+  return baseType->GetPerTableEntry(entry);
+}
+
+
+PString DefinedType::GetPerTableReference(const PString & tableName, ostream & decl, ostream & defs)
+{
+  if (baseType == NULL)
+    return TypeBase::GetPerTableReference(tableName, decl, defs);
+
+  if (PIsDescendant(baseType, ImportedType)) {
+    if (HasConstraints())
+      PError << StdError(Warning) << "PER table for " << GetName()
+             << " cannot constrain imported type " << referenceName << ", ignored." << endl;
+    return '&' + baseType->GetIdentifier() + "_Table";
+  }
+
+  if (!HasConstraints())
+    return '&' + baseType->GetIdentifier() + "_Table";
+
+  return TypeBase::GetPerTableReference(tableName, decl, defs);
+}
+
+
+void DefinedType::GeneratePerTable(ostream & decl, ostream & defs)
+{
+  if (baseType == NULL || !PIsDescendant(baseType, ImportedType)) {
+    TypeBase::GeneratePerTable(decl, defs);
+    return;
+  }
+
+  // The structure is in another module, so can only copy it at run time
+  if (HasConstraints())
+    PError << StdError(Warning) << "PER table for " << GetName()
+           << " cannot constrain imported type " << referenceName << ", ignored." << endl;
+
+  defs << "//\n"
+          "// " << GetName() << "\n"
+          "//\n"
+          "\n"
+          "const PPER_Type " << GetIdentifier() << "_Table = " << baseType->GetIdentifier() << "_Table;\n"
+          "\n"
+          "\n";
+}
+
+
 /////////////////////////////////////////////////////////
 
 ParameterizedType::ParameterizedType(PString * name, TypesList * args)
@@ -1577,8 +1978,11 @@ EnumeratedType::EnumeratedType(NamedNumberList * enums, PBoolean extend, NamedNu
   extendable = extend;
   if (ext != NULL) {
     ext->DisallowDeleteObjects();
-    for (PINDEX i = 0; i < ext->GetSize(); i++)
+    for (PINDEX i = 0; i < ext->GetSize(); i++) {
+      // Additions carry on from the root, rather than starting again at zero
+      (*ext)[i].SetAutoNumber(enumerations[enumerations.GetSize()-1]);
       enumerations.Append(ext->GetAt(i));
+    }
     delete ext;
   }
 }
@@ -1749,6 +2153,21 @@ const char * EnumeratedType::GetAncestorClass() const
 }
 
 
+PBoolean EnumeratedType::GetPerStructure(PerTableEntry & entry)
+{
+  // Same as the constructor parameters in GenerateCplusplus()
+  int maxEnumValue = 0;
+  for (PINDEX i = 0; i < enumerations.GetSize(); i++) {
+    int num = enumerations[i].GetNumber();
+    if (maxEnumValue < num)
+      maxEnumValue = num;
+  }
+
+  entry.SetStructure("e_Enumeration", extendable, maxEnumValue, 0, 0);
+  return TRUE;
+}
+
+
 /////////////////////////////////////////////////////////
 
 RealType::RealType()
@@ -2212,6 +2631,47 @@ const char * SequenceType::GetAncestorClass() const
 }
 
 
+PBoolean SequenceType::GetPerStructure(PerTableEntry & entry)
+{
+  PINDEX baseOptions = 0;
+  for (PINDEX i = 0; i < numFields; i++) {
+    if (fields[i].IsOptional())
+      baseOptions++;
+  }
+
+  entry.SetStructure("e_Sequence", extendable, numFields, baseOptions, fields.GetSize() - numFields);
+  entry.SetFields(GetIdentifier() + "_Fields");
+  return TRUE;
+}
+
+
+void SequenceType::GeneratePerFields(ostream & decl, ostream & defs)
+{
+  PStringArray references(fields.GetSize());
+  PINDEX i;
+  for (i = 0; i < fields.GetSize(); i++)
+    references[i] = fields[i].GetPerTableReference(GetIdentifier() + '_' + fields[i].GetIdentifier() + "_FieldTable", decl, defs);
+
+  decl << "extern const PPER_Field " << GetIdentifier() << "_Fields[];\n";
+  defs << "const PPER_Field " << GetIdentifier() << "_Fields[] = {\n";
+
+  // Option bits are in the order of the OptionalFields enum, root fields only
+  int option = 0;
+  for (i = 0; i < fields.GetSize(); i++) {
+    defs << "  { \"" << fields[i].GetName() << "\", " << references[i] << ", ";
+    if (!IsChoice() && i < numFields && fields[i].IsOptional())
+      defs << option++;
+    else
+      defs << "-1";
+    defs << " },\n";
+  }
+
+  defs << "  { NULL, NULL, -1 }\n"
+          "};\n"
+          "\n";
+}
+
+
 PBoolean SequenceType::CanReferenceType() const
 {
   return TRUE;
@@ -2350,6 +2810,30 @@ const char * SequenceOfType::GetAncestorClass() const
 }
 
 
+PBoolean SequenceOfType::GetPerStructure(PerTableEntry & entry)
+{
+  if (!entry.SetAncestor("PASN_Array"))
+    return FALSE;
+
+  entry.SetFields(GetIdentifier() + "_Fields");
+  return TRUE;
+}
+
+
+void SequenceOfType::GeneratePerFields(ostream & decl, ostream & defs)
+{
+  // The element as CreateObject() makes it
+  PString reference = baseType->GetPerTableReference(GetIdentifier() + "_ElementTable", decl, defs);
+
+  decl << "extern const PPER_Field " << GetIdentifier() << "_Fields[];\n";
+  defs << "const PPER_Field " << GetIdentifier() << "_Fields[] = {\n"
+          "  { \"" << baseType->GetName() << "\", " << reference << ", -1 },\n"
+          "  { NULL, NULL, -1 }\n"
+          "};\n"
+          "\n";
+}
+
+
 PBoolean SequenceOfType::CanReferenceType() const
 {
   return TRUE;
@@ -2615,7 +3099,7 @@ void ChoiceType::GenerateCplusplus(ostream & hdr, ostream & cxx)
           continue;
     
         if (!outputEnum) {
-          cxx << "  switch (tag) {\n";
+          cxx << "  switch (m_tag) {\n";
           outputEnum = TRUE;
         }
 
@@ -2708,6 +3192,24 @@ const char * ChoiceType::GetAncestorClass() const
 }
 
 
+PBoolean ChoiceType::GetPerStructure(PerTableEntry & entry)
+{
+  // The table uses the position as the PER index, the class uses the tag number
+  for (PINDEX i = 0; i < fields.GetSize(); i++) {
+    const Tag & fieldTag = fields[i].GetTag();
+    if (fieldTag.mode != Tag::Automatic && (fields[i].IsChoice() || fieldTag.number != (unsigned)i)) {
+      PError << StdError(Warning) << "PER table for " << GetName()
+             << " assumes automatic tags, alternative " << fields[i].GetName() << " is not." << endl;
+      break;
+    }
+  }
+
+  entry.SetStructure("e_Choice", extendable, numFields, 0, fields.GetSize() - numFields);
+  entry.SetFields(GetIdentifier() + "_Fields");
+  return TRUE;
+}
+
+
 PBoolean ChoiceType::ReferencesType(const TypeBase & type)
 {
   for (PINDEX i = 0; i < fields.GetSize(); i++) {
@@ -2761,7 +3263,7 @@ AnyType::AnyType(PString * ident)
 void AnyType::PrintOn(ostream & strm) const
 {
   PrintStart(strm);
-  if (!identifier)
+  if (!identifier.IsEmpty())
     strm << "Defined by " << identifier;
   PrintFinish(strm);
 }
@@ -3212,7 +3714,7 @@ void ValueBase::SetValueName(PString * name)
 
 void ValueBase::PrintBase(ostream & strm) const
 {
-  if (!valueName)
+  if (!valueName.IsEmpty())
     strm << '\n' << indent() << valueName << '=';
 }
 
@@ -3721,13 +4223,14 @@ void ModuleDefinition::GenerateCplusplus(const PFilePath & path,
 {
   PArgList & args = PProcess::Current().GetArguments();
   PBoolean xml_output = args.HasOption('x');
+  PBoolean per_tables = args.HasOption('t');
   PINDEX i;
 
   usingInlines = useInlines;
   usingOperators = useOperators;
 
   // Adjust the module name to what is specified to a default
-  if (!modName)
+  if (!modName.IsEmpty())
     moduleName = modName;
   else
     moduleName = MakeIdentifierC(moduleName);
@@ -3837,8 +4340,12 @@ void ModuleDefinition::GenerateCplusplus(const PFilePath & path,
     hdrFile << "#define P_EXPAT 1\n"
                "#include <ptclib/pxml.h>\n";
 
-  hdrFile << "#include <ptclib/asner.h>\n"
-             "\n";
+  hdrFile << "#include <ptclib/asner.h>\n";
+
+  if (per_tables)
+    hdrFile << "#include <ptclib/asnpertab.h>\n";
+
+  hdrFile << "\n";
 
   // Start the first (and maybe only) cxx file
   OutputFile cxxFile;
@@ -3920,6 +4427,20 @@ void ModuleDefinition::GenerateCplusplus(const PFilePath & path,
   }
 
 
+  if (per_tables) {
+    hdrFile << "//\n"
+               "// PER codec tables\n"
+               "//\n"
+               "\n";
+    for (i = 0; i < types.GetSize(); i++) {
+      if (types[i].IsGenerated() && !types[i].HasParameters())
+        hdrFile << "extern const PPER_Type " << types[i].GetIdentifier() << "_Table;\n";
+    }
+    hdrFile << "\n"
+               "\n";
+  }
+
+
   // Close off the files
   if (useNamespaces)
     hdrFile << "};\n"
@@ -3936,6 +4457,45 @@ void ModuleDefinition::GenerateCplusplus(const PFilePath & path,
 
   if (verbose)
     cout << "Completed " << cxxFile.GetFilePath() << endl;
+
+  if (!per_tables)
+    return;
+
+  // Tables for PPER_TableCodec, fields and constrained members first
+  OutputFile perFile;
+  if (!perFile.Open(path, "_per", ".cxx"))
+    return;
+
+  PStringStream perDecl, perDefs;
+  for (i = 0; i < types.GetSize(); i++) {
+    if (types[i].IsGenerated() && !types[i].HasParameters())
+      types[i].GeneratePerTable(perDecl, perDefs);
+  }
+
+  perFile << "#include <ptlib.h>\n"
+             "#include \"" << headerPrefix << headerName << "\"\n"
+             "\n"
+             "\n"
+             "#if ! H323_DISABLE_" << moduleName.ToUpper() << "\n"
+             "\n";
+
+  if (useNamespaces)
+    perFile << "namespace " << moduleName << " {\n"
+               "\n";
+
+  perFile << perDecl << "\n"
+             "\n"
+          << perDefs;
+
+  if (useNamespaces)
+    perFile << "};\n"
+               "\n";
+
+  perFile << "#endif // if ! H323_DISABLE_" << moduleName.ToUpper() << "\n"
+             "\n";
+
+  if (verbose)
+    cout << "Completed " << perFile.GetFilePath() << endl;
 }
 
 
@@ -348,6 +348,37 @@ class UserDefinedConstraintElement : public ConstraintElementBase
 };
 
 
+class PASN_Object;
+
+class PerTableEntry : public PObject
+{
+    PCLASSINFO(PerTableEntry, PObject);
+  public:
+    PerTableEntry(const PString & name);
+    ~PerTableEntry();
+
+    PBoolean SetAncestor(const PString & ancestor);
+    void SetStructure(const char * kind, PBoolean extendable, unsigned count, unsigned options, unsigned extensions);
+    void SetFields(const PString & fieldsName) { fields = fieldsName; }
+    void ApplyConstraint(const PString & statement);
+    void PrintOn(ostream &) const;
+
+  protected:
+    PString       name;
+    PString       kind;
+    PASN_Object * object;
+    PBoolean      extendable;
+    unsigned      count;
+    unsigned      options;
+    unsigned      extensions;
+    PString       fields;
+
+  private:
+    PerTableEntry(const PerTableEntry &);
+    void operator=(const PerTableEntry &);
+};
+
+
 
 class TypeBase : public PObject
 {
@@ -391,12 +422,17 @@ class TypeBase : public PObject
     virtual PBoolean ReferencesType(const TypeBase & type);
     virtual void SetImportPrefix(const PString &);
     virtual PBoolean IsParameterisedImport() const;
+    virtual PBoolean GetPerStructure(PerTableEntry & entry);
+    virtual PString GetPerTableReference(const PString & tableName, ostream & decl, ostream & defs);
+    virtual void GeneratePerTable(ostream & decl, ostream & defs);
+    virtual void GeneratePerFields(ostream & decl, ostream & defs);
 
     PBoolean IsGenerated() const { return isGenerated; }
     void BeginGenerateCplusplus(ostream & hdr, ostream & cxx);
     void EndGenerateCplusplus(ostream & hdr, ostream & cxx);
     void GenerateCplusplusConstructor(ostream & hdr, ostream & cxx);
     void GenerateCplusplusConstraints(const PString & prefix, ostream & hdr, ostream & cxx);
+    PBoolean GetPerTableEntry(PerTableEntry & entry);
 
   protected:
     TypeBase(unsigned tagNum);
@@ -437,6 +473,9 @@ class DefinedType : public TypeBase
     virtual PString GetTypeName() const;
     virtual PBoolean CanReferenceType() const;
     virtual PBoolean ReferencesType(const TypeBase & type);
+    virtual PBoolean GetPerStructure(PerTableEntry & entry);
+    virtual PString GetPerTableReference(const PString & tableName, ostream & decl, ostream & defs);
+    virtual void GeneratePerTable(ostream & decl, ostream & defs);
 
   protected:
     void ConstructFromType(TypeBase * refType, const PString & name);
@@ -519,6 +558,7 @@ class EnumeratedType : public TypeBase
     virtual void GenerateCplusplus(ostream & hdr, ostream & cxx);
     virtual void GenerateOperators(ostream & hdr, ostream & cxx, const TypeBase & actualType);
     virtual const char * GetAncestorClass() const;
+    virtual PBoolean GetPerStructure(PerTableEntry & entry);
   protected:
     NamedNumberList enumerations;
     PINDEX numEnums;
@@ -584,6 +624,8 @@ class SequenceType : public TypeBase
     virtual const char * GetAncestorClass() const;
     virtual PBoolean CanReferenceType() const;
     virtual PBoolean ReferencesType(const TypeBase & type);
+    virtual PBoolean GetPerStructure(PerTableEntry & entry);
+    virtual void GeneratePerFields(ostream & decl, ostream & defs);
   protected:
     TypesList fields;
     PINDEX numFields;
@@ -606,6 +648,8 @@ class SequenceOfType : public TypeBase
     virtual const char * GetAncestorClass() const;
     virtual PBoolean CanReferenceType() const;
     virtual PBoolean ReferencesType(const TypeBase & type);
+    virtual PBoolean GetPerStructure(PerTableEntry & entry);
+    virtual void GeneratePerFields(ostream & decl, ostream & defs);
   protected:
     TypeBase * baseType;
 };
@@ -642,6 +686,7 @@ class ChoiceType : public SequenceType
     virtual PBoolean IsChoice() const;
     virtual const char * GetAncestorClass() const;
     virtual PBoolean ReferencesType(const TypeBase & type);
+    virtual PBoolean GetPerStructure(PerTableEntry & entry);
 };
 
 
@@ -939,7 +984,6 @@ class IntegerValue : public ValueBase
     virtual void GenerateCplusplus(ostream & hdr, ostream & cxx);
 
     operator PInt64() const { return value; }
-    operator long() const { return (long)value; }
 
   protected:
     PInt64 value;
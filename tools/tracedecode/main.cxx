@@ -0,0 +1,283 @@
+/*
+ * main.cxx
+ *
+ * Convert a binary trace file, as produced by the PTrace::BinaryOutput
+ * option, to the normal text format.
+ *
+ * Portable Tools Library
+ *
+ * Copyright (C) 2026 Vox Lucida Pty. Ltd.
+ *
+ * The contents of this file are subject to the Mozilla Public License
+ * Version 1.0 (the "License"); you may not use this file except in
+ * compliance with the License. You may obtain a copy of the License at
+ * http://www.mozilla.org/MPL/
+ *
+ * Software distributed under the License is distributed on an "AS IS"
+ * basis, WITHOUT WARRANTY OF ANY KIND, either express or implied. See
+ * the License for the specific language governing rights and limitations
+ * under the License.
+ *
+ * The Original Code is Portable Tools Library.
+ *
+ * The Initial Developer of the Original Code is Vox Lucida Pty. Ltd.
+ *
+ * Contributor(s): ______________________________________.
+ */
+
+#include <ptlib.h>
+#include <ptlib/pprocess.h>
+#include <ptlib/tracebinary.h>
+
+#include <iomanip>
+
+
+class TraceDecode : public PProcess
+{
+  PCLASSINFO(TraceDecode, PProcess)
+  public:
+    TraceDecode();
+    void Main();
+
+  protected:
+    struct ThreadInfo
+    {
+      PString   m_name;
+      uintptr_t m_address;
+    };
+
+    bool Decode(const PFilePath & filename, ostream & output, const PString & optionOverrides);
+    void OutputLine(ostream & output, const PTraceBinary::LineRecord & record, const char * text);
+
+    PTraceBinary::FileHeader          m_header;
+    unsigned                          m_options;
+    std::map<unsigned, PString>       m_strings;
+    std::map<uint64_t, ThreadInfo>    m_threads;
+};
+
+PCREATE_PROCESS(TraceDecode);
+
+
+TraceDecode::TraceDecode()
+  : PProcess("Vox Lucida Pty. Ltd.", "tracedecode", 1, 0, ReleaseCode, 0)
+  , m_options(0)
+{
+}
+
+
+void TraceDecode::Main()
+{
+  PArgList & args = GetArguments();
+  args.Parse("o-output:  Output text file, default is standard output\n"
+             "O-options: Override trace options in file, e.g. \"+date-thread\"\n"
+             "h-help.    This help\n");
+
+  if (args.HasOption('h') || args.GetCount() == 0) {
+    args.Usage(cerr, "[ options ] binary-trace-file [ ... ]");
+    return;
+  }
+
+  PTextFile outputFile;
+  if (args.HasOption('o') && !outputFile.Open(args.GetOptionString('o'), PFile::WriteOnly)) {
+    cerr << "Could not open output file \"" << args.GetOptionString('o') << "\": " << outputFile.GetErrorText() << endl;
+    SetTerminationValue(1);
+    return;
+  }
+  ostream & output = outputFile.IsOpen() ? (ostream &)outputFile : cout;
+
+  for (PINDEX i = 0; i < args.GetCount(); ++i) {
+    if (!Decode(args[i], output, args.GetOptionString('O')))
+      SetTerminationValue(1);
+  }
+}
+
+
+bool TraceDecode::Decode(const PFilePath & filename, ostream & output, const PString & optionOverrides)
+{
+  PFile file;
+  if (!file.Open(filename, PFile::ReadOnly, PFile::MustExist)) {
+    cerr << "Could not open \"" << filename << "\": " << file.GetErrorText() << endl;
+    return false;
+  }
+
+  PBYTEArray data;
+  PINDEX length = (PINDEX)file.GetLength();
+  if (!file.Read(data.GetPointer(length), length) || file.GetLastReadCount() != length) {
+    cerr << "Could not read \"" << filename << "\": " << file.GetErrorText() << endl;
+    return false;
+  }
+
+  if (length < (PINDEX)sizeof(m_header) || memcmp(data, PTraceBinary::Magic(), sizeof(m_header.m_magic)) != 0) {
+    cerr << '"' << filename << "\" is not a binary trace file" << endl;
+    return false;
+  }
+
+  m_header = *(const PTraceBinary::FileHeader *)(const BYTE *)data;
+  if (m_header.m_version != PTraceBinary::Version) {
+    cerr << '"' << filename << "\" is unsupported version " << m_header.m_version << endl;
+    return false;
+  }
+
+  /* Use the PTrace option parser to apply any overrides, this process does
+     not trace so it does not matter that we change the global state. */
+  m_options = m_header.m_options;
+  if (!optionOverrides.IsEmpty()) {
+    unsigned internal = PTrace::Asynchronous|PTrace::BinaryOutput|PTrace::SystemLogStream|PTrace::RotateLogMask;
+    PTrace::ClearOptions(UINT_MAX);
+    PTrace::SetOptions(m_options & ~internal);
+    PTrace::SetOptionsByName(optionOverrides);
+    m_options = PTrace::GetOptions();
+  }
+
+  m_strings.clear();
+  m_threads.clear();
+
+  PINDEX position = PTraceBinary::RecordSize(m_header.m_headerSize, 0);
+  while (position + (PINDEX)sizeof(PTraceBinary::Record) <= length) {
+    const PTraceBinary::Record & record = *(const PTraceBinary::Record *)(data.GetPointer() + position);
+    if (record.m_size == 0 || position + (PINDEX)record.m_size > length)
+      break;
+
+    switch (record.m_type) {
+      case PTraceBinary::LineType :
+      case PTraceBinary::TextType :
+      {
+        const PTraceBinary::LineRecord & line = (const PTraceBinary::LineRecord &)record;
+        const char * text = (const char *)(&line+1);
+        if (record.m_type == PTraceBinary::LineType)
+          OutputLine(output, line, text);
+        else
+          output.write(text, line.m_textLength) << '\n';
+        break;
+      }
+
+      case PTraceBinary::StringType :
+      {
+        const PTraceBinary::StringRecord & str = (const PTraceBinary::StringRecord &)record;
+        m_strings[str.m_id] = PString((const char *)(&str+1), str.m_length);
+        break;
+      }
+
+      case PTraceBinary::ThreadType :
+      {
+        const PTraceBinary::ThreadRecord & thrd = (const PTraceBinary::ThreadRecord &)record;
+        ThreadInfo & info = m_threads[thrd.m_threadId];
+        info.m_name = PString((const char *)(&thrd+1), thrd.m_length);
+        info.m_address = (uintptr_t)(uint64_t)thrd.m_threadAddress;
+        break;
+      }
+
+      default :
+        break; // Ignore unknown record types from later versions
+    }
+
+    position += record.m_size;
+  }
+
+  output.flush();
+  return true;
+}
+
+
+// Reproduces the layout of PTraceInfo::InternalBegin()/InternalEnd()
+void TraceDecode::OutputLine(ostream & output, const PTraceBinary::LineRecord & record, const char * text)
+{
+  PStringStream stream;
+
+  if (m_options & PTrace::DateAndTime) {
+    PTime when(0, m_header.m_startTime + record.m_tick/1000);
+    stream << when.AsString(PTime::LoggingFormat, (m_options & PTrace::GMTTime) ? PTime::GMT : PTime::Local) << '\t';
+  }
+
+  if (m_options & PTrace::Timestamp)
+    stream << setprecision(3) << setw(10) << PTimeInterval::NanoSeconds(record.m_tick) << '\t';
+
+  if (m_options & PTrace::TraceLevel)
+    stream << record.m_level << '\t';
+
+  std::map<uint64_t, ThreadInfo>::iterator thread = m_threads.find(record.m_threadId);
+
+  if (m_options & PTrace::Thread) {
+    PString name = thread != m_threads.end() ? thread->second.m_name : PSTRSTRM("Thread:" << (uint64_t)record.m_threadId);
+#if P_64BIT && !defined(WIN32) && !defined(P_UNIQUE_THREAD_ID_FMT)
+    static const PINDEX ThreadNameWidth = 31;
+#else
+    static const PINDEX ThreadNameWidth = 23;
+#endif
+    if (name.GetLength() <= ThreadNameWidth)
+      stream << setw(ThreadNameWidth) << name;
+    else
+      stream << name.Left(10) << "..." << name.Right(ThreadNameWidth-13);
+    stream << '\t';
+  }
+
+  if (m_options & PTrace::ThreadAddress)
+    stream << hex << setfill('0') << setw(7) << (void *)(thread != m_threads.end() ? thread->second.m_address : 0)
+           << dec << setfill(' ') << '\t';
+
+  if (m_options & PTrace::FileAndLine) {
+    PString file = m_strings[record.m_fileId];
+    if (file.IsEmpty())
+      file = "-";
+    else {
+      PINDEX slash = file.FindLast('/');
+      if (slash == P_MAX_INDEX)
+        slash = file.FindLast('\\');
+      if (slash != P_MAX_INDEX)
+        file.Delete(0, slash+1);
+    }
+    static unsigned const FileWidth = 16;
+    stream << setw(FileWidth) << file.Left(FileWidth);
+
+    if (record.m_lineNum > 0)
+      stream << '(' << record.m_lineNum << ')';
+    else
+      stream << "       ";
+
+    stream << '\t';
+  }
+
+  if (m_options & PTrace::ObjectInstance) {
+    static unsigned const ObjWidth = 31;
+    if (record.m_object == 0)
+      stream << setw(ObjWidth/2) << '-' << setw(ObjWidth/2+1) << ' ';
+    else {
+      PString addr(PSTRSTRM(hex << (uint64_t)record.m_object));
+      unsigned width = ObjWidth - addr.GetLength() - 1;
+      PString cls = m_strings[record.m_classId];
+      if (cls.NumCompare("class ") == PObject::EqualTo)
+        cls.Delete(0, 6);
+      stream << setw(width) << cls.Left(width) << ':' << addr;
+    }
+    stream << '\t';
+  }
+
+  if (m_options & PTrace::ContextIdentifier) {
+    if (record.m_contextId != 0)
+      stream << setfill('0') << setw(13) << record.m_contextId << setfill(' ');
+    else
+      stream << "- - - - - - -";
+    stream << '\t';
+  }
+
+  if (record.m_moduleId != 0)
+    stream << left << setw(8) << m_strings[record.m_moduleId] << right << '\t';
+
+  PINDEX prefixLength = stream.GetLength();
+  stream << PString(text, record.m_textLength);
+
+  PINDEX tab = stream.Find('\t', prefixLength);
+  if (tab != P_MAX_INDEX && tab - prefixLength < 8)
+    stream.Splice("      ", tab, 0);
+
+  if (m_options & PTrace::SingleLine) {
+    stream.Replace("\\", "\\\\", true);
+    stream.Replace("\r", "\\r", true);
+    stream.Replace("\n", "\\n", true);
+  }
+
+  output << stream << '\n';
+}
+
+
+// End of File ///////////////////////////////////////////////////////////////